@@ -0,0 +1,73 @@
+#include "BatchEvaluator.hpp"
+#include "BenchmarkUtils.hpp"
+#include "Bytecode.hpp"
+#include <cstdint>
+#include "Parser.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string nameOf(MathTree::BatchEvaluator::InstructionSet instructionSet) {
+  using InstructionSet = MathTree::BatchEvaluator::InstructionSet;
+  switch (instructionSet) {
+  case InstructionSet::Avx2:
+    return "AVX2";
+  case InstructionSet::Sse2:
+    return "SSE2";
+  default:
+    return "scalar";
+  }
+}
+
+void compareEvaluations(std::string const& input, size_t rowCount) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const expression = parser.parse(input);
+  auto& symbols = parser.symbols();
+  auto const xIdx = symbols.declare("x");
+  auto const yIdx = symbols.declare("y");
+
+  std::vector<std::vector<double>> columnValues(symbols.size(), std::vector<double>(rowCount));
+  for (size_t row = 0; row < rowCount; ++row) {
+    columnValues[xIdx][row] = (row % 1000) * 0.01 + 0.5;
+    columnValues[yIdx][row] = (row % 7) * 0.25 + 1.0;
+  }
+  std::vector<double const*> columns;
+  for (auto const& column: columnValues) {
+    columns.push_back(column.data());
+  }
+  std::vector<double> out(rowCount);
+  std::vector<std::uint8_t> errorMask(rowCount);
+
+  auto const program = BytecodeProgram::compile(*expression);
+  auto const rowByRowTime = Benchmark::nanosecondsPerCall(rowCount, [&](size_t row) {
+    symbols.bind(xIdx, columnValues[xIdx][row]);
+    symbols.bind(yIdx, columnValues[yIdx][row]);
+    out[row] = program.evaluate();
+  });
+  Benchmark::report(input + " (bytecode, row by row)", rowByRowTime, "ns/row");
+
+  using InstructionSet = BatchEvaluator::InstructionSet;
+  size_t constexpr repetitions = 10;
+  for (auto instructionSet: {InstructionSet::Scalar, InstructionSet::Sse2, InstructionSet::Avx2}) {
+    if (!BatchEvaluator::isSupported(instructionSet)) {
+      continue;
+    }
+    BatchEvaluator evaluator(*expression, instructionSet);
+    auto const batchTime = Benchmark::nanosecondsPerCall(repetitions, [&](size_t) {
+      evaluator.evaluateBatch(columns.data(), columns.size(), out.data(), rowCount, errorMask.data());
+    }) / rowCount;
+    Benchmark::report(input + " (batch, " + nameOf(instructionSet) + ")", batchTime, "ns/row");
+  }
+}
+
+}
+
+int main() {
+  size_t constexpr rowCount = 1000000;
+  compareEvaluations("x*y+x/y-2*x", rowCount);
+  compareEvaluations("sqrt(x*x+y*y)", rowCount);
+  compareEvaluations("x^y+log_2(x)", rowCount);
+  return 0;
+}
\ No newline at end of file
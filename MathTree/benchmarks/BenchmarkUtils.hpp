@@ -0,0 +1,62 @@
+#ifndef MATHTREE_BENCHMARKUTILS
+#define MATHTREE_BENCHMARKUTILS
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace Benchmark {
+
+/// Returns the average number of nanoseconds taken by one of the given number of calls to the function.
+template<typename Function>
+double nanosecondsPerCall(size_t calls, Function&& function) {
+  auto const start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < calls; ++i) {
+    function(i);
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+/// Prevents the compiler from discarding the computation of the value given.
+inline void consume(double value) {
+  static double volatile sink;
+  sink = value;
+}
+
+/// Prints a row of results made of a label and a measure followed by its unit.
+inline void report(std::string_view label, double measure, std::string_view unit) {
+  std::cout << std::left << std::setw(48) << label << std::right << std::setw(14)
+            << std::fixed << std::setprecision(2) << measure << ' ' << unit << '\n';
+}
+
+/**
+ * Returns an expression made of the given number of terms chained by operators, which
+ * the parser turns into a tree as deep as the number of terms.
+ **/
+inline std::string chainedExpression(size_t terms) {
+  static char constexpr operators[] = {'+', '*', '-', '/'};
+  std::string expression = "1.5";
+  for (size_t i = 1; i < terms; ++i) {
+    expression += operators[i % 4];
+    expression += std::to_string(i % 9 + 1) + ".25";
+  }
+  return expression;
+}
+
+/// Returns an expression whose tree is perfectly balanced and has the given depth.
+inline std::string balancedExpression(size_t depth) {
+  // only positive terms are generated, so that no division by zero can take place
+  static char constexpr operators[] = {'+', '*', '+', '/'};
+  if (depth <= 1) {
+    return std::to_string(depth + 1) + ".5";
+  }
+  auto const subexpression = balancedExpression(depth - 1);
+  return '(' + subexpression + operators[depth % 4] + subexpression + ')';
+}
+
+}
+
+#endif // MATHTREE_BENCHMARKUTILS
\ No newline at end of file
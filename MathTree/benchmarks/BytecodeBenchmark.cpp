@@ -0,0 +1,34 @@
+#include "BenchmarkUtils.hpp"
+#include "Bytecode.hpp"
+#include "Parser.hpp"
+#include <string>
+
+namespace {
+
+void compareEvaluations(std::string const& label, std::string const& input, size_t evaluations) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  // no node keeps its result between evaluations, so the same tree is evaluated every time
+  auto const tree = parser.parse(input);
+  auto const program = BytecodeProgram::compile(*tree);
+
+  auto const treeTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(tree->evaluate());
+  });
+  auto const programTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(program.evaluate());
+  });
+
+  Benchmark::report(label + " (tree walk)", treeTime, "ns/eval");
+  Benchmark::report(label + " (bytecode)", programTime, "ns/eval");
+  Benchmark::report(label + " (speedup)", treeTime / programTime, "x");
+}
+
+}
+
+int main() {
+  compareEvaluations("deep, 1000 terms", Benchmark::chainedExpression(1000), 500);
+  compareEvaluations("wide, depth 12", Benchmark::balancedExpression(12), 200);
+  compareEvaluations("small, 8 terms", Benchmark::chainedExpression(8), 100000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include "BenchmarkUtils.hpp"
+#include "Parser.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Returns the evaluations per second achieved by the given number of threads evaluating the same tree.
+double evaluationsPerSecond(MathTree::Expression const& tree, size_t threadCount, size_t evaluationsPerThread) {
+  std::vector<std::thread> threads;
+  auto const start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back([&tree, evaluationsPerThread] {
+      for (size_t j = 0; j < evaluationsPerThread; ++j) {
+        Benchmark::consume(tree.evaluate());
+      }
+    });
+  }
+  for (auto& thread: threads) {
+    thread.join();
+  }
+  auto const nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return threadCount * evaluationsPerThread / nanoseconds * 1e9;
+}
+
+void measureScaling(std::string const& label, std::string const& input, size_t evaluationsPerThread) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const tree = parser.parse(input);
+  parser.symbols().bind("x", 1.75);
+
+  // at least four threads are run, so that contention shows up even on machines with fewer cores
+  size_t const maxThreads = std::max(4u, std::thread::hardware_concurrency());
+  auto const singleThreaded = evaluationsPerSecond(*tree, 1, evaluationsPerThread);
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    auto const throughput = evaluationsPerSecond(*tree, threads, evaluationsPerThread);
+    auto const threadsLabel = " (" + std::to_string(threads) + " threads)";
+    Benchmark::report(label + threadsLabel, throughput, "evals/s");
+    Benchmark::report(label + threadsLabel + " scaling", throughput / singleThreaded, "x");
+  }
+}
+
+}
+
+int main() {
+  // the variable comes first, so that every node of the chain depends on it and none is cached
+  auto const variableChain = "x" + Benchmark::chainedExpression(1000).substr(3);
+  measureScaling("shared tree, 1000 terms", variableChain, 2000);
+  measureScaling("shared tree, 8 terms", "x" + Benchmark::chainedExpression(8).substr(3), 500000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "BenchmarkUtils.hpp"
+#include "Bytecode.hpp"
+#include "ExpressionDag.hpp"
+#include "Parser.hpp"
+#include <string>
+
+namespace {
+
+// Returns an expression where every level repeats the one below three times, as in (a+b)^2+(a+b)*c+sqrt(a+b).
+std::string nestedRedundantExpression(size_t depth) {
+  std::string expression = "(a+b)";
+  for (size_t i = 0; i < depth; ++i) {
+    expression = '(' + expression + "^2+" + expression + "*c+sqrt(" + expression + "))";
+  }
+  return expression;
+}
+
+// Returns a sum of the given number of terms, each drawn from a small pool of distinct subexpressions.
+std::string pooledSum(size_t terms, size_t poolSize) {
+  std::string expression;
+  for (size_t i = 0; i < terms; ++i) {
+    auto const k = std::to_string(i % poolSize + 1);
+    expression += (i > 0 ? "+" : "") + ("sqrt(a*b+" + k + ")*log_2(c+" + k + ")");
+  }
+  return expression;
+}
+
+void compareEvaluations(std::string const& label, std::string const& input, size_t evaluations) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const tree = parser.parse(input);
+  parser.symbols().bind("a", 1.0);
+  parser.symbols().bind("b", 2.0);
+  parser.symbols().bind("c", 0.5);
+  auto const program = BytecodeProgram::compile(*tree);
+  auto const dag = ExpressionDag::build(*tree);
+
+  // the trees depend on variables, so no node caches its result between evaluations
+  auto const treeTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(tree->evaluate());
+  });
+  auto const programTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(program.evaluate());
+  });
+  auto const dagTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(dag.evaluate());
+  });
+
+  Benchmark::report(label + " (tree nodes)", static_cast<double>(dag.treeSize()), "nodes");
+  Benchmark::report(label + " (graph nodes)", static_cast<double>(dag.nodes().size()), "nodes");
+  Benchmark::report(label + " (tree walk)", treeTime, "ns/eval");
+  Benchmark::report(label + " (bytecode)", programTime, "ns/eval");
+  Benchmark::report(label + " (graph)", dagTime, "ns/eval");
+  Benchmark::report(label + " (speedup vs tree)", treeTime / dagTime, "x");
+  Benchmark::report(label + " (speedup vs bytecode)", programTime / dagTime, "x");
+}
+
+}
+
+int main() {
+  compareEvaluations("nested, depth 4", nestedRedundantExpression(4), 20000);
+  compareEvaluations("nested, depth 6", nestedRedundantExpression(6), 2000);
+  // every term is one of ten distinct subexpressions
+  compareEvaluations("pooled, 300 terms", pooledSum(300, 10), 5000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "BenchmarkUtils.hpp"
+#include "Expression.hpp"
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/**
+ * Sweeps the variable x of the expression across the interval [start, start + 2), and compares catching
+ * the domain errors thrown by evaluate() with reading the errors returned by tryEvaluate().
+ **/
+void compareErrorHandling(std::string const& label, std::string const& input, double start, size_t points) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const tree = parser.parse(input);
+  auto const x = parser.symbols().declare("x");
+  auto const step = 2.0 / points;
+
+  size_t errors = 0;
+  auto const throwingTime = Benchmark::nanosecondsPerCall(points, [&](size_t i) {
+    parser.symbols().bind(x, start + i * step);
+    try {
+      Benchmark::consume(tree->evaluate());
+    } catch (std::domain_error const&) {
+      ++errors;
+    }
+  });
+  auto const nonThrowingTime = Benchmark::nanosecondsPerCall(points, [&](size_t i) {
+    parser.symbols().bind(x, start + i * step);
+    auto const result = tree->tryEvaluate();
+    Benchmark::consume(result ? result.value() : 0.0);
+  });
+
+  Benchmark::report(label + " (failed points)", 100.0 * errors / points, "%");
+  Benchmark::report(label + " (evaluate and catch)", throwingTime, "ns/point");
+  Benchmark::report(label + " (tryEvaluate)", nonThrowingTime, "ns/point");
+  Benchmark::report(label + " (speedup)", throwingTime / nonThrowingTime, "x");
+}
+
+}
+
+int main() {
+  // the square root is the deepest expression of the chain, so errors unwind through the whole tree
+  auto const chain = [](size_t terms) {
+    return "sqrt(x)" + Benchmark::chainedExpression(terms).substr(3);
+  };
+  compareErrorHandling("small, 8 terms, x in [0, 2)", chain(8), 0.0, 200000);
+  compareErrorHandling("small, 8 terms, x in [-1, 1)", chain(8), -1.0, 200000);
+  compareErrorHandling("deep, 1000 terms, x in [0, 2)", chain(1000), 0.0, 5000);
+  compareErrorHandling("deep, 1000 terms, x in [-1, 1)", chain(1000), -1.0, 5000);
+  return 0;
+}
\ No newline at end of file
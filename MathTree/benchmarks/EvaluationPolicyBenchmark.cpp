@@ -0,0 +1,65 @@
+#include "BenchmarkUtils.hpp"
+#include "EvaluationPolicy.hpp"
+#include "Expression.hpp"
+#include "Parser.hpp"
+#include <string>
+
+namespace {
+
+/// Returns the number of nanoseconds taken to evaluate the tree as per the policy given, for values of x in [1, 2).
+template<typename Policy>
+double nanosecondsPerEvaluation(MathTree::Expression const& tree, MathTree::SymbolTable& symbols, size_t x,
+                                size_t evaluations) {
+  return Benchmark::nanosecondsPerCall(evaluations, [&](size_t i) {
+    symbols.bind(x, 1.0 + static_cast<double>(i) / evaluations);
+    Benchmark::consume(tree.evaluateWith<Policy>());
+  });
+}
+
+/// Evaluates the same tree, which depends on the variable x, with each of the evaluation policies.
+void comparePolicies(std::string const& label, std::string const& input, size_t evaluations) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const tree = parser.parse(input);
+  auto& symbols = parser.symbols();
+  auto const x = *symbols.indexOf("x");
+
+  auto const checked = nanosecondsPerEvaluation<EvaluationPolicy::Checked>(*tree, symbols, x, evaluations);
+  auto const propagating = nanosecondsPerEvaluation<EvaluationPolicy::Propagating>(*tree, symbols, x, evaluations);
+  auto const unchecked = nanosecondsPerEvaluation<EvaluationPolicy::Unchecked>(*tree, symbols, x, evaluations);
+
+  Benchmark::report(label + " (checked)", checked, "ns/evaluation");
+  Benchmark::report(label + " (propagating)", propagating, "ns/evaluation");
+  Benchmark::report(label + " (unchecked)", unchecked, "ns/evaluation");
+  Benchmark::report(label + " (propagating speedup)", checked / propagating, "x");
+  Benchmark::report(label + " (unchecked speedup)", checked / unchecked, "x");
+}
+
+/// Returns the given expression with every occurrence of the literal given replaced by the variable x.
+std::string withVariable(std::string expression, std::string const& literal) {
+  for (auto position = expression.find(literal); position != std::string::npos;
+       position = expression.find(literal, position + 1)) {
+    expression.replace(position, literal.size(), "x");
+  }
+  return expression;
+}
+
+/// Returns a sum of terms which each compute a square root, a logarithm, a power and a division of x.
+std::string functionsExpression(size_t terms) {
+  std::string expression = "0";
+  for (size_t i = 1; i <= terms; ++i) {
+    auto const shift = std::to_string(i % 7 + 1);
+    expression += "+sqrt(x+" + shift + ")*log_2(x*" + shift + ")-x^1.5/(x+" + shift + ")";
+  }
+  return expression;
+}
+
+}
+
+int main() {
+  // x is the deepest operand of the chain, so that no subexpression is constant
+  comparePolicies("chain, 1000 terms", "x" + Benchmark::chainedExpression(1000).substr(3), 20000);
+  comparePolicies("balanced, depth 12", withVariable(Benchmark::balancedExpression(12), "2.5"), 5000);
+  comparePolicies("functions, 100 terms", functionsExpression(100), 20000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "BenchmarkUtils.hpp"
+#include <cmath>
+#include <memory_resource>
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <string>
+#include <utility>
+
+namespace {
+
+// Counts the bytes held at any time by the trees allocated through it.
+class LiveBytesResource: public std::pmr::memory_resource {
+public:
+  size_t liveBytes() const {
+    return m_liveBytes;
+  }
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    m_liveBytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+    m_liveBytes -= bytes;
+    std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    return this == &other;
+  }
+
+  size_t m_liveBytes = 0;
+};
+
+// Returns a sum of the given number of terms alternating between two variables and a product.
+std::string variableSum(size_t terms) {
+  std::string expression = "x";
+  for (size_t i = 1; i < terms; ++i) {
+    expression += i % 3 == 0 ? "-y" : i % 3 == 1 ? "+x*y*0.5" : "+y";
+  }
+  return expression;
+}
+
+void compareEvaluations(std::string const& label, size_t terms, size_t evaluations) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const input = variableSum(terms);
+  parser.parse(input);
+  parser.symbols().bind("x", 0.1);
+  parser.symbols().bind("y", 0.7);
+
+  LiveBytesResource chainResource;
+  auto const chain = parser.parse(input, chainResource);
+  auto const chainTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(chain->evaluate());
+  });
+  Benchmark::report(label + " (binary chain)", chainTime, "ns/eval");
+  Benchmark::report(label + " (binary chain memory)", static_cast<double>(chainResource.liveBytes()), "bytes");
+
+  static std::pair<SummationMode, char const*> constexpr modes[] = {{SummationMode::Sequential, "sequential"},
+                                                                    {SummationMode::Pairwise, "pairwise"},
+                                                                    {SummationMode::Kahan, "kahan"}};
+  for (auto const& [mode, name]: modes) {
+    LiveBytesResource resource;
+    auto const flattened = flattenAssociativeChains(parser.parse(input, resource), mode, resource).tree;
+    auto const time = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+      Benchmark::consume(flattened->evaluate());
+    });
+    Benchmark::report(label + " (" + name + ")", time, "ns/eval");
+    Benchmark::report(label + " (" + name + " speedup)", chainTime / time, "x");
+    if (mode == SummationMode::Sequential) {
+      Benchmark::report(label + " (flattened memory)", static_cast<double>(resource.liveBytes()), "bytes");
+    }
+  }
+}
+
+// Sums the same inexact number many times, whose exact total is known.
+void compareAccuracy(size_t terms) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  std::string input = "0.1";
+  for (size_t i = 1; i < terms; ++i) {
+    input += "+0.1";
+  }
+  auto const exact = 0.1L * terms;
+  auto const label = std::to_string(terms) + " x 0.1";
+  // the errors are too small to be printed as they are
+  Benchmark::report(label + " (binary chain error)", static_cast<double>(std::abs(parser.parse(input)->evaluate() - exact) * 1e12), "x 1e-12");
+  static std::pair<SummationMode, char const*> constexpr modes[] = {{SummationMode::Pairwise, "pairwise"},
+                                                                    {SummationMode::Kahan, "kahan"}};
+  for (auto const& [mode, name]: modes) {
+    auto const sum = flattenAssociativeChains(parser.parse(input), mode).tree->evaluate();
+    Benchmark::report(label + " (" + name + " error)", static_cast<double>(std::abs(sum - exact) * 1e12), "x 1e-12");
+  }
+}
+
+}
+
+int main() {
+  compareEvaluations("100 terms", 100, 100000);
+  compareEvaluations("10000 terms", 10000, 1000);
+  compareAccuracy(10000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "BenchmarkUtils.hpp"
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <string>
+
+namespace {
+
+/// Compares evaluating a tree which depends on the variable x before and after its multiply-adds are contracted.
+void compareContraction(std::string const& label, std::string const& input, size_t evaluations) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const original = parser.parse(input);
+  auto const separate = contractMultiplyAdds(parser.parse(input), MultiplyAddRounding::Separate).tree;
+  auto const fused = contractMultiplyAdds(parser.parse(input), MultiplyAddRounding::Fused).tree;
+  auto const x = *parser.symbols().indexOf("x");
+
+  auto const measure = [&](Expression const& tree) {
+    return Benchmark::nanosecondsPerCall(evaluations, [&](size_t i) {
+      parser.symbols().bind(x, 1.0 + static_cast<double>(i) / evaluations);
+      Benchmark::consume(tree.evaluate());
+    });
+  };
+  auto const originalTime = measure(*original);
+  auto const separateTime = measure(*separate);
+  auto const fusedTime = measure(*fused);
+
+  Benchmark::report(label + " (original)", originalTime, "ns/eval");
+  Benchmark::report(label + " (separate rounding)", separateTime, "ns/eval");
+  Benchmark::report(label + " (fused rounding)", fusedTime, "ns/eval");
+  Benchmark::report(label + " (speedup, separate)", originalTime / separateTime, "x");
+  Benchmark::report(label + " (speedup, fused)", originalTime / fusedTime, "x");
+}
+
+/// Returns a polynomial in x of the given degree written in Horner's form, where every level is a multiply-add.
+std::string hornerForm(size_t degree) {
+  std::string expression = "1";
+  for (size_t i = 1; i <= degree; ++i) {
+    expression = "(" + expression + ")*x+" + std::to_string(i % 7 + 1);
+  }
+  return expression;
+}
+
+/// Returns a sum of the given number of products, which contracts into a chain of multiply-adds.
+std::string dotProduct(size_t terms) {
+  std::string expression = "0";
+  for (size_t i = 1; i <= terms; ++i) {
+    expression += "+" + std::to_string(i % 7 + 1) + "*(x-" + std::to_string(i % 3) + ")";
+  }
+  return expression;
+}
+
+}
+
+int main() {
+  compareContraction("Horner's form, degree 100", hornerForm(100), 20000);
+  compareContraction("dot product, 100 terms", dotProduct(100), 20000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "BenchmarkUtils.hpp"
+#include "IterativeEvaluator.hpp"
+#include "Parser.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+void compareEvaluations(std::string const& label, std::string const& input, size_t evaluations, bool canRecurse = true) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  // no node keeps its result between evaluations, so the same tree is evaluated every time
+  auto const tree = parser.parse(input);
+  double recursiveTime = 0;
+  if (canRecurse) {
+    recursiveTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+      Benchmark::consume(tree->evaluate());
+    });
+  }
+  IterativeEvaluator evaluator;
+  auto const iterativeTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t) {
+    Benchmark::consume(evaluator.evaluate(*tree));
+  });
+
+  // every tree can only be destroyed once
+  std::vector<std::unique_ptr<Expression>> trees;
+  for (size_t i = 0; i < evaluations; ++i) {
+    trees.push_back(parser.parse(input));
+  }
+  auto const destructionTime = Benchmark::nanosecondsPerCall(evaluations, [&](size_t i) {
+    trees[i].reset();
+  });
+
+  if (canRecurse) {
+    Benchmark::report(label + " (recursive)", recursiveTime, "ns/eval");
+    Benchmark::report(label + " (speedup)", recursiveTime / iterativeTime, "x");
+  }
+  Benchmark::report(label + " (iterative)", iterativeTime, "ns/eval");
+  Benchmark::report(label + " (destruction)", destructionTime, "ns/tree");
+}
+
+}
+
+int main() {
+  compareEvaluations("deep, 1000 terms", Benchmark::chainedExpression(1000), 500);
+  compareEvaluations("wide, depth 12", Benchmark::balancedExpression(12), 200);
+  compareEvaluations("small, 8 terms", Benchmark::chainedExpression(8), 100000);
+  // recursing through a tree this deep overflows the stack, so only the iterative evaluation is measured
+  compareEvaluations("very deep, 10^6 terms", Benchmark::chainedExpression(1000000), 3, false);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "BenchmarkUtils.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "Scanning.hpp"
+#include <string>
+#include <utility>
+
+namespace {
+
+// Returns a sum of the given number of long decimal constants, as found in tables of coefficients.
+std::string decimalTable(size_t constants) {
+  std::string expression;
+  for (size_t i = 0; i < constants; ++i) {
+    expression += (i > 0 ? "+" : "") + std::to_string(i % 97 + 1) + ".0123456789" + std::to_string(i % 89 + 10);
+  }
+  return expression;
+}
+
+// Returns a sum of products of constants and variables, with logarithms of a given base.
+std::string mixedExpression(size_t terms) {
+  std::string expression;
+  for (size_t i = 0; i < terms; ++i) {
+    expression += (i > 0 ? "+" : "") + ("2.5*rate_" + std::to_string(i % 10) + "/log_2.75(x+" +
+                                        std::to_string(i % 9 + 1) + ".125)");
+  }
+  return expression;
+}
+
+// Returns a product of the given number of bracketed groups, dense in operators and single digits.
+std::string operatorHeavyExpression(size_t groups) {
+  std::string expression;
+  for (size_t i = 0; i < groups; ++i) {
+    expression += (i > 0 ? "*" : "") + std::string("(-(1+2)/(3-4)^2+sqrt(5))");
+  }
+  return expression;
+}
+
+// Returns a generated sum of long integers padded with runs of spaces, about the given number of bytes long.
+std::string paddedIntegers(size_t bytes) {
+  std::string expression = "1";
+  for (size_t i = 0; expression.size() < bytes; ++i) {
+    expression += std::string(i % 24 + 1, ' ') + "+ " + std::to_string(1234567890123 + i * 7919) +
+                  std::string(i % 7, ' ');
+  }
+  return expression;
+}
+
+// Returns a generated expression laid out over many lines, each indented by a long run of spaces.
+std::string indentedLines(size_t bytes) {
+  std::string expression = "0";
+  for (size_t i = 0; expression.size() < bytes; ++i) {
+    expression += "\n" + std::string(32 + i % 64, ' ') + "+ " + std::to_string(i % 1000) + " * x";
+  }
+  return expression;
+}
+
+void measure(std::string const& label, std::string const& input, size_t passes) {
+  using namespace MathTree;
+  ArithmeticLexer lexer;
+  size_t tokens = 0;
+  auto const lexingTime = Benchmark::nanosecondsPerCall(passes, [&](size_t) {
+    lexer.reset(input);
+    while (lexer.next().type() != TokenType::Stop) {
+      ++tokens;
+    }
+  });
+
+  ArithmeticParser parser;
+  auto const parsingTime = Benchmark::nanosecondsPerCall(passes, [&](size_t) {
+    Benchmark::consume(parser.parse(input)->isConstant());
+  });
+
+  auto const validationTime = Benchmark::nanosecondsPerCall(passes, [&](size_t) {
+    Benchmark::consume(static_cast<double>(ArithmeticParser::validateSyntax(input).size()));
+  });
+
+  // bytes per nanosecond are thousands of megabytes per second
+  Benchmark::report(label + " (lexing)", lexingTime * passes / tokens, "ns/token");
+  Benchmark::report(label + " (lexing)", input.size() / lexingTime * 1000, "MB/s");
+  Benchmark::report(label + " (validation)", input.size() / validationTime * 1000, "MB/s");
+  Benchmark::report(label + " (parsing)", input.size() / parsingTime * 1000, "MB/s");
+}
+
+// Measures how fast each instruction set skips a run of characters as long as the whole input.
+void measureScanning(size_t bytes, size_t passes) {
+  using namespace MathTree;
+  std::string const spaces = std::string(bytes, ' ') + 'x';
+  std::string const digits = std::string(bytes, '7') + 'x';
+  for (auto const& [instructionSet, name]: {std::pair{Utils::InstructionSet::Scalar, "scalar"},
+                                            std::pair{Utils::InstructionSet::Sse2, "sse2"},
+                                            std::pair{Utils::InstructionSet::Avx2, "avx2"}}) {
+    if (!Utils::isSupported(instructionSet)) {
+      continue;
+    }
+    auto const spacesTime = Benchmark::nanosecondsPerCall(passes, [&](size_t) {
+      Benchmark::consume(static_cast<double>(Scanning::skipSpaces(spaces, 0, instructionSet)));
+    });
+    auto const digitsTime = Benchmark::nanosecondsPerCall(passes, [&](size_t) {
+      Benchmark::consume(static_cast<double>(Scanning::skipNumberCharacters(digits, 0, instructionSet)));
+    });
+    Benchmark::report(std::string("skipping spaces (") + name + ")", bytes / spacesTime * 1000, "MB/s");
+    Benchmark::report(std::string("skipping digits (") + name + ")", bytes / digitsTime * 1000, "MB/s");
+  }
+}
+
+}
+
+int main() {
+  measure("decimal table, 1000 constants", decimalTable(1000), 300);
+  measure("mixed, 300 terms", mixedExpression(300), 300);
+  measure("operator heavy, 300 groups", operatorHeavyExpression(300), 300);
+  measure("padded integers, 4 MB", paddedIntegers(4 << 20), 5);
+  measure("indented lines, 4 MB", indentedLines(4 << 20), 5);
+  measureScanning(4 << 20, 20);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "BenchmarkUtils.hpp"
+#include "ExpressionDag.hpp"
+#include <memory>
+#include <memory_resource>
+#include "Parser.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Counts the bytes requested from the default resource, which does not include the overhead of the allocator.
+class CountingResource: public std::pmr::memory_resource {
+public:
+  size_t bytes = 0;
+
+private:
+  void* do_allocate(size_t size, size_t alignment) override {
+    bytes += size;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+  }
+
+  void do_deallocate(void* memory, size_t size, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(memory, size, alignment);
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/// Returns one of many distinct formulas of the same shape, which has a large constant subtree if asked to.
+std::string formula(size_t index, bool mostlyConstant) {
+  auto const constant = [index](size_t salt) {
+    return std::to_string((index * 7919 + salt * 104729) % 97 + 1);
+  };
+  auto const variableTerms = "sqrt(x*" + constant(1) + "+" + constant(2) + ")-x/" + constant(3) +
+                             "+(x-" + constant(4) + ")^2*x";
+  auto const constantTerms = "sqrt(" + constant(5) + "+" + constant(6) + ")*log_2(" + constant(7) + "+1)^2";
+  return mostlyConstant ? variableTerms + "+x*(" + constantTerms + "-" + constant(8) + "/" + constant(9) + ")"
+                        : variableTerms + "+" + constant(8) + "*x^3";
+}
+
+/**
+ * Compares keeping the given number of formulas resident without memoisation, with their constant subtrees
+ * memoised in their nodes, and as graphs memoising every result in a scratch buffer for one evaluation only.
+ **/
+void compareMemoisations(std::string const& label, bool mostlyConstant, size_t formulas, size_t rounds) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  CountingResource plainResource;
+  CountingResource memoisedResource;
+  std::vector<std::unique_ptr<Expression>> plainTrees;
+  std::vector<std::unique_ptr<Expression>> memoisedTrees;
+  std::vector<ExpressionDag> graphs;
+  size_t nodes = 0;
+  size_t graphBytes = 0;
+  size_t scratchBytes = 0;
+  for (size_t i = 0; i < formulas; ++i) {
+    auto const input = formula(i, mostlyConstant);
+    parser.setMemoisation(Memoisation::None);
+    plainTrees.push_back(parser.parse(input, plainResource));
+    parser.setMemoisation(Memoisation::ConstantSubtrees);
+    memoisedTrees.push_back(parser.parse(input, memoisedResource));
+    graphs.push_back(ExpressionDag::build(*plainTrees.back()));
+    nodes += graphs.back().treeSize();
+    graphBytes += graphs.back().nodes().capacity() * sizeof(ExpressionDag::Node);
+    scratchBytes += graphs.back().nodes().size() * sizeof(double);
+  }
+  auto const x = *parser.symbols().indexOf("x");
+  parser.symbols().bind(x, 1.0);
+
+  auto const timeOf = [&](auto const& evaluate) {
+    // the memoised trees only keep their results from the first evaluation on, as a resident tree would
+    evaluate();
+    return Benchmark::nanosecondsPerCall(rounds, [&](size_t i) {
+      parser.symbols().bind(x, 1.0 + static_cast<double>(i) / rounds);
+      evaluate();
+    }) / formulas;
+  };
+  auto const plainTime = timeOf([&] {
+    for (auto const& tree: plainTrees) {
+      Benchmark::consume(tree->evaluate());
+    }
+  });
+  auto const memoisedTime = timeOf([&] {
+    for (auto const& tree: memoisedTrees) {
+      Benchmark::consume(tree->evaluate());
+    }
+  });
+  auto const graphTime = timeOf([&] {
+    for (auto const& graph: graphs) {
+      Benchmark::consume(graph.evaluate());
+    }
+  });
+
+  // bytes are counted per node of the tree without memoisation, so that the memoisations count as overhead
+  Benchmark::report(label + " (nodes per formula)", static_cast<double>(nodes) / formulas, "nodes");
+  Benchmark::report(label + " (none)", static_cast<double>(plainResource.bytes) / nodes, "bytes/node");
+  Benchmark::report(label + " (constant subtrees)", static_cast<double>(memoisedResource.bytes) / nodes, "bytes/node");
+  Benchmark::report(label + " (per evaluation)", static_cast<double>(graphBytes) / nodes, "bytes/node");
+  Benchmark::report(label + " (scratch buffer)", static_cast<double>(scratchBytes) / nodes, "bytes/node");
+  Benchmark::report(label + " (none)", plainTime, "ns/formula");
+  Benchmark::report(label + " (constant subtrees)", memoisedTime, "ns/formula");
+  Benchmark::report(label + " (per evaluation)", graphTime, "ns/formula");
+}
+
+}
+
+int main() {
+  compareMemoisations("no constant subtree", false, 20000, 20);
+  compareMemoisations("constant subtree", true, 20000, 20);
+  return 0;
+}
\ No newline at end of file
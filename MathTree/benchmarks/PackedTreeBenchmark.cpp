@@ -0,0 +1,86 @@
+#include "BenchmarkUtils.hpp"
+#include <memory>
+#include <memory_resource>
+#include "PackedTree.hpp"
+#include "Parser.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Counts the bytes requested from the default resource, which does not include the overhead of the allocator.
+class CountingResource: public std::pmr::memory_resource {
+public:
+  size_t bytes = 0;
+
+private:
+  void* do_allocate(size_t size, size_t alignment) override {
+    bytes += size;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+  }
+
+  void do_deallocate(void* memory, size_t size, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(memory, size, alignment);
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/// Returns one of many distinct formulas depending on the variable x, all of the same shape.
+std::string formula(size_t index) {
+  auto const constant = [index](size_t salt) {
+    return std::to_string((index * 7919 + salt * 104729) % 97 + 1);
+  };
+  return "sqrt(x*" + constant(1) + "+" + constant(2) + ")*log_2(x+" + constant(3) + ")-x/" + constant(4) +
+         "+(x-" + constant(5) + ")^2*(" + constant(6) + "-x*x/" + constant(7) + ")";
+}
+
+/// Compares keeping the given number of formulas resident as trees and as packed trees, and evaluating them all.
+void compareResidentFormulas(size_t formulas, size_t rounds) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  CountingResource resource;
+  std::vector<std::unique_ptr<Expression>> trees;
+  std::vector<PackedTree> packedTrees;
+  size_t nodes = 0;
+  size_t packedBytes = 0;
+  for (size_t i = 0; i < formulas; ++i) {
+    trees.push_back(parser.parse(formula(i), resource));
+    packedTrees.push_back(PackedTree::build(*trees.back()));
+    nodes += packedTrees.back().size();
+    packedBytes += packedTrees.back().memoryFootprint();
+  }
+  auto const x = *parser.symbols().indexOf("x");
+
+  auto const treeTime = Benchmark::nanosecondsPerCall(rounds, [&](size_t i) {
+    parser.symbols().bind(x, 1.0 + static_cast<double>(i) / rounds);
+    for (auto const& tree: trees) {
+      Benchmark::consume(tree->evaluate());
+    }
+  });
+  auto const packedTime = Benchmark::nanosecondsPerCall(rounds, [&](size_t i) {
+    parser.symbols().bind(x, 1.0 + static_cast<double>(i) / rounds);
+    for (auto const& tree: packedTrees) {
+      Benchmark::consume(tree.evaluate());
+    }
+  });
+
+  auto const label = std::to_string(formulas) + " formulas";
+  Benchmark::report(label + " (nodes per formula)", static_cast<double>(nodes) / formulas, "nodes");
+  Benchmark::report(label + " (tree)", static_cast<double>(resource.bytes) / nodes, "bytes/node");
+  Benchmark::report(label + " (packed)", static_cast<double>(packedBytes) / nodes, "bytes/node");
+  Benchmark::report(label + " (tree walk)", treeTime / formulas, "ns/formula");
+  Benchmark::report(label + " (packed)", packedTime / formulas, "ns/formula");
+  Benchmark::report(label + " (speedup)", treeTime / packedTime, "x");
+}
+
+}
+
+int main() {
+  compareResidentFormulas(1000, 200);
+  compareResidentFormulas(20000, 10);
+  compareResidentFormulas(100000, 2);
+  return 0;
+}
\ No newline at end of file
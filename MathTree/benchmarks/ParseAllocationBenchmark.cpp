@@ -0,0 +1,103 @@
+#include "BenchmarkUtils.hpp"
+#include <cstdlib>
+#include "Lexer.hpp"
+#include <memory_resource>
+#include <new>
+#include "Parser.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+size_t allocationCount = 0;
+}
+
+// every allocation made through the global operator new is counted
+void* operator new(size_t size) {
+  ++allocationCount;
+  if (auto memory = std::malloc(size > 0 ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  ++allocationCount;
+  auto const align = static_cast<size_t>(alignment);
+  // std::aligned_alloc requires the size to be a multiple of the alignment
+  if (auto memory = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+void compareAllocations(std::string const& label, std::string const& input, size_t parses) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  // the first parse declares any variable, so that later parses do not grow the symbol table
+  parser.parse(input);
+
+  auto countBefore = allocationCount;
+  auto const heapTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    auto tree = parser.parse(input);
+    Benchmark::consume(tree->isConstant());
+  });
+  auto const heapAllocations = static_cast<double>(allocationCount - countBefore) / parses;
+
+  // the buffer is large enough for the deepest tree, so that the arena never allocates
+  std::vector<std::byte> buffer(512 * 1024);
+  countBefore = allocationCount;
+  auto const arenaTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    auto tree = parser.parse(input, arena);
+    Benchmark::consume(tree->isConstant());
+  });
+  auto const arenaAllocations = static_cast<double>(allocationCount - countBefore) / parses;
+
+  Benchmark::report(label + " (heap)", heapAllocations, "allocs/parse");
+  Benchmark::report(label + " (arena)", arenaAllocations, "allocs/parse");
+  Benchmark::report(label + " (heap)", heapTime, "ns/parse");
+  Benchmark::report(label + " (arena)", arenaTime, "ns/parse");
+}
+
+void measureLexing(std::string const& label, std::string const& input, size_t passes) {
+  using namespace MathTree;
+  ArithmeticLexer lexer;
+  size_t tokens = 0;
+  auto const countBefore = allocationCount;
+  auto const time = Benchmark::nanosecondsPerCall(passes, [&](size_t) {
+    lexer.reset(input);
+    while (lexer.next().type() != TokenType::Stop) {
+      ++tokens;
+    }
+  });
+  Benchmark::report(label + " (lexing)", static_cast<double>(allocationCount - countBefore) / tokens, "allocs/token");
+  Benchmark::report(label + " (lexing)", time * passes / tokens, "ns/token");
+}
+
+}
+
+int main() {
+  compareAllocations("small, 8 terms", Benchmark::chainedExpression(8), 100000);
+  compareAllocations("functions and variables", "(x+2.5)*sqrt(y)/log_2(z)-3^2", 100000);
+  compareAllocations("deep, 1000 terms", Benchmark::chainedExpression(1000), 500);
+  measureLexing("functions and long names", "(rate_of_growth+2.5)*sqrt(y)/log_2.75(z)-3.125^2", 100000);
+  return 0;
+}
\ No newline at end of file
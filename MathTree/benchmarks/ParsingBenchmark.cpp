@@ -0,0 +1,137 @@
+#include "BenchmarkUtils.hpp"
+#include <cstddef>
+#include "Lexer.hpp"
+#include <memory_resource>
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Returns a sum of terms mixing functions, signs, brackets and variables.
+std::string functionsExpression(size_t terms) {
+  std::string expression;
+  for (size_t i = 0; i < terms; ++i) {
+    expression += (i > 0 ? "+" : "") + std::string("-sqrt(x*2.5)^2/log_2(y+") + std::to_string(i % 9 + 1) + ")";
+  }
+  return expression;
+}
+
+void compareDispatch(std::string const& label, std::string const& input, size_t parses) {
+  using namespace MathTree;
+  auto const symbols = std::make_shared<SymbolTable>();
+  // the trees are built in an arena, so that the measures are not dominated by allocations
+  std::vector<std::byte> buffer(4 << 20);
+
+  auto const runtimeTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    ArithmeticLexer lexer(input);
+    PrattParser parser(ArithmeticParser::grammar(), lexer, symbols, arena);
+    Benchmark::consume(parser.parse()->isConstant());
+  });
+  auto const staticTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    ArithmeticLexer lexer(input);
+    StaticPrattParser<ArithmeticGrammar> parser(lexer, symbols, arena);
+    Benchmark::consume(parser.parse()->isConstant());
+  });
+
+  Benchmark::report(label + " (runtime grammar)", runtimeTime, "ns/parse");
+  Benchmark::report(label + " (static grammar)", staticTime, "ns/parse");
+  Benchmark::report(label + " (speedup)", runtimeTime / staticTime, "x");
+}
+
+// Returns a number enclosed in the given number of brackets, each one negated.
+std::string nestedExpression(size_t depth) {
+  std::string expression;
+  for (size_t i = 0; i < depth; ++i) {
+    expression += "-(";
+  }
+  return expression + "1" + std::string(depth, ')');
+}
+
+double nanosecondsPerParse(MathTree::ArithmeticParser::ParsingEngine engine, std::string const& input, size_t parses) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  parser.setParsingEngine(engine);
+  std::vector<std::byte> buffer(64 << 20);
+  return Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    Benchmark::consume(parser.parse(input, arena)->isConstant());
+  });
+}
+
+void compareEngines(std::string const& label, std::string const& input, size_t parses) {
+  using Engine = MathTree::ArithmeticParser::ParsingEngine;
+  auto const recursiveTime = nanosecondsPerParse(Engine::Recursive, input, parses);
+  auto const iterativeTime = nanosecondsPerParse(Engine::Iterative, input, parses);
+  Benchmark::report(label + " (recursive engine)", recursiveTime, "ns/parse");
+  Benchmark::report(label + " (iterative engine)", iterativeTime, "ns/parse");
+  Benchmark::report(label + " (iterative/recursive)", iterativeTime / recursiveTime, "x");
+}
+
+// The recursive engine cannot parse these depths, so only the iterative one is measured, per nesting level.
+void measureDeepNesting(size_t depth, size_t parses) {
+  using Engine = MathTree::ArithmeticParser::ParsingEngine;
+  auto const time = nanosecondsPerParse(Engine::Iterative, nestedExpression(depth), parses);
+  Benchmark::report("nested, depth " + std::to_string(depth) + " (iterative engine)", time / depth, "ns/level");
+}
+
+// Compares validating then parsing, as drivers used to, with validating and parsing in a single pass.
+void compareValidation(std::string const& label, std::string const& input, size_t parses) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  std::vector<std::byte> buffer(4 << 20);
+  auto const separateTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    if (ArithmeticParser::validateSyntax(input).empty()) {
+      Benchmark::consume(parser.parse(input, arena)->isConstant());
+    }
+  });
+  auto const fusedTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    Benchmark::consume(static_cast<double>(parser.tryParse(input, arena).errors.size()));
+  });
+  Benchmark::report(label + " (validate, then parse)", separateTime, "ns/input");
+  Benchmark::report(label + " (single pass)", fusedTime, "ns/input");
+  Benchmark::report(label + " (speedup)", separateTime / fusedTime, "x");
+}
+
+// Compares catching the exception thrown by parsing a malformed input with reading its syntax errors.
+void compareMalformedInput(std::string const& label, std::string const& input, size_t parses) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const throwingTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    try {
+      Benchmark::consume(parser.parse(input)->isConstant());
+    } catch (std::logic_error const&) {
+      Benchmark::consume(1.0);
+    }
+  });
+  auto const fusedTime = Benchmark::nanosecondsPerCall(parses, [&](size_t) {
+    Benchmark::consume(static_cast<double>(parser.tryParse(input).errors.size()));
+  });
+  Benchmark::report(label + " (parse and catch)", throwingTime, "ns/input");
+  Benchmark::report(label + " (single pass)", fusedTime, "ns/input");
+  Benchmark::report(label + " (speedup)", throwingTime / fusedTime, "x");
+}
+
+}
+
+int main() {
+  compareDispatch("small, 8 terms", Benchmark::chainedExpression(8), 200000);
+  compareDispatch("chained, 1000 terms", Benchmark::chainedExpression(1000), 1000);
+  compareDispatch("functions, 300 terms", functionsExpression(300), 1000);
+  compareEngines("chained, 1000 terms", Benchmark::chainedExpression(1000), 1000);
+  compareEngines("functions, 300 terms", functionsExpression(300), 1000);
+  compareEngines("nested, depth 1000", nestedExpression(1000), 1000);
+  for (size_t depth: {10000, 100000, 1000000}) {
+    measureDeepNesting(depth, 10000000 / depth);
+  }
+  compareValidation("small, 8 terms", Benchmark::chainedExpression(8), 200000);
+  compareValidation("functions, 300 terms", functionsExpression(300), 1000);
+  compareMalformedInput("unclosed bracket, 8 terms", "(" + Benchmark::chainedExpression(8), 200000);
+  compareMalformedInput("trailing operator, 8 terms", Benchmark::chainedExpression(8) + "*", 200000);
+  return 0;
+}
\ No newline at end of file
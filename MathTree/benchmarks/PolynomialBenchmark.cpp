@@ -0,0 +1,89 @@
+#include "BenchmarkUtils.hpp"
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Returns a polynomial of the given degree in x, written out in expanded form.
+std::string expandedPolynomial(size_t degree) {
+  std::string expression = "1";
+  for (size_t i = 1; i <= degree; ++i) {
+    expression += (i % 2 == 0 ? "+" : "-") + std::to_string(i % 5 + 1) + ".5*x^" + std::to_string(i);
+  }
+  return expression;
+}
+
+double horner(std::vector<double> const& coefficients, double argument) {
+  auto result = coefficients.back();
+  for (size_t i = coefficients.size() - 1; i > 0; --i) {
+    result = result * argument + coefficients[i - 1];
+  }
+  return result;
+}
+
+// the coefficients must be padded with zeros to a multiple of four
+double estrin(std::vector<double> const& coefficients, double argument) {
+  auto const square = argument * argument;
+  auto const fourthPower = square * square;
+  auto result = 0.0;
+  for (auto block = coefficients.size(); block > 0; block -= 4) {
+    auto const first = coefficients.data() + block - 4;
+    result = result * fourthPower + ((first[0] + first[1] * argument) + (first[2] + first[3] * argument) * square);
+  }
+  return result;
+}
+
+/**
+ * Compares evaluating the expanded form of a polynomial with evaluating the node it is recognised as,
+ * and the two schemes the node chooses from on their own, outside of any tree.
+ **/
+void comparePolynomials(size_t degree, size_t evaluations) {
+  using namespace MathTree;
+  auto const label = "degree " + std::to_string(degree);
+  ArithmeticParser parser;
+  auto const input = expandedPolynomial(degree);
+  auto const original = parser.parse(input);
+  auto const recognised = recognisePolynomials(parser.parse(input)).tree;
+  auto const polynomial = dynamic_cast<PolynomialExpression const*>(recognised.get());
+  if (polynomial == nullptr) {
+    Benchmark::report(label + " (not recognised)", 0.0, "");
+    return;
+  }
+  auto const x = *parser.symbols().indexOf("x");
+
+  auto const measure = [&](Expression const& tree) {
+    return Benchmark::nanosecondsPerCall(evaluations, [&](size_t i) {
+      parser.symbols().bind(x, 0.5 + static_cast<double>(i) / evaluations);
+      Benchmark::consume(tree.evaluate());
+    });
+  };
+  auto const originalTime = measure(*original);
+  auto const polynomialTime = measure(*recognised);
+
+  std::vector<double> const coefficients(polynomial->coefficients().begin(), polynomial->coefficients().end());
+  auto const hornerTime = Benchmark::nanosecondsPerCall(evaluations * 10, [&](size_t i) {
+    Benchmark::consume(horner(coefficients, 0.5 + static_cast<double>(i) / evaluations));
+  });
+  auto blockCoefficients = coefficients;
+  blockCoefficients.resize((coefficients.size() + 3) / 4 * 4, 0.0);
+  auto const estrinTime = Benchmark::nanosecondsPerCall(evaluations * 10, [&](size_t i) {
+    Benchmark::consume(estrin(blockCoefficients, 0.5 + static_cast<double>(i) / evaluations));
+  });
+
+  Benchmark::report(label + " (expanded tree)", originalTime, "ns/eval");
+  Benchmark::report(label + " (polynomial node)", polynomialTime, "ns/eval");
+  Benchmark::report(label + " (speedup)", originalTime / polynomialTime, "x");
+  Benchmark::report(label + " (Horner's scheme alone)", hornerTime, "ns/eval");
+  Benchmark::report(label + " (Estrin's scheme alone)", estrinTime, "ns/eval");
+}
+
+}
+
+int main() {
+  for (size_t degree: {2, 4, 6, 8, 12, 16, 24, 32}) {
+    comparePolynomials(degree, 100000);
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "BenchmarkUtils.hpp"
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <string>
+
+namespace {
+
+/// Compares evaluating a tree which depends on the variable x before and after its strength is reduced.
+void compareReduction(std::string const& label, std::string const& input, size_t evaluations) {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  auto const original = parser.parse(input);
+  auto const reduced = reduceStrength(parser.parse(input)).tree;
+  auto const x = *parser.symbols().indexOf("x");
+
+  auto const measure = [&](Expression const& tree) {
+    return Benchmark::nanosecondsPerCall(evaluations, [&](size_t i) {
+      parser.symbols().bind(x, 1.0 + static_cast<double>(i) / evaluations);
+      Benchmark::consume(tree.evaluate());
+    });
+  };
+  auto const originalTime = measure(*original);
+  auto const reducedTime = measure(*reduced);
+
+  Benchmark::report(label + " (original)", originalTime, "ns/eval");
+  Benchmark::report(label + " (reduced)", reducedTime, "ns/eval");
+  Benchmark::report(label + " (speedup)", originalTime / reducedTime, "x");
+}
+
+/// Returns a sum of the given number of terms, each made of the operation given applied to a shifted x.
+std::string sumOf(size_t terms, std::string const& prefix, std::string const& suffix) {
+  std::string expression = "0";
+  for (size_t i = 1; i <= terms; ++i) {
+    expression += "+" + prefix + "(x+" + std::to_string(i % 7) + ")" + suffix;
+  }
+  return expression;
+}
+
+}
+
+int main() {
+  compareReduction("squares, 100 terms", sumOf(100, "", "^2"), 20000);
+  compareReduction("cubes, 100 terms", sumOf(100, "", "^3"), 20000);
+  compareReduction("eighth powers, 100 terms", sumOf(100, "", "^8"), 20000);
+  compareReduction("half powers, 100 terms", sumOf(100, "", "^0.5"), 20000);
+  compareReduction("decimal logarithms, 100 terms", sumOf(100, "log", ""), 20000);
+  compareReduction("binary logarithms, 100 terms", sumOf(100, "log_2", ""), 20000);
+  compareReduction("logarithms in base 3, 100 terms", sumOf(100, "log_3", ""), 20000);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "BenchmarkUtils.hpp"
+#include <cstdlib>
+#include "Expression.hpp"
+#include <new>
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <string>
+
+namespace {
+size_t allocationCount = 0;
+}
+
+// every allocation made through the global operator new is counted
+void* operator new(size_t size) {
+  ++allocationCount;
+  if (auto memory = std::malloc(size > 0 ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+/// Returns the number of nodes of the tree, listing the subexpressions of every node.
+size_t countByList(MathTree::Expression const& expression) {
+  size_t count = 1;
+  for (auto subexpression: expression.subexpressions()) {
+    count += countByList(*subexpression);
+  }
+  return count;
+}
+
+/// Returns the number of nodes of the tree, accessing the subexpressions of every node by position.
+size_t countByPosition(MathTree::Expression const& expression) {
+  size_t count = 1;
+  for (size_t i = 0; i < expression.subexpressionCount(); ++i) {
+    count += countByPosition(expression.subexpression(i));
+  }
+  return count;
+}
+
+/// Compares walking the tree given both ways, which visits every node of the tree once per walk.
+void compareWalks(std::string const& label, MathTree::Expression const& tree, size_t walks) {
+  auto const nodes = countByPosition(tree);
+
+  auto allocationsBefore = allocationCount;
+  auto const listTime = Benchmark::nanosecondsPerCall(walks, [&](size_t) {
+    Benchmark::consume(static_cast<double>(countByList(tree)));
+  });
+  auto const listAllocations = allocationCount - allocationsBefore;
+  allocationsBefore = allocationCount;
+  auto const positionTime = Benchmark::nanosecondsPerCall(walks, [&](size_t) {
+    Benchmark::consume(static_cast<double>(countByPosition(tree)));
+  });
+  auto const positionAllocations = allocationCount - allocationsBefore;
+
+  Benchmark::report(label + " (nodes)", static_cast<double>(nodes), "nodes");
+  Benchmark::report(label + " (subexpressions)", listTime / nodes, "ns/node");
+  Benchmark::report(label + " (subexpressions)", static_cast<double>(listAllocations) / walks, "allocs/walk");
+  Benchmark::report(label + " (by position)", positionTime / nodes, "ns/node");
+  Benchmark::report(label + " (by position)", static_cast<double>(positionAllocations) / walks, "allocs/walk");
+  Benchmark::report(label + " (speedup)", listTime / positionTime, "x");
+}
+
+/// Returns a sum of the given number of terms, each made of a few operations on the variable x.
+std::string sumOfTerms(size_t terms) {
+  std::string expression = "0";
+  for (size_t i = 1; i <= terms; ++i) {
+    expression += "+sqrt(x*" + std::to_string(i % 7 + 1) + ")";
+  }
+  return expression;
+}
+
+}
+
+int main() {
+  using namespace MathTree;
+  ArithmeticParser parser;
+  // 2^20 - 1 nodes, every one of which but the leaves has two subexpressions
+  compareWalks("balanced, depth 20", *parser.parse(Benchmark::balancedExpression(20)), 10);
+  // the chain of additions is merged into a single sum of 250000 terms of 4 nodes each
+  auto const sum = flattenAssociativeChains(parser.parse(sumOfTerms(250000))).tree;
+  compareWalks("flattened sum, 250000 terms", *sum, 10);
+  return 0;
+}
\ No newline at end of file
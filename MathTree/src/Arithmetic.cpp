@@ -0,0 +1,81 @@
+#include <array>
+#include "Arithmetic.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace MathTree {
+
+namespace Arithmetic {
+
+void throwDivisionByZero() {
+  throw std::domain_error("Detected a divide-by-zero operation.");
+}
+
+void throwInvalidPower(double base, double exponent) {
+  throw std::domain_error("Cannot compute " + std::to_string(base) +
+                          " to the power of " + std::to_string(exponent) + ".");
+}
+
+void throwInvalidSquareRoot(double radicand) {
+  throw std::domain_error("Cannot compute the square root of " + std::to_string(radicand) + ".");
+}
+
+void throwInvalidLogarithm(double argument) {
+  throw std::domain_error("Cannot compute the logarithm of " + std::to_string(argument) +
+                          ". The argument must be a positive number.");
+}
+
+void throwInvalidLogarithmBase(double base) {
+  throw std::domain_error("Cannot have a logarithm with base " + std::to_string(base) +
+                          ". The base must be a finite, positive number.");
+}
+
+double pairwiseSum(double const* values, size_t count) {
+  // blocks up to this size are not split any further
+  static size_t constexpr blockSize = 32;
+  if (count > blockSize) {
+    auto const half = count / 2;
+    return pairwiseSum(values, half) + pairwiseSum(values + half, count - half);
+  }
+
+  static size_t constexpr accumulatorCount = 4;
+  std::array<double, accumulatorCount> accumulators{};
+  size_t i = 0;
+  for (; i + accumulatorCount <= count; i += accumulatorCount) {
+    for (size_t j = 0; j < accumulatorCount; ++j) {
+      accumulators[j] += values[i + j];
+    }
+  }
+  auto sum = (accumulators[0] + accumulators[1]) + (accumulators[2] + accumulators[3]);
+  for (; i < count; ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+double compensatedSum(double const* values, size_t count) {
+  if (count == 0) {
+    return 0.0;
+  }
+
+  auto sum = values[0];
+  auto compensation = 0.0;
+  for (size_t i = 1; i < count; ++i) {
+    auto const value = values[i];
+    auto const total = sum + value;
+    // recovers the low order bits lost by the addition, from whichever operand is smaller
+    if (std::abs(sum) >= std::abs(value)) {
+      compensation += (sum - total) + value;
+    } else {
+      compensation += (value - total) + sum;
+    }
+    sum = total;
+  }
+  // an infinite sum would turn the compensation into NaN
+  return std::isfinite(sum) ? sum + compensation : sum;
+}
+
+}
+
+}
\ No newline at end of file
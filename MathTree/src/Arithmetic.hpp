@@ -0,0 +1,112 @@
+#ifndef MATHTREE_ARITHMETIC
+#define MATHTREE_ARITHMETIC
+
+#include <cmath>
+#include <cstddef>
+
+namespace MathTree {
+
+namespace Arithmetic {
+
+/// Throws the domain error reported when dividing by zero.
+[[noreturn]] void throwDivisionByZero();
+/// Throws the domain error reported when the base raised to the exponent is not a real number.
+[[noreturn]] void throwInvalidPower(double base, double exponent);
+/// Throws the domain error reported when the radicand of a square root is not valid.
+[[noreturn]] void throwInvalidSquareRoot(double radicand);
+/// Throws the domain error reported when the argument of a logarithm is not valid.
+[[noreturn]] void throwInvalidLogarithm(double argument);
+/// Throws the domain error reported when the base of a logarithm is not valid.
+[[noreturn]] void throwInvalidLogarithmBase(double base);
+
+/// Returns true if the divisor is not zero, false otherwise.
+inline bool isValidDivisor(double divisor) {
+  return divisor != 0.0;
+}
+
+/// Throws if the divisor is zero.
+inline void ensureValidDivisor(double divisor) {
+  if (!isValidDivisor(divisor)) {
+    throwDivisionByZero();
+  }
+}
+
+/**
+ * Returns true if the base raised to the exponent is a real number, false otherwise.
+ * Namely, with a and b denoting real numbers, the following are not real:
+ * 0^0 for any a and b;
+ * 0^a with a < 0;
+ * a^b with a < 0 and b non-integer.
+ **/
+inline bool isValidPower(double base, double exponent) {
+  // 0^0 is not defined for real numbers
+  // 0^a with a < 0 implies 1/0, which is not a real number
+  // a^b with a < 0 is only a real number when b is an integer
+  return !((base == 0.0 && exponent <= 0.0) ||
+           (base < 0.0 && std::floor(exponent) != std::ceil(exponent)));
+}
+
+/// Returns the base raised to the exponent. Throws if the result is not real, as per isValidPower.
+inline double power(double base, double exponent) {
+  if (!isValidPower(base, exponent)) {
+    throwInvalidPower(base, exponent);
+  }
+  return std::pow(base, exponent);
+}
+
+/// Returns true if the radicand is a finite, non-negative number, false otherwise.
+inline bool isValidRadicand(double radicand) {
+  return !(radicand < 0 || std::isinf(radicand) || std::isnan(radicand));
+}
+
+/// Returns the square root of the radicand. Throws if the radicand is infinite, negative or non-real.
+inline double squareRoot(double radicand) {
+  if (!isValidRadicand(radicand)) {
+    throwInvalidSquareRoot(radicand);
+  }
+  return std::sqrt(radicand);
+}
+
+/// Returns false if the argument of a logarithm is a non-positive number, true otherwise.
+inline bool isValidLogarithmArgument(double argument) {
+  return !(argument <= 0);
+}
+
+/// Returns the logarithm of the argument in the given base. Throws if the argument is non-positive.
+inline double logarithm(double argument, double base) {
+  if (!isValidLogarithmArgument(argument)) {
+    throwInvalidLogarithm(argument);
+  }
+  return std::log2(argument) / std::log2(base);
+}
+
+/// Returns true if the base of a logarithm is a finite, positive number, false otherwise.
+inline bool isValidLogarithmBase(double base) {
+  return std::isfinite(base) && base > 0;
+}
+
+/// Throws if the base is not a finite, positive number.
+inline void ensureValidLogarithmBase(double base) {
+  if (!isValidLogarithmBase(base)) {
+    throwInvalidLogarithmBase(base);
+  }
+}
+
+/**
+ * Returns the sum of the values given computed by pairwise summation, whose rounding error grows with the
+ * logarithm of the number of values rather than linearly. Small blocks of values are added up by independent
+ * accumulators, which the compiler can vectorise.
+ **/
+double pairwiseSum(double const* values, size_t count);
+
+/**
+ * Returns the sum of the values given computed by Kahan's compensated summation, in the variant of Neumaier which
+ * also compensates values larger than the running sum. Its rounding error does not grow with the number of values.
+ **/
+double compensatedSum(double const* values, size_t count);
+
+}
+
+}
+
+#endif // MATHTREE_ARITHMETIC
\ No newline at end of file
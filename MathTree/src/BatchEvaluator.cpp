@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <array>
+#include "Arithmetic.hpp"
+#include "BatchEvaluator.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "Utils.hpp"
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MATHTREE_X86_64
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MATHTREE_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define MATHTREE_AVX2_TARGET
+#endif
+
+namespace MathTree {
+
+namespace {
+
+struct Kernels {
+  void (*negate)(double* values, size_t count);
+  void (*add)(double* left, double const* right, size_t count);
+  void (*subtract)(double* left, double const* right, size_t count);
+  void (*multiply)(double* left, double const* right, size_t count);
+  void (*checkDivisors)(double const* divisors, std::uint8_t* errors, size_t count);
+  void (*divide)(double* divisors, double const* dividends, size_t count);
+  void (*power)(double* bases, double const* exponents, std::uint8_t* errors, size_t count);
+  void (*squareRoot)(double* radicands, std::uint8_t* errors, size_t count);
+  void (*logarithm)(double* arguments, double log2Base, std::uint8_t* errors, size_t count);
+  void (*constantPower)(double* bases, double exponent, std::uint8_t* errors, size_t count);
+  void (*specialisedLogarithm)(double* arguments, double base, std::uint8_t* errors, size_t count);
+  void (*polynomial)(double* arguments, double const* coefficients, size_t coefficientCount, size_t count);
+  void (*fusedMultiplyAdd)(double* results, double const* multiplicands, double const* multipliers,
+                           double const* addends, size_t count);
+};
+
+namespace Scalar {
+
+struct Ops {
+  using Vector = double;
+  static size_t constexpr width = 1;
+
+  static Vector load(double const* source) { return *source; }
+  static void store(double* destination, Vector value) { *destination = value; }
+  static Vector broadcast(double value) { return value; }
+  static Vector negate(Vector value) { return -value; }
+  static Vector add(Vector left, Vector right) { return left + right; }
+  static Vector subtract(Vector left, Vector right) { return left - right; }
+  static Vector multiply(Vector left, Vector right) { return left * right; }
+  static Vector divide(Vector left, Vector right) { return left / right; }
+  static Vector squareRoot(Vector value) { return std::sqrt(value); }
+  static int zeroLanes(Vector value) { return !Arithmetic::isValidDivisor(value); }
+  static int nonPositiveLanes(Vector value) { return !Arithmetic::isValidLogarithmArgument(value); }
+  static int invalidRadicandLanes(Vector value) { return !Arithmetic::isValidRadicand(value); }
+  static int invalidPowerLanes(Vector bases, Vector exponents) {
+    return !Arithmetic::isValidPower(bases, exponents);
+  }
+};
+
+#define MATHTREE_KERNEL
+#include "BatchKernels.inl"
+#undef MATHTREE_KERNEL
+
+}
+
+#ifdef MATHTREE_X86_64
+namespace Sse2 {
+
+struct Ops {
+  using Vector = __m128d;
+  static size_t constexpr width = 2;
+
+  static Vector load(double const* source) { return _mm_loadu_pd(source); }
+  static void store(double* destination, Vector value) { _mm_storeu_pd(destination, value); }
+  static Vector broadcast(double value) { return _mm_set1_pd(value); }
+  static Vector negate(Vector value) { return _mm_xor_pd(value, _mm_set1_pd(-0.0)); }
+  static Vector add(Vector left, Vector right) { return _mm_add_pd(left, right); }
+  static Vector subtract(Vector left, Vector right) { return _mm_sub_pd(left, right); }
+  static Vector multiply(Vector left, Vector right) { return _mm_mul_pd(left, right); }
+  static Vector divide(Vector left, Vector right) { return _mm_div_pd(left, right); }
+  static Vector squareRoot(Vector value) { return _mm_sqrt_pd(value); }
+  static int zeroLanes(Vector value) {
+    return _mm_movemask_pd(_mm_cmpeq_pd(value, _mm_setzero_pd()));
+  }
+  static int nonPositiveLanes(Vector value) {
+    return _mm_movemask_pd(_mm_cmple_pd(value, _mm_setzero_pd()));
+  }
+  static int invalidRadicandLanes(Vector value) {
+    // "not greater or equal" also holds for NaN
+    auto const infinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    return _mm_movemask_pd(_mm_or_pd(_mm_cmpnge_pd(value, _mm_setzero_pd()),
+                                     _mm_cmpeq_pd(value, infinity)));
+  }
+  static int invalidPowerLanes(Vector bases, Vector exponents) {
+    // SSE2 cannot round to an integer, so the lanes are checked one at a time
+    alignas(16) double basesArray[width], exponentsArray[width];
+    _mm_store_pd(basesArray, bases);
+    _mm_store_pd(exponentsArray, exponents);
+    int mask = 0;
+    for (size_t lane = 0; lane < width; ++lane) {
+      mask |= !Arithmetic::isValidPower(basesArray[lane], exponentsArray[lane]) << lane;
+    }
+    return mask;
+  }
+};
+
+#define MATHTREE_KERNEL
+#include "BatchKernels.inl"
+#undef MATHTREE_KERNEL
+
+}
+
+namespace Avx2 {
+
+struct Ops {
+  using Vector = __m256d;
+  static size_t constexpr width = 4;
+
+  MATHTREE_AVX2_TARGET static Vector load(double const* source) { return _mm256_loadu_pd(source); }
+  MATHTREE_AVX2_TARGET static void store(double* destination, Vector value) {
+    _mm256_storeu_pd(destination, value);
+  }
+  MATHTREE_AVX2_TARGET static Vector broadcast(double value) { return _mm256_set1_pd(value); }
+  MATHTREE_AVX2_TARGET static Vector negate(Vector value) {
+    return _mm256_xor_pd(value, _mm256_set1_pd(-0.0));
+  }
+  MATHTREE_AVX2_TARGET static Vector add(Vector left, Vector right) { return _mm256_add_pd(left, right); }
+  MATHTREE_AVX2_TARGET static Vector subtract(Vector left, Vector right) { return _mm256_sub_pd(left, right); }
+  MATHTREE_AVX2_TARGET static Vector multiply(Vector left, Vector right) { return _mm256_mul_pd(left, right); }
+  MATHTREE_AVX2_TARGET static Vector divide(Vector left, Vector right) { return _mm256_div_pd(left, right); }
+  MATHTREE_AVX2_TARGET static Vector squareRoot(Vector value) { return _mm256_sqrt_pd(value); }
+  MATHTREE_AVX2_TARGET static int zeroLanes(Vector value) {
+    return _mm256_movemask_pd(_mm256_cmp_pd(value, _mm256_setzero_pd(), _CMP_EQ_OQ));
+  }
+  MATHTREE_AVX2_TARGET static int nonPositiveLanes(Vector value) {
+    return _mm256_movemask_pd(_mm256_cmp_pd(value, _mm256_setzero_pd(), _CMP_LE_OQ));
+  }
+  MATHTREE_AVX2_TARGET static int invalidRadicandLanes(Vector value) {
+    auto const infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    return _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(value, _mm256_setzero_pd(), _CMP_NGE_UQ),
+                                           _mm256_cmp_pd(value, infinity, _CMP_EQ_OQ)));
+  }
+  MATHTREE_AVX2_TARGET static int invalidPowerLanes(Vector bases, Vector exponents) {
+    auto const zero = _mm256_setzero_pd();
+    auto const roundedDown = _mm256_round_pd(exponents, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    auto const roundedUp = _mm256_round_pd(exponents, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+    auto const zeroToNonPositive = _mm256_and_pd(_mm256_cmp_pd(bases, zero, _CMP_EQ_OQ),
+                                                 _mm256_cmp_pd(exponents, zero, _CMP_LE_OQ));
+    auto const negativeToNonInteger = _mm256_and_pd(_mm256_cmp_pd(bases, zero, _CMP_LT_OQ),
+                                                    _mm256_cmp_pd(roundedDown, roundedUp, _CMP_NEQ_UQ));
+    return _mm256_movemask_pd(_mm256_or_pd(zeroToNonPositive, negativeToNonInteger));
+  }
+};
+
+#define MATHTREE_KERNEL MATHTREE_AVX2_TARGET
+#include "BatchKernels.inl"
+#undef MATHTREE_KERNEL
+
+}
+#endif
+
+Kernels const& kernelsFor(BatchEvaluator::InstructionSet instructionSet) {
+  switch (instructionSet) {
+#ifdef MATHTREE_X86_64
+  case BatchEvaluator::InstructionSet::Avx2:
+    return Avx2::kernels;
+  case BatchEvaluator::InstructionSet::Sse2:
+    return Sse2::kernels;
+#endif
+  default:
+    return Scalar::kernels;
+  }
+}
+
+}
+
+BatchEvaluator::InstructionSet BatchEvaluator::bestInstructionSet() {
+  return Utils::bestInstructionSet();
+}
+
+bool BatchEvaluator::isSupported(InstructionSet instructionSet) {
+  return Utils::isSupported(instructionSet);
+}
+
+BatchEvaluator::BatchEvaluator(Expression const& expression):
+                                  BatchEvaluator(expression, bestInstructionSet()) {}
+
+BatchEvaluator::BatchEvaluator(Expression const& expression, InstructionSet instructionSet):
+                                  m_program(BytecodeProgram::compile(expression)),
+                                  m_instructionSet(instructionSet) {
+  if (!isSupported(instructionSet)) {
+    throw std::invalid_argument("The instruction set requested is not supported on this machine.");
+  }
+
+  for (auto const& instruction: m_program.instructions()) {
+    if (instruction.opCode == BytecodeProgram::OpCode::LoadVariable) {
+      m_requiredColumns = std::max<size_t>(m_requiredColumns, instruction.index + 1);
+    }
+  }
+}
+
+size_t BatchEvaluator::evaluateBatch(double const* const* columns, size_t columnCount,
+                                     double* out, size_t rowCount,
+                                     std::uint8_t* errorMask) const {
+  using OpCode = BytecodeProgram::OpCode;
+  if (columnCount < m_requiredColumns) {
+    throw std::invalid_argument("The expression references more variables than the columns provided.");
+  }
+
+  auto const& kernels = kernelsFor(m_instructionSet);
+  // every slot of the stack holds the values of a whole chunk
+  std::vector<double> stack(m_program.maxStackDepth() * chunkSize);
+  std::uint8_t errors[chunkSize];
+  size_t errorCount = 0;
+  for (size_t firstRow = 0; firstRow < rowCount; firstRow += chunkSize) {
+    auto const rows = std::min(chunkSize, rowCount - firstRow);
+    std::fill_n(errors, rows, 0);
+
+    // points to the first free slot of the stack
+    auto top = stack.data();
+    for (auto const& instruction: m_program.instructions()) {
+      switch (instruction.opCode) {
+      case OpCode::PushConstant:
+        std::fill_n(top, rows, instruction.operand);
+        top += chunkSize;
+        break;
+      case OpCode::LoadVariable:
+        std::copy_n(columns[instruction.index] + firstRow, rows, top);
+        top += chunkSize;
+        break;
+      case OpCode::Negate:
+        kernels.negate(top - chunkSize, rows);
+        break;
+      case OpCode::Add:
+        top -= chunkSize;
+        kernels.add(top - chunkSize, top, rows);
+        break;
+      case OpCode::Subtract:
+        top -= chunkSize;
+        kernels.subtract(top - chunkSize, top, rows);
+        break;
+      case OpCode::Multiply:
+        top -= chunkSize;
+        kernels.multiply(top - chunkSize, top, rows);
+        break;
+      case OpCode::CheckDivisor:
+        kernels.checkDivisors(top - chunkSize, errors, rows);
+        break;
+      case OpCode::Divide:
+        top -= chunkSize;
+        kernels.divide(top - chunkSize, top, rows);
+        break;
+      case OpCode::Power:
+        top -= chunkSize;
+        kernels.power(top - chunkSize, top, errors, rows);
+        break;
+      case OpCode::SquareRoot:
+        kernels.squareRoot(top - chunkSize, errors, rows);
+        break;
+      case OpCode::Logarithm:
+        kernels.logarithm(top - chunkSize, std::log2(instruction.operand), errors, rows);
+        break;
+      case OpCode::ConstantPower:
+        kernels.constantPower(top - chunkSize, instruction.operand, errors, rows);
+        break;
+      case OpCode::SpecialisedLogarithm:
+        kernels.specialisedLogarithm(top - chunkSize, instruction.operand, errors, rows);
+        break;
+      case OpCode::Polynomial: {
+        auto const& coefficients = m_program.polynomials()[instruction.index];
+        kernels.polynomial(top - chunkSize, coefficients.data(), coefficients.size(), rows);
+        break;
+      }
+      case OpCode::FusedMultiplyAdd:
+        top -= 2 * chunkSize;
+        kernels.fusedMultiplyAdd(top - chunkSize, top - chunkSize, top, top + chunkSize, rows);
+        break;
+      case OpCode::FusedAddMultiply:
+        top -= 2 * chunkSize;
+        kernels.fusedMultiplyAdd(top - chunkSize, top, top + chunkSize, top - chunkSize, rows);
+        break;
+      }
+    }
+
+    for (size_t row = 0; row < rows; ++row) {
+      out[firstRow + row] = errors[row] ? std::numeric_limits<double>::quiet_NaN() : stack[row];
+      errorCount += errors[row];
+    }
+    if (errorMask != nullptr) {
+      std::copy_n(errors, rows, errorMask + firstRow);
+    }
+  }
+  return errorCount;
+}
+
+BatchEvaluator::InstructionSet BatchEvaluator::instructionSet() const {
+  return m_instructionSet;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef MATHTREE_BATCHEVALUATOR
+#define MATHTREE_BATCHEVALUATOR
+
+#include "Bytecode.hpp"
+#include <cstdint>
+#include "Expression.hpp"
+#include "Utils.hpp"
+
+namespace MathTree {
+
+/**
+ * Evaluates an expression over many rows of variable bindings at once.
+ * Rows are processed a chunk at a time, and every operation of the expression is
+ * applied to a whole chunk using the widest SIMD instructions supported by the processor.
+ **/
+class BatchEvaluator {
+public:
+  /// Represents the instructions used to evaluate a chunk of rows: SSE2 handles two rows at a time, and AVX2 four.
+  using InstructionSet = Utils::InstructionSet;
+
+  /// The number of rows evaluated together by each operation.
+  static size_t constexpr chunkSize = 256;
+
+  /// Returns the widest instruction set supported by both the build and the processor.
+  static InstructionSet bestInstructionSet();
+  /// Returns true if the given instruction set can be used by both the build and the processor, false otherwise.
+  static bool isSupported(InstructionSet instructionSet);
+
+  /**
+   * Constructs a batch evaluator for the given expression, using the best instruction set available.
+   * Throws if the expression cannot be compiled into a BytecodeProgram.
+   **/
+  explicit BatchEvaluator(Expression const& expression);
+  /**
+   * Constructs a batch evaluator for the given expression, using the instruction set provided.
+   * Throws if the instruction set is not supported or if the expression cannot be compiled.
+   **/
+  BatchEvaluator(Expression const& expression, InstructionSet instructionSet);
+
+  /**
+   * Evaluates the expression once for every row, and stores the results in the output provided.
+   * Columns are indexed like the symbol table of the expression, so that the i-th column holds
+   * the values taken by the variable with index i, one per row.
+   * Rows for which the expression throws a domain error produce a NaN result and, if an
+   * error mask is provided, are flagged by setting the corresponding element of the mask to 1.
+   * Returns the number of rows that produced a domain error.
+   * Throws if fewer columns are provided than the variables referenced by the expression.
+   **/
+  size_t evaluateBatch(double const* const* columns, size_t columnCount,
+                       double* out, size_t rowCount,
+                       std::uint8_t* errorMask = nullptr) const;
+  /// Returns the instruction set used for the evaluation.
+  InstructionSet instructionSet() const;
+
+private:
+  BytecodeProgram m_program;
+  InstructionSet m_instructionSet;
+  size_t m_requiredColumns = 0;
+};
+
+}
+
+#endif // MATHTREE_BATCHEVALUATOR
\ No newline at end of file
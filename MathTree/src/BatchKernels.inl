@@ -0,0 +1,218 @@
+// Kernels applying a single operation to a chunk of rows.
+// This file is included by BatchEvaluator.cpp once per instruction set, after defining
+// the Ops structure and the MATHTREE_KERNEL attributes for that instruction set.
+
+MATHTREE_KERNEL inline void markLanes(int laneMask, std::uint8_t* errors) {
+  for (size_t lane = 0; lane < Ops::width; ++lane) {
+    errors[lane] |= (laneMask >> lane) & 1;
+  }
+}
+
+MATHTREE_KERNEL void negate(double* values, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(values + i, Ops::negate(Ops::load(values + i)));
+  }
+  for (; i < count; ++i) {
+    values[i] = -values[i];
+  }
+}
+
+MATHTREE_KERNEL void add(double* left, double const* right, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(left + i, Ops::add(Ops::load(left + i), Ops::load(right + i)));
+  }
+  for (; i < count; ++i) {
+    left[i] = left[i] + right[i];
+  }
+}
+
+MATHTREE_KERNEL void subtract(double* left, double const* right, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(left + i, Ops::subtract(Ops::load(left + i), Ops::load(right + i)));
+  }
+  for (; i < count; ++i) {
+    left[i] = left[i] - right[i];
+  }
+}
+
+MATHTREE_KERNEL void multiply(double* left, double const* right, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(left + i, Ops::multiply(Ops::load(left + i), Ops::load(right + i)));
+  }
+  for (; i < count; ++i) {
+    left[i] = left[i] * right[i];
+  }
+}
+
+MATHTREE_KERNEL void checkDivisors(double const* divisors, std::uint8_t* errors, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    markLanes(Ops::zeroLanes(Ops::load(divisors + i)), errors + i);
+  }
+  for (; i < count; ++i) {
+    errors[i] |= !Arithmetic::isValidDivisor(divisors[i]);
+  }
+}
+
+// the quotient overwrites the divisors, which sit below the dividends on the stack
+MATHTREE_KERNEL void divide(double* divisors, double const* dividends, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(divisors + i, Ops::divide(Ops::load(dividends + i), Ops::load(divisors + i)));
+  }
+  for (; i < count; ++i) {
+    divisors[i] = dividends[i] / divisors[i];
+  }
+}
+
+MATHTREE_KERNEL void power(double* bases, double const* exponents, std::uint8_t* errors, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    markLanes(Ops::invalidPowerLanes(Ops::load(bases + i), Ops::load(exponents + i)), errors + i);
+  }
+  for (; i < count; ++i) {
+    errors[i] |= !Arithmetic::isValidPower(bases[i], exponents[i]);
+  }
+  // the power is computed by the C library, so that results match the ones of the tree exactly
+  for (i = 0; i < count; ++i) {
+    bases[i] = std::pow(bases[i], exponents[i]);
+  }
+}
+
+MATHTREE_KERNEL void squareRoot(double* radicands, std::uint8_t* errors, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    auto const radicand = Ops::load(radicands + i);
+    markLanes(Ops::invalidRadicandLanes(radicand), errors + i);
+    Ops::store(radicands + i, Ops::squareRoot(radicand));
+  }
+  for (; i < count; ++i) {
+    errors[i] |= !Arithmetic::isValidRadicand(radicands[i]);
+    radicands[i] = std::sqrt(radicands[i]);
+  }
+}
+
+MATHTREE_KERNEL void logarithm(double* arguments, double log2Base, std::uint8_t* errors, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    markLanes(Ops::nonPositiveLanes(Ops::load(arguments + i)), errors + i);
+  }
+  for (; i < count; ++i) {
+    errors[i] |= !Arithmetic::isValidLogarithmArgument(arguments[i]);
+  }
+  // the binary logarithm is computed by the C library, so that results match the ones of the tree exactly
+  for (i = 0; i < count; ++i) {
+    arguments[i] = std::log2(arguments[i]);
+  }
+  auto const divisor = Ops::broadcast(log2Base);
+  for (i = 0; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(arguments + i, Ops::divide(Ops::load(arguments + i), divisor));
+  }
+  for (; i < count; ++i) {
+    arguments[i] = arguments[i] / log2Base;
+  }
+}
+
+// raises the bases to the reducible exponent given with the operations of ConstantPowerExpression::power, in the same
+// order, so that results match the ones of the tree exactly
+MATHTREE_KERNEL inline Ops::Vector constantPowerOf(Ops::Vector bases, double exponent) {
+  if (exponent == 0.5) {
+    return Ops::add(Ops::squareRoot(bases), Ops::broadcast(0.0));
+  }
+  auto remaining = static_cast<unsigned>(std::abs(exponent));
+  auto factor = bases;
+  auto result = Ops::broadcast(1.0);
+  while (remaining != 0) {
+    if (remaining & 1) {
+      result = Ops::multiply(result, factor);
+    }
+    remaining >>= 1;
+    if (remaining != 0) {
+      factor = Ops::multiply(factor, factor);
+    }
+  }
+  return exponent < 0 ? Ops::divide(Ops::broadcast(1.0), result) : result;
+}
+
+MATHTREE_KERNEL void constantPower(double* bases, double exponent, std::uint8_t* errors, size_t count) {
+  auto const exponents = Ops::broadcast(exponent);
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    auto const base = Ops::load(bases + i);
+    markLanes(Ops::invalidPowerLanes(base, exponents), errors + i);
+    Ops::store(bases + i, constantPowerOf(base, exponent));
+  }
+  for (; i < count; ++i) {
+    errors[i] |= !Arithmetic::isValidPower(bases[i], exponent);
+    bases[i] = ConstantPowerExpression::power(bases[i], exponent);
+  }
+}
+
+MATHTREE_KERNEL void specialisedLogarithm(double* arguments, double base, std::uint8_t* errors, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    markLanes(Ops::nonPositiveLanes(Ops::load(arguments + i)), errors + i);
+  }
+  for (; i < count; ++i) {
+    errors[i] |= !Arithmetic::isValidLogarithmArgument(arguments[i]);
+  }
+  // the logarithms are computed by the C library, as the tree computes them
+  SpecialisedLogarithmExpression::logarithms(arguments, count, base);
+}
+
+// computes (c0 + c1x) + (c2 + c3x)x^2 for the block of four coefficients given, as PolynomialExpression::valueAt does
+MATHTREE_KERNEL inline Ops::Vector blockValueOf(double const* block, Ops::Vector arguments, Ops::Vector squares) {
+  auto const low = Ops::add(Ops::broadcast(block[0]), Ops::multiply(Ops::broadcast(block[1]), arguments));
+  auto const high = Ops::add(Ops::broadcast(block[2]), Ops::multiply(Ops::broadcast(block[3]), arguments));
+  return Ops::add(low, Ops::multiply(high, squares));
+}
+
+// evaluates the polynomial with the scheme and the operations of PolynomialExpression::valueAt, in the same order,
+// so that results match the ones of the tree exactly
+MATHTREE_KERNEL inline Ops::Vector polynomialAt(double const* coefficients, size_t count, Ops::Vector arguments) {
+  if (count - 1 < PolynomialExpression::estrinDegree) {
+    auto result = Ops::broadcast(coefficients[count - 1]);
+    for (size_t i = count - 1; i > 0; --i) {
+      result = Ops::add(Ops::multiply(result, arguments), Ops::broadcast(coefficients[i - 1]));
+    }
+    return result;
+  }
+
+  auto const squares = Ops::multiply(arguments, arguments);
+  auto const fourthPowers = Ops::multiply(squares, squares);
+  auto const lastBlockStart = (count - 1) / 4 * 4;
+  std::array<double, 4> lastBlock{};
+  std::copy(coefficients + lastBlockStart, coefficients + count, lastBlock.begin());
+  auto result = blockValueOf(lastBlock.data(), arguments, squares);
+  for (auto block = coefficients + lastBlockStart; block != coefficients;) {
+    block -= 4;
+    result = Ops::add(Ops::multiply(result, fourthPowers), blockValueOf(block, arguments, squares));
+  }
+  return result;
+}
+
+MATHTREE_KERNEL void polynomial(double* arguments, double const* coefficients, size_t coefficientCount, size_t count) {
+  size_t i = 0;
+  for (; i + Ops::width <= count; i += Ops::width) {
+    Ops::store(arguments + i, polynomialAt(coefficients, coefficientCount, Ops::load(arguments + i)));
+  }
+  for (; i < count; ++i) {
+    arguments[i] = PolynomialExpression::valueAt(coefficients, coefficientCount, arguments[i]);
+  }
+}
+
+// the results overwrite either the multiplicands or the addends, depending on which sits lower on the stack
+MATHTREE_KERNEL void fusedMultiplyAdd(double* results, double const* multiplicands, double const* multipliers,
+                                      double const* addends, size_t count) {
+  // the C library rounds once whatever the processor, so that results match the ones of the tree exactly
+  for (size_t i = 0; i < count; ++i) {
+    results[i] = std::fma(multiplicands[i], multipliers[i], addends[i]);
+  }
+}
+
+Kernels const kernels{negate, add, subtract, multiply, checkDivisors, divide, power, squareRoot, logarithm,
+                      constantPower, specialisedLogarithm, polynomial, fusedMultiplyAdd};
\ No newline at end of file
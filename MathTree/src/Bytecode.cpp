@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <array>
+#include "Arithmetic.hpp"
+#include "Bytecode.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace MathTree {
+
+class BytecodeProgram::Compiler {
+public:
+  Compiler(BytecodeProgram& program): m_program(program) {}
+
+  // compiles the tree without recursion, taking the expressions from an explicit stack whatever the height of the tree
+  void compile(Expression const& expression) {
+    std::vector<Frame> frames{{&expression, 0}};
+    while (!frames.empty()) {
+      auto const frame = frames.back();
+      ++frames.back().step;
+      if (auto const operand = compileStep(*frame.expression, frame.step)) {
+        frames.push_back({operand, 0});
+      } else {
+        frames.pop_back();
+      }
+    }
+  }
+
+private:
+  // an expression being compiled, along with the number of steps already performed
+  struct Frame {
+    Expression const* expression;
+    size_t step;
+  };
+
+  /**
+   * Performs the given step of compiling the expression provided, the instructions of each operand compiled by a
+   * previous step being emitted already. Returns the next operand to compile, or null once the expression is compiled.
+   **/
+  Expression const* compileStep(Expression const& expression, size_t step) {
+    if (dynamic_cast<RealNumberExpression const*>(&expression)) {
+      emit(OpCode::PushConstant, expression.evaluate());
+      return nullptr;
+    } else if (auto variable = dynamic_cast<VariableExpression const*>(&expression)) {
+      if (m_program.m_symbols == nullptr) {
+        m_program.m_symbols = variable->symbols();
+      } else if (m_program.m_symbols != variable->symbols()) {
+        throw std::logic_error("Cannot compile variables belonging to different symbol tables.");
+      }
+      emitVariable(variable->index());
+      return nullptr;
+    } else if (auto memoised = dynamic_cast<MemoisedExpression const*>(&expression)) {
+      // programs keep no result across runs, so the memoised subtree is compiled as it is
+      return step == 0 ? &memoised->subexpression(0) : nullptr;
+    } else if (auto negation = dynamic_cast<NegativeSignExpression const*>(&expression)) {
+      return compileUnaryStep(step, negation->subexpression(0), OpCode::Negate);
+    } else if (auto squareRoot = dynamic_cast<SquareRootExpression const*>(&expression)) {
+      return compileUnaryStep(step, squareRoot->subexpression(0), OpCode::SquareRoot);
+    } else if (auto logarithm = dynamic_cast<LogarithmExpression const*>(&expression)) {
+      return compileUnaryStep(step, logarithm->subexpression(0), OpCode::Logarithm, logarithm->base());
+    } else if (auto power = dynamic_cast<ConstantPowerExpression const*>(&expression)) {
+      return compileUnaryStep(step, power->subexpression(0), OpCode::ConstantPower, power->exponent());
+    } else if (auto specialisedLogarithm = dynamic_cast<SpecialisedLogarithmExpression const*>(&expression)) {
+      return compileUnaryStep(step, specialisedLogarithm->subexpression(0), OpCode::SpecialisedLogarithm,
+                              specialisedLogarithm->base());
+    } else if (auto polynomial = dynamic_cast<PolynomialExpression const*>(&expression)) {
+      if (step == 0) {
+        return &polynomial->subexpression(0);
+      }
+      emitPolynomial(polynomial->coefficients());
+      return nullptr;
+    } else if (auto multiplyAdd = dynamic_cast<FmaExpression const*>(&expression)) {
+      return compileMultiplyAddStep(*multiplyAdd, step);
+    } else if (auto sum = dynamic_cast<SumExpression const*>(&expression)) {
+      return compileSumStep(*sum, step);
+    } else if (auto product = dynamic_cast<ProductExpression const*>(&expression)) {
+      if (step >= 2) {
+        emit(OpCode::Multiply);
+      }
+      return step < product->subexpressionCount() ? &product->subexpression(step) : nullptr;
+    } else if (auto division = dynamic_cast<DivisionExpression const*>(&expression)) {
+      // the tree validates the divisor before evaluating the dividend, so the order of
+      // evaluation is kept in order to report the same error when both are invalid
+      switch (step) {
+      case 0:
+        return &division->right();
+      case 1:
+        emit(OpCode::CheckDivisor);
+        return &division->left();
+      default:
+        emit(OpCode::Divide);
+        return nullptr;
+      }
+    } else if (auto binary = dynamic_cast<BinaryExpression const*>(&expression)) {
+      switch (step) {
+      case 0:
+        return &binary->left();
+      case 1:
+        return &binary->right();
+      default:
+        emit(opCodeFor(*binary));
+        return nullptr;
+      }
+    }
+    throw std::logic_error("Cannot compile an expression of unknown type.");
+  }
+
+  Expression const* compileUnaryStep(size_t step, Expression const& operand, OpCode opCode, double value = 0.0) {
+    if (step == 0) {
+      return &operand;
+    }
+    emit(opCode, value);
+    return nullptr;
+  }
+
+  Expression const* compileSumStep(SumExpression const& sum, size_t step) {
+    // the virtual machine adds terms one at a time, which only matches sequential summation
+    if (sum.mode() != SummationMode::Sequential) {
+      throw std::logic_error("Cannot compile a sum whose terms are not added sequentially.");
+    }
+    if (step == 1 && sum.isSubtracted(0)) {
+      emit(OpCode::Negate);
+    } else if (step >= 2) {
+      emit(sum.isSubtracted(step - 1) ? OpCode::Subtract : OpCode::Add);
+    }
+    return step < sum.subexpressionCount() ? &sum.subexpression(step) : nullptr;
+  }
+
+  Expression const* compileMultiplyAddStep(FmaExpression const& multiplyAdd, size_t step) {
+    using Pattern = FmaExpression::Pattern;
+    auto const pattern = multiplyAdd.pattern();
+    auto const isAddendFirst = FmaExpression::isAddendFirst(pattern);
+    auto const isSeparate = multiplyAdd.rounding() == MultiplyAddRounding::Separate;
+    // the operands are compiled in the order they are evaluated in, so that the same error is reported
+    if (step == 2) {
+      if (isSeparate && !isAddendFirst) {
+        // rounding the product and then the sum is what the multiplication and addition replaced do
+        emit(OpCode::Multiply);
+      } else if (!isSeparate && pattern == Pattern::AddendMinusProduct) {
+        // negating the subtracted operand is exact, so the result is the one of FmaExpression::combine
+        emit(OpCode::Negate);
+      }
+    }
+    if (step < multiplyAdd.subexpressionCount()) {
+      return &multiplyAdd.subexpression(step);
+    }
+
+    if (isSeparate) {
+      if (isAddendFirst) {
+        emit(OpCode::Multiply);
+      }
+      auto const isSubtraction = pattern == Pattern::ProductMinusAddend || pattern == Pattern::AddendMinusProduct;
+      emit(isSubtraction ? OpCode::Subtract : OpCode::Add);
+      return nullptr;
+    }
+    if (pattern == Pattern::ProductMinusAddend) {
+      emit(OpCode::Negate);
+    }
+    emit(isAddendFirst ? OpCode::FusedAddMultiply : OpCode::FusedMultiplyAdd);
+    return nullptr;
+  }
+
+  static OpCode opCodeFor(BinaryExpression const& binary) {
+    if (dynamic_cast<AdditionExpression const*>(&binary)) {
+      return OpCode::Add;
+    } else if (dynamic_cast<SubtractionExpression const*>(&binary)) {
+      return OpCode::Subtract;
+    } else if (dynamic_cast<MultiplicationExpression const*>(&binary)) {
+      return OpCode::Multiply;
+    } else if (dynamic_cast<ExponentiationExpression const*>(&binary)) {
+      return OpCode::Power;
+    }
+    throw std::logic_error("Cannot compile a binary expression of unknown type.");
+  }
+
+  void emitVariable(size_t index) {
+    if (index > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::logic_error("Cannot compile a variable with index " + std::to_string(index) + ".");
+    }
+    emit(OpCode::LoadVariable, 0.0, static_cast<std::uint32_t>(index));
+  }
+
+  void emitPolynomial(PolynomialExpression::Coefficients const& coefficients) {
+    auto& polynomials = m_program.m_polynomials;
+    if (polynomials.size() > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::logic_error("Cannot compile more than " + std::to_string(polynomials.size()) + " polynomials.");
+    }
+    emit(OpCode::Polynomial, 0.0, static_cast<std::uint32_t>(polynomials.size()));
+    polynomials.emplace_back(coefficients.begin(), coefficients.end());
+  }
+
+  void emit(OpCode opCode, double operand = 0.0, std::uint32_t index = 0) {
+    m_program.m_instructions.push_back({opCode, index, operand});
+    switch (opCode) {
+    case OpCode::PushConstant:
+    case OpCode::LoadVariable:
+      ++m_stackDepth;
+      break;
+    case OpCode::Add:
+    case OpCode::Subtract:
+    case OpCode::Multiply:
+    case OpCode::Divide:
+    case OpCode::Power:
+      --m_stackDepth;
+      break;
+    case OpCode::FusedMultiplyAdd:
+    case OpCode::FusedAddMultiply:
+      m_stackDepth -= 2;
+      break;
+    default:
+      break;
+    }
+    m_program.m_maxStackDepth = std::max(m_program.m_maxStackDepth, m_stackDepth);
+  }
+
+  BytecodeProgram& m_program;
+  size_t m_stackDepth = 0;
+};
+
+BytecodeProgram BytecodeProgram::compile(Expression const& expression) {
+  BytecodeProgram program;
+  Compiler(program).compile(expression);
+  return program;
+}
+
+double BytecodeProgram::evaluate() const {
+  // most programs fit in a small stack, which avoids allocating on every evaluation
+  static size_t constexpr inlineStackSize = 64;
+  std::array<double, inlineStackSize> inlineStack;
+  std::vector<double> heapStack;
+  auto stack = inlineStack.data();
+  if (m_maxStackDepth > inlineStackSize) {
+    heapStack.resize(m_maxStackDepth);
+    stack = heapStack.data();
+  }
+
+  // points to the first free slot of the stack
+  auto top = stack;
+  for (auto const& instruction: m_instructions) {
+    switch (instruction.opCode) {
+    case OpCode::PushConstant:
+      *top++ = instruction.operand;
+      break;
+    case OpCode::LoadVariable:
+      *top++ = m_symbols->value(instruction.index);
+      break;
+    case OpCode::Negate:
+      top[-1] = -top[-1];
+      break;
+    case OpCode::Add:
+      --top;
+      top[-1] = top[-1] + top[0];
+      break;
+    case OpCode::Subtract:
+      --top;
+      top[-1] = top[-1] - top[0];
+      break;
+    case OpCode::Multiply:
+      --top;
+      top[-1] = top[-1] * top[0];
+      break;
+    case OpCode::CheckDivisor:
+      Arithmetic::ensureValidDivisor(top[-1]);
+      break;
+    case OpCode::Divide:
+      --top;
+      top[-1] = top[0] / top[-1];
+      break;
+    case OpCode::Power:
+      --top;
+      top[-1] = Arithmetic::power(top[-1], top[0]);
+      break;
+    case OpCode::SquareRoot:
+      top[-1] = Arithmetic::squareRoot(top[-1]);
+      break;
+    case OpCode::Logarithm:
+      top[-1] = Arithmetic::logarithm(top[-1], instruction.operand);
+      break;
+    case OpCode::ConstantPower:
+      if (!Arithmetic::isValidPower(top[-1], instruction.operand)) {
+        Arithmetic::throwInvalidPower(top[-1], instruction.operand);
+      }
+      top[-1] = ConstantPowerExpression::power(top[-1], instruction.operand);
+      break;
+    case OpCode::SpecialisedLogarithm:
+      if (!Arithmetic::isValidLogarithmArgument(top[-1])) {
+        Arithmetic::throwInvalidLogarithm(top[-1]);
+      }
+      top[-1] = SpecialisedLogarithmExpression::logarithm(top[-1], instruction.operand);
+      break;
+    case OpCode::Polynomial: {
+      auto const& coefficients = m_polynomials[instruction.index];
+      top[-1] = PolynomialExpression::valueAt(coefficients.data(), coefficients.size(), top[-1]);
+      break;
+    }
+    case OpCode::FusedMultiplyAdd:
+      top -= 2;
+      top[-1] = std::fma(top[-1], top[0], top[1]);
+      break;
+    case OpCode::FusedAddMultiply:
+      top -= 2;
+      top[-1] = std::fma(top[0], top[1], top[-1]);
+      break;
+    }
+  }
+  return stack[0];
+}
+
+std::vector<BytecodeProgram::Instruction> const& BytecodeProgram::instructions() const {
+  return m_instructions;
+}
+
+std::vector<std::vector<double>> const& BytecodeProgram::polynomials() const {
+  return m_polynomials;
+}
+
+size_t BytecodeProgram::maxStackDepth() const {
+  return m_maxStackDepth;
+}
+
+std::shared_ptr<SymbolTable const> const& BytecodeProgram::symbols() const {
+  return m_symbols;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef MATHTREE_BYTECODE
+#define MATHTREE_BYTECODE
+
+#include <cstdint>
+#include "Expression.hpp"
+#include <memory>
+#include "SymbolTable.hpp"
+#include <vector>
+
+namespace MathTree {
+
+/**
+ * Represents an expression tree lowered into a flat sequence of instructions,
+ * which are executed by a stack-based virtual machine.
+ * Evaluating a program gives the same results and throws the same errors as
+ * evaluating the tree it was compiled from.
+ **/
+class BytecodeProgram {
+public:
+  /// Represents the operations the virtual machine can execute.
+  enum class OpCode: std::uint8_t {
+    /// Pushes the operand of the instruction on the stack.
+    PushConstant,
+    /// Pushes the value of the variable whose index is stored in the instruction.
+    LoadVariable,
+    /// Replaces the top of the stack with its negation.
+    Negate,
+    /// Pops the right and then the left term, and pushes their sum.
+    Add,
+    /// Pops the right and then the left term, and pushes their difference.
+    Subtract,
+    /// Pops the right and then the left factor, and pushes their product.
+    Multiply,
+    /// Throws if the top of the stack is zero. Does not modify the stack.
+    CheckDivisor,
+    /// Pops the dividend and then the divisor, and pushes their quotient.
+    Divide,
+    /// Pops the exponent and then the base, and pushes the resulting power.
+    Power,
+    /// Replaces the top of the stack with its square root.
+    SquareRoot,
+    /// Replaces the top of the stack with its logarithm, using the operand of the instruction as base.
+    Logarithm,
+    /// Raises the top of the stack to the operand of the instruction, as per ConstantPowerExpression.
+    ConstantPower,
+    /**
+     * Replaces the top of the stack with its logarithm, using the operand of the instruction as base,
+     * computed as per SpecialisedLogarithmExpression.
+     **/
+    SpecialisedLogarithm,
+    /**
+     * Replaces the top of the stack with the value at it of the polynomial whose index in polynomials()
+     * is stored in the instruction, computed as per PolynomialExpression.
+     **/
+    Polynomial,
+    /// Pops the addend, the multiplier and then the multiplicand, and pushes the product plus the addend rounded once.
+    FusedMultiplyAdd,
+    /// Pops the multiplier, the multiplicand and then the addend, and pushes the addend plus the product rounded once.
+    FusedAddMultiply
+  };
+
+  /// Represents a single operation along with its operand or the index of its variable or polynomial, if it has any.
+  struct Instruction {
+    OpCode opCode;
+    std::uint32_t index;
+    double operand;
+  };
+
+  /**
+   * Returns the program obtained by compiling the given expression tree.
+   * Throws if the tree contains expressions that cannot be compiled, or
+   * variables that belong to different symbol tables.
+   **/
+  static BytecodeProgram compile(Expression const& expression);
+
+  /**
+   * Returns the real valued number obtained by executing the program.
+   * Variables are read from the symbol table of the tree the program was compiled from.
+   * Throws the same errors as the expression tree the program was compiled from.
+   **/
+  double evaluate() const;
+  /// Returns the instructions of the program, in execution order.
+  std::vector<Instruction> const& instructions() const;
+  /// Returns the coefficients of the polynomials the program evaluates, each starting from the constant one.
+  std::vector<std::vector<double>> const& polynomials() const;
+  /// Returns the maximum number of values the program keeps on the stack while executing.
+  size_t maxStackDepth() const;
+  /// Returns the symbol table the variables of the program are read from, or null if there are no variables.
+  std::shared_ptr<SymbolTable const> const& symbols() const;
+
+private:
+  class Compiler;
+  BytecodeProgram() = default;
+
+  std::vector<Instruction> m_instructions;
+  std::vector<std::vector<double>> m_polynomials;
+  size_t m_maxStackDepth = 0;
+  std::shared_ptr<SymbolTable const> m_symbols;
+};
+
+}
+
+#endif // MATHTREE_BYTECODE
\ No newline at end of file
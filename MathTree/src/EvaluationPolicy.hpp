@@ -0,0 +1,71 @@
+#ifndef MATHTREE_EVALUATIONPOLICY
+#define MATHTREE_EVALUATIONPOLICY
+
+#include <cmath>
+#include <limits>
+#include "SymbolTable.hpp"
+
+namespace MathTree {
+
+/**
+ * The policies selecting at compile time how Expression::evaluateWith handles the operations without a real result,
+ * such as divisions by zero or square roots of negative numbers. Each policy is compiled into its own evaluation
+ * routines, so that none of them tests a flag at runtime.
+ **/
+namespace EvaluationPolicy {
+
+/// Validates every operation and throws on those without a real result, as Expression::evaluate() does.
+struct Checked {};
+
+/// The arithmetic of IEEE 754, which computes every operation without branching on the validity of its operands.
+struct IeeeArithmetic {
+  static double power(double base, double exponent) {
+    return std::pow(base, exponent);
+  }
+  static double squareRoot(double radicand) {
+    return std::sqrt(radicand);
+  }
+  static double logarithm(double argument, double base) {
+    return std::log2(argument) / std::log2(base);
+  }
+};
+
+/**
+ * Computes every operation with IEEE 754 arithmetic and reports no error: operations without a real result give
+ * NaN or an infinity, which propagates to the result of the tree. For instance, 1/0 gives infinity, sqrt(-1) gives
+ * NaN and 0^0 gives 1, as std::pow does. Unbound variables evaluate to NaN. Cached results are read but never
+ * stored, as the results computed may not be real.
+ **/
+struct Propagating: IeeeArithmetic {
+  /// Returns false, as any result may stand for an error.
+  static bool keepsResult(double) {
+    return false;
+  }
+  static double variable(SymbolTable const& symbols, size_t index) {
+    return symbols.valueOr(index, std::numeric_limits<double>::quiet_NaN());
+  }
+};
+
+/**
+ * Computes every operation with IEEE 754 arithmetic, for trees known to have a real result and bound variables,
+ * which gives the same results as Checked without validating anything. Unlike Propagating, variables are read
+ * without checking that they are bound. The results of trees without a real result are unspecified, and evaluating
+ * a tree with an unbound variable is undefined behaviour. Only finite results are cached, so that the NaN and
+ * infinities given by operations without a real result are never kept, but a finite result of such a tree, like the
+ * 1 given by 0^0, may be.
+ **/
+struct Unchecked: IeeeArithmetic {
+  /// Returns true if the result given is finite, false otherwise.
+  static bool keepsResult(double result) {
+    return std::isfinite(result);
+  }
+  static double variable(SymbolTable const& symbols, size_t index) {
+    return symbols.boundValue(index);
+  }
+};
+
+}
+
+}
+
+#endif // MATHTREE_EVALUATIONPOLICY
\ No newline at end of file
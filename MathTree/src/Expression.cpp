@@ -1,10 +1,17 @@
 #include <algorithm>
+#include "Arithmetic.hpp"
+#include <array>
 #include <cctype>
 #include <charconv>
 #include <cmath>
+#include <cstddef>
 #include "Expression.hpp"
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include "TokenMatchers.hpp"
@@ -12,11 +19,175 @@
 #include <vector>
 
 namespace MathTree {
+
+namespace {
+
+[[noreturn]] void throwMissingSubexpression(size_t index, size_t count) {
+  throw std::out_of_range("Cannot access subexpression " + std::to_string(index) + " of an expression with " +
+                          std::to_string(count) + ".");
+}
+
+// throws if there is no subexpression at the given position of an expression which has the given number of them
+void ensureSubexpressionIndex(size_t index, size_t count) {
+  if (index >= count) {
+    throwMissingSubexpression(index, count);
+  }
+}
+
+// prints Euler's number by its symbol, so that the logarithm printed is parsed back in the same base
+void printLogarithmBase(std::ostream& stream, double base) {
+  if (base == std::exp(1.0)) {
+    stream << LogarithmMatcher::naturalBaseSymbol;
+  } else {
+    stream << base;
+  }
+}
+
+}
+
 std::ostream& operator<<(std::ostream& left, Expression const& right) {
   right.print(left);
   return left;
 }
 
+size_t Expression::height() const {
+  return 1;
+}
+
+size_t Expression::subexpressionCount() const {
+  return subexpressions().size();
+}
+
+Expression const& Expression::subexpression(size_t index) const {
+  auto const all = subexpressions();
+  ensureSubexpressionIndex(index, all.size());
+  return *all[index];
+}
+
+bool Expression::isConstant() const {
+  auto const count = subexpressionCount();
+  for (size_t i = 0; i < count; ++i) {
+    if (!subexpression(i).isConstant()) {
+      return false;
+    }
+  }
+  return count > 0;
+}
+
+void Expression::transformSubexpressions(Transformation const&) {}
+
+EvaluationResult Expression::tryEvaluate() const {
+  return evaluate();
+}
+
+double Expression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluate();
+}
+
+double Expression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluate();
+}
+
+void EvaluationResult::throwError() const {
+  switch (m_error) {
+  case EvaluationError::DivisionByZero:
+    Arithmetic::throwDivisionByZero();
+  case EvaluationError::InvalidPower:
+    Arithmetic::throwInvalidPower(m_value, m_secondOperand);
+  case EvaluationError::InvalidSquareRoot:
+    Arithmetic::throwInvalidSquareRoot(m_value);
+  case EvaluationError::InvalidLogarithm:
+    Arithmetic::throwInvalidLogarithm(m_value);
+  case EvaluationError::UnboundVariable:
+    if (auto variable = dynamic_cast<VariableExpression const*>(m_failedExpression)) {
+      // reading the variable throws, unless it was bound in the meantime
+      variable->symbols()->value(variable->index());
+    }
+    break;
+  }
+  throw std::logic_error("The error of the evaluation could not be reported.");
+}
+
+Expression const* Expression::evaluateStep(size_t, std::vector<double>& stack) const {
+  stack.push_back(evaluate());
+  return nullptr;
+}
+
+Expression const* Expression::tryEvaluateStep(size_t, std::vector<double>& stack, EvaluationResult& error) const {
+  auto const result = tryEvaluate();
+  if (!result) {
+    error = result;
+  } else {
+    stack.push_back(result.value());
+  }
+  return nullptr;
+}
+
+Expression const* Expression::evaluateStep(size_t, std::vector<double>& stack,
+                                           EvaluationPolicy::Propagating policy) const {
+  stack.push_back(evaluate(policy));
+  return nullptr;
+}
+
+Expression const* Expression::evaluateStep(size_t, std::vector<double>& stack,
+                                           EvaluationPolicy::Unchecked policy) const {
+  stack.push_back(evaluate(policy));
+  return nullptr;
+}
+
+void Expression::releaseSubexpressions(ExpressionList&) {}
+
+void Expression::destroySubexpressions() {
+  // the expressions pending destruction of most trees fit in a buffer on the stack, so destroying them does not allocate
+  static size_t constexpr inlineCapacity = 32;
+  std::array<std::byte, inlineCapacity * sizeof(std::unique_ptr<Expression>)> buffer;
+  std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+  ExpressionList pending(&resource);
+  pending.reserve(inlineCapacity);
+
+  releaseSubexpressions(pending);
+  while (!pending.empty()) {
+    auto expression = std::move(pending.back());
+    pending.pop_back();
+    // shallow expressions are deleted by recursing, the others are left without subexpressions first
+    if (expression->height() > maxRecursionHeight) {
+      expression->releaseSubexpressions(pending);
+    }
+  }
+}
+
+namespace {
+
+// Every expression is preceded by a header recording where its memory came from,
+// so that deleting it through a std::unique_ptr returns the memory to the right resource.
+// The size of the memory is not recorded, as the virtual destructor passes it to operator delete.
+using AllocationHeader = std::pmr::memory_resource*;
+auto constexpr headerSize = alignof(Expression);
+static_assert(sizeof(AllocationHeader) <= headerSize, "The allocation header must not overlap the expression.");
+
+AllocationHeader& headerOf(void* memory) {
+  return *reinterpret_cast<AllocationHeader*>(static_cast<std::byte*>(memory) - headerSize);
+}
+}
+
+void* Expression::operator new(size_t size) {
+  return operator new(size, *std::pmr::get_default_resource());
+}
+
+void* Expression::operator new(size_t size, std::pmr::memory_resource& resource) {
+  auto memory = static_cast<std::byte*>(resource.allocate(headerSize + size, alignof(Expression)));
+  new (memory) AllocationHeader(&resource);
+  return memory + headerSize;
+}
+
+void Expression::operator delete(void* memory, size_t size) {
+  if (memory == nullptr) {
+    return;
+  }
+  auto const resource = headerOf(memory);
+  resource->deallocate(static_cast<std::byte*>(memory) - headerSize, headerSize + size, alignof(Expression));
+}
+
 BinaryExpression::BinaryExpression(std::unique_ptr<Expression> left,
                                    TokenType tokenType,
                                    std::unique_ptr<Expression> right):
@@ -24,6 +195,14 @@ BinaryExpression::BinaryExpression(std::unique_ptr<Expression> left,
   if (m_left == nullptr || m_right == nullptr) {
     throw std::logic_error("A binary expression cannot be constructed if one or more of its subexpressions are null.");
   }
+  m_isConstant = m_left->isConstant() && m_right->isConstant();
+  m_height = std::max(m_left->height(), m_right->height()) + 1;
+}
+
+BinaryExpression::~BinaryExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
 }
 
 void BinaryExpression::print(std::ostream& stream) const {
@@ -43,9 +222,110 @@ std::vector<Expression const*> BinaryExpression::subexpressions() const {
   return {m_left.get(), m_right.get()};
 }
 
+size_t BinaryExpression::subexpressionCount() const {
+  return 2;
+}
+
+Expression const& BinaryExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 2);
+  return index == 0 ? *m_left : *m_right;
+}
+
+bool BinaryExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t BinaryExpression::height() const {
+  return m_height;
+}
+
+void BinaryExpression::transformSubexpressions(Transformation const& transformation) {
+  m_left = transformation(std::move(m_left));
+  m_right = transformation(std::move(m_right));
+  if (m_left == nullptr || m_right == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_left->isConstant() && m_right->isConstant();
+  m_height = std::max(m_left->height(), m_right->height()) + 1;
+}
+
+void BinaryExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_left != nullptr) {
+    released.push_back(std::move(m_left));
+  }
+  if (m_right != nullptr) {
+    released.push_back(std::move(m_right));
+  }
+  m_height = 1;
+}
+
+template<typename Operation>
+EvaluationResult BinaryExpression::tryEvaluateLeftToRight(Operation operation) const {
+  auto const leftResult = m_left->tryEvaluate();
+  if (!leftResult) {
+    return leftResult;
+  }
+  auto const rightResult = m_right->tryEvaluate();
+  if (!rightResult) {
+    return rightResult;
+  }
+  return operation(leftResult.value(), rightResult.value());
+}
+
+template<typename Policy, typename Operation>
+double BinaryExpression::evaluateLeftToRight(Operation operation) const {
+  auto const left = m_left->evaluateWith<Policy>();
+  return operation(left, m_right->evaluateWith<Policy>());
+}
+
+template<typename Operation>
+Expression const* BinaryExpression::evaluateStepLeftToRight(size_t step, std::vector<double>& stack,
+                                                            Operation operation) const {
+  switch (step) {
+  case 0:
+    return m_left.get();
+  case 1:
+    return m_right.get();
+  default:
+    auto const rightResult = stack.back();
+    stack.pop_back();
+    stack.back() = operation(stack.back(), rightResult);
+    return nullptr;
+  }
+}
+
+template<typename Operation>
+Expression const* BinaryExpression::tryEvaluateStepLeftToRight(size_t step, std::vector<double>& stack,
+                                                               EvaluationResult& error, Operation operation) const {
+  switch (step) {
+  case 0:
+    return m_left.get();
+  case 1:
+    return m_right.get();
+  default:
+    auto const rightResult = stack.back();
+    stack.pop_back();
+    auto const result = operation(stack.back(), rightResult);
+    if (!result) {
+      error = result;
+    } else {
+      stack.back() = result.value();
+    }
+    return nullptr;
+  }
+}
+
 NegativeSignExpression::NegativeSignExpression(TokenType operatorToken, std::unique_ptr<Expression> right) {
   m_operator = operatorToken;
   m_right = std::move(right);
+  m_isConstant = m_right != nullptr && m_right->isConstant();
+  m_height = m_right != nullptr ? m_right->height() + 1 : 1;
+}
+
+NegativeSignExpression::~NegativeSignExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
 }
 
 void NegativeSignExpression::print(std::ostream& stream) const {
@@ -54,18 +334,92 @@ void NegativeSignExpression::print(std::ostream& stream) const {
 }
 
 double NegativeSignExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
+  return -m_right->evaluate();
+}
+
+EvaluationResult NegativeSignExpression::tryEvaluate() const {
+  auto const operand = m_right->tryEvaluate();
+  if (!operand) {
+    return operand;
+  }
+  return -operand.value();
+}
+
+template<typename Policy>
+double NegativeSignExpression::evaluateAs() const {
+  return -m_right->evaluateWith<Policy>();
+}
+
+double NegativeSignExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double NegativeSignExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* NegativeSignExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_right.get();
   }
 
-  m_cache = -(m_right->evaluate());
-  return *m_cache;
+  stack.back() = -stack.back();
+  return nullptr;
+}
+
+Expression const* NegativeSignExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                          EvaluationResult&) const {
+  // negating cannot fail
+  return evaluateStep(step, stack);
+}
+
+Expression const* NegativeSignExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                      EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* NegativeSignExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                      EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
 }
 
 std::vector<Expression const*> NegativeSignExpression::subexpressions() const {
   return {m_right.get()};
 }
 
+size_t NegativeSignExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& NegativeSignExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_right;
+}
+
+bool NegativeSignExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t NegativeSignExpression::height() const {
+  return m_height;
+}
+
+void NegativeSignExpression::transformSubexpressions(Transformation const& transformation) {
+  m_right = transformation(std::move(m_right));
+  if (m_right == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_right->isConstant();
+  m_height = m_right->height() + 1;
+}
+
+void NegativeSignExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_right != nullptr) {
+    released.push_back(std::move(m_right));
+  }
+  m_height = 1;
+}
+
 RealNumberExpression::RealNumberExpression(std::string_view num) {
   auto numberOpt = Utils::parseDouble(num);
   if (!numberOpt.has_value() || std::isinf(*numberOpt) || std::isnan(*numberOpt)) {
@@ -78,6 +432,24 @@ std::vector<Expression const*> RealNumberExpression::subexpressions() const {
   return {};
 }
 
+size_t RealNumberExpression::subexpressionCount() const {
+  return 0;
+}
+
+Expression const& RealNumberExpression::subexpression(size_t index) const {
+  throwMissingSubexpression(index, 0);
+}
+
+bool RealNumberExpression::isConstant() const {
+  return true;
+}
+
+RealNumberExpression::RealNumberExpression(double value): m_value(value) {
+  if (std::isinf(m_value) || std::isnan(m_value)) {
+    throw std::logic_error("A real number cannot be infinite or NaN.");
+  }
+}
+
 void RealNumberExpression::print(std::ostream& stream) const {
   stream << m_value;
 }
@@ -86,130 +458,1836 @@ double RealNumberExpression::evaluate() const {
   return m_value;
 }
 
-double AdditionExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
+VariableExpression::VariableExpression(std::shared_ptr<SymbolTable const> symbols, size_t index):
+                                          m_symbols(std::move(symbols)), m_index(index) {
+  if (m_symbols == nullptr || m_index >= m_symbols->size()) {
+    throw std::logic_error("A variable cannot be constructed without being declared in a symbol table.");
   }
+}
 
-  m_cache = left().evaluate() + right().evaluate();
-  return *m_cache;
+double VariableExpression::evaluate() const {
+  return m_symbols->value(m_index);
 }
 
-double SubtractionExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
+EvaluationResult VariableExpression::tryEvaluate() const {
+  if (!m_symbols->isBound(m_index)) {
+    return {EvaluationError::UnboundVariable, *this};
   }
+  return m_symbols->value(m_index);
+}
+
+double VariableExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return EvaluationPolicy::Propagating::variable(*m_symbols, m_index);
+}
+
+double VariableExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return EvaluationPolicy::Unchecked::variable(*m_symbols, m_index);
+}
+
+void VariableExpression::print(std::ostream& stream) const {
+  stream << m_symbols->name(m_index);
+}
+
+std::vector<Expression const*> VariableExpression::subexpressions() const {
+  return {};
+}
+
+size_t VariableExpression::subexpressionCount() const {
+  return 0;
+}
+
+Expression const& VariableExpression::subexpression(size_t index) const {
+  throwMissingSubexpression(index, 0);
+}
+
+bool VariableExpression::isConstant() const {
+  return false;
+}
+
+std::shared_ptr<SymbolTable const> const& VariableExpression::symbols() const {
+  return m_symbols;
+}
+
+size_t VariableExpression::index() const {
+  return m_index;
+}
+
+double AdditionExpression::evaluate() const {
+  return evaluateLeftToRight<EvaluationPolicy::Checked>(std::plus<>());
+}
+
+EvaluationResult AdditionExpression::tryEvaluate() const {
+  return tryEvaluateLeftToRight([](double left, double right) -> EvaluationResult {
+    return left + right;
+  });
+}
 
-  m_cache = left().evaluate() - right().evaluate();
-  return *m_cache;
+double AdditionExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateLeftToRight<EvaluationPolicy::Propagating>(std::plus<>());
+}
+
+double AdditionExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateLeftToRight<EvaluationPolicy::Unchecked>(std::plus<>());
+}
+
+Expression const* AdditionExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  return evaluateStepLeftToRight(step, stack, std::plus<>());
+}
+
+Expression const* AdditionExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  return evaluateStepLeftToRight(step, stack, std::plus<>());
+}
+
+Expression const* AdditionExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                  EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* AdditionExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                  EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
+}
+
+double SubtractionExpression::evaluate() const {
+  return evaluateLeftToRight<EvaluationPolicy::Checked>(std::minus<>());
+}
+
+EvaluationResult SubtractionExpression::tryEvaluate() const {
+  return tryEvaluateLeftToRight([](double left, double right) -> EvaluationResult {
+    return left - right;
+  });
+}
+
+double SubtractionExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateLeftToRight<EvaluationPolicy::Propagating>(std::minus<>());
+}
+
+double SubtractionExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateLeftToRight<EvaluationPolicy::Unchecked>(std::minus<>());
+}
+
+Expression const* SubtractionExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  return evaluateStepLeftToRight(step, stack, std::minus<>());
+}
+
+Expression const* SubtractionExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  return evaluateStepLeftToRight(step, stack, std::minus<>());
+}
+
+Expression const* SubtractionExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                     EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* SubtractionExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                     EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
 }
 
 double MultiplicationExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
-  }
+  return evaluateLeftToRight<EvaluationPolicy::Checked>(std::multiplies<>());
+}
+
+EvaluationResult MultiplicationExpression::tryEvaluate() const {
+  return tryEvaluateLeftToRight([](double left, double right) -> EvaluationResult {
+    return left * right;
+  });
+}
+
+double MultiplicationExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateLeftToRight<EvaluationPolicy::Propagating>(std::multiplies<>());
+}
+
+double MultiplicationExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateLeftToRight<EvaluationPolicy::Unchecked>(std::multiplies<>());
+}
+
+Expression const* MultiplicationExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  return evaluateStepLeftToRight(step, stack, std::multiplies<>());
+}
+
+Expression const* MultiplicationExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  return evaluateStepLeftToRight(step, stack, std::multiplies<>());
+}
+
+Expression const* MultiplicationExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                        EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
 
-  m_cache = left().evaluate() * right().evaluate();
-  return *m_cache;
+Expression const* MultiplicationExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                        EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
 }
 
 double DivisionExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
-  }
+  // the divisor is validated before the dividend is evaluated
+  auto const divisor = right().evaluate();
+  Arithmetic::ensureValidDivisor(divisor);
+  return left().evaluate() / divisor;
+}
 
-  auto divisor = right().evaluate();
-  if (divisor == 0.0) {
-    throw std::domain_error("Detected a divide-by-zero operation.");
+EvaluationResult DivisionExpression::tryEvaluate() const {
+  // the divisor is validated before the dividend is evaluated
+  auto const divisor = right().tryEvaluate();
+  if (!divisor) {
+    return divisor;
+  } else if (!Arithmetic::isValidDivisor(divisor.value())) {
+    return {EvaluationError::DivisionByZero, *this};
+  }
+  auto const dividend = left().tryEvaluate();
+  if (!dividend) {
+    return dividend;
   }
-  m_cache = left().evaluate() / divisor;
-  return *m_cache;
+  return dividend.value() / divisor.value();
 }
 
-double ExponentiationExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
+template<typename Policy>
+double DivisionExpression::evaluateAs() const {
+  // the divisor is evaluated first, as in evaluate()
+  auto const divisor = right().evaluateWith<Policy>();
+  return left().evaluateWith<Policy>() / divisor;
+}
+
+double DivisionExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double DivisionExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* DivisionExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  switch (step) {
+  case 0:
+    // as in evaluate(), the divisor is validated before the dividend is evaluated
+    return &right();
+  case 1:
+    Arithmetic::ensureValidDivisor(stack.back());
+    return &left();
+  default:
+    auto const dividend = stack.back();
+    stack.pop_back();
+    stack.back() = dividend / stack.back();
+    return nullptr;
   }
+}
 
-  auto leftEval = left().evaluate();
-  auto rightEval = right().evaluate();
-  if ((leftEval == 0.0 && rightEval <= 0.0) ||
-      (leftEval < 0.0 && std::floor(rightEval) != std::ceil(rightEval))) {
-    // 0^0 is not defined for real numbers
-    // 0^a with a < 0 implies 1/0, which is not a real number
-    // a^b with a < 0 is only a real number when b is an integer
-    throw std::domain_error("Cannot compute " + std::to_string(leftEval) +
-                           " to the power of " + std::to_string(rightEval) + ".");
+Expression const* DivisionExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                      EvaluationResult& error) const {
+  if (step == 1 && !Arithmetic::isValidDivisor(stack.back())) {
+    error = {EvaluationError::DivisionByZero, *this};
+    return nullptr;
   }
-  m_cache = std::pow(leftEval, rightEval);
-  return *m_cache;
+  return evaluateStep(step, stack);
 }
 
-SquareRootExpression::SquareRootExpression(std::unique_ptr<Expression> innerExpression, 
-                                          TokenType tokenType):
-                                            m_innerExpression(std::move(innerExpression)),
-                                            m_tokenType(tokenType) {}
+template<typename Policy>
+Expression const* DivisionExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  // the divisor is still evaluated first, but not validated
+  return step == 1 ? &left() : evaluateStep(step, stack);
+}
 
-double SquareRootExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
-  }
+Expression const* DivisionExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                  EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* DivisionExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                  EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+double ExponentiationExpression::evaluate() const {
+  return evaluateLeftToRight<EvaluationPolicy::Checked>([](double base, double exponent) {
+    return Arithmetic::power(base, exponent);
+  });
+}
 
-  auto innerResult = m_innerExpression->evaluate();
-  if (innerResult < 0 || std::isinf(innerResult) || std::isnan(innerResult)) {
-    throw std::domain_error("Cannot compute the square root of " + std::to_string(innerResult) + ".");
+EvaluationResult ExponentiationExpression::tryEvaluate() const {
+  return tryEvaluateLeftToRight([this](double base, double exponent) {
+    return tryPower(base, exponent);
+  });
+}
+
+EvaluationResult ExponentiationExpression::tryPower(double base, double exponent) const {
+  if (!Arithmetic::isValidPower(base, exponent)) {
+    return {EvaluationError::InvalidPower, *this, base, exponent};
   }
-  m_cache = std::sqrt(innerResult);
-  return *m_cache;
+  return std::pow(base, exponent);
 }
 
-void SquareRootExpression::print(std::ostream& stream) const {
-  stream << symboliseTokenType(m_tokenType) << "(";
-  stream << *m_innerExpression << ")";
+double ExponentiationExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateLeftToRight<EvaluationPolicy::Propagating>(EvaluationPolicy::Propagating::power);
 }
 
-std::vector<Expression const*> SquareRootExpression::subexpressions() const {
-  return {m_innerExpression.get()};
+double ExponentiationExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateLeftToRight<EvaluationPolicy::Unchecked>(EvaluationPolicy::Unchecked::power);
 }
 
-LogarithmExpression::LogarithmExpression(std::unique_ptr<Expression> innerExpression,
-                                         double base,
-                                         TokenType tokenType):
+Expression const* ExponentiationExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  return evaluateStepLeftToRight(step, stack, [](double base, double exponent) {
+    return Arithmetic::power(base, exponent);
+  });
+}
+
+Expression const* ExponentiationExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                            EvaluationResult& error) const {
+  return tryEvaluateStepLeftToRight(step, stack, error, [this](double base, double exponent) {
+    return tryPower(base, exponent);
+  });
+}
+
+template<typename Policy>
+Expression const* ExponentiationExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  return evaluateStepLeftToRight(step, stack, Policy::power);
+}
+
+Expression const* ExponentiationExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                        EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* ExponentiationExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                        EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+SquareRootExpression::SquareRootExpression(std::unique_ptr<Expression> innerExpression, 
+                                          TokenType tokenType):
                                             m_innerExpression(std::move(innerExpression)),
-                                            m_base(base),
                                             m_tokenType(tokenType) {
-  if (m_innerExpression == nullptr) {
-    throw std::logic_error("Cannot instantiate a LogarithmExpression with an empty inner expression.");
-  }
+  m_isConstant = m_innerExpression != nullptr && m_innerExpression->isConstant();
+  m_height = m_innerExpression != nullptr ? m_innerExpression->height() + 1 : 1;
+}
 
-  if (std::isnan(base) || std::isinf(base) || base <= 0) {
-    throw std::domain_error("Cannot have a logarithm with base " + std::to_string(base) +
-                            ". The base must be a finite, positive number.");
+SquareRootExpression::~SquareRootExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
   }
 }
 
-double LogarithmExpression::evaluate() const {
-  if (m_cache.has_value()) {
-    return *m_cache;
+double SquareRootExpression::evaluate() const {
+  return Arithmetic::squareRoot(m_innerExpression->evaluate());
+}
+
+EvaluationResult SquareRootExpression::tryEvaluate() const {
+  auto const radicand = m_innerExpression->tryEvaluate();
+  if (!radicand) {
+    return radicand;
   }
+  return trySquareRoot(radicand.value());
+}
 
-  auto inner = m_innerExpression->evaluate();
-  if (inner <= 0) {
-    throw std::domain_error("Cannot compute the logarithm of " + std::to_string(inner) +
-                            ". The argument must be a positive number.");
+EvaluationResult SquareRootExpression::trySquareRoot(double radicand) const {
+  if (!Arithmetic::isValidRadicand(radicand)) {
+    return {EvaluationError::InvalidSquareRoot, *this, radicand};
   }
-  m_cache = std::log2(inner) / std::log2(m_base);
-  return *m_cache;
+  return std::sqrt(radicand);
 }
 
-void LogarithmExpression::print(std::ostream& stream) const {
-  stream << symboliseTokenType(m_tokenType);
-  stream << delimeterFor(TokenType::Log) << m_base << "(";
+template<typename Policy>
+double SquareRootExpression::evaluateAs() const {
+  return Policy::squareRoot(m_innerExpression->evaluateWith<Policy>());
+}
+
+double SquareRootExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double SquareRootExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* SquareRootExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  stack.back() = Arithmetic::squareRoot(stack.back());
+  return nullptr;
+}
+
+Expression const* SquareRootExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                        EvaluationResult& error) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  auto const result = trySquareRoot(stack.back());
+  if (!result) {
+    error = result;
+  } else {
+    stack.back() = result.value();
+  }
+  return nullptr;
+}
+
+template<typename Policy>
+Expression const* SquareRootExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  stack.back() = Policy::squareRoot(stack.back());
+  return nullptr;
+}
+
+Expression const* SquareRootExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                    EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* SquareRootExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                    EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+void SquareRootExpression::print(std::ostream& stream) const {
+  stream << symboliseTokenType(m_tokenType) << "(";
   stream << *m_innerExpression << ")";
 }
 
+std::vector<Expression const*> SquareRootExpression::subexpressions() const {
+  return {m_innerExpression.get()};
+}
+
+size_t SquareRootExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& SquareRootExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_innerExpression;
+}
+
+bool SquareRootExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t SquareRootExpression::height() const {
+  return m_height;
+}
+
+void SquareRootExpression::transformSubexpressions(Transformation const& transformation) {
+  m_innerExpression = transformation(std::move(m_innerExpression));
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+void SquareRootExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_innerExpression != nullptr) {
+    released.push_back(std::move(m_innerExpression));
+  }
+  m_height = 1;
+}
+
+LogarithmExpression::LogarithmExpression(std::unique_ptr<Expression> innerExpression,
+                                         double base,
+                                         TokenType tokenType):
+                                            m_innerExpression(std::move(innerExpression)),
+                                            m_base(base),
+                                            m_tokenType(tokenType) {
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("Cannot instantiate a LogarithmExpression with an empty inner expression.");
+  }
+
+  Arithmetic::ensureValidLogarithmBase(base);
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+LogarithmExpression::~LogarithmExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double LogarithmExpression::evaluate() const {
+  return Arithmetic::logarithm(m_innerExpression->evaluate(), m_base);
+}
+
+EvaluationResult LogarithmExpression::tryEvaluate() const {
+  auto const argument = m_innerExpression->tryEvaluate();
+  if (!argument) {
+    return argument;
+  }
+  return tryLogarithm(argument.value());
+}
+
+EvaluationResult LogarithmExpression::tryLogarithm(double argument) const {
+  if (!Arithmetic::isValidLogarithmArgument(argument)) {
+    return {EvaluationError::InvalidLogarithm, *this, argument};
+  }
+  return Arithmetic::logarithm(argument, m_base);
+}
+
+template<typename Policy>
+double LogarithmExpression::evaluateAs() const {
+  return Policy::logarithm(m_innerExpression->evaluateWith<Policy>(), m_base);
+}
+
+double LogarithmExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double LogarithmExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* LogarithmExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  stack.back() = Arithmetic::logarithm(stack.back(), m_base);
+  return nullptr;
+}
+
+Expression const* LogarithmExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                       EvaluationResult& error) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  auto const result = tryLogarithm(stack.back());
+  if (!result) {
+    error = result;
+  } else {
+    stack.back() = result.value();
+  }
+  return nullptr;
+}
+
+template<typename Policy>
+Expression const* LogarithmExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  stack.back() = Policy::logarithm(stack.back(), m_base);
+  return nullptr;
+}
+
+Expression const* LogarithmExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                   EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* LogarithmExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                   EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+double LogarithmExpression::base() const {
+  return m_base;
+}
+
+TokenType LogarithmExpression::tokenType() const {
+  return m_tokenType;
+}
+
+void LogarithmExpression::print(std::ostream& stream) const {
+  stream << symboliseTokenType(m_tokenType) << delimeterFor(TokenType::Log);
+  printLogarithmBase(stream, m_base);
+  stream << "(" << *m_innerExpression << ")";
+}
+
 std::vector<Expression const*> LogarithmExpression::subexpressions() const {
   return {m_innerExpression.get()};
 }
 
+size_t LogarithmExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& LogarithmExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_innerExpression;
+}
+
+bool LogarithmExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t LogarithmExpression::height() const {
+  return m_height;
+}
+
+void LogarithmExpression::transformSubexpressions(Transformation const& transformation) {
+  m_innerExpression = transformation(std::move(m_innerExpression));
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+void LogarithmExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_innerExpression != nullptr) {
+    released.push_back(std::move(m_innerExpression));
+  }
+  m_height = 1;
+}
+
+bool ConstantPowerExpression::isReducible(double exponent) {
+  return exponent == 0.5 ||
+         (std::abs(exponent) <= maxIntegerExponent && std::floor(exponent) == exponent);
+}
+
+ConstantPowerExpression::ConstantPowerExpression(std::unique_ptr<Expression> innerExpression, double exponent):
+                                                   m_innerExpression(std::move(innerExpression)),
+                                                   m_exponent(exponent) {
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("Cannot instantiate a ConstantPowerExpression with an empty inner expression.");
+  } else if (!isReducible(exponent)) {
+    throw std::logic_error("Cannot instantiate a ConstantPowerExpression with exponent " + std::to_string(exponent) + ".");
+  }
+
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+ConstantPowerExpression::~ConstantPowerExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double ConstantPowerExpression::power(double base, double exponent) {
+  if (exponent == 0.5) {
+    // adding zero turns the square root of -0 into +0, as given by std::pow
+    return std::sqrt(base) + 0.0;
+  }
+
+  // exponentiation by squaring, where the factor holds base^(2^i) on the i-th iteration
+  auto remaining = static_cast<unsigned>(std::abs(exponent));
+  auto factor = base;
+  auto result = 1.0;
+  while (remaining != 0) {
+    if (remaining & 1) {
+      result *= factor;
+    }
+    remaining >>= 1;
+    if (remaining != 0) {
+      factor *= factor;
+    }
+  }
+  return exponent < 0 ? 1.0 / result : result;
+}
+
+double ConstantPowerExpression::evaluate() const {
+  auto const base = m_innerExpression->evaluate();
+  if (!Arithmetic::isValidPower(base, m_exponent)) {
+    Arithmetic::throwInvalidPower(base, m_exponent);
+  }
+  return power(base, m_exponent);
+}
+
+EvaluationResult ConstantPowerExpression::tryEvaluate() const {
+  auto const base = m_innerExpression->tryEvaluate();
+  if (!base) {
+    return base;
+  }
+  return tryPower(base.value());
+}
+
+EvaluationResult ConstantPowerExpression::tryPower(double base) const {
+  if (!Arithmetic::isValidPower(base, m_exponent)) {
+    return {EvaluationError::InvalidPower, *this, base, m_exponent};
+  }
+  return power(base, m_exponent);
+}
+
+template<typename Policy>
+double ConstantPowerExpression::evaluateAs() const {
+  return power(m_innerExpression->evaluateWith<Policy>(), m_exponent);
+}
+
+double ConstantPowerExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double ConstantPowerExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* ConstantPowerExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  if (!Arithmetic::isValidPower(stack.back(), m_exponent)) {
+    Arithmetic::throwInvalidPower(stack.back(), m_exponent);
+  }
+  stack.back() = power(stack.back(), m_exponent);
+  return nullptr;
+}
+
+Expression const* ConstantPowerExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                           EvaluationResult& error) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  auto const result = tryPower(stack.back());
+  if (!result) {
+    error = result;
+  } else {
+    stack.back() = result.value();
+  }
+  return nullptr;
+}
+
+template<typename Policy>
+Expression const* ConstantPowerExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  stack.back() = power(stack.back(), m_exponent);
+  return nullptr;
+}
+
+Expression const* ConstantPowerExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                       EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* ConstantPowerExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                       EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+double ConstantPowerExpression::exponent() const {
+  return m_exponent;
+}
+
+void ConstantPowerExpression::print(std::ostream& stream) const {
+  stream << '(' << *m_innerExpression << ' ';
+  stream << symboliseTokenType(TokenType::Caret) << ' ';
+  stream << m_exponent << ')';
+}
+
+std::vector<Expression const*> ConstantPowerExpression::subexpressions() const {
+  return {m_innerExpression.get()};
+}
+
+size_t ConstantPowerExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& ConstantPowerExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_innerExpression;
+}
+
+bool ConstantPowerExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t ConstantPowerExpression::height() const {
+  return m_height;
+}
+
+void ConstantPowerExpression::transformSubexpressions(Transformation const& transformation) {
+  m_innerExpression = transformation(std::move(m_innerExpression));
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+void ConstantPowerExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_innerExpression != nullptr) {
+    released.push_back(std::move(m_innerExpression));
+  }
+  m_height = 1;
+}
+
+SpecialisedLogarithmExpression::SpecialisedLogarithmExpression(std::unique_ptr<Expression> innerExpression,
+                                                               double base,
+                                                               TokenType tokenType):
+                                                                 m_innerExpression(std::move(innerExpression)),
+                                                                 m_base(base),
+                                                                 m_tokenType(tokenType) {
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("Cannot instantiate a SpecialisedLogarithmExpression with an empty inner expression.");
+  }
+
+  Arithmetic::ensureValidLogarithmBase(base);
+  m_form = formOf(base);
+  if (m_form == Form::Scaled) {
+    m_scale = 1.0 / std::log2(base);
+  }
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+SpecialisedLogarithmExpression::~SpecialisedLogarithmExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+SpecialisedLogarithmExpression::Form SpecialisedLogarithmExpression::formOf(double base) {
+  if (base == 2.0) {
+    return Form::Binary;
+  } else if (base == 10.0) {
+    return Form::Decimal;
+  } else if (base == std::exp(1.0)) {
+    return Form::Natural;
+  }
+  return Form::Scaled;
+}
+
+double SpecialisedLogarithmExpression::logarithm(double argument, Form form, double scale) {
+  switch (form) {
+  case Form::Binary:
+    return std::log2(argument);
+  case Form::Decimal:
+    return std::log10(argument);
+  case Form::Natural:
+    return std::log(argument);
+  default:
+    return std::log2(argument) * scale;
+  }
+}
+
+double SpecialisedLogarithmExpression::logarithm(double argument, double base) {
+  auto const form = formOf(base);
+  return logarithm(argument, form, form == Form::Scaled ? 1.0 / std::log2(base) : 0.0);
+}
+
+void SpecialisedLogarithmExpression::logarithms(double* arguments, size_t count, double base) {
+  auto const form = formOf(base);
+  auto const scale = form == Form::Scaled ? 1.0 / std::log2(base) : 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    arguments[i] = logarithm(arguments[i], form, scale);
+  }
+}
+
+double SpecialisedLogarithmExpression::logarithm(double argument) const {
+  return logarithm(argument, m_form, m_scale);
+}
+
+double SpecialisedLogarithmExpression::evaluate() const {
+  auto const argument = m_innerExpression->evaluate();
+  if (!Arithmetic::isValidLogarithmArgument(argument)) {
+    Arithmetic::throwInvalidLogarithm(argument);
+  }
+  return logarithm(argument);
+}
+
+EvaluationResult SpecialisedLogarithmExpression::tryEvaluate() const {
+  auto const argument = m_innerExpression->tryEvaluate();
+  if (!argument) {
+    return argument;
+  }
+  return tryLogarithm(argument.value());
+}
+
+EvaluationResult SpecialisedLogarithmExpression::tryLogarithm(double argument) const {
+  if (!Arithmetic::isValidLogarithmArgument(argument)) {
+    return {EvaluationError::InvalidLogarithm, *this, argument};
+  }
+  return logarithm(argument);
+}
+
+template<typename Policy>
+double SpecialisedLogarithmExpression::evaluateAs() const {
+  return logarithm(m_innerExpression->evaluateWith<Policy>());
+}
+
+double SpecialisedLogarithmExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double SpecialisedLogarithmExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* SpecialisedLogarithmExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  if (!Arithmetic::isValidLogarithmArgument(stack.back())) {
+    Arithmetic::throwInvalidLogarithm(stack.back());
+  }
+  stack.back() = logarithm(stack.back());
+  return nullptr;
+}
+
+Expression const* SpecialisedLogarithmExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                                  EvaluationResult& error) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  auto const result = tryLogarithm(stack.back());
+  if (!result) {
+    error = result;
+  } else {
+    stack.back() = result.value();
+  }
+  return nullptr;
+}
+
+template<typename Policy>
+Expression const* SpecialisedLogarithmExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_innerExpression.get();
+  }
+
+  stack.back() = logarithm(stack.back());
+  return nullptr;
+}
+
+Expression const* SpecialisedLogarithmExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                              EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* SpecialisedLogarithmExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                              EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+double SpecialisedLogarithmExpression::base() const {
+  return m_base;
+}
+
+void SpecialisedLogarithmExpression::print(std::ostream& stream) const {
+  stream << symboliseTokenType(m_tokenType) << delimeterFor(TokenType::Log);
+  printLogarithmBase(stream, m_base);
+  stream << "(" << *m_innerExpression << ")";
+}
+
+std::vector<Expression const*> SpecialisedLogarithmExpression::subexpressions() const {
+  return {m_innerExpression.get()};
+}
+
+size_t SpecialisedLogarithmExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& SpecialisedLogarithmExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_innerExpression;
+}
+
+bool SpecialisedLogarithmExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t SpecialisedLogarithmExpression::height() const {
+  return m_height;
+}
+
+void SpecialisedLogarithmExpression::transformSubexpressions(Transformation const& transformation) {
+  m_innerExpression = transformation(std::move(m_innerExpression));
+  if (m_innerExpression == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_innerExpression->isConstant();
+  m_height = m_innerExpression->height() + 1;
+}
+
+void SpecialisedLogarithmExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_innerExpression != nullptr) {
+    released.push_back(std::move(m_innerExpression));
+  }
+  m_height = 1;
+}
+
+namespace {
+/**
+ * Holds the results of the subexpressions of an n-ary expression while they are combined. Most
+ * expressions have few enough subexpressions for their results to fit inline, which avoids allocating.
+ **/
+class ResultBuffer {
+public:
+  ResultBuffer(size_t size) {
+    if (size > m_inlineResults.size()) {
+      m_heapResults.resize(size);
+      m_results = m_heapResults.data();
+    }
+  }
+  double* data() {
+    return m_results;
+  }
+
+private:
+  std::array<double, 64> m_inlineResults;
+  std::vector<double> m_heapResults;
+  double* m_results = m_inlineResults.data();
+};
+}
+
+SumExpression::SumExpression(TermList terms, SummationMode mode): m_terms(std::move(terms)), m_mode(mode) {
+  if (m_terms.size() < 2) {
+    throw std::logic_error("A sum cannot be constructed with fewer than two terms.");
+  }
+  m_isConstant = true;
+  for (auto const& term: m_terms) {
+    if (term.expression == nullptr) {
+      throw std::logic_error("A sum cannot be constructed if one or more of its terms are null.");
+    }
+    m_isConstant = m_isConstant && term.expression->isConstant();
+    m_height = std::max(m_height, term.expression->height() + 1);
+  }
+}
+
+SumExpression::~SumExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double SumExpression::evaluate() const {
+  return evaluateAs<EvaluationPolicy::Checked>();
+}
+
+EvaluationResult SumExpression::tryEvaluate() const {
+  double result = 0.0;
+  if (m_mode == SummationMode::Sequential) {
+    // the terms are added as soon as they are evaluated, which needs no buffer
+    for (size_t i = 0; i < m_terms.size(); ++i) {
+      auto const term = m_terms[i].expression->tryEvaluate();
+      if (!term) {
+        return term;
+      }
+      auto const signedTerm = m_terms[i].isSubtracted ? -term.value() : term.value();
+      result = i == 0 ? signedTerm : result + signedTerm;
+    }
+  } else {
+    ResultBuffer results(m_terms.size());
+    for (size_t i = 0; i < m_terms.size(); ++i) {
+      auto const term = m_terms[i].expression->tryEvaluate();
+      if (!term) {
+        return term;
+      }
+      results.data()[i] = m_terms[i].isSubtracted ? -term.value() : term.value();
+    }
+    result = sumOf(results.data());
+  }
+  return result;
+}
+
+template<typename Policy>
+double SumExpression::evaluateAs() const {
+  double result = 0.0;
+  if (m_mode == SummationMode::Sequential) {
+    for (size_t i = 0; i < m_terms.size(); ++i) {
+      auto const term = m_terms[i].expression->evaluateWith<Policy>();
+      auto const signedTerm = m_terms[i].isSubtracted ? -term : term;
+      result = i == 0 ? signedTerm : result + signedTerm;
+    }
+  } else {
+    ResultBuffer results(m_terms.size());
+    for (size_t i = 0; i < m_terms.size(); ++i) {
+      auto const term = m_terms[i].expression->evaluateWith<Policy>();
+      results.data()[i] = m_terms[i].isSubtracted ? -term : term;
+    }
+    result = sumOf(results.data());
+  }
+  return result;
+}
+
+double SumExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double SumExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+double SumExpression::sumOf(double const* results) const {
+  switch (m_mode) {
+  case SummationMode::Pairwise:
+    return Arithmetic::pairwiseSum(results, m_terms.size());
+  case SummationMode::Kahan:
+    return Arithmetic::compensatedSum(results, m_terms.size());
+  default:
+    auto sum = results[0];
+    for (size_t i = 1; i < m_terms.size(); ++i) {
+      sum += results[i];
+    }
+    return sum;
+  }
+}
+
+void SumExpression::print(std::ostream& stream) const {
+  stream << '(';
+  for (size_t i = 0; i < m_terms.size(); ++i) {
+    auto const symbol = symboliseTokenType(m_terms[i].isSubtracted ? TokenType::Minus : TokenType::Plus);
+    if (i > 0) {
+      stream << ' ' << symbol << ' ';
+    } else if (m_terms[i].isSubtracted) {
+      stream << symbol;
+    }
+    stream << *m_terms[i].expression;
+  }
+  stream << ')';
+}
+
+std::vector<Expression const*> SumExpression::subexpressions() const {
+  std::vector<Expression const*> terms;
+  terms.reserve(m_terms.size());
+  for (auto const& term: m_terms) {
+    terms.push_back(term.expression.get());
+  }
+  return terms;
+}
+
+size_t SumExpression::subexpressionCount() const {
+  return m_terms.size();
+}
+
+Expression const& SumExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, m_terms.size());
+  return *m_terms[index].expression;
+}
+
+bool SumExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t SumExpression::height() const {
+  return m_height;
+}
+
+void SumExpression::transformSubexpressions(Transformation const& transformation) {
+  m_isConstant = true;
+  m_height = 1;
+  for (auto& term: m_terms) {
+    term.expression = transformation(std::move(term.expression));
+    if (term.expression == nullptr) {
+      throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+    }
+    m_isConstant = m_isConstant && term.expression->isConstant();
+    m_height = std::max(m_height, term.expression->height() + 1);
+  }
+}
+
+Expression const* SumExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step < m_terms.size()) {
+    return m_terms[step].expression.get();
+  }
+
+  // the results of all the terms are on top of the stack, in order
+  auto const results = stack.data() + stack.size() - m_terms.size();
+  for (size_t i = 0; i < m_terms.size(); ++i) {
+    if (m_terms[i].isSubtracted) {
+      results[i] = -results[i];
+    }
+  }
+  auto const result = sumOf(results);
+  stack.resize(stack.size() - m_terms.size() + 1);
+  stack.back() = result;
+  return nullptr;
+}
+
+Expression const* SumExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  // combining the results of the operands cannot fail
+  return evaluateStep(step, stack);
+}
+
+Expression const* SumExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                             EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* SumExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                             EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
+}
+
+void SumExpression::releaseSubexpressions(ExpressionList& released) {
+  for (auto& term: m_terms) {
+    if (term.expression != nullptr) {
+      released.push_back(std::move(term.expression));
+    }
+  }
+  m_height = 1;
+}
+
+bool SumExpression::isSubtracted(size_t index) const {
+  return m_terms.at(index).isSubtracted;
+}
+
+SummationMode SumExpression::mode() const {
+  return m_mode;
+}
+
+ProductExpression::ProductExpression(ExpressionList factors): m_factors(std::move(factors)) {
+  if (m_factors.size() < 2) {
+    throw std::logic_error("A product cannot be constructed with fewer than two factors.");
+  }
+  m_isConstant = true;
+  for (auto const& factor: m_factors) {
+    if (factor == nullptr) {
+      throw std::logic_error("A product cannot be constructed if one or more of its factors are null.");
+    }
+    m_isConstant = m_isConstant && factor->isConstant();
+    m_height = std::max(m_height, factor->height() + 1);
+  }
+}
+
+ProductExpression::~ProductExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double ProductExpression::evaluate() const {
+  return evaluateAs<EvaluationPolicy::Checked>();
+}
+
+EvaluationResult ProductExpression::tryEvaluate() const {
+  double result = 1.0;
+  for (size_t i = 0; i < m_factors.size(); ++i) {
+    auto const factor = m_factors[i]->tryEvaluate();
+    if (!factor) {
+      return factor;
+    }
+    result = i == 0 ? factor.value() : result * factor.value();
+  }
+  return result;
+}
+
+template<typename Policy>
+double ProductExpression::evaluateAs() const {
+  auto result = m_factors.front()->evaluateWith<Policy>();
+  for (size_t i = 1; i < m_factors.size(); ++i) {
+    result *= m_factors[i]->evaluateWith<Policy>();
+  }
+  return result;
+}
+
+double ProductExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double ProductExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+void ProductExpression::print(std::ostream& stream) const {
+  stream << '(' << *m_factors.front();
+  for (size_t i = 1; i < m_factors.size(); ++i) {
+    stream << ' ' << symboliseTokenType(TokenType::Asterisk) << ' ' << *m_factors[i];
+  }
+  stream << ')';
+}
+
+std::vector<Expression const*> ProductExpression::subexpressions() const {
+  std::vector<Expression const*> factors;
+  factors.reserve(m_factors.size());
+  for (auto const& factor: m_factors) {
+    factors.push_back(factor.get());
+  }
+  return factors;
+}
+
+size_t ProductExpression::subexpressionCount() const {
+  return m_factors.size();
+}
+
+Expression const& ProductExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, m_factors.size());
+  return *m_factors[index];
+}
+
+bool ProductExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t ProductExpression::height() const {
+  return m_height;
+}
+
+void ProductExpression::transformSubexpressions(Transformation const& transformation) {
+  m_isConstant = true;
+  m_height = 1;
+  for (auto& factor: m_factors) {
+    factor = transformation(std::move(factor));
+    if (factor == nullptr) {
+      throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+    }
+    m_isConstant = m_isConstant && factor->isConstant();
+    m_height = std::max(m_height, factor->height() + 1);
+  }
+}
+
+Expression const* ProductExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step < m_factors.size()) {
+    return m_factors[step].get();
+  }
+
+  // the results of all the factors are on top of the stack, in order
+  auto const results = stack.data() + stack.size() - m_factors.size();
+  auto result = results[0];
+  for (size_t i = 1; i < m_factors.size(); ++i) {
+    result = result * results[i];
+  }
+  stack.resize(stack.size() - m_factors.size() + 1);
+  stack.back() = result;
+  return nullptr;
+}
+
+Expression const* ProductExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  // combining the results of the operands cannot fail
+  return evaluateStep(step, stack);
+}
+
+Expression const* ProductExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                 EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* ProductExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                 EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
+}
+
+void ProductExpression::releaseSubexpressions(ExpressionList& released) {
+  for (auto& factor: m_factors) {
+    if (factor != nullptr) {
+      released.push_back(std::move(factor));
+    }
+  }
+  m_height = 1;
+}
+
+PolynomialExpression::PolynomialExpression(std::unique_ptr<Expression> argument, Coefficients coefficients):
+                                             m_argument(std::move(argument)),
+                                             m_coefficients(std::move(coefficients)) {
+  if (m_argument == nullptr) {
+    throw std::logic_error("Cannot instantiate a PolynomialExpression with an empty argument.");
+  } else if (m_coefficients.empty() || m_coefficients.size() > maxDegree + 1) {
+    throw std::logic_error("Cannot instantiate a PolynomialExpression with " + std::to_string(m_coefficients.size()) +
+                           " coefficients.");
+  }
+
+  m_isConstant = m_argument->isConstant();
+  m_height = m_argument->height() + 1;
+}
+
+PolynomialExpression::~PolynomialExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double PolynomialExpression::valueAt(double const* coefficients, size_t count, double argument) {
+  if (count - 1 < estrinDegree) {
+    // Horner's scheme: c0 + x(c1 + x(c2 + ...))
+    auto result = coefficients[count - 1];
+    for (size_t i = count - 1; i > 0; --i) {
+      result = result * argument + coefficients[i - 1];
+    }
+    return result;
+  }
+
+  // Estrin's scheme on each block of four coefficients, (c0 + c1x) + (c2 + c3x)x^2, the blocks being
+  // combined from the last one with Horner's scheme in x^4. The last block is padded with zeros.
+  auto const square = argument * argument;
+  auto const fourthPower = square * square;
+  auto const blockValue = [argument, square](double const* block) {
+    return (block[0] + block[1] * argument) + (block[2] + block[3] * argument) * square;
+  };
+  auto const lastBlockStart = (count - 1) / 4 * 4;
+  std::array<double, 4> lastBlock{};
+  std::copy(coefficients + lastBlockStart, coefficients + count, lastBlock.begin());
+  auto result = blockValue(lastBlock.data());
+  for (auto block = coefficients + lastBlockStart; block != coefficients;) {
+    block -= 4;
+    result = result * fourthPower + blockValue(block);
+  }
+  return result;
+}
+
+double PolynomialExpression::valueAt(double argument) const {
+  return valueAt(m_coefficients.data(), m_coefficients.size(), argument);
+}
+
+double PolynomialExpression::evaluate() const {
+  return evaluateAs<EvaluationPolicy::Checked>();
+}
+
+EvaluationResult PolynomialExpression::tryEvaluate() const {
+  auto const argument = m_argument->tryEvaluate();
+  if (!argument) {
+    return argument;
+  }
+  return valueAt(argument.value());
+}
+
+template<typename Policy>
+double PolynomialExpression::evaluateAs() const {
+  return valueAt(m_argument->evaluateWith<Policy>());
+}
+
+double PolynomialExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double PolynomialExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* PolynomialExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return m_argument.get();
+  }
+
+  stack.back() = valueAt(stack.back());
+  return nullptr;
+}
+
+Expression const* PolynomialExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  // combining the results of the operands cannot fail
+  return evaluateStep(step, stack);
+}
+
+Expression const* PolynomialExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                    EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* PolynomialExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                    EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
+}
+
+PolynomialExpression::Coefficients const& PolynomialExpression::coefficients() const {
+  return m_coefficients;
+}
+
+size_t PolynomialExpression::degree() const {
+  return m_coefficients.size() - 1;
+}
+
+void PolynomialExpression::print(std::ostream& stream) const {
+  stream << '(';
+  auto isFirst = true;
+  for (auto i = m_coefficients.size(); i-- > 0;) {
+    auto const coefficient = m_coefficients[i];
+    if (coefficient == 0.0 && (i != 0 || !isFirst)) {
+      continue;
+    }
+    if (isFirst) {
+      stream << coefficient;
+    } else {
+      auto const sign = coefficient < 0 ? TokenType::Minus : TokenType::Plus;
+      stream << ' ' << symboliseTokenType(sign) << ' ' << std::abs(coefficient);
+    }
+    isFirst = false;
+    if (i > 0) {
+      stream << ' ' << symboliseTokenType(TokenType::Asterisk) << ' ' << *m_argument;
+    }
+    if (i > 1) {
+      stream << ' ' << symboliseTokenType(TokenType::Caret) << ' ' << i;
+    }
+  }
+  stream << ')';
+}
+
+std::vector<Expression const*> PolynomialExpression::subexpressions() const {
+  return {m_argument.get()};
+}
+
+size_t PolynomialExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& PolynomialExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_argument;
+}
+
+bool PolynomialExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t PolynomialExpression::height() const {
+  return m_height;
+}
+
+void PolynomialExpression::transformSubexpressions(Transformation const& transformation) {
+  m_argument = transformation(std::move(m_argument));
+  if (m_argument == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  m_isConstant = m_argument->isConstant();
+  m_height = m_argument->height() + 1;
+}
+
+void PolynomialExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_argument != nullptr) {
+    released.push_back(std::move(m_argument));
+  }
+  m_height = 1;
+}
+
+FmaExpression::FmaExpression(std::unique_ptr<Expression> multiplicand, std::unique_ptr<Expression> multiplier,
+                             std::unique_ptr<Expression> addend, Pattern pattern, MultiplyAddRounding rounding):
+                               m_multiplicand(std::move(multiplicand)),
+                               m_multiplier(std::move(multiplier)),
+                               m_addend(std::move(addend)),
+                               m_pattern(pattern),
+                               m_rounding(rounding) {
+  if (m_multiplicand == nullptr || m_multiplier == nullptr || m_addend == nullptr) {
+    throw std::logic_error("Cannot instantiate an FmaExpression with an empty operand.");
+  }
+  updateOperandProperties();
+}
+
+FmaExpression::~FmaExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double FmaExpression::combine(double multiplicand, double multiplier, double addend,
+                              Pattern pattern, MultiplyAddRounding rounding) {
+  auto const isProductSubtracted = pattern == Pattern::AddendMinusProduct;
+  auto const isAddendSubtracted = pattern == Pattern::ProductMinusAddend;
+  if (rounding == MultiplyAddRounding::Fused) {
+    return std::fma(isProductSubtracted ? -multiplicand : multiplicand, multiplier,
+                    isAddendSubtracted ? -addend : addend);
+  }
+
+  // the operations of the original expression, in the same order, so that the results are bit-identical
+  auto const product = multiplicand * multiplier;
+  switch (pattern) {
+  case Pattern::ProductPlusAddend:
+    return product + addend;
+  case Pattern::AddendPlusProduct:
+    return addend + product;
+  case Pattern::ProductMinusAddend:
+    return product - addend;
+  default:
+    return addend - product;
+  }
+}
+
+double FmaExpression::combine(double multiplicand, double multiplier, double addend) const {
+  return combine(multiplicand, multiplier, addend, m_pattern, m_rounding);
+}
+
+bool FmaExpression::isAddendFirst(Pattern pattern) {
+  return pattern == Pattern::AddendPlusProduct || pattern == Pattern::AddendMinusProduct;
+}
+
+bool FmaExpression::isAddendFirst() const {
+  return isAddendFirst(m_pattern);
+}
+
+double FmaExpression::evaluate() const {
+  return evaluateAs<EvaluationPolicy::Checked>();
+}
+
+EvaluationResult FmaExpression::tryEvaluate() const {
+  // the operands are evaluated in the order of the original expression, so that the same error is reported
+  auto const operands = isAddendFirst() ?
+    std::array<Expression const*, 3>{m_addend.get(), m_multiplicand.get(), m_multiplier.get()} :
+    std::array<Expression const*, 3>{m_multiplicand.get(), m_multiplier.get(), m_addend.get()};
+  std::array<double, 3> results;
+  for (size_t i = 0; i < operands.size(); ++i) {
+    auto const result = operands[i]->tryEvaluate();
+    if (!result) {
+      return result;
+    }
+    results[i] = result.value();
+  }
+  return isAddendFirst() ? combine(results[1], results[2], results[0]) :
+                           combine(results[0], results[1], results[2]);
+}
+
+template<typename Policy>
+double FmaExpression::evaluateAs() const {
+  // the operands are evaluated in the same order as in evaluate()
+  if (isAddendFirst()) {
+    auto const addend = m_addend->evaluateWith<Policy>();
+    auto const multiplicand = m_multiplicand->evaluateWith<Policy>();
+    return combine(multiplicand, m_multiplier->evaluateWith<Policy>(), addend);
+  }
+  auto const multiplicand = m_multiplicand->evaluateWith<Policy>();
+  auto const multiplier = m_multiplier->evaluateWith<Policy>();
+  return combine(multiplicand, multiplier, m_addend->evaluateWith<Policy>());
+}
+
+double FmaExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double FmaExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* FmaExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  switch (step) {
+  case 0:
+    return isAddendFirst() ? m_addend.get() : m_multiplicand.get();
+  case 1:
+    return isAddendFirst() ? m_multiplicand.get() : m_multiplier.get();
+  case 2:
+    return isAddendFirst() ? m_multiplier.get() : m_addend.get();
+  default:
+    auto const third = stack.back();
+    stack.pop_back();
+    auto const second = stack.back();
+    stack.pop_back();
+    stack.back() = isAddendFirst() ? combine(second, third, stack.back()) : combine(stack.back(), second, third);
+    return nullptr;
+  }
+}
+
+Expression const* FmaExpression::tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult&) const {
+  // combining the results of the operands cannot fail
+  return evaluateStep(step, stack);
+}
+
+Expression const* FmaExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                             EvaluationPolicy::Propagating) const {
+  return evaluateStep(step, stack);
+}
+
+Expression const* FmaExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                             EvaluationPolicy::Unchecked) const {
+  return evaluateStep(step, stack);
+}
+
+FmaExpression::Pattern FmaExpression::pattern() const {
+  return m_pattern;
+}
+
+MultiplyAddRounding FmaExpression::rounding() const {
+  return m_rounding;
+}
+
+void FmaExpression::print(std::ostream& stream) const {
+  auto const isSubtraction = m_pattern == Pattern::ProductMinusAddend || m_pattern == Pattern::AddendMinusProduct;
+  auto const operation = symboliseTokenType(isSubtraction ? TokenType::Minus : TokenType::Plus);
+  if (isAddendFirst()) {
+    stream << '(' << *m_addend << ' ' << operation << ' ';
+  } else {
+    stream << '(';
+  }
+  stream << '(' << *m_multiplicand << ' ' << symboliseTokenType(TokenType::Asterisk) << ' ' << *m_multiplier << ')';
+  if (!isAddendFirst()) {
+    stream << ' ' << operation << ' ' << *m_addend;
+  }
+  stream << ')';
+}
+
+std::vector<Expression const*> FmaExpression::subexpressions() const {
+  if (isAddendFirst()) {
+    return {m_addend.get(), m_multiplicand.get(), m_multiplier.get()};
+  }
+  return {m_multiplicand.get(), m_multiplier.get(), m_addend.get()};
+}
+
+size_t FmaExpression::subexpressionCount() const {
+  return 3;
+}
+
+Expression const& FmaExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 3);
+  // the operands are ordered as they are evaluated, as in subexpressions()
+  if (isAddendFirst()) {
+    return index == 0 ? *m_addend : index == 1 ? *m_multiplicand : *m_multiplier;
+  }
+  return index == 0 ? *m_multiplicand : index == 1 ? *m_multiplier : *m_addend;
+}
+
+bool FmaExpression::isConstant() const {
+  return m_isConstant;
+}
+
+size_t FmaExpression::height() const {
+  return m_height;
+}
+
+void FmaExpression::transformSubexpressions(Transformation const& transformation) {
+  auto const transform = [&transformation](std::unique_ptr<Expression>& operand) {
+    operand = transformation(std::move(operand));
+    if (operand == nullptr) {
+      throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+    }
+  };
+  if (isAddendFirst()) {
+    transform(m_addend);
+  }
+  transform(m_multiplicand);
+  transform(m_multiplier);
+  if (!isAddendFirst()) {
+    transform(m_addend);
+  }
+  updateOperandProperties();
+}
+
+void FmaExpression::releaseSubexpressions(ExpressionList& released) {
+  for (auto operand: {&m_multiplicand, &m_multiplier, &m_addend}) {
+    if (*operand != nullptr) {
+      released.push_back(std::move(*operand));
+    }
+  }
+  m_height = 1;
+}
+
+void FmaExpression::updateOperandProperties() {
+  m_isConstant = m_multiplicand->isConstant() && m_multiplier->isConstant() && m_addend->isConstant();
+  m_height = std::max({m_multiplicand->height(), m_multiplier->height(), m_addend->height()}) + 1;
+}
+
+MemoisedExpression::MemoisedExpression(std::unique_ptr<Expression> memoised): m_memoised(std::move(memoised)) {
+  if (m_memoised == nullptr || !m_memoised->isConstant()) {
+    throw std::logic_error("Only a constant expression can be memoised.");
+  }
+  m_height = m_memoised->height() + 1;
+}
+
+MemoisedExpression::~MemoisedExpression() {
+  if (m_height > maxRecursionHeight) {
+    destroySubexpressions();
+  }
+}
+
+double MemoisedExpression::evaluate() const {
+  if (auto cached = m_cache.load()) {
+    return *cached;
+  }
+
+  auto const result = m_memoised->evaluate();
+  m_cache.store(result);
+  return result;
+}
+
+EvaluationResult MemoisedExpression::tryEvaluate() const {
+  if (auto cached = m_cache.load()) {
+    return *cached;
+  }
+
+  auto const result = m_memoised->tryEvaluate();
+  if (result) {
+    m_cache.store(result.value());
+  }
+  return result;
+}
+
+template<typename Policy>
+double MemoisedExpression::evaluateAs() const {
+  if (auto cached = m_cache.load()) {
+    return *cached;
+  }
+
+  auto const result = m_memoised->evaluateWith<Policy>();
+  // policies letting results without a real value through must not keep them
+  if (Policy::keepsResult(result)) {
+    m_cache.store(result);
+  }
+  return result;
+}
+
+double MemoisedExpression::evaluate(EvaluationPolicy::Propagating) const {
+  return evaluateAs<EvaluationPolicy::Propagating>();
+}
+
+double MemoisedExpression::evaluate(EvaluationPolicy::Unchecked) const {
+  return evaluateAs<EvaluationPolicy::Unchecked>();
+}
+
+Expression const* MemoisedExpression::evaluateStep(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    if (auto cached = m_cache.load()) {
+      stack.push_back(*cached);
+      return nullptr;
+    }
+    return m_memoised.get();
+  }
+
+  m_cache.store(stack.back());
+  return nullptr;
+}
+
+Expression const* MemoisedExpression::tryEvaluateStep(size_t step, std::vector<double>& stack,
+                                                      EvaluationResult&) const {
+  // the evaluation stops at the first error, so only results with a real value reach the last step and are kept
+  return evaluateStep(step, stack);
+}
+
+template<typename Policy>
+Expression const* MemoisedExpression::evaluateStepAs(size_t step, std::vector<double>& stack) const {
+  if (step == 0) {
+    return evaluateStep(step, stack);
+  }
+
+  if (Policy::keepsResult(stack.back())) {
+    m_cache.store(stack.back());
+  }
+  return nullptr;
+}
+
+Expression const* MemoisedExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                  EvaluationPolicy::Propagating) const {
+  return evaluateStepAs<EvaluationPolicy::Propagating>(step, stack);
+}
+
+Expression const* MemoisedExpression::evaluateStep(size_t step, std::vector<double>& stack,
+                                                  EvaluationPolicy::Unchecked) const {
+  return evaluateStepAs<EvaluationPolicy::Unchecked>(step, stack);
+}
+
+void MemoisedExpression::print(std::ostream& stream) const {
+  stream << *m_memoised;
+}
+
+std::vector<Expression const*> MemoisedExpression::subexpressions() const {
+  return {m_memoised.get()};
+}
+
+size_t MemoisedExpression::subexpressionCount() const {
+  return 1;
+}
+
+Expression const& MemoisedExpression::subexpression(size_t index) const {
+  ensureSubexpressionIndex(index, 1);
+  return *m_memoised;
+}
+
+bool MemoisedExpression::isConstant() const {
+  return true;
+}
+
+size_t MemoisedExpression::height() const {
+  return m_height;
+}
+
+void MemoisedExpression::transformSubexpressions(Transformation const& transformation) {
+  m_memoised = transformation(std::move(m_memoised));
+  if (m_memoised == nullptr) {
+    throw std::logic_error("A transformation cannot replace a subexpression with a null expression.");
+  }
+  // the result kept would go stale if the subexpression could change
+  if (!m_memoised->isConstant()) {
+    throw std::logic_error("A transformation cannot replace a memoised expression with one which is not constant.");
+  }
+  m_height = m_memoised->height() + 1;
+}
+
+void MemoisedExpression::releaseSubexpressions(ExpressionList& released) {
+  if (m_memoised != nullptr) {
+    released.push_back(std::move(m_memoised));
+  }
+  m_height = 1;
+}
+
 }
\ No newline at end of file
@@ -1,31 +1,300 @@
 #ifndef MATHTREE_EXPRESSION_H
 #define MATHTREE_EXPRESSION_H
 
+#include <atomic>
+#include "EvaluationPolicy.hpp"
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <optional>
 #include <string_view>
+#include "SymbolTable.hpp"
 #include "Token.hpp"
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace MathTree {
 
+/**
+ * Holds the result of an expression once computed, and can be read and filled by many threads at once.
+ * Threads racing to fill an empty cache store the same result, so it does not matter which store comes last.
+ **/
+class ResultCache {
+public:
+  /// Returns the result stored, or std::nullopt if no result was stored yet.
+  std::optional<double> load() const {
+    if (!m_isFilled.load(std::memory_order_acquire)) {
+      return std::nullopt;
+    }
+    return m_value.load(std::memory_order_relaxed);
+  }
+  /// Stores the given result, which is visible to any thread that loads it afterwards.
+  void store(double value) {
+    m_value.store(value, std::memory_order_relaxed);
+    m_isFilled.store(true, std::memory_order_release);
+  }
+
+private:
+  std::atomic<double> m_value{0};
+  std::atomic<bool> m_isFilled{false};
+};
+
+class Expression;
+
+/// Represents the reason why an expression has no real result.
+enum class EvaluationError: unsigned char {
+  /// A division whose divisor is zero.
+  DivisionByZero,
+  /// An exponentiation whose result is not real, as per Arithmetic::isValidPower.
+  InvalidPower,
+  /// A square root whose radicand is infinite, negative or non-real.
+  InvalidSquareRoot,
+  /// A logarithm whose argument is non-positive.
+  InvalidLogarithm,
+  /// A variable which is not bound to any value.
+  UnboundVariable
+};
+
+/**
+ * Holds either the result of an evaluation, or the error that prevented it together with the expression where
+ * it occurred, like std::expected does. Neither holding nor reading an error allocates, and the error is only
+ * turned into an exception, with its message, when value() is called.
+ **/
+class EvaluationResult {
+public:
+  /// Constructs a result holding the value given.
+  EvaluationResult(double value): m_value(value) {}
+  /**
+   * Constructs a result holding the error given, which occurred while evaluating the expression provided
+   * with the operands given, which are the ones reported by the exception thrown by value().
+   **/
+  EvaluationResult(EvaluationError error,
+                   Expression const& failedExpression,
+                   double firstOperand = 0.0,
+                   double secondOperand = 0.0): m_value(firstOperand),
+                                                m_secondOperand(secondOperand),
+                                                m_failedExpression(&failedExpression),
+                                                m_error(error) {}
+
+  /// Returns true if the result holds a value, false if it holds an error.
+  bool hasValue() const {
+    return m_failedExpression == nullptr;
+  }
+  /// Returns true if the result holds a value, false if it holds an error.
+  explicit operator bool() const {
+    return hasValue();
+  }
+  /**
+   * Returns the value held. If the result holds an error, throws the same exception as evaluating
+   * the failed expression with Expression::evaluate() does.
+   **/
+  double value() const {
+    if (!hasValue()) {
+      throwError();
+    }
+    return m_value;
+  }
+  /// Returns the error held. Only meaningful if the result holds no value.
+  EvaluationError error() const {
+    return m_error;
+  }
+  /// Returns the expression where the error occurred, or null if the result holds a value.
+  Expression const* failedExpression() const {
+    return m_failedExpression;
+  }
+
+private:
+  [[noreturn]] void throwError() const;
+
+  // holds the first operand of the failed operation when there is no value
+  double m_value;
+  double m_secondOperand{0};
+  Expression const* m_failedExpression = nullptr;
+  EvaluationError m_error{};
+};
+
 /// Represents a mathematical expression of real numbers.
 class Expression {
 public:
-  /// Returns the real valued number obtained by solving the expression.
+  /**
+   * Returns the real valued number obtained by solving the expression.
+   * A tree can be evaluated by many threads at once, as long as no thread binds
+   * its variables to new values in the meantime.
+   **/
   virtual double evaluate() const = 0;
+  /**
+   * Returns the result of the expression, or the error that prevented computing it, without throwing and without
+   * allocating on errors. Subexpressions are evaluated in the same order as evaluate() does, so the error held is
+   * the one evaluate() would throw. By default, the result of evaluate() is returned, so expressions which do not
+   * override it report their errors by throwing.
+   **/
+  virtual EvaluationResult tryEvaluate() const;
+  /**
+   * Returns the result of the expression computed as per the policy given, among those of EvaluationPolicy,
+   * which is chosen at compile time. EvaluationPolicy::Checked gives the same result as evaluate().
+   **/
+  template<typename Policy>
+  double evaluateWith() const;
+  /**
+   * Returns the result of the expression computed as per EvaluationPolicy::Propagating.
+   * By default, the result of evaluate() is returned, so expressions which do not override it throw on errors.
+   **/
+  virtual double evaluate(EvaluationPolicy::Propagating policy) const;
+  /**
+   * Returns the result of the expression computed as per EvaluationPolicy::Unchecked.
+   * By default, the result of evaluate() is returned.
+   **/
+  virtual double evaluate(EvaluationPolicy::Unchecked policy) const;
   /// Prints the expression to the output stream provided.
   virtual void print(std::ostream& stream) const = 0;
   /// Returns the list of subexpressions that make up this expression, if there are any, ordered left to right.
   virtual std::vector<Expression const*> subexpressions() const = 0;
+  /**
+   * Returns the number of subexpressions of this expression, without allocating.
+   * By default, the size of subexpressions() is returned.
+   **/
+  virtual size_t subexpressionCount() const;
+  /**
+   * Returns the subexpression at the given position among those of subexpressions(), without allocating.
+   * Throws if there is no such subexpression. By default, the subexpression is read from subexpressions().
+   **/
+  virtual Expression const& subexpression(size_t index) const;
+  /**
+   * Returns true if the expression always evaluates to the same result, false if
+   * its result can change between evaluations (e.g. because it depends on a variable).
+   * Only the results of constant expressions can be memoised across evaluations, by a MemoisedExpression.
+   * By default, an expression is constant if it has subexpressions and all of them are constant, so that
+   * expressions without subexpressions are never memoised unless they override this.
+   **/
+  virtual bool isConstant() const;
+  /**
+   * Returns the number of expressions on the longest path from this expression down to one without subexpressions,
+   * which is how deep recursing through the tree goes. Returns 1 by default.
+   **/
+  virtual size_t height() const;
+
+  /// A list of expressions, which owns them.
+  using ExpressionList = std::pmr::vector<std::unique_ptr<Expression>>;
+  /**
+   * Moves every subexpression to the end of the list provided, ordered left to right, which leaves the expression
+   * without any. The expression can only be destroyed afterwards. Does nothing by default.
+   **/
+  virtual void releaseSubexpressions(ExpressionList& released);
+
+  /// A function which receives a subexpression and returns the one that should take its place.
+  using Transformation = std::function<std::unique_ptr<Expression>(std::unique_ptr<Expression>)>;
+  /**
+   * Replaces every subexpression with the result of applying the given transformation to it.
+   * The transformation must return a non-null expression with the same result as the one it receives,
+   * as results already memoised are kept. Does nothing if there are no subexpressions.
+   **/
+  virtual void transformSubexpressions(Transformation const& transformation);
+
+  /**
+   * Performs one step of an evaluation which keeps intermediate results on the stack provided instead of recursing.
+   * At step 0, the expression either pushes its result onto the stack, or returns the first subexpression to evaluate.
+   * At every later step, the result of the subexpression returned by the previous step is on top of the stack, and
+   * the expression either returns the next subexpression to evaluate, or replaces the results of its subexpressions
+   * with its own result and returns null. Results are memoised and errors thrown in the same order as evaluate() does.
+   * By default, the result of evaluate() is pushed at step 0.
+   **/
+  virtual Expression const* evaluateStep(size_t step, std::vector<double>& stack) const;
+  /**
+   * Performs one step of an evaluation without recursion like evaluateStep(size_t, std::vector<double>&), but reports
+   * errors as tryEvaluate() does instead of throwing: an operation without a real result stores its error in the
+   * result given and returns null, after which the evaluation stops. By default, the result of tryEvaluate() is pushed
+   * at step 0, or stored in the result given if it is an error.
+   **/
+  virtual Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const;
+  /**
+   * Performs one step of an evaluation without recursion like evaluateStep(size_t, std::vector<double>&), computing
+   * the result as per the policy given, among those of EvaluationPolicy, which is chosen at compile time.
+   **/
+  template<typename Policy>
+  Expression const* evaluateStepWith(size_t step, std::vector<double>& stack) const;
+  /**
+   * Performs one step of an evaluation without recursion computed as per EvaluationPolicy::Propagating.
+   * By default, the result of evaluate(EvaluationPolicy::Propagating) is pushed at step 0.
+   **/
+  virtual Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                         EvaluationPolicy::Propagating policy) const;
+  /**
+   * Performs one step of an evaluation without recursion computed as per EvaluationPolicy::Unchecked.
+   * By default, the result of evaluate(EvaluationPolicy::Unchecked) is pushed at step 0.
+   **/
+  virtual Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                         EvaluationPolicy::Unchecked policy) const;
+  /**
+   * The height up to which trees are evaluated and destroyed by recursing, rather than by keeping an explicit stack.
+   * Recursing is faster, and bounding its depth bounds the call stack space it uses.
+   **/
+  static size_t constexpr maxRecursionHeight = 64;
+
+  /// Allocates an expression from the default memory resource.
+  static void* operator new(size_t size);
+  /**
+   * Allocates an expression from the memory resource provided, which must outlive the expression.
+   * Deleting the expression returns its memory to the same resource. Expressions are constructed in this memory
+   * by allocateExpression, which returns the memory to the resource if the construction throws.
+   **/
+  static void* operator new(size_t size, std::pmr::memory_resource& resource);
+  /**
+   * Returns the memory of an expression to the resource it was allocated from, the size being the one of the
+   * dynamic type of the expression, as passed by its virtual destructor.
+   **/
+  static void operator delete(void* memory, size_t size);
+  /**
+   * Not defined, as the size of an expression whose construction threw is not known to it,
+   * which makes allocateExpression the only way of constructing an expression in a memory resource.
+   **/
+  static void operator delete(void* memory, std::pmr::memory_resource& resource) = delete;
 
   Expression& operator=(Expression const&) = delete;
   Expression& operator=(Expression&&) = delete;
   virtual ~Expression() = default;
+
+protected:
+  /**
+   * Destroys all the subexpressions of the expression without recursing deeper than maxRecursionHeight,
+   * so that trees of any depth can be destroyed. Composite expressions call it from their destructor.
+   **/
+  void destroySubexpressions();
 };
 std::ostream& operator<<(std::ostream& left, Expression const& right);
 
+template<typename Policy>
+double Expression::evaluateWith() const {
+  if constexpr (std::is_same_v<Policy, EvaluationPolicy::Checked>) {
+    return evaluate();
+  } else {
+    return evaluate(Policy{});
+  }
+}
+
+template<typename Policy>
+Expression const* Expression::evaluateStepWith(size_t step, std::vector<double>& stack) const {
+  if constexpr (std::is_same_v<Policy, EvaluationPolicy::Checked>) {
+    return evaluateStep(step, stack);
+  } else {
+    return evaluateStep(step, stack, Policy{});
+  }
+}
+
+/// Constructs an expression of the given type with the arguments provided, allocating it from the memory resource given.
+template<typename ExpressionType, typename... Args>
+std::unique_ptr<ExpressionType> allocateExpression(std::pmr::memory_resource& resource, Args&&... args) {
+  static_assert(alignof(ExpressionType) <= alignof(Expression), "Expressions are only aligned as Expression is.");
+  auto const memory = Expression::operator new(sizeof(ExpressionType), resource);
+  try {
+    return std::unique_ptr<ExpressionType>(::new (memory) ExpressionType(std::forward<Args>(args)...));
+  } catch (...) {
+    Expression::operator delete(memory, sizeof(ExpressionType));
+    throw;
+  }
+}
+
 /// Represents an expression composed of two subexpressions.
 class BinaryExpression: public Expression {
 public:
@@ -36,6 +305,8 @@ public:
   BinaryExpression(std::unique_ptr<Expression> left,
                    TokenType tokenType,
                    std::unique_ptr<Expression> right);
+  /// Destroys the expression along with its subexpressions, without recursing deeper than maxRecursionHeight.
+  ~BinaryExpression() override;
 
   /**
    * Prints the binary expression to the output stream provided.
@@ -49,11 +320,53 @@ public:
   Expression const& right() const;
   /// Returns the left and right subexpressions, in this order.
   std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if both subexpressions are constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+protected:
+  /**
+   * Evaluates the left and then the right subexpression without throwing, and combines their results with
+   * the operation given, which returns an EvaluationResult.
+   **/
+  template<typename Operation>
+  EvaluationResult tryEvaluateLeftToRight(Operation operation) const;
+  /**
+   * Evaluates the left and then the right subexpression as per the policy given, and combines their results with
+   * the operation given.
+   **/
+  template<typename Policy, typename Operation>
+  double evaluateLeftToRight(Operation operation) const;
+  /**
+   * Performs a step of an evaluation without recursion that evaluates the left and then the right subexpression,
+   * and combines their results with the operation given.
+   **/
+  template<typename Operation>
+  Expression const* evaluateStepLeftToRight(size_t step, std::vector<double>& stack,
+                                            Operation operation) const;
+  /**
+   * Performs a step of an evaluation without recursion like evaluateStepLeftToRight, but reports errors instead of
+   * throwing. The operation given returns an EvaluationResult, which is stored in the result given if it is an error.
+   **/
+  template<typename Operation>
+  Expression const* tryEvaluateStepLeftToRight(size_t step, std::vector<double>& stack, EvaluationResult& error,
+                                               Operation operation) const;
 
 private:
   std::unique_ptr<Expression> m_left;
   std::unique_ptr<Expression> m_right;
   TokenType m_tokenType;
+  bool m_isConstant{false};
+  size_t m_height{1};
 };
 
 /// Represents an addition of two subexpressions.
@@ -62,8 +375,22 @@ public:
   using BinaryExpression::BinaryExpression;
   /// Returns the addition of the two subexpressions.
   double evaluate() const override;
-private:
-  mutable std::optional<double> m_cache;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
 };
 
 /// Represents a subtraction of two subexpressions.
@@ -72,8 +399,22 @@ public:
   using BinaryExpression::BinaryExpression;
   /// Returns the subtraction of the right subexpression from the left subexpression.
   double evaluate() const override;
-private:
-  mutable std::optional<double> m_cache;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
 };
 
 /// Represents a multiplication of two subexpressions.
@@ -82,8 +423,22 @@ public:
   using BinaryExpression::BinaryExpression;
   /// Returns the multiplication of the two subexpressions.
   double evaluate() const override;
-private:
-  mutable std::optional<double> m_cache;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
 };
 
 /// Represents a division of two subexpressions.
@@ -95,8 +450,29 @@ public:
    * Throws if the divisor evaluates to zero.
    **/
   double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
 private:
-  mutable std::optional<double> m_cache;
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
 };
 
 /// Represents the exponentiation of a base subexpression with an exponent subexpression.
@@ -111,8 +487,29 @@ public:
    * a^b with a < 0 and b non-integer.
    **/
   double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+
 private:
-  mutable std::optional<double> m_cache;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
+  // raises the base given to the exponent given, or returns the error if the result is not real
+  EvaluationResult tryPower(double base, double exponent) const;
 };
 
 /// Represents the negation of a subexpression.
@@ -123,6 +520,8 @@ public:
    * The negation will be applied to the right subexpression provided.
    **/
   NegativeSignExpression(TokenType operatorToken, std::unique_ptr<Expression> right);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~NegativeSignExpression() override;
   /**
    * Prints the expression to the output stream given, by first printing the negation symbol
    * and then the right subexpression.
@@ -130,13 +529,46 @@ public:
   void print(std::ostream& stream) const override;
   /// Returns the negation of the right subexpression.
   double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
   /// Returns the only subexpression.
   std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if the subexpression is constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
 
 private:
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+
   TokenType m_operator;
   std::unique_ptr<Expression> m_right;
-  mutable std::optional<double> m_cache;
+  bool m_isConstant{false};
+  size_t m_height{1};
 };
 
 /// Represents a finite real number limited by double precision.
@@ -144,17 +576,61 @@ class RealNumberExpression: public Expression {
 public:
   /// Constructs a real number from the string provided, with double precision.
   RealNumberExpression(std::string_view num);
+  /// Constructs a real number with the given value. Throws if the value is infinite or NaN.
+  explicit RealNumberExpression(double value);
   /// Returns the real number.
   double evaluate() const override;
   /// Prints the real number to the output stream.
   void print(std::ostream& stream) const override;
   /// Returns an empty container.
   std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true.
+  bool isConstant() const override;
 
 private:
   double m_value{0};
 };
 
+/// Represents a named variable, whose value is looked up in a symbol table on every evaluation.
+class VariableExpression: public Expression {
+public:
+  /**
+   * Constructs the variable found at the given index of the symbol table provided.
+   * Throws if the symbol table is null or if it has no variable with that index.
+   **/
+  VariableExpression(std::shared_ptr<SymbolTable const> symbols, size_t index);
+  /// Returns the value currently bound to the variable. Throws if the variable is unbound.
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  /// Prints the name of the variable to the output stream.
+  void print(std::ostream& stream) const override;
+  /// Returns an empty container.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns false, as the variable can be bound to a different value between evaluations.
+  bool isConstant() const override;
+  /// Returns the symbol table where the value of the variable is stored.
+  std::shared_ptr<SymbolTable const> const& symbols() const;
+  /// Returns the index of the variable in its symbol table.
+  size_t index() const;
+
+private:
+  std::shared_ptr<SymbolTable const> m_symbols;
+  size_t m_index{0};
+};
+
 /// Represents the square root of a subexpression.
 class SquareRootExpression: public Expression {
 public:
@@ -164,11 +640,29 @@ public:
    **/
   SquareRootExpression(std::unique_ptr<Expression> innerExpression,
                        TokenType tokenType);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~SquareRootExpression() override;
   /**
    * Returns the square root of the subexpression.
    * Throws if the subexpression is infinite, negative or non-real.
    **/
   double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
   /**
    * Prints the symbol of this expression, followed by an opening bracket,
    * then the subexpression, and finally a closing bracket.
@@ -176,11 +670,33 @@ public:
   void print(std::ostream& stream) const override;
   /// Returns the only subexpression.
   std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if the subexpression is constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
 
 private:
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
+  // returns the square root of the radicand given, or the error if it has no real square root
+  EvaluationResult trySquareRoot(double radicand) const;
+
   std::unique_ptr<Expression> m_innerExpression;
   TokenType m_tokenType;
-  mutable std::optional<double> m_cache;
+  bool m_isConstant{false};
+  size_t m_height{1};
 };
 
 /// Represents the logarithm of a subexpression with an arbitrary base.
@@ -194,21 +710,641 @@ public:
   LogarithmExpression(std::unique_ptr<Expression> innerExpression,
                        double base,
                        TokenType tokenType);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~LogarithmExpression() override;
   /**
    * Returns the logarithm of the given subexpression using the base specified on construction.
    * Throws if the subexpression is non-positive.
    **/
   double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  /// Returns the base of the logarithm.
+  double base() const;
+  /// Returns the token type used as the symbol of the logarithm.
+  TokenType tokenType() const;
   /// Prints to the output stream provided using a log_b(a) format.
   void print(std::ostream& stream) const override;
   /// Returns the only subexpression.
   std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if the subexpression is constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
 
 private:
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
+  // returns the logarithm of the argument given, or the error if it has no real logarithm
+  EvaluationResult tryLogarithm(double argument) const;
+
   std::unique_ptr<Expression> m_innerExpression;
   double m_base{0};
   TokenType m_tokenType;
-  mutable std::optional<double> m_cache;
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/**
+ * Represents a subexpression raised to a constant exponent which is either a small integer or one half, as produced
+ * by reduceStrength. Integer powers are computed by exponentiation by squaring, and differ from std::pow by at most
+ * |n| + 1 ulps for an exponent n, unless an intermediate result overflows or underflows. Powers of one half are
+ * computed by std::sqrt, which gives the same result as a correctly rounded std::pow.
+ **/
+class ConstantPowerExpression: public Expression {
+public:
+  /// The largest magnitude of the integer exponents that can be reduced.
+  static int constexpr maxIntegerExponent = 8;
+  /// Returns true if the exponent given is an integer of magnitude up to maxIntegerExponent or one half.
+  static bool isReducible(double exponent);
+  /// Raises the base given to the reducible exponent given as the expression does, without validating the result.
+  static double power(double base, double exponent);
+  /**
+   * Constructs the power of the inner expression provided to the given exponent.
+   * Throws if the subexpression is null, or if the exponent is not reducible.
+   **/
+  ConstantPowerExpression(std::unique_ptr<Expression> innerExpression, double exponent);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~ConstantPowerExpression() override;
+  /**
+   * Returns the subexpression raised to the exponent specified on construction.
+   * Throws the same errors as an ExponentiationExpression.
+   **/
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  /**
+   * Returns the result of the expression computed as per EvaluationPolicy::Propagating.
+   * The results match those of std::pow, except for a negative infinity raised to one half, which gives NaN.
+   **/
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  /// Returns the exponent of the power.
+  double exponent() const;
+  /// Prints the subexpression and the exponent as an ExponentiationExpression would.
+  void print(std::ostream& stream) const override;
+  /// Returns the only subexpression.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if the subexpression is constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+private:
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
+  // raises the base given to the exponent, or returns the error if the result is not real
+  EvaluationResult tryPower(double base) const;
+
+  std::unique_ptr<Expression> m_innerExpression;
+  double m_exponent{0};
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/**
+ * Represents the logarithm of a subexpression with a base known ahead of evaluation, as produced by reduceStrength.
+ * Logarithms in base 2, 10 and e are computed by std::log2, std::log10 and std::log respectively. The others are
+ * computed by multiplying std::log2 with the reciprocal of the binary logarithm of the base, which is computed once.
+ * The results are within 2 ulps of those of a LogarithmExpression, and equal to them in base 2.
+ **/
+class SpecialisedLogarithmExpression: public Expression {
+public:
+  /**
+   * Constructs a logarithm expression which is applied to the given subexpression
+   * using the base provided, and with the token type given as its symbol.
+   * Throws if the base is infinite or negative, or if the subexpression is null.
+   **/
+  SpecialisedLogarithmExpression(std::unique_ptr<Expression> innerExpression,
+                                 double base,
+                                 TokenType tokenType);
+  /**
+   * Returns the logarithm of the argument in the base given as the expression computes it, without validating it.
+   * The reciprocal of the binary logarithm of the base is computed on every call.
+   **/
+  static double logarithm(double argument, double base);
+  /**
+   * Replaces each of the arguments given with its logarithm in the base given, as logarithm(double, double)
+   * computes it, without validating them. The reciprocal of the binary logarithm of the base is computed once.
+   **/
+  static void logarithms(double* arguments, size_t count, double base);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~SpecialisedLogarithmExpression() override;
+  /**
+   * Returns the logarithm of the given subexpression using the base specified on construction.
+   * Throws if the subexpression is non-positive.
+   **/
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  /// Returns the base of the logarithm.
+  double base() const;
+  /// Prints to the output stream provided using a log_b(a) format.
+  void print(std::ostream& stream) const override;
+  /// Returns the only subexpression.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if the subexpression is constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+private:
+  // the function of the standard library computing the logarithm
+  enum class Form {
+    Binary,
+    Decimal,
+    Natural,
+    Scaled
+  };
+
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
+  // returns the logarithm of the argument given, or the error if it has no real logarithm
+  EvaluationResult tryLogarithm(double argument) const;
+  // returns the form in which logarithms in the base given are computed
+  static Form formOf(double base);
+  // computes the logarithm of the argument given in the form given, without validating it
+  static double logarithm(double argument, Form form, double scale);
+  // computes the logarithm of the argument given, without validating it
+  double logarithm(double argument) const;
+
+  std::unique_ptr<Expression> m_innerExpression;
+  double m_base{0};
+  // the reciprocal of the binary logarithm of the base, only used in the scaled form
+  double m_scale{0};
+  Form m_form{Form::Scaled};
+  TokenType m_tokenType;
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/// Selects how a sum adds up its terms, trading speed for accuracy.
+enum class SummationMode {
+  /// Adds the terms left to right, which gives the same result as a chain of additions and subtractions.
+  Sequential,
+  /// Adds the terms pairwise, as per Arithmetic::pairwiseSum.
+  Pairwise,
+  /// Adds the terms while compensating for rounding errors, as per Arithmetic::compensatedSum.
+  Kahan
+};
+
+/// Represents the sum of any number of terms, each of which is either added or subtracted.
+class SumExpression: public Expression {
+public:
+  /// Represents a term of a sum, together with whether it is subtracted rather than added.
+  struct Term {
+    std::unique_ptr<Expression> expression;
+    bool isSubtracted = false;
+  };
+  /// A list of terms, which are stored contiguously.
+  using TermList = std::pmr::vector<Term>;
+
+  /**
+   * Constructs the sum of the terms provided, which are added up as per the summation mode given.
+   * Throws if there are fewer than two terms, or if any of them is null.
+   **/
+  explicit SumExpression(TermList terms, SummationMode mode = SummationMode::Sequential);
+  /// Destroys the expression along with its subexpressions, without recursing deeper than maxRecursionHeight.
+  ~SumExpression() override;
+  /**
+   * Returns the sum of the terms, which are evaluated left to right in a single loop.
+   * Subtracting a term gives the same result as adding its negation.
+   **/
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  /// Prints the terms left to right, each preceded by the symbol of addition or subtraction but the first.
+  void print(std::ostream& stream) const override;
+  /// Returns the terms, ordered left to right.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if all the terms are constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+  /// Returns true if the term at the given index is subtracted, false if it is added.
+  bool isSubtracted(size_t index) const;
+  /// Returns how the terms are added up.
+  SummationMode mode() const;
+
+private:
+  // computes the result of the expression as per the policy given
+  template<typename Policy>
+  double evaluateAs() const;
+
+  /// Returns the sum of the results of the terms, which are given in order with the subtracted ones negated.
+  double sumOf(double const* results) const;
+
+  TermList m_terms;
+  SummationMode m_mode;
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/// Represents the product of any number of factors.
+class ProductExpression: public Expression {
+public:
+  /// Constructs the product of the factors provided. Throws if there are fewer than two factors, or if any of them is null.
+  explicit ProductExpression(ExpressionList factors);
+  /// Destroys the expression along with its subexpressions, without recursing deeper than maxRecursionHeight.
+  ~ProductExpression() override;
+  /**
+   * Returns the product of the factors, which are evaluated and multiplied left to right in a single loop.
+   * This gives the same result as a chain of multiplications.
+   **/
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  /// Prints the factors left to right, separated by the symbol of multiplication.
+  void print(std::ostream& stream) const override;
+  /// Returns the factors, ordered left to right.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if all the factors are constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+private:
+  // computes the result of the expression as per the policy given
+  template<typename Policy>
+  double evaluateAs() const;
+
+  ExpressionList m_factors;
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/**
+ * Represents a polynomial in a single subexpression, usually a variable, as produced by recognisePolynomials.
+ * The polynomial is stored as its coefficients and evaluated with Horner's scheme or, from estrinDegree onwards,
+ * with Estrin's scheme on blocks of four coefficients, which are then combined with Horner's scheme in x^4.
+ * The blocks are independent of each other, so the processor can evaluate them in parallel.
+ * The results differ from those of the expanded form by rounding. Arguments whose powers overflow may give NaN
+ * rather than an infinity with Estrin's scheme.
+ **/
+class PolynomialExpression: public Expression {
+public:
+  /// Holds the coefficients of a polynomial, starting from the constant one.
+  using Coefficients = std::pmr::vector<double>;
+
+  /// The largest degree a polynomial can have.
+  static size_t constexpr maxDegree = 32;
+  /// The lowest degree from which polynomials are evaluated with Estrin's scheme rather than Horner's.
+  static size_t constexpr estrinDegree = 6;
+
+  /**
+   * Constructs the polynomial with the coefficients given, starting from the constant one, in the argument provided.
+   * Throws if the argument is null, or if there are no coefficients or more than maxDegree + 1 of them.
+   **/
+  PolynomialExpression(std::unique_ptr<Expression> argument, Coefficients coefficients);
+  /**
+   * Returns the value at the argument given of the polynomial with the coefficients given, starting from the constant
+   * one, computed with the scheme the expression uses for the same coefficients. There must be at least one coefficient.
+   **/
+  static double valueAt(double const* coefficients, size_t count, double argument);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~PolynomialExpression() override;
+  /// Returns the value of the polynomial at the result of its argument. Throws if the argument throws.
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  /// Returns the coefficients of the polynomial, starting from the constant one.
+  Coefficients const& coefficients() const;
+  /// Returns the degree of the polynomial, which is its number of coefficients minus one.
+  size_t degree() const;
+  /// Prints the non-zero terms of the polynomial in decreasing degree, as a sum of products of powers.
+  void print(std::ostream& stream) const override;
+  /// Returns the argument of the polynomial.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if the argument is constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+private:
+  // computes the result of the expression as per the policy given
+  template<typename Policy>
+  double evaluateAs() const;
+  // computes the value of the polynomial at the argument given with the scheme suited to its degree
+  double valueAt(double argument) const;
+
+  std::unique_ptr<Expression> m_argument;
+  Coefficients m_coefficients;
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/// Selects how a multiply-add rounds its result.
+enum class MultiplyAddRounding {
+  /// Rounds the product and then the sum, which gives the same results as a multiplication under an addition.
+  Separate,
+  /// Rounds the result once, as std::fma does, which is more accurate.
+  Fused
+};
+
+/**
+ * Represents the sum or difference of a product and an addend, as produced by contractMultiplyAdds.
+ * The operands are evaluated in the order of the expression it replaces, so that the same errors are reported.
+ **/
+class FmaExpression: public Expression {
+public:
+  /// Selects which operation of a product and an addend the expression computes.
+  enum class Pattern {
+    /// a * b + c
+    ProductPlusAddend,
+    /// c + a * b
+    AddendPlusProduct,
+    /// a * b - c
+    ProductMinusAddend,
+    /// c - a * b
+    AddendMinusProduct
+  };
+
+  /**
+   * Constructs the multiply-add of the multiplicand, multiplier and addend provided, as per the pattern
+   * and rounding given. Throws if any of the operands is null.
+   **/
+  FmaExpression(std::unique_ptr<Expression> multiplicand, std::unique_ptr<Expression> multiplier,
+                std::unique_ptr<Expression> addend, Pattern pattern, MultiplyAddRounding rounding);
+  /// Returns the result of the pattern computed from the operands given, rounded as per the rounding given.
+  static double combine(double multiplicand, double multiplier, double addend,
+                        Pattern pattern, MultiplyAddRounding rounding);
+  /// Returns true if the addend of the pattern given is evaluated before the product, false otherwise.
+  static bool isAddendFirst(Pattern pattern);
+  /// Destroys the expression along with its subexpressions, without recursing deeper than maxRecursionHeight.
+  ~FmaExpression() override;
+  /// Returns the result of the pattern computed from the operands. Throws if any operand throws.
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  /// Returns the operation of the product and the addend computed.
+  Pattern pattern() const;
+  /// Returns how the result is rounded.
+  MultiplyAddRounding rounding() const;
+  /// Prints the expression as the multiplication and addition or subtraction it replaces would be printed.
+  void print(std::ostream& stream) const override;
+  /// Returns the operands in the order they are evaluated in.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true if all the operands are constant, false otherwise.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  //! @copydoc Expression::transformSubexpressions(Transformation const&)
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+private:
+  // computes the result of the expression as per the policy given
+  template<typename Policy>
+  double evaluateAs() const;
+  // computes the pattern from the results of the operands
+  double combine(double multiplicand, double multiplier, double addend) const;
+  // returns true if the addend is evaluated before the product
+  bool isAddendFirst() const;
+  // updates whether the expression is constant and its height, from its operands
+  void updateOperandProperties();
+
+  std::unique_ptr<Expression> m_multiplicand;
+  std::unique_ptr<Expression> m_multiplier;
+  std::unique_ptr<Expression> m_addend;
+  Pattern m_pattern;
+  MultiplyAddRounding m_rounding;
+  bool m_isConstant{false};
+  size_t m_height{1};
+};
+
+/// Selects which results of a tree are kept across evaluations, and so how much memory its nodes take.
+enum class Memoisation {
+  /// Keeps no result, so that nodes take no memory for it and every evaluation computes the whole tree.
+  None,
+  /**
+   * Keeps the result of every largest constant subtree in a MemoisedExpression, so that only the first evaluation
+   * computes it. Each of them takes one node more, while all other nodes take no memory for results.
+   **/
+  ConstantSubtrees
+};
+
+/**
+ * Wraps a constant expression and keeps its result once computed, so that later evaluations read it instead of
+ * evaluating the expression again. Errors are never kept, so an expression that fails fails on every evaluation.
+ * Results computed as per a policy are only kept if the keepsResult function of the policy accepts them, so that
+ * the NaN and infinities given in place of errors are never kept.
+ * Many threads can evaluate the expression at once, as the result is kept in a ResultCache.
+ **/
+class MemoisedExpression: public Expression {
+public:
+  /// Constructs the memoisation of the expression provided. Throws if it is null or not constant.
+  explicit MemoisedExpression(std::unique_ptr<Expression> memoised);
+  /// Destroys the expression along with its subexpression, without recursing deeper than maxRecursionHeight.
+  ~MemoisedExpression() override;
+  /// Returns the result kept, or the result of the subexpression if none was kept yet. Throws if the subexpression throws.
+  double evaluate() const override;
+  //! @copydoc Expression::tryEvaluate() const
+  EvaluationResult tryEvaluate() const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Propagating) const
+  double evaluate(EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluate(EvaluationPolicy::Unchecked) const
+  double evaluate(EvaluationPolicy::Unchecked policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack) const override;
+  //! @copydoc Expression::tryEvaluateStep(size_t, std::vector<double>&, EvaluationResult&) const
+  Expression const* tryEvaluateStep(size_t step, std::vector<double>& stack, EvaluationResult& error) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Propagating) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Propagating policy) const override;
+  //! @copydoc Expression::evaluateStep(size_t, std::vector<double>&, EvaluationPolicy::Unchecked) const
+  Expression const* evaluateStep(size_t step, std::vector<double>& stack,
+                                 EvaluationPolicy::Unchecked policy) const override;
+  /// Prints the subexpression, as the memoisation does not change it.
+  void print(std::ostream& stream) const override;
+  /// Returns the only subexpression.
+  std::vector<Expression const*> subexpressions() const override;
+  //! @copydoc Expression::subexpressionCount() const
+  size_t subexpressionCount() const override;
+  //! @copydoc Expression::subexpression(size_t) const
+  Expression const& subexpression(size_t index) const override;
+  /// Returns true, as only constant expressions are memoised.
+  bool isConstant() const override;
+  //! @copydoc Expression::height() const
+  size_t height() const override;
+  /**
+   * Replaces the subexpression with the result of applying the given transformation to it.
+   * Throws if the transformation returns a null expression or one which is not constant.
+   **/
+  void transformSubexpressions(Transformation const& transformation) override;
+  //! @copydoc Expression::releaseSubexpressions(ExpressionList&)
+  void releaseSubexpressions(ExpressionList& released) override;
+
+private:
+  // computes the result of the expression as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  double evaluateAs() const;
+  // performs a step of the evaluation as per the policy given, which is not EvaluationPolicy::Checked
+  template<typename Policy>
+  Expression const* evaluateStepAs(size_t step, std::vector<double>& stack) const;
+
+  std::unique_ptr<Expression> m_memoised;
+  size_t m_height{1};
+  mutable ResultCache m_cache;
 };
 
 }
@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <array>
+#include "Arithmetic.hpp"
+#include <cmath>
+#include <cstring>
+#include "ExpressionDag.hpp"
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MathTree {
+
+namespace {
+
+std::uint64_t bitsOf(double value) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+struct NodeHash {
+  size_t operator()(ExpressionDag::Node const& node) const {
+    auto hash = std::hash<std::uint64_t>{}(bitsOf(node.operand));
+    for (std::uint64_t field: {static_cast<std::uint64_t>(node.operation),
+                               static_cast<std::uint64_t>(node.index),
+                               static_cast<std::uint64_t>(node.first) << 32 | node.second}) {
+      hash ^= std::hash<std::uint64_t>{}(field) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+  }
+};
+
+}
+
+bool ExpressionDag::Node::operator==(Node const& other) const {
+  // constants are compared bit by bit, so that 0 and -0 are kept apart
+  return operation == other.operation && index == other.index &&
+         first == other.first && second == other.second && bitsOf(operand) == bitsOf(other.operand);
+}
+
+class ExpressionDag::Builder {
+public:
+  Builder(ExpressionDag& dag): m_dag(dag) {}
+
+  // adds the tree without recursion, taking the expressions from an explicit stack whatever the height of the tree
+  std::uint32_t add(Expression const& expression) {
+    std::vector<Frame> frames{{&expression, 0}};
+    while (!frames.empty()) {
+      auto const frame = frames.back();
+      ++frames.back().step;
+      if (auto const operand = addStep(*frame.expression, frame.step)) {
+        frames.push_back({operand, 0});
+      } else {
+        frames.pop_back();
+      }
+    }
+    return pop();
+  }
+
+private:
+  // an expression being added, along with the number of steps already performed
+  struct Frame {
+    Expression const* expression;
+    size_t step;
+  };
+
+  /**
+   * Performs the given step of adding the expression provided, the node of each operand added by a previous
+   * step being on top of m_operands. Returns the next operand to add, or null once the node of the expression
+   * has replaced the nodes of its operands on top of m_operands.
+   **/
+  Expression const* addStep(Expression const& expression, size_t step) {
+    if (step == 0) {
+      ++m_dag.m_treeSize;
+    }
+    if (dynamic_cast<RealNumberExpression const*>(&expression)) {
+      push({Operation::Constant, 0, 0, 0, expression.evaluate()});
+      return nullptr;
+    } else if (auto variable = dynamic_cast<VariableExpression const*>(&expression)) {
+      if (m_dag.m_symbols == nullptr) {
+        m_dag.m_symbols = variable->symbols();
+      } else if (m_dag.m_symbols != variable->symbols()) {
+        throw std::logic_error("Cannot build a graph from variables belonging to different symbol tables.");
+      }
+      if (variable->index() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::logic_error("Cannot build a graph with a variable of index " + std::to_string(variable->index()) + ".");
+      }
+      push({Operation::Variable, static_cast<std::uint32_t>(variable->index()), 0, 0, 0.0});
+      return nullptr;
+    } else if (auto memoised = dynamic_cast<MemoisedExpression const*>(&expression)) {
+      // graphs keep no result across evaluations, so the memoised subtree takes the place of its memoisation
+      return step == 0 ? &memoised->subexpression(0) : nullptr;
+    } else if (auto negation = dynamic_cast<NegativeSignExpression const*>(&expression)) {
+      return addUnaryStep(step, negation->subexpression(0), Operation::Negate);
+    } else if (auto squareRoot = dynamic_cast<SquareRootExpression const*>(&expression)) {
+      return addUnaryStep(step, squareRoot->subexpression(0), Operation::SquareRoot);
+    } else if (auto logarithm = dynamic_cast<LogarithmExpression const*>(&expression)) {
+      return addUnaryStep(step, logarithm->subexpression(0), Operation::Logarithm, logarithm->base());
+    } else if (auto power = dynamic_cast<ConstantPowerExpression const*>(&expression)) {
+      return addUnaryStep(step, power->subexpression(0), Operation::ConstantPower, power->exponent());
+    } else if (auto specialisedLogarithm = dynamic_cast<SpecialisedLogarithmExpression const*>(&expression)) {
+      return addUnaryStep(step, specialisedLogarithm->subexpression(0), Operation::SpecialisedLogarithm,
+                          specialisedLogarithm->base());
+    } else if (auto polynomial = dynamic_cast<PolynomialExpression const*>(&expression)) {
+      if (step == 0) {
+        return &polynomial->subexpression(0);
+      }
+      auto const argument = pop();
+      push({Operation::Polynomial, internPolynomial(polynomial->coefficients()), argument, 0, 0.0});
+      return nullptr;
+    } else if (auto multiplyAdd = dynamic_cast<FmaExpression const*>(&expression)) {
+      return addMultiplyAddStep(*multiplyAdd, step);
+    } else if (auto sum = dynamic_cast<SumExpression const*>(&expression)) {
+      return addSumStep(*sum, step);
+    } else if (auto product = dynamic_cast<ProductExpression const*>(&expression)) {
+      if (step >= 2) {
+        auto const factor = pop();
+        auto const result = pop();
+        push({Operation::Multiply, 0, result, factor, 0.0});
+      }
+      return step < product->subexpressionCount() ? &product->subexpression(step) : nullptr;
+    } else if (auto division = dynamic_cast<DivisionExpression const*>(&expression)) {
+      // the tree validates the divisor before evaluating the dividend, so the order of
+      // evaluation is kept in order to report the same error when both are invalid
+      switch (step) {
+      case 0:
+        return &division->right();
+      case 1:
+        push({Operation::CheckDivisor, 0, pop(), 0, 0.0});
+        return &division->left();
+      default:
+        auto const dividend = pop();
+        auto const divisor = pop();
+        push({Operation::Divide, 0, dividend, divisor, 0.0});
+        return nullptr;
+      }
+    } else if (auto binary = dynamic_cast<BinaryExpression const*>(&expression)) {
+      switch (step) {
+      case 0:
+        return &binary->left();
+      case 1:
+        return &binary->right();
+      default:
+        auto const right = pop();
+        auto const left = pop();
+        push({operationFor(*binary), 0, left, right, 0.0});
+        return nullptr;
+      }
+    }
+    throw std::logic_error("Cannot build a graph from an expression of unknown type.");
+  }
+
+  Expression const* addUnaryStep(size_t step, Expression const& operand, Operation operation, double value = 0.0) {
+    if (step == 0) {
+      return &operand;
+    }
+    push({operation, 0, pop(), 0, value});
+    return nullptr;
+  }
+
+  Expression const* addSumStep(SumExpression const& sum, size_t step) {
+    auto const isSequential = sum.mode() == SummationMode::Sequential;
+    if (isSequential && step >= 2) {
+      auto const term = pop();
+      auto const result = pop();
+      push({sum.isSubtracted(step - 1) ? Operation::Subtract : Operation::Add, 0, result, term, 0.0});
+    } else if ((step == 1 || (!isSequential && step >= 1)) && sum.isSubtracted(step - 1)) {
+      // terms added up all at once are negated as the sum negates them, like the first term of a sequential sum
+      push({Operation::Negate, 0, pop(), 0, 0.0});
+    }
+    auto const count = sum.subexpressionCount();
+    if (step < count) {
+      return &sum.subexpression(step);
+    }
+
+    if (!isSequential) {
+      std::vector<std::uint32_t> terms(m_operands.end() - count, m_operands.end());
+      m_operands.resize(m_operands.size() - count);
+      auto const operation = sum.mode() == SummationMode::Kahan ? Operation::CompensatedSum : Operation::PairwiseSum;
+      push({operation, internTerms(std::move(terms)), 0, 0, 0.0});
+    }
+    return nullptr;
+  }
+
+  Expression const* addMultiplyAddStep(FmaExpression const& multiplyAdd, size_t step) {
+    using Pattern = FmaExpression::Pattern;
+    auto const pattern = multiplyAdd.pattern();
+    auto const isAddendFirst = FmaExpression::isAddendFirst(pattern);
+    auto const isSeparate = multiplyAdd.rounding() == MultiplyAddRounding::Separate;
+    // the operands are added in the order they are evaluated in, so that the same error is reported
+    if (step == 2 && isSeparate && !isAddendFirst) {
+      // rounding the product and then the sum is what the multiplication and addition replaced do
+      auto const multiplier = pop();
+      auto const multiplicand = pop();
+      push({Operation::Multiply, 0, multiplicand, multiplier, 0.0});
+    }
+    if (step < multiplyAdd.subexpressionCount()) {
+      return &multiplyAdd.subexpression(step);
+    }
+
+    auto const isSubtraction = pattern == Pattern::ProductMinusAddend || pattern == Pattern::AddendMinusProduct;
+    if (isSeparate) {
+      auto const operation = isSubtraction ? Operation::Subtract : Operation::Add;
+      if (isAddendFirst) {
+        auto const multiplier = pop();
+        auto const multiplicand = pop();
+        auto const addend = pop();
+        auto const product = intern({Operation::Multiply, 0, multiplicand, multiplier, 0.0});
+        push({operation, 0, addend, product, 0.0});
+      } else {
+        auto const addend = pop();
+        auto const product = pop();
+        push({operation, 0, product, addend, 0.0});
+      }
+      return nullptr;
+    }
+
+    std::array<std::uint32_t, 3> operands;
+    for (auto i = operands.size(); i-- > 0;) {
+      operands[i] = pop();
+    }
+    auto multiplicand = operands[isAddendFirst ? 1 : 0];
+    auto const multiplier = operands[isAddendFirst ? 2 : 1];
+    auto addend = operands[isAddendFirst ? 0 : 2];
+    // negating the subtracted operand is exact, so the result is the one of FmaExpression::combine
+    if (pattern == Pattern::AddendMinusProduct) {
+      multiplicand = intern({Operation::Negate, 0, multiplicand, 0, 0.0});
+    } else if (pattern == Pattern::ProductMinusAddend) {
+      addend = intern({Operation::Negate, 0, addend, 0, 0.0});
+    }
+    push({Operation::FusedMultiplyAdd, addend, multiplicand, multiplier, 0.0});
+    return nullptr;
+  }
+
+  static Operation operationFor(BinaryExpression const& binary) {
+    if (dynamic_cast<AdditionExpression const*>(&binary)) {
+      return Operation::Add;
+    } else if (dynamic_cast<SubtractionExpression const*>(&binary)) {
+      return Operation::Subtract;
+    } else if (dynamic_cast<MultiplicationExpression const*>(&binary)) {
+      return Operation::Multiply;
+    } else if (dynamic_cast<ExponentiationExpression const*>(&binary)) {
+      return Operation::Power;
+    }
+    throw std::logic_error("Cannot build a graph from a binary expression of unknown type.");
+  }
+
+  std::uint32_t internPolynomial(PolynomialExpression::Coefficients const& coefficients) {
+    // coefficients are compared bit by bit as constants are, so that polynomials are merged along with their nodes
+    std::vector<std::uint64_t> bits(coefficients.size());
+    std::transform(coefficients.begin(), coefficients.end(), bits.begin(), bitsOf);
+    auto const [it, isNew] = m_polynomialIndexes.try_emplace(std::move(bits),
+                                                             static_cast<std::uint32_t>(m_dag.m_polynomials.size()));
+    if (isNew) {
+      m_dag.m_polynomials.emplace_back(coefficients.begin(), coefficients.end());
+    }
+    return it->second;
+  }
+
+  std::uint32_t internTerms(std::vector<std::uint32_t> terms) {
+    auto const [it, isNew] = m_termListIndexes.try_emplace(std::move(terms),
+                                                           static_cast<std::uint32_t>(m_dag.m_termLists.size()));
+    if (isNew) {
+      m_dag.m_termLists.push_back(it->first);
+    }
+    return it->second;
+  }
+
+  std::uint32_t intern(Node const& node) {
+    auto const [it, isNew] = m_indexes.try_emplace(node, static_cast<std::uint32_t>(m_dag.m_nodes.size()));
+    if (isNew) {
+      m_dag.m_nodes.push_back(node);
+    }
+    return it->second;
+  }
+
+  void push(Node const& node) {
+    m_operands.push_back(intern(node));
+  }
+
+  std::uint32_t pop() {
+    auto const node = m_operands.back();
+    m_operands.pop_back();
+    return node;
+  }
+
+  ExpressionDag& m_dag;
+  std::unordered_map<Node, std::uint32_t, NodeHash> m_indexes;
+  std::map<std::vector<std::uint64_t>, std::uint32_t> m_polynomialIndexes;
+  std::map<std::vector<std::uint32_t>, std::uint32_t> m_termListIndexes;
+  // the nodes of the operands added so far whose expression is still being added
+  std::vector<std::uint32_t> m_operands;
+};
+
+ExpressionDag ExpressionDag::build(Expression const& expression) {
+  ExpressionDag dag;
+  Builder(dag).add(expression);
+  return dag;
+}
+
+double ExpressionDag::evaluate() const {
+  // most graphs fit in a small buffer, which avoids allocating on every evaluation
+  static size_t constexpr inlineValuesSize = 256;
+  std::array<double, inlineValuesSize> inlineValues;
+  std::vector<double> heapValues;
+  auto values = inlineValues.data();
+  if (m_nodes.size() > inlineValuesSize) {
+    heapValues.resize(m_nodes.size());
+    values = heapValues.data();
+  }
+
+  // holds the values of the terms of a sum which is not sequential, as they are added up all at once
+  std::vector<double> terms;
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    auto const& node = m_nodes[i];
+    switch (node.operation) {
+    case Operation::Constant:
+      values[i] = node.operand;
+      break;
+    case Operation::Variable:
+      values[i] = m_symbols->value(node.index);
+      break;
+    case Operation::Negate:
+      values[i] = -values[node.first];
+      break;
+    case Operation::Add:
+      values[i] = values[node.first] + values[node.second];
+      break;
+    case Operation::Subtract:
+      values[i] = values[node.first] - values[node.second];
+      break;
+    case Operation::Multiply:
+      values[i] = values[node.first] * values[node.second];
+      break;
+    case Operation::CheckDivisor:
+      Arithmetic::ensureValidDivisor(values[node.first]);
+      values[i] = values[node.first];
+      break;
+    case Operation::Divide:
+      values[i] = values[node.first] / values[node.second];
+      break;
+    case Operation::Power:
+      values[i] = Arithmetic::power(values[node.first], values[node.second]);
+      break;
+    case Operation::SquareRoot:
+      values[i] = Arithmetic::squareRoot(values[node.first]);
+      break;
+    case Operation::Logarithm:
+      values[i] = Arithmetic::logarithm(values[node.first], node.operand);
+      break;
+    case Operation::ConstantPower:
+      if (!Arithmetic::isValidPower(values[node.first], node.operand)) {
+        Arithmetic::throwInvalidPower(values[node.first], node.operand);
+      }
+      values[i] = ConstantPowerExpression::power(values[node.first], node.operand);
+      break;
+    case Operation::SpecialisedLogarithm:
+      if (!Arithmetic::isValidLogarithmArgument(values[node.first])) {
+        Arithmetic::throwInvalidLogarithm(values[node.first]);
+      }
+      values[i] = SpecialisedLogarithmExpression::logarithm(values[node.first], node.operand);
+      break;
+    case Operation::Polynomial: {
+      auto const& coefficients = m_polynomials[node.index];
+      values[i] = PolynomialExpression::valueAt(coefficients.data(), coefficients.size(), values[node.first]);
+      break;
+    }
+    case Operation::FusedMultiplyAdd:
+      values[i] = std::fma(values[node.first], values[node.second], values[node.index]);
+      break;
+    case Operation::PairwiseSum:
+    case Operation::CompensatedSum: {
+      terms.clear();
+      for (auto term: m_termLists[node.index]) {
+        terms.push_back(values[term]);
+      }
+      values[i] = node.operation == Operation::PairwiseSum ? Arithmetic::pairwiseSum(terms.data(), terms.size()) :
+                                                             Arithmetic::compensatedSum(terms.data(), terms.size());
+      break;
+    }
+    }
+  }
+  return values[m_nodes.size() - 1];
+}
+
+std::vector<ExpressionDag::Node> const& ExpressionDag::nodes() const {
+  return m_nodes;
+}
+
+std::vector<std::vector<double>> const& ExpressionDag::polynomials() const {
+  return m_polynomials;
+}
+
+std::vector<std::vector<std::uint32_t>> const& ExpressionDag::termLists() const {
+  return m_termLists;
+}
+
+size_t ExpressionDag::treeSize() const {
+  return m_treeSize;
+}
+
+std::shared_ptr<SymbolTable const> const& ExpressionDag::symbols() const {
+  return m_symbols;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef MATHTREE_EXPRESSIONDAG
+#define MATHTREE_EXPRESSIONDAG
+
+#include <cstdint>
+#include "Expression.hpp"
+#include <memory>
+#include "SymbolTable.hpp"
+#include <vector>
+
+namespace MathTree {
+
+/**
+ * Represents an expression tree in which structurally identical subexpressions are merged into
+ * a single node, turning the tree into a directed acyclic graph.
+ * Every node is identified by its operation, its operand and the nodes it operates on, so two
+ * subexpressions are merged when they have the same structure, regardless of where they appear.
+ * Evaluating the graph computes each distinct subexpression once, and gives the same results and
+ * throws the same errors as evaluating the tree it was built from.
+ **/
+class ExpressionDag {
+public:
+  /// Represents the operations performed by the nodes of the graph.
+  enum class Operation: std::uint8_t {
+    /// Results in the operand of the node.
+    Constant,
+    /// Results in the value of the variable whose index is stored in the node.
+    Variable,
+    /// Results in the negation of the first node.
+    Negate,
+    /// Results in the sum of the first and second node.
+    Add,
+    /// Results in the difference between the first and second node.
+    Subtract,
+    /// Results in the product of the first and second node.
+    Multiply,
+    /// Results in the value of the first node. Throws if that value is zero.
+    CheckDivisor,
+    /// Results in the first node divided by the second one, which is always a CheckDivisor node.
+    Divide,
+    /// Results in the first node raised to the power of the second one.
+    Power,
+    /// Results in the square root of the first node.
+    SquareRoot,
+    /// Results in the logarithm of the first node, using the operand of the node as base.
+    Logarithm,
+    /// Results in the first node raised to the operand of the node, computed as per ConstantPowerExpression.
+    ConstantPower,
+    /**
+     * Results in the logarithm of the first node, using the operand of the node as base,
+     * computed as per SpecialisedLogarithmExpression.
+     **/
+    SpecialisedLogarithm,
+    /**
+     * Results in the value at the first node of the polynomial whose index in polynomials() is stored
+     * in the node, computed as per PolynomialExpression.
+     **/
+    Polynomial,
+    /// Results in the product of the first and second node plus the node whose index is stored, rounded once.
+    FusedMultiplyAdd,
+    /**
+     * Results in the sum of the nodes of the list in termLists() whose index is stored in the node,
+     * added up as per Arithmetic::pairwiseSum.
+     **/
+    PairwiseSum,
+    /**
+     * Results in the sum of the nodes of the list in termLists() whose index is stored in the node,
+     * added up as per Arithmetic::compensatedSum.
+     **/
+    CompensatedSum
+  };
+
+  /**
+   * Represents a single operation, along with the nodes it operates on and its operand
+   * or the index of its variable, polynomial, addend or list of terms.
+   **/
+  struct Node {
+    Operation operation;
+    std::uint32_t index;
+    std::uint32_t first;
+    std::uint32_t second;
+    double operand;
+
+    /// Returns true if the two nodes perform the same operation on the same operands, false otherwise.
+    bool operator==(Node const& other) const;
+  };
+
+  /**
+   * Returns the graph obtained by merging the identical subexpressions of the given tree.
+   * The tree is traversed without recursion, so that graphs can be built from trees of any height.
+   * Throws if the tree contains expressions of unknown type, or variables that belong
+   * to different symbol tables.
+   **/
+  static ExpressionDag build(Expression const& expression);
+
+  /**
+   * Returns the real valued number obtained by evaluating the graph.
+   * Variables are read from the symbol table of the tree the graph was built from.
+   * Throws the same errors as the expression tree the graph was built from.
+   **/
+  double evaluate() const;
+  /**
+   * Returns the nodes of the graph, ordered so that every node comes after the ones it operates on.
+   * Nodes appear in the order in which the tree evaluates them for the first time, and the last one is the root.
+   **/
+  std::vector<Node> const& nodes() const;
+  /**
+   * Returns the coefficients of the polynomials the graph evaluates, each starting from the constant one.
+   * Polynomials with the same coefficients are stored once.
+   **/
+  std::vector<std::vector<double>> const& polynomials() const;
+  /**
+   * Returns the lists of the nodes added up by the sums whose terms are not added sequentially.
+   * Sums of the same nodes are given the same list.
+   **/
+  std::vector<std::vector<std::uint32_t>> const& termLists() const;
+  /// Returns the number of nodes of the tree the graph was built from.
+  size_t treeSize() const;
+  /// Returns the symbol table the variables of the graph are read from, or null if there are no variables.
+  std::shared_ptr<SymbolTable const> const& symbols() const;
+
+private:
+  class Builder;
+  ExpressionDag() = default;
+
+  std::vector<Node> m_nodes;
+  std::vector<std::vector<double>> m_polynomials;
+  std::vector<std::vector<std::uint32_t>> m_termLists;
+  size_t m_treeSize = 0;
+  std::shared_ptr<SymbolTable const> m_symbols;
+};
+
+}
+
+#endif // MATHTREE_EXPRESSIONDAG
\ No newline at end of file
@@ -12,37 +12,37 @@ int BinaryOperatorParselet::priority() const {
 
 std::unique_ptr<Expression> AdditionParselet::parse(AbstractPrattParser& parser,
                                                     std::unique_ptr<Expression> left,
-                                                    Token const& token) {
+                                                    Token const& token) const {
   auto right = parser.parse(priority());
-  return std::make_unique<AdditionExpression>(std::move(left), token.type(), std::move(right));
+  return allocateExpression<AdditionExpression>(parser.memoryResource(), std::move(left), token.type(), std::move(right));
 }
 
 std::unique_ptr<Expression> SubtractionParselet::parse(AbstractPrattParser& parser,
                                                        std::unique_ptr<Expression> left,
-                                                       Token const& token) {
+                                                       Token const& token) const {
   auto right = parser.parse(priority());
-  return std::make_unique<SubtractionExpression>(std::move(left), token.type(), std::move(right));
+  return allocateExpression<SubtractionExpression>(parser.memoryResource(), std::move(left), token.type(), std::move(right));
 }
 
 std::unique_ptr<Expression> MultiplicationParselet::parse(AbstractPrattParser& parser,
                                                           std::unique_ptr<Expression> left,
-                                                          Token const& token) {
+                                                          Token const& token) const {
   auto right = parser.parse(priority());
-  return std::make_unique<MultiplicationExpression>(std::move(left), token.type(), std::move(right));
+  return allocateExpression<MultiplicationExpression>(parser.memoryResource(), std::move(left), token.type(), std::move(right));
 }
 
 std::unique_ptr<Expression> DivisionParselet::parse(AbstractPrattParser& parser,
                                                     std::unique_ptr<Expression> left,
-                                                    Token const& token) {
+                                                    Token const& token) const {
   auto right = parser.parse(priority());
-  return std::make_unique<DivisionExpression>(std::move(left), token.type(), std::move(right));
+  return allocateExpression<DivisionExpression>(parser.memoryResource(), std::move(left), token.type(), std::move(right));
 }
 
 std::unique_ptr<Expression> ExponentiationParselet::parse(AbstractPrattParser& parser,
                                                           std::unique_ptr<Expression> left,
-                                                          Token const& token) {
+                                                          Token const& token) const {
   auto right = parser.parse(priority() - 1); // right associativity needs a lower priority
-  return std::make_unique<ExponentiationExpression>(std::move(left), token.type(), std::move(right));
+  return allocateExpression<ExponentiationExpression>(parser.memoryResource(), std::move(left), token.type(), std::move(right));
 }
 
 }
\ No newline at end of file
@@ -14,7 +14,7 @@ public:
   /// Constructs an expression tree from the left subexpression given, and using the token and parser provided.
   virtual std::unique_ptr<Expression> parse(AbstractPrattParser& parser,
                                             std::unique_ptr<Expression> left,
-                                            Token const& token) = 0;
+                                            Token const& token) const = 0;
   /// Returns the priority of the parselet.
   virtual int priority() const = 0;
 
@@ -42,7 +42,7 @@ public:
   //! @copydoc InfixParselet::parse(AbstractPrattParser&,std::unique_ptr<Expression>,Token const&)
   std::unique_ptr<Expression> parse(AbstractPrattParser& parser,
                                     std::unique_ptr<Expression> left,
-                                    Token const& token) override;
+                                    Token const& token) const override;
 };
 
 /// Represents a parselet that can parse subtractions.
@@ -52,7 +52,7 @@ public:
   //! @copydoc InfixParselet::parse(AbstractPrattParser&,std::unique_ptr<Expression>,Token const&)
   std::unique_ptr<Expression> parse(AbstractPrattParser& parser,
                                     std::unique_ptr<Expression> left,
-                                    Token const& token) override;
+                                    Token const& token) const override;
 };
 
 /// Represents a parselet that can parse multiplications.
@@ -62,7 +62,7 @@ public:
   //! @copydoc InfixParselet::parse(AbstractPrattParser&,std::unique_ptr<Expression>,Token const&)
   std::unique_ptr<Expression> parse(AbstractPrattParser& parser,
                                     std::unique_ptr<Expression> left,
-                                    Token const& token) override;
+                                    Token const& token) const override;
 };
 
 /// Represents a parselet that can parse divisions.
@@ -72,7 +72,7 @@ public:
   //! @copydoc InfixParselet::parse(AbstractPrattParser&,std::unique_ptr<Expression>,Token const&)
   std::unique_ptr<Expression> parse(AbstractPrattParser& parser,
                                     std::unique_ptr<Expression> left,
-                                    Token const& token) override;
+                                    Token const& token) const override;
 };
 
 /// Represents a parselet that can parse exponentiations.
@@ -82,7 +82,7 @@ public:
   //! @copydoc InfixParselet::parse(AbstractPrattParser&,std::unique_ptr<Expression>,Token const&)
   std::unique_ptr<Expression> parse(AbstractPrattParser& parser,
                                     std::unique_ptr<Expression> left,
-                                    Token const& token) override;
+                                    Token const& token) const override;
 };
 
 }
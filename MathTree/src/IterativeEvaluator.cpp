@@ -0,0 +1,75 @@
+#include "IterativeEvaluator.hpp"
+
+namespace MathTree {
+
+template<typename RecursiveEvaluation, typename StepEvaluation>
+EvaluationResult IterativeEvaluator::evaluateIteratively(Expression const& expression,
+                                                         RecursiveEvaluation evaluateRecursively,
+                                                         StepEvaluation evaluateStep) {
+  // an evaluation interrupted by an error may have left frames and results behind
+  m_frames.clear();
+  m_results.clear();
+
+  // holds a value until a step reports an error
+  EvaluationResult error = 0.0;
+  auto next = &expression;
+  while (true) {
+    // descends until an expression pushes its result instead of returning a subexpression, so that
+    // shallow subtrees and cached results never need a frame
+    while (next != nullptr) {
+      if (next->height() <= Expression::maxRecursionHeight) {
+        auto const result = evaluateRecursively(*next);
+        if (!result) {
+          return result;
+        }
+        m_results.push_back(result.value());
+        break;
+      }
+      auto subexpression = evaluateStep(*next, 0, m_results, error);
+      if (!error) {
+        return error;
+      } else if (subexpression != nullptr) {
+        m_frames.emplace_back(next, 1);
+      }
+      next = subexpression;
+    }
+    if (m_frames.empty()) {
+      return m_results.back();
+    }
+
+    auto& frame = m_frames.back();
+    next = evaluateStep(*frame.expression, frame.step++, m_results, error);
+    if (!error) {
+      return error;
+    } else if (next == nullptr) {
+      m_frames.pop_back();
+    }
+  }
+}
+
+double IterativeEvaluator::evaluate(Expression const& expression) {
+  return evaluateWith<EvaluationPolicy::Checked>(expression);
+}
+
+template<typename Policy>
+double IterativeEvaluator::evaluateWith(Expression const& expression) {
+  // the policies report errors by throwing or not at all, so the result always holds a value
+  return evaluateIteratively(expression, [](Expression const& subtree) -> EvaluationResult {
+    return subtree.evaluateWith<Policy>();
+  }, [](Expression const& subtree, size_t step, std::vector<double>& results, EvaluationResult&) {
+    return subtree.evaluateStepWith<Policy>(step, results);
+  }).value();
+}
+template double IterativeEvaluator::evaluateWith<EvaluationPolicy::Checked>(Expression const&);
+template double IterativeEvaluator::evaluateWith<EvaluationPolicy::Propagating>(Expression const&);
+template double IterativeEvaluator::evaluateWith<EvaluationPolicy::Unchecked>(Expression const&);
+
+EvaluationResult IterativeEvaluator::tryEvaluate(Expression const& expression) {
+  return evaluateIteratively(expression, [](Expression const& subtree) {
+    return subtree.tryEvaluate();
+  }, [](Expression const& subtree, size_t step, std::vector<double>& results, EvaluationResult& error) {
+    return subtree.tryEvaluateStep(step, results, error);
+  });
+}
+
+}
@@ -0,0 +1,57 @@
+#ifndef MATHTREE_ITERATIVEEVALUATOR
+#define MATHTREE_ITERATIVEEVALUATOR
+
+#include "Expression.hpp"
+#include <vector>
+
+namespace MathTree {
+
+/**
+ * Evaluates expressions by keeping the subexpressions left to evaluate and their intermediate results on stacks
+ * allocated from the heap. Only subtrees no higher than Expression::maxRecursionHeight are evaluated by recursing,
+ * so trees of any depth can be evaluated in bounded call stack space, with the same results, caching and errors
+ * as the recursive evaluations of Expression.
+ * The stacks are kept between evaluations, so an evaluator stops allocating once they grew large enough.
+ * An evaluator must not be used by many threads at once, but many evaluators can share the same tree.
+ **/
+class IterativeEvaluator {
+public:
+  /// Returns the result of the expression provided.
+  double evaluate(Expression const& expression);
+  /**
+   * Returns the result of the expression provided, or the error that prevented computing it, without throwing.
+   * The result is the one Expression::tryEvaluate() returns, and the evaluation stops at the first error.
+   **/
+  EvaluationResult tryEvaluate(Expression const& expression);
+  /**
+   * Returns the result of the expression provided computed as per the policy given, among those of EvaluationPolicy,
+   * which is chosen at compile time. The result is the one Expression::evaluateWith returns.
+   **/
+  template<typename Policy>
+  double evaluateWith(Expression const& expression);
+
+private:
+  /// Represents an expression being evaluated, and the step of its evaluation to perform next.
+  struct Frame {
+    Frame(Expression const* expression, size_t step): expression(expression), step(step) {}
+
+    Expression const* expression;
+    size_t step;
+  };
+
+  /**
+   * Evaluates the expression provided, evaluating the subtrees no higher than Expression::maxRecursionHeight with
+   * the first function given, and performing the steps of the others with the second. Stops at the first error
+   * returned by the first function or reported by a step.
+   **/
+  template<typename RecursiveEvaluation, typename StepEvaluation>
+  EvaluationResult evaluateIteratively(Expression const& expression, RecursiveEvaluation evaluateRecursively,
+                                       StepEvaluation evaluateStep);
+
+  std::vector<Frame> m_frames;
+  std::vector<double> m_results;
+};
+
+}
+
+#endif // MATHTREE_ITERATIVEEVALUATOR
@@ -1,35 +1,115 @@
-#include <cmath>
+#include <array>
 #include "Lexer.hpp"
+#include <optional>
+#include "Scanning.hpp"
 #include <stdexcept>
-#include "Utils.hpp"
+#include <string>
+#include "TokenMatchers.hpp"
 
 namespace MathTree {
 
-auto constexpr symbolsList = {TokenType::Plus, TokenType::Minus,
-                                    TokenType::Slash, TokenType::Asterisk,
-                                    TokenType::Caret, TokenType::SquareRoot,
-                                    TokenType::OpeningBracket, TokenType::ClosingBracket};
+auto constexpr operatorsList = {TokenType::Plus, TokenType::Minus,
+                                TokenType::Slash, TokenType::Asterisk,
+                                TokenType::Caret, TokenType::OpeningBracket,
+                                TokenType::ClosingBracket};
+auto constexpr functionsList = {TokenType::SquareRoot, TokenType::Log};
 
-ArithmeticLexer::ArithmeticLexer(): ArithmeticLexer("") {}
+namespace {
+/// Represents what a token starting with a given character can be.
+enum class CharacterClass: unsigned char {
+  Invalid,
+  Space,
+  Operator,
+  Number,
+  Identifier,
+  FunctionOrIdentifier
+};
+
+struct CharacterEntry {
+  CharacterClass characterClass = CharacterClass::Invalid;
+  // the type of the token made of this character alone, when it is an operator
+  TokenType operatorType = TokenType::Stop;
+};
+
+// the matchers and the character table are only ever read, so they are shared by all lexers
+struct ArithmeticScanners {
+  ArithmeticScanners() {
+    for (int i = 0; i < characterCount; ++i) {
+      auto const c = static_cast<char>(i);
+      if (Scanning::isSpace(c)) {
+        characters[i].characterClass = CharacterClass::Space;
+      } else if (Scanning::isDigit(c) || c == '.') {
+        characters[i].characterClass = CharacterClass::Number;
+      } else if (Scanning::isLetter(c) || c == '_') {
+        characters[i].characterClass = CharacterClass::Identifier;
+      }
+    }
+    for (auto const& type: operatorsList) {
+      auto const symbol = symboliseTokenType(type);
+      if (symbol.size() != 1) {
+        throw std::logic_error("The symbol of an operator must be a single character.");
+      }
+      characters[static_cast<unsigned char>(symbol.front())] = {CharacterClass::Operator, type};
+    }
+    // any other letter can only start an identifier, which saves matching the functions
+    for (auto const& type: functionsList) {
+      characters[static_cast<unsigned char>(symboliseTokenType(type).front())].characterClass =
+                                                                              CharacterClass::FunctionOrIdentifier;
+    }
+  }
+
+  static int constexpr characterCount = 256;
+  std::array<CharacterEntry, characterCount> characters{};
+  SymbolMatcher squareRootMatcher{TokenType::SquareRoot};
+  LogarithmMatcher logMatcher;
+  UnsignedNumberMatcher numberMatcher;
+  IdentifierMatcher identifierMatcher;
+};
 
-ArithmeticLexer::ArithmeticLexer(std::string text): m_text(std::move(text)) {
-  m_matchers.reserve(2);
-  m_matchers.push_back(std::make_unique<SymbolMatcher>(symbolsList));
-  m_matchers.push_back(std::make_unique<UnsignedNumberMatcher>());
-  m_matchers.push_back(std::make_unique<LogarithmMatcher>());
+ArithmeticScanners const& arithmeticScanners() {
+  static ArithmeticScanners const scanners;
+  return scanners;
 }
+}
+
+ArithmeticLexer::ArithmeticLexer(): ArithmeticLexer("") {}
+
+ArithmeticLexer::ArithmeticLexer(std::string_view text): m_text(text) {}
 
 Token ArithmeticLexer::next() {
+  auto const& scanners = arithmeticScanners();
   while (m_currentIndex < m_text.length()) {
-    for (auto const& matcher: m_matchers) {
-      if (auto tokenOpt = matcher->match(m_text, m_currentIndex)) {
-        m_currentIndex += tokenOpt->text().size();
-        return *tokenOpt;
+    auto const& entry = scanners.characters[static_cast<unsigned char>(m_text[m_currentIndex])];
+    std::optional<Token> tokenOpt;
+    switch (entry.characterClass) {
+    case CharacterClass::Space:
+      m_currentIndex = Scanning::skipSpaces(m_text, m_currentIndex);
+      continue;
+    case CharacterClass::Operator:
+      tokenOpt = Token{entry.operatorType, m_text.substr(m_currentIndex, 1)};
+      break;
+    case CharacterClass::Number:
+      tokenOpt = scanners.numberMatcher.match(m_text, m_currentIndex);
+      break;
+    case CharacterClass::Identifier:
+      tokenOpt = Token{TokenType::Variable,
+                       m_text.substr(m_currentIndex, IdentifierMatcher::identifierLength(m_text, m_currentIndex))};
+      break;
+    case CharacterClass::FunctionOrIdentifier:
+      if (auto squareRootOpt = scanners.squareRootMatcher.match(m_text, m_currentIndex)) {
+        tokenOpt = squareRootOpt;
+      } else if (auto logOpt = scanners.logMatcher.match(m_text, m_currentIndex)) {
+        tokenOpt = logOpt;
+      } else {
+        tokenOpt = scanners.identifierMatcher.match(m_text, m_currentIndex);
       }
+      break;
+    case CharacterClass::Invalid:
+      break;
     }
-    if (std::isspace(m_text[m_currentIndex])) {
-      ++m_currentIndex;
-      continue;
+    if (tokenOpt) {
+      m_currentIndex += tokenOpt->text().size();
+      return *tokenOpt;
     }
     throw std::logic_error("Lexer could not extract token at index " +
                                    std::to_string(m_currentIndex) + ".");
@@ -37,8 +117,8 @@ Token ArithmeticLexer::next() {
   return {TokenType::Stop, ""};
 }
 
-void ArithmeticLexer::reset(std::string newText) {
-  m_text = std::move(newText);
+void ArithmeticLexer::reset(std::string_view newText) {
+  m_text = newText;
   reset();
 }
 
@@ -1,12 +1,8 @@
 #ifndef MATHTREE_LEXER
 #define MATHTREE_LEXER
 
-#include <memory>
-#include <string>
+#include <string_view>
 #include "Token.hpp"
-#include "TokenMatchers.hpp"
-#include <unordered_map>
-#include <vector>
 
 namespace MathTree {
 
@@ -17,32 +13,39 @@ public:
   virtual Token next() = 0;
   /// Resets the lexer to its initial state.
   virtual void reset() = 0;
-  /// Resets the lexer to point to the beginning of the given string.
-  virtual void reset(std::string) = 0;
+  /// Resets the lexer to point to the beginning of the given string, which must outlive the lexer.
+  virtual void reset(std::string_view) = 0;
 
   Lexer& operator=(Lexer const&) = delete;
   Lexer& operator=(Lexer&&) = delete;
   virtual ~Lexer() = default;
 };
 
-/// Represents a lexer which can tokenise an arithmetic expression in string form.
+/**
+ * Represents a lexer which can tokenise an arithmetic expression in string form.
+ * The matchers recognising each token are shared by all lexers, and the lexer
+ * only holds a view of its input, so that a lexer can be constructed for every
+ * input at no cost. The tokens are views into the input, so lexing never allocates.
+ * The first character of a token is looked up in a table of character classes, which
+ * selects the only matcher that can recognise it, so the cost of lexing a character
+ * does not grow with the number of operators.
+ **/
 class ArithmeticLexer: public Lexer {
 public:
   /// Constructs a lexer with an empty string.
   ArithmeticLexer();
-  /// Constructs a lexer with the given string.
-  ArithmeticLexer(std::string text);
+  /// Constructs a lexer with the given string, which must outlive the lexer.
+  ArithmeticLexer(std::string_view text);
   //! @copydoc Lexer::next()
   Token next() override;
-  //! @copydoc Lexer::reset(std::string)
-  void reset(std::string newText) override;
+  //! @copydoc Lexer::reset(std::string_view)
+  void reset(std::string_view newText) override;
   //! @copydoc Lexer::reset()
   void reset() override;
 
 private:
-  std::string m_text;
+  std::string_view m_text;
   size_t m_currentIndex = 0;
-  std::vector<std::unique_ptr<TokenMatcher>> m_matchers;
 };
 
 }
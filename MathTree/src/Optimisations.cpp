@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <cmath>
+#include "IterativeEvaluator.hpp"
+#include "Optimisations.hpp"
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace MathTree {
+
+namespace {
+
+size_t countNodes(Expression const& expression) {
+  size_t count = 0;
+  std::vector<Expression const*> pending{&expression};
+  while (!pending.empty()) {
+    auto const current = pending.back();
+    pending.pop_back();
+    ++count;
+    for (size_t i = 0; i < current->subexpressionCount(); ++i) {
+      pending.push_back(&current->subexpression(i));
+    }
+  }
+  return count;
+}
+
+// returns the expressions of the tree which have subexpressions, each of them before its subexpressions
+std::vector<Expression*> parentsFirst(Expression& tree) {
+  std::vector<Expression*> parents;
+  if (tree.subexpressionCount() > 0) {
+    parents.push_back(&tree);
+  }
+  for (size_t i = 0; i < parents.size(); ++i) {
+    parents[i]->transformSubexpressions([&parents](std::unique_ptr<Expression> subexpression) {
+      if (subexpression->subexpressionCount() > 0) {
+        parents.push_back(subexpression.get());
+      }
+      return subexpression;
+    });
+  }
+  return parents;
+}
+
+/**
+ * Replaces every expression of the tree with its rewriting, subexpressions before the expressions containing them,
+ * without recursing whatever the height of the tree. The subexpressions are rewritten through the expressions
+ * containing them, children first, so that the height of every expression is updated once those of its
+ * subexpressions are final.
+ **/
+std::unique_ptr<Expression> rewriteBottomUp(std::unique_ptr<Expression> tree,
+                                            Expression::Transformation const& rewriting) {
+  auto const parents = parentsFirst(*tree);
+  for (auto parent = parents.rbegin(); parent != parents.rend(); ++parent) {
+    (*parent)->transformSubexpressions(rewriting);
+  }
+  return rewriting(std::move(tree));
+}
+
+/**
+ * Collapses the expression into a real number if it is constant, its subexpressions being folded already, so that
+ * each constant expression is evaluated from numbers only, and is not evaluated at all once one of its
+ * subexpressions failed to be collapsed.
+ **/
+std::unique_ptr<Expression> fold(std::unique_ptr<Expression> expression,
+                                 std::pmr::memory_resource& resource,
+                                 size_t& removedNodes) {
+  if (!expression->isConstant() || expression->subexpressionCount() == 0) {
+    return expression;
+  }
+  for (size_t i = 0; i < expression->subexpressionCount(); ++i) {
+    // a constant subexpression which is left with subexpressions failed to be collapsed, which makes every
+    // constant expression above it fail as well
+    if (expression->subexpression(i).subexpressionCount() > 0) {
+      return expression;
+    }
+  }
+
+  try {
+    auto const result = expression->evaluate();
+    if (std::isfinite(result)) {
+      removedNodes += countNodes(*expression) - 1;
+      return allocateExpression<RealNumberExpression>(resource, result);
+    }
+  } catch (std::domain_error const&) {
+    // the error is left to be thrown by the evaluation of the tree
+  }
+  return expression;
+}
+
+enum class ChainKind {
+  None,
+  Sum,
+  Product
+};
+
+ChainKind chainKindOf(Expression const& expression) {
+  if (dynamic_cast<AdditionExpression const*>(&expression) || dynamic_cast<SubtractionExpression const*>(&expression)) {
+    return ChainKind::Sum;
+  } else if (dynamic_cast<MultiplicationExpression const*>(&expression)) {
+    return ChainKind::Product;
+  }
+  return ChainKind::None;
+}
+
+// merges the chain at the top of the expression given into a single n-ary node, leaving its operands as they are
+std::unique_ptr<Expression> flattenChain(std::unique_ptr<Expression> expression,
+                                         SummationMode mode,
+                                         std::pmr::memory_resource& resource,
+                                         size_t& removedNodes) {
+  auto const kind = chainKindOf(*expression);
+  if (kind == ChainKind::None) {
+    return expression;
+  }
+
+  // walks down the left operands of the chain, collecting the right ones from last to first
+  Expression::ExpressionList operands(&resource);
+  std::vector<bool> isSubtracted;
+  Expression::ExpressionList released(&resource);
+  size_t links = 0;
+  while (chainKindOf(*expression) == kind) {
+    isSubtracted.push_back(dynamic_cast<SubtractionExpression const*>(expression.get()) != nullptr);
+    released.clear();
+    expression->releaseSubexpressions(released);
+    operands.push_back(std::move(released.back()));
+    expression = std::move(released.front());
+    ++links;
+  }
+  operands.push_back(std::move(expression));
+  isSubtracted.push_back(false);
+  std::reverse(operands.begin(), operands.end());
+  std::reverse(isSubtracted.begin(), isSubtracted.end());
+  // the chain made of n operations is replaced by a single node
+  removedNodes += links - 1;
+
+  if (kind == ChainKind::Product) {
+    return allocateExpression<ProductExpression>(resource, std::move(operands));
+  }
+  SumExpression::TermList terms(&resource);
+  terms.reserve(operands.size());
+  for (size_t i = 0; i < operands.size(); ++i) {
+    terms.push_back({std::move(operands[i]), isSubtracted[i]});
+  }
+  return allocateExpression<SumExpression>(resource, std::move(terms), mode);
+}
+
+std::unique_ptr<Expression> flatten(std::unique_ptr<Expression> tree,
+                                    SummationMode mode,
+                                    std::pmr::memory_resource& resource,
+                                    size_t& removedNodes) {
+  // the chains are merged from the top down, the operands of every expression having their own chains merged in turn
+  tree = flattenChain(std::move(tree), mode, resource, removedNodes);
+  std::vector<Expression*> pending{tree.get()};
+  while (!pending.empty()) {
+    auto const expression = pending.back();
+    pending.pop_back();
+    expression->transformSubexpressions([&](std::unique_ptr<Expression> subexpression) {
+      subexpression = flattenChain(std::move(subexpression), mode, resource, removedNodes);
+      if (subexpression->subexpressionCount() > 0) {
+        pending.push_back(subexpression.get());
+      }
+      return subexpression;
+    });
+  }
+
+  // merging a chain lowers the expressions above it, whose heights are updated once those of the chains are final
+  return rewriteBottomUp(std::move(tree), [](std::unique_ptr<Expression> expression) {
+    return expression;
+  });
+}
+
+std::unique_ptr<Expression> reduce(std::unique_ptr<Expression> expression,
+                                   std::pmr::memory_resource& resource,
+                                   size_t& removedNodes) {
+  if (auto power = dynamic_cast<ExponentiationExpression const*>(expression.get())) {
+    auto const exponent = dynamic_cast<RealNumberExpression const*>(&power->right());
+    if (exponent == nullptr || !ConstantPowerExpression::isReducible(exponent->evaluate())) {
+      return expression;
+    }
+    auto const value = exponent->evaluate();
+    Expression::ExpressionList released(&resource);
+    expression->releaseSubexpressions(released);
+    // the exponent is stored in the power rather than in a node of its own
+    ++removedNodes;
+    return allocateExpression<ConstantPowerExpression>(resource, std::move(released.front()), value);
+  } else if (auto logarithm = dynamic_cast<LogarithmExpression const*>(expression.get())) {
+    auto const base = logarithm->base();
+    auto const tokenType = logarithm->tokenType();
+    Expression::ExpressionList released(&resource);
+    expression->releaseSubexpressions(released);
+    return allocateExpression<SpecialisedLogarithmExpression>(resource, std::move(released.front()), base, tokenType);
+  }
+  return expression;
+}
+
+std::unique_ptr<Expression> contract(std::unique_ptr<Expression> expression,
+                                     MultiplyAddRounding rounding,
+                                     std::pmr::memory_resource& resource,
+                                     size_t& removedNodes) {
+  auto const isAddition = dynamic_cast<AdditionExpression const*>(expression.get()) != nullptr;
+  auto const isSubtraction = dynamic_cast<SubtractionExpression const*>(expression.get()) != nullptr;
+  if (!isAddition && !isSubtraction) {
+    return expression;
+  }
+  auto const& binary = static_cast<BinaryExpression const&>(*expression);
+  // a product on the left is preferred, so that a*b+c*d contracts the first product
+  auto const isProductFirst = dynamic_cast<MultiplicationExpression const*>(&binary.left()) != nullptr;
+  if (!isProductFirst && dynamic_cast<MultiplicationExpression const*>(&binary.right()) == nullptr) {
+    return expression;
+  }
+
+  Expression::ExpressionList operands(&resource);
+  expression->releaseSubexpressions(operands);
+  auto& product = isProductFirst ? operands[0] : operands[1];
+  auto addend = std::move(isProductFirst ? operands[1] : operands[0]);
+  Expression::ExpressionList factors(&resource);
+  product->releaseSubexpressions(factors);
+  using Pattern = FmaExpression::Pattern;
+  auto const pattern = isProductFirst ? (isAddition ? Pattern::ProductPlusAddend : Pattern::ProductMinusAddend) :
+                                        (isAddition ? Pattern::AddendPlusProduct : Pattern::AddendMinusProduct);
+  ++removedNodes;
+  return allocateExpression<FmaExpression>(resource, std::move(factors[0]), std::move(factors[1]), std::move(addend),
+                                           pattern, rounding);
+}
+
+// Represents the polynomial computed by a subtree, together with the variable it is a polynomial of, if any.
+struct Polynomial {
+  // the coefficients, starting from the constant one
+  std::vector<double> coefficients;
+  VariableExpression const* variable = nullptr;
+
+  size_t degree() const {
+    return coefficients.size() - 1;
+  }
+
+  bool isMonomial() const {
+    return std::count_if(coefficients.begin(), coefficients.end(), [](double coefficient) {
+      return coefficient != 0.0;
+    }) <= 1;
+  }
+};
+
+// returns true if both polynomials are of the same variable, or if either of them does not depend on any variable
+bool haveSameVariable(Polynomial const& left, Polynomial const& right) {
+  return left.variable == nullptr || right.variable == nullptr ||
+         (left.variable->symbols() == right.variable->symbols() && left.variable->index() == right.variable->index());
+}
+
+std::optional<Polynomial> add(Polynomial left, Polynomial const& right, bool isSubtracted) {
+  if (!haveSameVariable(left, right)) {
+    return std::nullopt;
+  }
+  left.variable = left.variable != nullptr ? left.variable : right.variable;
+  left.coefficients.resize(std::max(left.coefficients.size(), right.coefficients.size()), 0.0);
+  for (size_t i = 0; i < right.coefficients.size(); ++i) {
+    left.coefficients[i] += isSubtracted ? -right.coefficients[i] : right.coefficients[i];
+  }
+  // terms which cancel each other out do not count towards the degree
+  while (left.coefficients.size() > 1 && left.coefficients.back() == 0.0) {
+    left.coefficients.pop_back();
+  }
+  return left;
+}
+
+std::optional<Polynomial> multiply(Polynomial const& left, Polynomial const& right) {
+  // only products distributing a monomial are expanded, as expanding products of sums may lose accuracy
+  if (!haveSameVariable(left, right) || !(left.isMonomial() || right.isMonomial()) ||
+      left.degree() + right.degree() > PolynomialExpression::maxDegree) {
+    return std::nullopt;
+  }
+  Polynomial product{std::vector<double>(left.degree() + right.degree() + 1, 0.0),
+                     left.variable != nullptr ? left.variable : right.variable};
+  for (size_t i = 0; i < left.coefficients.size(); ++i) {
+    for (size_t j = 0; j < right.coefficients.size(); ++j) {
+      product.coefficients[i + j] += left.coefficients[i] * right.coefficients[j];
+    }
+  }
+  return product;
+}
+
+std::optional<Polynomial> divide(Polynomial dividend, Polynomial const& divisor) {
+  // only divisions by non-zero constants are polynomials, which keeps divisions by zero in the tree
+  if (divisor.variable != nullptr || divisor.degree() != 0 || divisor.coefficients.front() == 0.0) {
+    return std::nullopt;
+  }
+  for (auto& coefficient: dividend.coefficients) {
+    coefficient /= divisor.coefficients.front();
+  }
+  return dividend;
+}
+
+std::optional<Polynomial> power(Polynomial const& base, double exponent) {
+  // only positive integer powers of monomials are polynomials, and 0^0 is left to throw
+  if (!base.isMonomial() || exponent < 1 || std::floor(exponent) != exponent ||
+      base.degree() * exponent > PolynomialExpression::maxDegree) {
+    return std::nullopt;
+  }
+  auto const degree = base.degree() * static_cast<size_t>(exponent);
+  Polynomial result{std::vector<double>(degree + 1, 0.0), base.variable};
+  result.coefficients.back() = std::pow(base.coefficients.back(), exponent);
+  return result;
+}
+
+std::optional<Polynomial> power(Polynomial const& base, Polynomial const& exponent) {
+  if (exponent.variable != nullptr || exponent.degree() != 0) {
+    return std::nullopt;
+  }
+  return power(base, exponent.coefficients.front());
+}
+
+// Replaces the largest subtrees computing a polynomial of a single variable with a PolynomialExpression.
+class PolynomialRecogniser {
+public:
+  PolynomialRecogniser(std::pmr::memory_resource& resource, size_t& removedNodes):
+                         m_resource(resource), m_removedNodes(removedNodes) {}
+
+  /**
+   * Computes the polynomial of every expression which is not constant, subexpressions first, and replaces the
+   * polynomials among the subexpressions of those which are not polynomials. The subexpressions of a polynomial are
+   * left to the expression which contains it. The tree is walked without recursing, whatever its height.
+   **/
+  std::unique_ptr<Expression> recognise(std::unique_ptr<Expression> tree) {
+    auto const parents = parentsFirst(*tree);
+    for (auto parent = parents.rbegin(); parent != parents.rend(); ++parent) {
+      auto& expression = **parent;
+      if (expression.isConstant()) {
+        continue;
+      }
+      std::vector<std::optional<Polynomial>> operands;
+      for (size_t i = 0; i < expression.subexpressionCount(); ++i) {
+        operands.push_back(polynomialOf(expression.subexpression(i)));
+      }
+      auto polynomial = combine(expression, operands);
+      if (!polynomial) {
+        size_t i = 0;
+        expression.transformSubexpressions([this, &operands, &i](std::unique_ptr<Expression> subexpression) {
+          auto const& operand = operands[i++];
+          return operand ? replace(std::move(subexpression), *operand) : std::move(subexpression);
+        });
+      }
+      // the polynomials of the subexpressions are no longer needed once the expression is analysed
+      for (size_t i = 0; i < expression.subexpressionCount(); ++i) {
+        m_polynomials.erase(&expression.subexpression(i));
+      }
+      m_polynomials.emplace(&expression, std::move(polynomial));
+    }
+
+    auto const polynomial = polynomialOf(*tree);
+    return polynomial ? replace(std::move(tree), *polynomial) : std::move(tree);
+  }
+
+private:
+  // returns the polynomial computed by the expression, whose subexpressions are analysed already
+  std::optional<Polynomial> polynomialOf(Expression const& expression) const {
+    if (expression.isConstant()) {
+      // the constant subtree is evaluated without recursing, as it may be of any height
+      auto const value = IterativeEvaluator().tryEvaluate(expression);
+      if (value && std::isfinite(value.value())) {
+        return Polynomial{{value.value()}, nullptr};
+      }
+      // the error is left to be thrown by the evaluation of the tree
+      return std::nullopt;
+    } else if (expression.subexpressionCount() == 0) {
+      return combine(expression, {});
+    }
+    auto const it = m_polynomials.find(&expression);
+    return it != m_polynomials.end() ? it->second : std::nullopt;
+  }
+
+  static std::optional<Polynomial> combine(Expression const& expression,
+                                           std::vector<std::optional<Polynomial>> const& operands) {
+    if (auto variable = dynamic_cast<VariableExpression const*>(&expression)) {
+      return Polynomial{{0.0, 1.0}, variable};
+    } else if (operands.empty() || std::any_of(operands.begin(), operands.end(), [](auto const& operand) {
+                 return !operand;
+               })) {
+      return std::nullopt;
+    }
+
+    if (dynamic_cast<NegativeSignExpression const*>(&expression)) {
+      return add(Polynomial{{0.0}, nullptr}, *operands[0], true);
+    } else if (dynamic_cast<AdditionExpression const*>(&expression)) {
+      return add(*operands[0], *operands[1], false);
+    } else if (dynamic_cast<SubtractionExpression const*>(&expression)) {
+      return add(*operands[0], *operands[1], true);
+    } else if (dynamic_cast<MultiplicationExpression const*>(&expression)) {
+      return multiply(*operands[0], *operands[1]);
+    } else if (dynamic_cast<DivisionExpression const*>(&expression)) {
+      return divide(*operands[0], *operands[1]);
+    } else if (dynamic_cast<ExponentiationExpression const*>(&expression)) {
+      return power(*operands[0], *operands[1]);
+    } else if (auto constantPower = dynamic_cast<ConstantPowerExpression const*>(&expression)) {
+      return power(*operands[0], constantPower->exponent());
+    } else if (auto sum = dynamic_cast<SumExpression const*>(&expression)) {
+      std::optional<Polynomial> result = Polynomial{{0.0}, nullptr};
+      for (size_t i = 0; i < operands.size() && result; ++i) {
+        result = add(*result, *operands[i], sum->isSubtracted(i));
+      }
+      return result;
+    } else if (dynamic_cast<ProductExpression const*>(&expression)) {
+      auto result = operands[0];
+      for (size_t i = 1; i < operands.size() && result; ++i) {
+        result = multiply(*result, *operands[i]);
+      }
+      return result;
+    }
+    return std::nullopt;
+  }
+
+  // replaces the expression with the polynomial it computes, if it is worth it
+  std::unique_ptr<Expression> replace(std::unique_ptr<Expression> expression, Polynomial const& polynomial) {
+    if (polynomial.variable == nullptr || polynomial.degree() < 2 ||
+        !std::all_of(polynomial.coefficients.begin(), polynomial.coefficients.end(), [](double coefficient) {
+          return std::isfinite(coefficient);
+        })) {
+      return expression;
+    }
+
+    // the subtree is replaced by the polynomial and its variable
+    m_removedNodes += countNodes(*expression) - 2;
+    PolynomialExpression::Coefficients coefficients(polynomial.coefficients.begin(), polynomial.coefficients.end(),
+                                                    &m_resource);
+    auto variable = allocateExpression<VariableExpression>(m_resource, polynomial.variable->symbols(),
+                                                           polynomial.variable->index());
+    return allocateExpression<PolynomialExpression>(m_resource, std::move(variable), std::move(coefficients));
+  }
+
+  std::pmr::memory_resource& m_resource;
+  size_t& m_removedNodes;
+  // the polynomials of the expressions analysed whose containing expression is yet to be
+  std::unordered_map<Expression const*, std::optional<Polynomial>> m_polynomials;
+};
+// wraps the expression given in a MemoisedExpression if it is constant and keeping its result saves evaluating it
+std::unique_ptr<Expression> memoise(std::unique_ptr<Expression> expression, std::pmr::memory_resource& resource) {
+  // expressions without subexpressions, such as real numbers, are as cheap to evaluate as a memoised result
+  if (!expression->isConstant() || expression->subexpressionCount() == 0 ||
+      dynamic_cast<MemoisedExpression const*>(expression.get())) {
+    return expression;
+  }
+  return allocateExpression<MemoisedExpression>(resource, std::move(expression));
+}
+
+}
+
+OptimisationResult foldConstants(std::unique_ptr<Expression> tree, std::pmr::memory_resource& resource) {
+  if (tree == nullptr) {
+    throw std::logic_error("Cannot fold the constants of an empty tree.");
+  }
+  OptimisationResult result;
+  result.tree = rewriteBottomUp(std::move(tree), [&resource, &result](std::unique_ptr<Expression> expression) {
+    return fold(std::move(expression), resource, result.removedNodes);
+  });
+  return result;
+}
+
+OptimisationResult flattenAssociativeChains(std::unique_ptr<Expression> tree,
+                                            SummationMode mode,
+                                            std::pmr::memory_resource& resource) {
+  if (tree == nullptr) {
+    throw std::logic_error("Cannot flatten the chains of an empty tree.");
+  }
+  OptimisationResult result;
+  result.tree = flatten(std::move(tree), mode, resource, result.removedNodes);
+  return result;
+}
+
+OptimisationResult reduceStrength(std::unique_ptr<Expression> tree, std::pmr::memory_resource& resource) {
+  if (tree == nullptr) {
+    throw std::logic_error("Cannot reduce the strength of the operations of an empty tree.");
+  }
+  OptimisationResult result;
+  result.tree = rewriteBottomUp(std::move(tree), [&resource, &result](std::unique_ptr<Expression> expression) {
+    return reduce(std::move(expression), resource, result.removedNodes);
+  });
+  return result;
+}
+
+OptimisationResult recognisePolynomials(std::unique_ptr<Expression> tree, std::pmr::memory_resource& resource) {
+  if (tree == nullptr) {
+    throw std::logic_error("Cannot recognise the polynomials of an empty tree.");
+  }
+  OptimisationResult result;
+  result.tree = PolynomialRecogniser(resource, result.removedNodes).recognise(std::move(tree));
+  return result;
+}
+
+OptimisationResult contractMultiplyAdds(std::unique_ptr<Expression> tree,
+                                        MultiplyAddRounding rounding,
+                                        std::pmr::memory_resource& resource) {
+  if (tree == nullptr) {
+    throw std::logic_error("Cannot contract the multiply-adds of an empty tree.");
+  }
+  OptimisationResult result;
+  result.tree = rewriteBottomUp(std::move(tree), [rounding, &resource, &result](std::unique_ptr<Expression> expression) {
+    return contract(std::move(expression), rounding, resource, result.removedNodes);
+  });
+  return result;
+}
+
+OptimisationResult memoiseConstantSubtrees(std::unique_ptr<Expression> tree, std::pmr::memory_resource& resource) {
+  if (tree == nullptr) {
+    throw std::logic_error("Cannot memoise the constant subtrees of an empty tree.");
+  }
+  OptimisationResult result;
+  if (tree->isConstant()) {
+    result.tree = memoise(std::move(tree), resource);
+    return result;
+  }
+
+  // the expressions which are not constant are collected parents first, and have their subexpressions memoised
+  // children first, so that the height of every expression is updated once those of its subexpressions are final
+  std::vector<Expression*> variable{tree.get()};
+  for (size_t i = 0; i < variable.size(); ++i) {
+    variable[i]->transformSubexpressions([&variable](std::unique_ptr<Expression> subexpression) {
+      if (!subexpression->isConstant()) {
+        variable.push_back(subexpression.get());
+      }
+      return subexpression;
+    });
+  }
+  for (auto expression = variable.rbegin(); expression != variable.rend(); ++expression) {
+    (*expression)->transformSubexpressions([&resource](std::unique_ptr<Expression> subexpression) {
+      return memoise(std::move(subexpression), resource);
+    });
+  }
+  result.tree = std::move(tree);
+  return result;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef MATHTREE_OPTIMISATIONS
+#define MATHTREE_OPTIMISATIONS
+
+#include "Expression.hpp"
+#include <memory>
+#include <memory_resource>
+
+namespace MathTree {
+
+/// Represents the tree produced by an optimisation pass, together with the effect of the pass.
+struct OptimisationResult {
+  /// The optimised tree.
+  std::unique_ptr<Expression> tree;
+  /// The number of nodes which the pass removed from the original tree.
+  size_t removedNodes = 0;
+};
+
+/**
+ * Collapses every subtree which does not depend on a variable into a single real number,
+ * allocated from the memory resource provided. The tree given is reused and returned.
+ * Subtrees whose evaluation throws a domain error (e.g. a constant division by zero) are not
+ * collapsed, so that the error is still thrown when the tree is evaluated. Only their
+ * constant subtrees which can be evaluated are collapsed. The same goes for subtrees
+ * whose result is not finite, as real numbers must be finite, and for the subtrees containing them.
+ * Each node is evaluated at most once, as constant subtrees are collapsed from the bottom up without recursing.
+ * Throws if the tree is null.
+ **/
+OptimisationResult foldConstants(std::unique_ptr<Expression> tree,
+                                 std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+/**
+ * Merges every chain of additions and subtractions into a single SumExpression using the summation mode provided,
+ * and every chain of multiplications into a single ProductExpression, allocated from the memory resource given.
+ * Only the left operands of a chain are merged into it, as merging a right operand would change the order of the
+ * operations. The tree is walked without recursing, so a chain of any length leaves a tree of bounded height.
+ * With sequential summation, the flattened tree gives the same results as the original one. Throws if the tree is null.
+ **/
+OptimisationResult flattenAssociativeChains(std::unique_ptr<Expression> tree,
+                                            SummationMode mode = SummationMode::Sequential,
+                                            std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+/**
+ * Replaces the operations which have a cheaper equivalent, allocating the new nodes from the memory resource given:
+ * every exponentiation to a real number n which is an integer with |n| <= ConstantPowerExpression::maxIntegerExponent
+ * or one half by a ConstantPowerExpression, and every logarithm by a SpecialisedLogarithmExpression. The results and
+ * errors of the tree are kept, within the bounds in ulps documented by both expressions. As only exponents which are
+ * real numbers are reduced, exponents such as 1/2 or -2 are only reduced once their constants are folded.
+ * Trees of any height are reduced, as they are walked without recursing. Throws if the tree is null.
+ **/
+OptimisationResult reduceStrength(std::unique_ptr<Expression> tree,
+                                  std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+/**
+ * Replaces the largest subtrees which compute a polynomial of degree two or more in a single variable with a
+ * PolynomialExpression, allocated from the memory resource given. Polynomials are recognised in expanded form:
+ * sums and differences, divisions by non-zero constants, positive integer powers of monomials, and products where
+ * all factors but one are monomials, such as 3*x^4+2*x^3-x^2/2+7*x+1 or x*(x+1). Products of sums are not expanded,
+ * as their expanded form may be less accurate. Constant subtrees are taken as coefficients once evaluated, unless
+ * they throw or are not finite. The results of the polynomials differ from those of the original subtrees by
+ * rounding, and their errors are the same, as only operations which cannot fail are recognised. Trees of any height
+ * are analysed without recursing. Throws if the tree is null.
+ **/
+OptimisationResult recognisePolynomials(std::unique_ptr<Expression> tree,
+                                        std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+/**
+ * Replaces every addition or subtraction of which an operand is a multiplication with an FmaExpression, allocated
+ * from the memory resource given, so that each of them takes one node less. When both operands are multiplications,
+ * the left one is contracted. With MultiplyAddRounding::Separate, the contracted tree gives the same results as the
+ * original one bit for bit; with MultiplyAddRounding::Fused, the results are rounded once and are more accurate.
+ * The operands are evaluated in the same order either way, so the errors are the same. Chains merged into a
+ * SumExpression are not contracted. Trees of any height are contracted without recursing. Throws if the tree is null.
+ **/
+OptimisationResult contractMultiplyAdds(std::unique_ptr<Expression> tree,
+                                        MultiplyAddRounding rounding = MultiplyAddRounding::Fused,
+                                        std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+/**
+ * Wraps every largest constant subtree in a MemoisedExpression, allocated from the memory resource given, so that
+ * its result is only computed by the first evaluation of the tree. Subtrees without subexpressions and subtrees
+ * already memoised are left as they are. The tree is walked without recursing, so trees of any height can be memoised.
+ * No node is removed, and the tree given is reused and returned. Throws if the tree is null.
+ **/
+OptimisationResult memoiseConstantSubtrees(std::unique_ptr<Expression> tree,
+                                           std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+}
+
+#endif // MATHTREE_OPTIMISATIONS
\ No newline at end of file
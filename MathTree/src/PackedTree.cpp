@@ -0,0 +1,475 @@
+#include <array>
+#include "Arithmetic.hpp"
+#include <cmath>
+#include <limits>
+#include "PackedTree.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace MathTree {
+
+class PackedTree::Builder {
+public:
+  Builder(PackedTree& tree): m_tree(tree) {}
+
+  // packs the tree without recursion, taking the steps from an explicit stack whatever the height of the tree
+  void add(Expression const& expression) {
+    m_steps.push_back({Step::Kind::Add, &expression});
+    while (!m_steps.empty()) {
+      auto const step = m_steps.back();
+      m_steps.pop_back();
+      switch (step.kind) {
+      case Step::Kind::Add:
+        addNode(*step.expression);
+        break;
+      case Step::Kind::AddNegated:
+        addUnary(Operation::Negate, *step.expression);
+        break;
+      case Step::Kind::AddConstant:
+        close(open(Operation::Constant, m_tree.m_literals.size()));
+        m_tree.m_literals.push_back(step.value);
+        break;
+      case Step::Kind::Close:
+        close(step.node);
+        break;
+      }
+    }
+  }
+
+  void shrink() {
+    m_tree.m_operations.shrink_to_fit();
+    m_tree.m_subtreeEnds.shrink_to_fit();
+    m_tree.m_operands.shrink_to_fit();
+    m_tree.m_literals.shrink_to_fit();
+    m_tree.m_bases.shrink_to_fit();
+  }
+
+private:
+  // a step of the depth-first traversal, which either packs an expression or closes a node once its operands are packed
+  struct Step {
+    enum class Kind {
+      Add,
+      AddNegated,
+      AddConstant,
+      Close
+    };
+    Kind kind;
+    Expression const* expression = nullptr;
+    size_t node = 0;
+    double value = 0.0;
+  };
+
+  // packs the node of the expression given, and schedules its operands, which are taken from the stack first to last
+  void addNode(Expression const& expression) {
+    if (dynamic_cast<RealNumberExpression const*>(&expression)) {
+      close(open(Operation::Constant, m_tree.m_literals.size()));
+      m_tree.m_literals.push_back(expression.evaluate());
+    } else if (auto variable = dynamic_cast<VariableExpression const*>(&expression)) {
+      if (m_tree.m_symbols == nullptr) {
+        m_tree.m_symbols = variable->symbols();
+      } else if (m_tree.m_symbols != variable->symbols()) {
+        throw std::logic_error("Cannot pack variables belonging to different symbol tables.");
+      }
+      close(open(Operation::Variable, variable->index()));
+    } else if (auto memoised = dynamic_cast<MemoisedExpression const*>(&expression)) {
+      // packed trees keep no result across evaluations, so the memoised subtree is packed as it is
+      m_steps.push_back({Step::Kind::Add, &memoised->subexpression(0)});
+    } else if (auto negation = dynamic_cast<NegativeSignExpression const*>(&expression)) {
+      addUnary(Operation::Negate, negation->subexpression(0));
+    } else if (auto squareRoot = dynamic_cast<SquareRootExpression const*>(&expression)) {
+      addUnary(Operation::SquareRoot, squareRoot->subexpression(0));
+    } else if (auto logarithm = dynamic_cast<LogarithmExpression const*>(&expression)) {
+      auto const node = open(Operation::Logarithm, m_tree.m_bases.size());
+      m_tree.m_bases.push_back(logarithm->base());
+      schedule(node, logarithm->subexpression(0));
+    } else if (auto specialisedLogarithm = dynamic_cast<SpecialisedLogarithmExpression const*>(&expression)) {
+      auto const node = open(Operation::SpecialisedLogarithm, m_tree.m_bases.size());
+      m_tree.m_bases.push_back(specialisedLogarithm->base());
+      schedule(node, specialisedLogarithm->subexpression(0));
+    } else if (auto power = dynamic_cast<ConstantPowerExpression const*>(&expression)) {
+      auto const exponent = power->exponent();
+      addWithConstants(open(Operation::ConstantPower), power->subexpression(0), &exponent, 1);
+    } else if (auto polynomial = dynamic_cast<PolynomialExpression const*>(&expression)) {
+      auto const& coefficients = polynomial->coefficients();
+      addWithConstants(open(Operation::Polynomial), polynomial->subexpression(0),
+                       coefficients.data(), coefficients.size());
+    } else if (auto multiplyAdd = dynamic_cast<FmaExpression const*>(&expression)) {
+      auto const operation = multiplyAdd->rounding() == MultiplyAddRounding::Fused ? Operation::FusedMultiplyAdd :
+                                                                                     Operation::MultiplyAdd;
+      auto const node = open(operation, static_cast<size_t>(multiplyAdd->pattern()));
+      m_steps.push_back({Step::Kind::Close, nullptr, node});
+      for (auto i = multiplyAdd->subexpressionCount(); i-- > 0;) {
+        m_steps.push_back({Step::Kind::Add, &multiplyAdd->subexpression(i)});
+      }
+    } else if (auto sum = dynamic_cast<SumExpression const*>(&expression)) {
+      if (sum->mode() != SummationMode::Sequential) {
+        // the terms are added up all at once, each subtracted one being negated as the sum negates it
+        auto const node = open(Operation::Sum, static_cast<size_t>(sum->mode()));
+        m_steps.push_back({Step::Kind::Close, nullptr, node});
+        for (auto i = sum->subexpressionCount(); i-- > 0;) {
+          m_steps.push_back({sum->isSubtracted(i) ? Step::Kind::AddNegated : Step::Kind::Add, &sum->subexpression(i)});
+        }
+        return;
+      }
+      addChain(*sum, [sum](size_t i) {
+        return sum->isSubtracted(i) ? Operation::Subtract : Operation::Add;
+      }, sum->isSubtracted(0));
+    } else if (auto product = dynamic_cast<ProductExpression const*>(&expression)) {
+      addChain(*product, [](size_t) {
+        return Operation::Multiply;
+      }, false);
+    } else if (auto binary = dynamic_cast<BinaryExpression const*>(&expression)) {
+      auto const node = open(operationFor(*binary));
+      m_steps.push_back({Step::Kind::Close, nullptr, node});
+      m_steps.push_back({Step::Kind::Add, &binary->right()});
+      m_steps.push_back({Step::Kind::Add, &binary->left()});
+    } else {
+      throw std::logic_error("Cannot pack an expression of unknown type.");
+    }
+  }
+
+  void addUnary(Operation operation, Expression const& operand) {
+    schedule(open(operation), operand);
+  }
+
+  // schedules the only operand of the node at the given position, and the closing of the node after it
+  void schedule(size_t node, Expression const& operand) {
+    m_steps.push_back({Step::Kind::Close, nullptr, node});
+    m_steps.push_back({Step::Kind::Add, &operand});
+  }
+
+  // schedules the first operand of the node at the given position, followed by constants holding the values given
+  void addWithConstants(size_t node, Expression const& operand, double const* values, size_t count) {
+    m_steps.push_back({Step::Kind::Close, nullptr, node});
+    for (auto i = count; i-- > 0;) {
+      m_steps.push_back({Step::Kind::AddConstant, nullptr, 0, values[i]});
+    }
+    m_steps.push_back({Step::Kind::Add, &operand});
+  }
+
+  // stores the operands as a chain of binary nodes combining them left to right, the last of which comes first
+  template<typename OperationOf>
+  void addChain(Expression const& chain, OperationOf operationOf, bool isFirstNegated) {
+    // each node is closed right after its second operand, the first operand of the chain being packed first
+    for (auto i = chain.subexpressionCount() - 1; i > 0; --i) {
+      auto const node = open(operationOf(i));
+      m_steps.push_back({Step::Kind::Close, nullptr, node});
+      m_steps.push_back({Step::Kind::Add, &chain.subexpression(i)});
+    }
+    m_steps.push_back({isFirstNegated ? Step::Kind::AddNegated : Step::Kind::Add, &chain.subexpression(0)});
+  }
+
+  static Operation operationFor(BinaryExpression const& binary) {
+    if (dynamic_cast<AdditionExpression const*>(&binary)) {
+      return Operation::Add;
+    } else if (dynamic_cast<SubtractionExpression const*>(&binary)) {
+      return Operation::Subtract;
+    } else if (dynamic_cast<MultiplicationExpression const*>(&binary)) {
+      return Operation::Multiply;
+    } else if (dynamic_cast<DivisionExpression const*>(&binary)) {
+      return Operation::Divide;
+    } else if (dynamic_cast<ExponentiationExpression const*>(&binary)) {
+      return Operation::Power;
+    }
+    throw std::logic_error("Cannot pack a binary expression of unknown type.");
+  }
+
+  // appends a node whose subtree is still to be added, and returns its position
+  size_t open(Operation operation, size_t operand = 0) {
+    auto constexpr maxIndex = std::numeric_limits<std::uint32_t>::max();
+    if (m_tree.m_operations.size() >= maxIndex) {
+      throw std::logic_error("Cannot pack a tree of more than " + std::to_string(maxIndex) + " nodes.");
+    } else if (operand > maxIndex) {
+      throw std::logic_error("Cannot pack a node with operand " + std::to_string(operand) + ".");
+    }
+    m_tree.m_operations.push_back(operation);
+    m_tree.m_subtreeEnds.push_back(0);
+    m_tree.m_operands.push_back(static_cast<std::uint32_t>(operand));
+    return m_tree.m_operations.size() - 1;
+  }
+
+  // marks the subtree of the node at the given position as complete
+  void close(size_t node) {
+    m_tree.m_subtreeEnds[node] = static_cast<std::uint32_t>(m_tree.m_operations.size());
+  }
+
+  PackedTree& m_tree;
+  std::vector<Step> m_steps;
+};
+
+PackedTree::NodeView::NodeView(PackedTree const& tree, size_t index): m_tree(&tree), m_index(index) {}
+
+PackedTree::Operation PackedTree::NodeView::operation() const {
+  return m_tree->m_operations[m_index];
+}
+
+double PackedTree::NodeView::value() const {
+  switch (operation()) {
+  case Operation::Constant:
+    return m_tree->m_literals[m_tree->m_operands[m_index]];
+  case Operation::Logarithm:
+  case Operation::SpecialisedLogarithm:
+    return m_tree->m_bases[m_tree->m_operands[m_index]];
+  default:
+    return 0.0;
+  }
+}
+
+size_t PackedTree::NodeView::variableIndex() const {
+  return m_tree->m_operands[m_index];
+}
+
+std::vector<PackedTree::NodeView> PackedTree::NodeView::subexpressions() const {
+  std::vector<NodeView> operands;
+  auto const end = m_tree->m_subtreeEnds[m_index];
+  for (auto i = m_index + 1; i < end; i = m_tree->m_subtreeEnds[i]) {
+    operands.push_back({*m_tree, i});
+  }
+  return operands;
+}
+
+size_t PackedTree::NodeView::size() const {
+  return m_tree->m_subtreeEnds[m_index] - m_index;
+}
+
+size_t PackedTree::NodeView::index() const {
+  return m_index;
+}
+
+PackedTree PackedTree::build(Expression const& expression) {
+  PackedTree tree;
+  Builder builder(tree);
+  builder.add(expression);
+  builder.shrink();
+  return tree;
+}
+
+double PackedTree::evaluate() const {
+  // most trees fit in small buffers, which avoids allocating on every evaluation
+  static size_t constexpr inlineSize = 256;
+  std::array<double, inlineSize> inlineValues;
+  std::array<std::uint8_t, inlineSize> inlineFailed;
+  std::vector<double> heapValues;
+  std::vector<std::uint8_t> heapFailed;
+  auto values = inlineValues.data();
+  auto failed = inlineFailed.data();
+  if (size() > inlineSize) {
+    heapValues.resize(size());
+    heapFailed.resize(size());
+    values = heapValues.data();
+    failed = heapFailed.data();
+  }
+
+  // The nodes are evaluated from the last one, which computes the operands of every node before the node itself,
+  // but not in the order of the original tree. Errors are therefore only recorded, and the one the original tree
+  // would have thrown first is looked for once the whole tree is known to have failed.
+  auto const operations = m_operations.data();
+  auto const ends = m_subtreeEnds.data();
+  auto const operands = m_operands.data();
+  // the results of the terms of the sum being computed, which are added up at once
+  std::vector<double> terms;
+  for (auto i = size(); i-- > 0;) {
+    auto const first = i + 1;
+    switch (operations[i]) {
+    case Operation::Constant:
+      values[i] = m_literals[operands[i]];
+      failed[i] = false;
+      break;
+    case Operation::Variable:
+      values[i] = m_symbols->valueOr(operands[i], 0.0);
+      failed[i] = !m_symbols->isBound(operands[i]);
+      break;
+    case Operation::Negate:
+      values[i] = -values[first];
+      failed[i] = failed[first];
+      break;
+    case Operation::Add:
+      values[i] = values[first] + values[ends[first]];
+      failed[i] = failed[first] | failed[ends[first]];
+      break;
+    case Operation::Subtract:
+      values[i] = values[first] - values[ends[first]];
+      failed[i] = failed[first] | failed[ends[first]];
+      break;
+    case Operation::Multiply:
+      values[i] = values[first] * values[ends[first]];
+      failed[i] = failed[first] | failed[ends[first]];
+      break;
+    case Operation::Divide:
+      values[i] = values[first] / values[ends[first]];
+      failed[i] = failed[first] | failed[ends[first]] | !Arithmetic::isValidDivisor(values[ends[first]]);
+      break;
+    case Operation::Power:
+      values[i] = std::pow(values[first], values[ends[first]]);
+      failed[i] = failed[first] | failed[ends[first]] | !Arithmetic::isValidPower(values[first], values[ends[first]]);
+      break;
+    case Operation::SquareRoot:
+      values[i] = std::sqrt(values[first]);
+      failed[i] = failed[first] | !Arithmetic::isValidRadicand(values[first]);
+      break;
+    case Operation::Logarithm:
+      values[i] = std::log2(values[first]) / std::log2(m_bases[operands[i]]);
+      failed[i] = failed[first] | !Arithmetic::isValidLogarithmArgument(values[first]);
+      break;
+    case Operation::ConstantPower:
+      values[i] = ConstantPowerExpression::power(values[first], values[ends[first]]);
+      failed[i] = failed[first] | !Arithmetic::isValidPower(values[first], values[ends[first]]);
+      break;
+    case Operation::SpecialisedLogarithm:
+      values[i] = SpecialisedLogarithmExpression::logarithm(values[first], m_bases[operands[i]]);
+      failed[i] = failed[first] | !Arithmetic::isValidLogarithmArgument(values[first]);
+      break;
+    case Operation::Polynomial: {
+      // the coefficients are constants following the argument, whose numbers are contiguous in the literals
+      auto const coefficients = ends[first];
+      values[i] = PolynomialExpression::valueAt(&m_literals[operands[coefficients]], ends[i] - coefficients,
+                                                values[first]);
+      failed[i] = failed[first];
+      break;
+    }
+    case Operation::MultiplyAdd:
+    case Operation::FusedMultiplyAdd: {
+      auto const second = ends[first];
+      auto const third = ends[second];
+      auto const pattern = static_cast<FmaExpression::Pattern>(operands[i]);
+      auto const rounding = operations[i] == Operation::FusedMultiplyAdd ? MultiplyAddRounding::Fused :
+                                                                           MultiplyAddRounding::Separate;
+      values[i] = FmaExpression::isAddendFirst(pattern) ?
+        FmaExpression::combine(values[second], values[third], values[first], pattern, rounding) :
+        FmaExpression::combine(values[first], values[second], values[third], pattern, rounding);
+      failed[i] = failed[first] | failed[second] | failed[third];
+      break;
+    }
+    case Operation::Sum:
+      terms.clear();
+      failed[i] = false;
+      for (auto j = first; j < ends[i]; j = ends[j]) {
+        terms.push_back(values[j]);
+        failed[i] |= failed[j];
+      }
+      values[i] = static_cast<SummationMode>(operands[i]) == SummationMode::Kahan ?
+        Arithmetic::compensatedSum(terms.data(), terms.size()) : Arithmetic::pairwiseSum(terms.data(), terms.size());
+      break;
+    }
+  }
+
+  if (failed[0]) {
+    throwFirstError(values, failed);
+  }
+  return values[0];
+}
+
+void PackedTree::throwFirstError(double const* values, std::uint8_t const* failed) const {
+  // goes down the failed nodes, following the order in which the original tree evaluates operands, until
+  // reaching a node whose operands are all valid, which is the one the original tree would throw from
+  size_t i = 0;
+  while (true) {
+    auto const first = i + 1;
+    auto const second = first < size() ? m_subtreeEnds[first] : 0;
+    switch (m_operations[i]) {
+    case Operation::Variable:
+      m_symbols->value(m_operands[i]);
+      break;
+    case Operation::Negate:
+      i = first;
+      continue;
+    case Operation::Add:
+    case Operation::Subtract:
+    case Operation::Multiply:
+      i = failed[first] ? first : second;
+      continue;
+    case Operation::Polynomial:
+      i = first;
+      continue;
+    case Operation::MultiplyAdd:
+    case Operation::FusedMultiplyAdd:
+    case Operation::Sum:
+      // the operands are stored in the order they are evaluated in
+      i = first;
+      while (!failed[i]) {
+        i = m_subtreeEnds[i];
+      }
+      continue;
+    case Operation::Divide:
+      // the divisor is validated before the dividend is evaluated
+      if (failed[second]) {
+        i = second;
+        continue;
+      }
+      Arithmetic::ensureValidDivisor(values[second]);
+      i = first;
+      continue;
+    case Operation::Power:
+    case Operation::ConstantPower:
+      if (failed[first] || failed[second]) {
+        i = failed[first] ? first : second;
+        continue;
+      }
+      Arithmetic::power(values[first], values[second]);
+      break;
+    case Operation::SquareRoot:
+      if (failed[first]) {
+        i = first;
+        continue;
+      }
+      Arithmetic::squareRoot(values[first]);
+      break;
+    case Operation::Logarithm:
+    case Operation::SpecialisedLogarithm:
+      if (failed[first]) {
+        i = first;
+        continue;
+      }
+      Arithmetic::logarithm(values[first], m_bases[m_operands[i]]);
+      break;
+    default:
+      break;
+    }
+    throw std::logic_error("Could not find the error of a packed tree which failed to evaluate.");
+  }
+}
+
+PackedTree::NodeView PackedTree::root() const {
+  return node(0);
+}
+
+PackedTree::NodeView PackedTree::node(size_t index) const {
+  if (index >= size()) {
+    throw std::out_of_range("A packed tree of " + std::to_string(size()) + " nodes has no node at " +
+                            std::to_string(index) + ".");
+  }
+  return {*this, index};
+}
+
+size_t PackedTree::size() const {
+  return m_operations.size();
+}
+
+std::vector<PackedTree::Operation> const& PackedTree::operations() const {
+  return m_operations;
+}
+
+std::vector<std::uint32_t> const& PackedTree::subtreeEnds() const {
+  return m_subtreeEnds;
+}
+
+std::vector<double> const& PackedTree::literals() const {
+  return m_literals;
+}
+
+std::vector<double> const& PackedTree::bases() const {
+  return m_bases;
+}
+
+size_t PackedTree::memoryFootprint() const {
+  return sizeof(*this) + m_operations.capacity() * sizeof(Operation) +
+         m_subtreeEnds.capacity() * sizeof(std::uint32_t) + m_operands.capacity() * sizeof(std::uint32_t) +
+         (m_literals.capacity() + m_bases.capacity()) * sizeof(double);
+}
+
+std::shared_ptr<SymbolTable const> const& PackedTree::symbols() const {
+  return m_symbols;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef MATHTREE_PACKEDTREE
+#define MATHTREE_PACKEDTREE
+
+#include <cstdint>
+#include "Expression.hpp"
+#include <memory>
+#include "SymbolTable.hpp"
+#include <vector>
+
+namespace MathTree {
+
+/**
+ * Represents an immutable expression tree packed into contiguous arrays, one entry per node in depth-first
+ * order: every node is followed by the subtrees of its operands, from left to right. The operations, the
+ * indices where subtrees end and the operands of the nodes are kept in separate arrays, as are the values
+ * of the numbers and the bases of the logarithms, so a packed tree takes a fraction of the memory of the
+ * tree it was built from and is read without chasing pointers.
+ * Sequential sums and products are stored as chains of binary operations, in the order they are computed.
+ * The nodes produced by the optimisations are stored as operations of their own, computed as those nodes compute them.
+ * Evaluating a packed tree gives the same results and throws the same errors as evaluating the tree it was built from.
+ **/
+class PackedTree {
+public:
+  /// Represents the operations performed by the nodes of the tree.
+  enum class Operation: std::uint8_t {
+    /// Results in the number whose index in literals() is the operand of the node.
+    Constant,
+    /// Results in the value of the variable whose index is the operand of the node.
+    Variable,
+    /// Results in the negation of its operand.
+    Negate,
+    /// Results in the sum of its operands.
+    Add,
+    /// Results in the difference between its operands.
+    Subtract,
+    /// Results in the product of its operands.
+    Multiply,
+    /// Results in the first operand divided by the second one, which is validated before the first is evaluated.
+    Divide,
+    /// Results in the first operand raised to the power of the second one.
+    Power,
+    /// Results in the square root of its operand.
+    SquareRoot,
+    /// Results in the logarithm of its operand, in the base whose index in bases() is the operand of the node.
+    Logarithm,
+    /// Results in the first operand raised to the second one, a constant, computed as per ConstantPowerExpression.
+    ConstantPower,
+    /**
+     * Results in the logarithm of its operand computed as per SpecialisedLogarithmExpression, in the base whose
+     * index in bases() is the operand of the node.
+     **/
+    SpecialisedLogarithm,
+    /**
+     * Results in the polynomial in its first operand whose coefficients, starting from the constant one, are the
+     * following operands, which are constants. Computed as per PolynomialExpression.
+     **/
+    Polynomial,
+    /**
+     * Results in the FmaExpression::Pattern which is the operand of the node, computed from its operands in the
+     * order they are evaluated in, with the product and the sum rounded separately.
+     **/
+    MultiplyAdd,
+    /// Results in the same as MultiplyAdd, with the result rounded once.
+    FusedMultiplyAdd,
+    /// Results in the sum of its operands, added up as per the SummationMode which is the operand of the node.
+    Sum
+  };
+
+  /// Represents a view of a node of a packed tree, which is only valid as long as the tree is.
+  class NodeView {
+  public:
+    /// Returns the operation performed by the node.
+    Operation operation() const;
+    /// Returns the number stored in the node for constants, its base for both kinds of logarithms, and zero otherwise.
+    double value() const;
+    /// Returns the index of the variable read by the node. Only meaningful for variables.
+    size_t variableIndex() const;
+    /// Returns the operands of the node, ordered left to right.
+    std::vector<NodeView> subexpressions() const;
+    /// Returns the number of nodes in the subtree of the node, including the node itself.
+    size_t size() const;
+    /// Returns the position of the node in the arrays of the tree.
+    size_t index() const;
+
+  private:
+    friend class PackedTree;
+    NodeView(PackedTree const& tree, size_t index);
+
+    PackedTree const* m_tree;
+    size_t m_index;
+  };
+
+  /**
+   * Returns the packed tree built from the given expression tree.
+   * Throws if the tree contains expressions of unknown type, variables that belong to different symbol tables,
+   * or more nodes than can be indexed with 32 bits.
+   **/
+  static PackedTree build(Expression const& expression);
+
+  /**
+   * Returns the real valued number obtained by evaluating the tree.
+   * Variables are read from the symbol table of the tree the packed tree was built from.
+   * Throws the same errors as the expression tree the packed tree was built from.
+   **/
+  double evaluate() const;
+  /// Returns a view of the root of the tree.
+  NodeView root() const;
+  /// Returns a view of the node at the given position. Throws if there is no such node.
+  NodeView node(size_t index) const;
+  /// Returns the number of nodes of the tree.
+  size_t size() const;
+  /// Returns the operations of the nodes, in depth-first order.
+  std::vector<Operation> const& operations() const;
+  /// Returns, for every node, the position following the last node of its subtree.
+  std::vector<std::uint32_t> const& subtreeEnds() const;
+  /// Returns the numbers of the constants, in depth-first order.
+  std::vector<double> const& literals() const;
+  /// Returns the bases of the logarithms, in depth-first order.
+  std::vector<double> const& bases() const;
+  /// Returns the number of bytes taken by the arrays of the tree.
+  size_t memoryFootprint() const;
+  /// Returns the symbol table the variables of the tree are read from, or null if there are no variables.
+  std::shared_ptr<SymbolTable const> const& symbols() const;
+
+private:
+  class Builder;
+  PackedTree() = default;
+
+  // throws the error that evaluating the tree in order would throw, given the results of a failed evaluation
+  [[noreturn]] void throwFirstError(double const* values, std::uint8_t const* failed) const;
+
+  std::vector<Operation> m_operations;
+  std::vector<std::uint32_t> m_subtreeEnds;
+  // the index of the number, variable or base of every node, zero if it has none
+  std::vector<std::uint32_t> m_operands;
+  std::vector<double> m_literals;
+  std::vector<double> m_bases;
+  std::shared_ptr<SymbolTable const> m_symbols;
+};
+
+}
+
+#endif // MATHTREE_PACKEDTREE
\ No newline at end of file
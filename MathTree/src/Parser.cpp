@@ -1,9 +1,40 @@
+#include "Arithmetic.hpp"
+#include "Optimisations.hpp"
 #include "Parser.hpp"
+#include "Scanning.hpp"
 #include <stdexcept>
+#include "TokenMatchers.hpp"
 #include <limits>
+#include <vector>
 
 namespace MathTree {
 
+std::pmr::memory_resource& AbstractPrattParser::memoryResource() {
+  return *std::pmr::get_default_resource();
+}
+
+std::shared_ptr<SymbolTable> AbstractPrattParser::symbols() {
+  return nullptr;
+}
+
+void PrattGrammar::setPrefixParselet(TokenType token, std::unique_ptr<PrefixParselet> parselet) {
+  m_prefixParselets[token] = std::move(parselet);
+}
+
+void PrattGrammar::setInfixParselet(TokenType token, std::unique_ptr<InfixParselet> parselet) {
+  m_infixParselets[token] = std::move(parselet);
+}
+
+PrefixParselet const* PrattGrammar::prefixParseletFor(TokenType token) const {
+  auto it = m_prefixParselets.find(token);
+  return it != m_prefixParselets.end() ? it->second.get() : nullptr;
+}
+
+InfixParselet const* PrattGrammar::infixParseletFor(TokenType token) const {
+  auto it = m_infixParselets.find(token);
+  return it != m_infixParselets.end() ? it->second.get() : nullptr;
+}
+
 class PrattParser::ReferenceCountingResetter {
 public:
   ReferenceCountingResetter(PrattParser& parser): m_parser(parser) {
@@ -19,7 +50,13 @@ private:
   PrattParser& m_parser;
 };
 
-PrattParser::PrattParser(std::unique_ptr<Lexer> lexer): m_lexer(std::move(lexer)) {}
+PrattParser::PrattParser(PrattGrammar const& grammar,
+                         Lexer& lexer,
+                         std::shared_ptr<SymbolTable> symbols,
+                         std::pmr::memory_resource& resource): m_grammar(grammar),
+                                                               m_lexer(lexer),
+                                                               m_symbols(std::move(symbols)),
+                                                               m_memoryResource(resource) {}
 
 std::unique_ptr<Expression> PrattParser::parse() {
   return parse(minAllowedPriority);
@@ -28,96 +65,276 @@ std::unique_ptr<Expression> PrattParser::parse() {
 std::unique_ptr<Expression> PrattParser::parse(int priority) {
   ReferenceCountingResetter countingResetter(*this);
   auto token = consumeCurrentToken();
-  if (m_prefixParselets.count(token.type()) <= 0) {
+  auto prefix = m_grammar.prefixParseletFor(token.type());
+  if (prefix == nullptr) {
     throw std::logic_error("Expected a prefix parselet while parsing.");
   }
-  auto& prefix = *m_prefixParselets[token.type()];
-  auto left = prefix.parse(*this, token);
+  auto left = prefix->parse(*this, token);
 
   while (priority < infixPriorityFor(currentToken())) {
     token = consumeCurrentToken();
-    auto& infix = *m_infixParselets[token.type()];
+    auto& infix = *m_grammar.infixParseletFor(token.type());
     left = infix.parse(*this, std::move(left), token);
   }
 
   return left;
 }
 
-std::unique_ptr<Expression> PrattParser::parse(std::string input, int priority) {
-  m_lexer->reset(std::move(input));
-  return parse(priority);
-}
-
-void PrattParser::setPrefixParselet(TokenType token, std::unique_ptr<PrefixParselet> parselet) {
-  m_prefixParselets[token] = std::move(parselet);
-}
-
-void PrattParser::setInfixParselet(TokenType token, std::unique_ptr<InfixParselet> parselet) {
-  m_infixParselets[token] = std::move(parselet);
-}
-
 Token PrattParser::consumeCurrentToken() {
   auto token = currentToken();
   m_currentToken = std::nullopt;
   return token;
 }
 
+std::pmr::memory_resource& PrattParser::memoryResource() {
+  return m_memoryResource;
+}
+
+std::shared_ptr<SymbolTable> PrattParser::symbols() {
+  return m_symbols;
+}
+
 int PrattParser::infixPriorityFor(Token const& token) {
-  if (m_infixParselets.count(token.type()) <= 0) {
+  auto infix = m_grammar.infixParseletFor(token.type());
+  if (infix == nullptr) {
     return minAllowedPriority;
   }
-  InfixParselet const& infix = *m_infixParselets[token.type()];
-  return infix.priority();
+  return infix->priority();
 }
 
 Token const& PrattParser::currentToken() {
   if (!m_currentToken.has_value()) {
-    m_currentToken = m_lexer->next();
+    m_currentToken = m_lexer.next();
   }
   return *m_currentToken;
 }
 
 void PrattParser::reset() {
   m_currentToken = std::nullopt;
-  m_lexer->reset();
+  m_lexer.reset();
 }
 
-ArithmeticParser::IndexErrorPairs ArithmeticParser::validateSyntax(std::string_view input) {
+namespace {
+
+/**
+ * Parses arithmetic expressions like StaticPrattParser<ArithmeticGrammar>, but keeps the operations
+ * waiting for their last operand on an explicit stack instead of recursing once per nesting level.
+ * Each operation is built by ArithmeticGrammar once its last operand is known, so the trees are the same.
+ * The tokens are handed to the parser one at a time, so that it can be driven by a lexer or by a validator,
+ * and it reports the tokens that cannot continue the expression instead of throwing.
+ **/
+class IterativeArithmeticParser {
+public:
+  /// The state of the parse after reading a token.
+  enum class Status {
+    Incomplete,
+    Complete,
+    ExpectedOperand,
+    ExpectedClosingBracket
+  };
+
+  IterativeArithmeticParser(std::shared_ptr<SymbolTable> symbols,
+                            std::pmr::memory_resource& resource): m_symbols(std::move(symbols)),
+                                                                  m_memoryResource(resource) {}
+
+  // reads the next token of the input, which is ignored once the parse is no longer incomplete
+  Status read(Token const& token) {
+    if (m_status != Status::Incomplete) {
+      return m_status;
+    }
+    if (m_operand == nullptr) {
+      readOperand(token);
+    } else {
+      completeOperations(token);
+    }
+    return m_status;
+  }
+
+  // returns the tree once the parse is complete
+  std::unique_ptr<Expression> takeTree() {
+    return m_status == Status::Complete ? std::move(m_operand) : nullptr;
+  }
+
+private:
+  // an operation waiting for the expression parsed with the given priority as its last operand
+  struct PendingOperation {
+    Token token;
+    // the left operand of a binary operation, or null for a prefix operation
+    std::unique_ptr<Expression> left;
+    int priority;
+  };
+
+  // hands the last operand, already parsed, to ArithmeticGrammar as if it had just parsed it
+  class ParsedOperand {
+  public:
+    ParsedOperand(IterativeArithmeticParser& parser,
+                  std::unique_ptr<Expression> operand,
+                  Token const& nextToken): m_parser(parser),
+                                           m_operand(std::move(operand)),
+                                           m_nextToken(nextToken) {}
+
+    std::unique_ptr<Expression> parse(int = PrattParser::minAllowedPriority) {
+      return std::move(m_operand);
+    }
+
+    Token consumeCurrentToken() {
+      return m_nextToken;
+    }
+
+    std::pmr::memory_resource& memoryResource() {
+      return m_parser.m_memoryResource;
+    }
+
+    std::shared_ptr<SymbolTable> const& symbols() {
+      return m_parser.m_symbols;
+    }
+
+  private:
+    IterativeArithmeticParser& m_parser;
+    std::unique_ptr<Expression> m_operand;
+    Token const& m_nextToken;
+  };
+
+  // prefix operations are stacked until an operand is found
+  void readOperand(Token const& token) {
+    using Priority = ArithmeticParser::OperationPriority;
+    switch (token.type()) {
+    case TokenType::OpeningBracket:
+      m_pending.push_back({token, nullptr, PrattParser::minAllowedPriority});
+      break;
+    case TokenType::Plus:
+    case TokenType::Minus:
+      m_pending.push_back({token, nullptr, static_cast<int>(Priority::Sign)});
+      break;
+    case TokenType::SquareRoot:
+      m_pending.push_back({token, nullptr, static_cast<int>(Priority::SquareRoot)});
+      break;
+    case TokenType::Log:
+      m_pending.push_back({token, nullptr, static_cast<int>(Priority::Logarithm)});
+      break;
+    case TokenType::Number:
+    case TokenType::Variable: {
+      ParsedOperand noOperand(*this, nullptr, token);
+      m_operand = ArithmeticGrammar::parsePrefix(noOperand, token);
+      break;
+    }
+    default:
+      m_status = Status::ExpectedOperand;
+    }
+  }
+
+  // the operand completes the pending operations binding tighter than the next token,
+  // which is where the recursive parser would return from its calls
+  void completeOperations(Token const& token) {
+    while (true) {
+      auto const priority = m_pending.empty() ? PrattParser::minAllowedPriority : m_pending.back().priority;
+      auto const infixPriority = ArithmeticGrammar::infixPriority(token.type());
+      if (priority < infixPriority) {
+        // right associativity needs a lower priority
+        auto const operandPriority = token.type() == TokenType::Caret ? infixPriority - 1 : infixPriority;
+        m_pending.push_back({token, std::move(m_operand), operandPriority});
+        return;
+      }
+      if (m_pending.empty()) {
+        m_status = Status::Complete;
+        return;
+      }
+
+      auto operation = std::move(m_pending.back());
+      m_pending.pop_back();
+      ParsedOperand parsedOperand(*this, std::move(m_operand), token);
+      if (operation.left != nullptr) {
+        m_operand = ArithmeticGrammar::parseInfix(parsedOperand, std::move(operation.left), operation.token);
+      } else if (operation.token.type() != TokenType::OpeningBracket) {
+        m_operand = ArithmeticGrammar::parsePrefix(parsedOperand, operation.token);
+      } else if (token.type() == TokenType::ClosingBracket) {
+        // the group consumes the closing bracket, so the next token is needed to go on
+        m_operand = ArithmeticGrammar::parsePrefix(parsedOperand, operation.token);
+        return;
+      } else {
+        m_status = Status::ExpectedClosingBracket;
+        return;
+      }
+    }
+  }
+
+  std::shared_ptr<SymbolTable> m_symbols;
+  std::pmr::memory_resource& m_memoryResource;
+  std::vector<PendingOperation> m_pending;
+  std::unique_ptr<Expression> m_operand;
+  Status m_status = Status::Incomplete;
+};
+
+std::unique_ptr<Expression> parseIteratively(Lexer& lexer,
+                                             std::shared_ptr<SymbolTable> symbols,
+                                             std::pmr::memory_resource& resource) {
+  using Status = IterativeArithmeticParser::Status;
+  IterativeArithmeticParser parser(std::move(symbols), resource);
+  auto status = Status::Incomplete;
+  while (status == Status::Incomplete) {
+    status = parser.read(lexer.next());
+  }
+  if (status == Status::ExpectedOperand) {
+    throw std::logic_error("Expected a prefix parselet while parsing.");
+  } else if (status == Status::ExpectedClosingBracket) {
+    throw std::logic_error("Expected a closing bracket during parsing.");
+  }
+  return parser.takeTree();
+}
+
+// tells whether the input goes on with letters or underscores at the given index, other than the name of a function
+bool continuesIdentifier(std::string_view input, size_t idx) {
+  static SymbolMatcher const functionMatcher({TokenType::SquareRoot, TokenType::Log});
+  return idx < input.size() && (Scanning::isLetter(input[idx]) || input[idx] == '_') &&
+         !functionMatcher.match(input, idx);
+}
+
+/**
+ * Scans the input for the syntax errors described by ArithmeticParser::validateSyntax, and hands every
+ * token recognised to the reader given, in order, so that the input can be parsed during the same pass.
+ * Tokens are only handed over until the first syntax error is found.
+ **/
+template<typename TokenReader>
+ArithmeticParser::IndexErrorPairs scanSyntax(std::string_view input, TokenReader&& readToken) {
+  using SyntaxErrors = ArithmeticParser::SyntaxErrors;
   static SymbolMatcher const symbolMatcher({TokenType::Plus, TokenType::Minus,
                                               TokenType::Slash, TokenType::Asterisk,
                                               TokenType::Caret, TokenType::SquareRoot});
   static SymbolMatcher const signMatcher({TokenType::Plus, TokenType::Minus});
   static UnsignedNumberMatcher const numberMatcher;
+  static IdentifierMatcher const identifierMatcher;
   // logMatcher is needed as it can match the base as well (so more than just the "log" symbol)
   static LogarithmMatcher const logMatcher;
-  
-  if (input.size() <= 0) {
-    return IndexErrorPairs{};
-  }
 
-  IndexErrorPairs idxErrorPairs;
+
+  ArithmeticParser::IndexErrorPairs idxErrorPairs;
   std::vector<size_t> openBracketsIdx;
   std::optional<size_t> lastNonSpaceIdx;
-  auto wasNumber = false;
+  auto wasOperand = false;
   auto wasOperator = false;
   for (size_t i = 0; i < input.size(); ++i) {
-    if (std::isspace(input[i])) {
+    if (Scanning::isSpace(input[i])) {
+      // the loop moves on to the character after the spaces
+      i = Scanning::skipSpaces(input, i) - 1;
       continue;
     }
 
     auto increment = 0;
-    std::optional<Token> operatorOpt, numberOpt;
-    if (operatorOpt = symbolMatcher.match(input, i)) {
+    std::optional<Token> operatorOpt, operandOpt;
+    if ((operatorOpt = symbolMatcher.match(input, i))) {
       increment += operatorOpt->text().size() - 1;
-    } else if (operatorOpt = logMatcher.match(input, i)) {
+    } else if ((operatorOpt = logMatcher.match(input, i))) {
       increment += operatorOpt->text().size() - 1;
-    } else if (numberOpt = numberMatcher.match(input, i)) {
-      increment += numberOpt->text().size() - 1;
+    } else if ((operandOpt = numberMatcher.match(input, i))) {
+      increment += operandOpt->text().size() - 1;
+    } else if ((operandOpt = identifierMatcher.match(input, i))) {
+      // variables are arranged in the same way as numbers
+      increment += operandOpt->text().size() - 1;
     }
 
     if (input[i] == '(') {
       openBracketsIdx.push_back(i);
-      if (wasNumber) {
+      if (wasOperand || (lastNonSpaceIdx && input[*lastNonSpaceIdx] == ')')) {
         idxErrorPairs.emplace_back(i, SyntaxErrors::MissingOperator);
       }
     } else if (input[i] == ')') {
@@ -147,14 +364,39 @@ ArithmeticParser::IndexErrorPairs ArithmeticParser::validateSyntax(std::string_v
         // Also ensure no binary operator is at the start of the expression.
         idxErrorPairs.emplace_back(i, SyntaxErrors::IncompleteOperation);
       }
-    } else if (numberOpt && (wasNumber || (lastNonSpaceIdx && input[*lastNonSpaceIdx] == ')'))) {
+      // the base is only decoded when it is written after the delimeter
+      auto const hasExplicitBase = operatorOpt->type() == TokenType::Log &&
+                                   operatorOpt->text().size() > symboliseTokenType(TokenType::Log).size();
+      if (hasExplicitBase && !Arithmetic::isValidLogarithmBase(operatorOpt->value())) {
+        idxErrorPairs.emplace_back(i, SyntaxErrors::InvalidLogarithmBase);
+      }
+      // a function followed by a variable without a space in between reads as a single name, such as logistic
+      if (isSqrtOrLog && continuesIdentifier(input, i + operatorOpt->text().size())) {
+        idxErrorPairs.emplace_back(i, SyntaxErrors::ReservedPrefix);
+      }
+    } else if (operandOpt && (wasOperand || (lastNonSpaceIdx && input[*lastNonSpaceIdx] == ')'))) {
       idxErrorPairs.emplace_back(i, SyntaxErrors::MissingOperator);
-    } else if (!operatorOpt && !numberOpt) {
+    } else if (auto const length = IdentifierMatcher::identifierLength(input, i); !operatorOpt && !operandOpt &&
+               length > symboliseTokenType(TokenType::Log).size() + delimeterFor(TokenType::Log).size()) {
+      // a name starting with the symbol of a logarithm and its delimeter, such as log_x, is not a base
+      idxErrorPairs.emplace_back(i, SyntaxErrors::ReservedPrefix);
+      increment += length - 1;
+    } else if (!operatorOpt && !operandOpt) {
       idxErrorPairs.emplace_back(i, SyntaxErrors::UnrecognisedSymbol);
     }
 
+    // the tokens from a syntax error onwards may not form a tree, so they are not handed over
+    if (idxErrorPairs.empty()) {
+      if (input[i] == '(' || input[i] == ')') {
+        auto const type = input[i] == '(' ? TokenType::OpeningBracket : TokenType::ClosingBracket;
+        readToken(Token{type, input.substr(i, 1)});
+      } else if (operatorOpt || operandOpt) {
+        readToken(operatorOpt ? *operatorOpt : *operandOpt);
+      }
+    }
+
     lastNonSpaceIdx = i;
-    wasNumber = numberOpt.has_value();
+    wasOperand = operandOpt.has_value();
     wasOperator = operatorOpt.has_value();
     i += increment;
   }
@@ -168,37 +410,192 @@ ArithmeticParser::IndexErrorPairs ArithmeticParser::validateSyntax(std::string_v
     idxErrorPairs.emplace_back(idx, SyntaxErrors::UnpairedOpeningBracket);
   }
 
+  if (!lastNonSpaceIdx.has_value()) {
+    idxErrorPairs.emplace_back(0, SyntaxErrors::EmptyExpression);
+  }
+
   return idxErrorPairs;
 }
 
-ArithmeticParser::ArithmeticParser(): m_parser(PrattParser(std::make_unique<ArithmeticLexer>())) {
-  m_parser.setPrefixParselet(TokenType::Plus,
-                             std::make_unique<PositiveSignParselet>(static_cast<int>(OperationPriority::Sign)));
-  m_parser.setPrefixParselet(TokenType::Minus,
-                             std::make_unique<NegativeSignParselet>(static_cast<int>(OperationPriority::Sign)));
-  m_parser.setPrefixParselet(TokenType::Number,
-                             std::make_unique<NumberParselet>());
-  m_parser.setPrefixParselet(TokenType::OpeningBracket,
-                             std::make_unique<GroupParselet>());
-  m_parser.setPrefixParselet(TokenType::SquareRoot,
-                             std::make_unique<SquareRootParselet>(static_cast<int>(OperationPriority::SquareRoot)));
-  m_parser.setPrefixParselet(TokenType::Log,
-                             std::make_unique<LogarithmParselet>(static_cast<int>(OperationPriority::Logarithm)));
-
-  m_parser.setInfixParselet(TokenType::Plus,
-                            std::make_unique<AdditionParselet>(static_cast<int>(OperationPriority::Addition)));
-  m_parser.setInfixParselet(TokenType::Minus,
-                            std::make_unique<SubtractionParselet>(static_cast<int>(OperationPriority::Subtraction)));
-  m_parser.setInfixParselet(TokenType::Asterisk,
-                            std::make_unique<MultiplicationParselet>(static_cast<int>(OperationPriority::Multiplication)));
-  m_parser.setInfixParselet(TokenType::Slash,
-                            std::make_unique<DivisionParselet>(static_cast<int>(OperationPriority::Division)));
-  m_parser.setInfixParselet(TokenType::Caret,
-                            std::make_unique<ExponentiationParselet>(static_cast<int>(OperationPriority::Exponentiation)));
-}
-
-std::unique_ptr<Expression> ArithmeticParser::parse(std::string input) {
-  return m_parser.parse(std::move(input));
+}
+
+ArithmeticParser::IndexErrorPairs ArithmeticParser::validateSyntax(std::string_view input) {
+  return scanSyntax(input, [](Token const&) {});
+}
+
+PrattGrammar const& ArithmeticParser::grammar() {
+  static PrattGrammar const grammar = [] {
+    PrattGrammar grammar;
+    grammar.setPrefixParselet(TokenType::Plus,
+                              std::make_unique<PositiveSignParselet>(static_cast<int>(OperationPriority::Sign)));
+    grammar.setPrefixParselet(TokenType::Minus,
+                              std::make_unique<NegativeSignParselet>(static_cast<int>(OperationPriority::Sign)));
+    grammar.setPrefixParselet(TokenType::Number,
+                              std::make_unique<NumberParselet>());
+    grammar.setPrefixParselet(TokenType::Variable,
+                              std::make_unique<VariableParselet>());
+    grammar.setPrefixParselet(TokenType::OpeningBracket,
+                              std::make_unique<GroupParselet>());
+    grammar.setPrefixParselet(TokenType::SquareRoot,
+                              std::make_unique<SquareRootParselet>(static_cast<int>(OperationPriority::SquareRoot)));
+    grammar.setPrefixParselet(TokenType::Log,
+                              std::make_unique<LogarithmParselet>(static_cast<int>(OperationPriority::Logarithm)));
+
+    grammar.setInfixParselet(TokenType::Plus,
+                             std::make_unique<AdditionParselet>(static_cast<int>(OperationPriority::Addition)));
+    grammar.setInfixParselet(TokenType::Minus,
+                             std::make_unique<SubtractionParselet>(static_cast<int>(OperationPriority::Subtraction)));
+    grammar.setInfixParselet(TokenType::Asterisk,
+                             std::make_unique<MultiplicationParselet>(static_cast<int>(OperationPriority::Multiplication)));
+    grammar.setInfixParselet(TokenType::Slash,
+                             std::make_unique<DivisionParselet>(static_cast<int>(OperationPriority::Division)));
+    grammar.setInfixParselet(TokenType::Caret,
+                             std::make_unique<ExponentiationParselet>(static_cast<int>(OperationPriority::Exponentiation)));
+    return grammar;
+  }();
+  return grammar;
+}
+
+ArithmeticParser::ArithmeticParser(): m_symbols(std::make_shared<SymbolTable>()) {}
+
+std::unique_ptr<Expression> ArithmeticParser::parse(std::string_view input) const {
+  return parse(input, m_symbols);
+}
+
+std::unique_ptr<Expression> ArithmeticParser::parse(std::string_view input, std::pmr::memory_resource& resource) const {
+  return parse(input, m_symbols, resource);
+}
+
+std::unique_ptr<Expression> ArithmeticParser::parse(std::string_view input,
+                                                    std::shared_ptr<SymbolTable> symbols,
+                                                    std::pmr::memory_resource& resource) const {
+  ArithmeticLexer lexer(input);
+  std::unique_ptr<Expression> tree;
+  if (m_engine == ParsingEngine::Iterative) {
+    tree = parseIteratively(lexer, std::move(symbols), resource);
+  } else {
+    tree = StaticPrattParser<ArithmeticGrammar>(lexer, std::move(symbols), resource).parse();
+  }
+  return optimise(std::move(tree), resource);
+}
+
+ArithmeticParser::ParseResult ArithmeticParser::tryParse(std::string_view input) const {
+  return tryParse(input, m_symbols);
+}
+
+ArithmeticParser::ParseResult ArithmeticParser::tryParse(std::string_view input,
+                                                         std::pmr::memory_resource& resource) const {
+  return tryParse(input, m_symbols, resource);
+}
+
+ArithmeticParser::ParseResult ArithmeticParser::tryParse(std::string_view input,
+                                                         std::shared_ptr<SymbolTable> symbols,
+                                                         std::pmr::memory_resource& resource) const {
+  using Status = IterativeArithmeticParser::Status;
+  IterativeArithmeticParser parser(std::move(symbols), resource);
+  auto readPastTheEnd = false;
+  ParseResult result;
+  result.errors = scanSyntax(input, [&parser, &readPastTheEnd](Token const& token) {
+    readPastTheEnd |= parser.read(token) == Status::Complete;
+  });
+  if (!result.errors.empty()) {
+    return result;
+  }
+
+  // any input free of syntax errors is a complete expression, which ends with the input
+  if (readPastTheEnd || parser.read(Token{TokenType::Stop, ""}) != Status::Complete) {
+    throw std::logic_error("Could not parse an input free of syntax errors.");
+  }
+  result.tree = optimise(parser.takeTree(), resource);
+  return result;
+}
+
+SymbolTable& ArithmeticParser::symbols() {
+  return *m_symbols;
+}
+
+void ArithmeticParser::setConstantFolding(bool enabled) {
+  m_foldsConstants = enabled;
+}
+
+bool ArithmeticParser::foldsConstants() const {
+  return m_foldsConstants;
+}
+
+void ArithmeticParser::setChainFlattening(bool enabled) {
+  m_flattensChains = enabled;
+}
+
+bool ArithmeticParser::flattensChains() const {
+  return m_flattensChains;
+}
+
+void ArithmeticParser::setPolynomialRecognition(bool enabled) {
+  m_recognisesPolynomials = enabled;
+}
+
+bool ArithmeticParser::recognisesPolynomials() const {
+  return m_recognisesPolynomials;
+}
+
+void ArithmeticParser::setStrengthReduction(bool enabled) {
+  m_reducesStrength = enabled;
+}
+
+bool ArithmeticParser::reducesStrength() const {
+  return m_reducesStrength;
+}
+
+void ArithmeticParser::setMultiplyAddContraction(bool enabled, MultiplyAddRounding rounding) {
+  m_contractsMultiplyAdds = enabled;
+  m_multiplyAddRounding = rounding;
+}
+
+bool ArithmeticParser::contractsMultiplyAdds() const {
+  return m_contractsMultiplyAdds;
+}
+
+MultiplyAddRounding ArithmeticParser::multiplyAddRounding() const {
+  return m_multiplyAddRounding;
+}
+
+void ArithmeticParser::setMemoisation(Memoisation memoisation) {
+  m_memoisation = memoisation;
+}
+
+Memoisation ArithmeticParser::memoisation() const {
+  return m_memoisation;
+}
+
+void ArithmeticParser::setParsingEngine(ParsingEngine engine) {
+  m_engine = engine;
+}
+
+ArithmeticParser::ParsingEngine ArithmeticParser::parsingEngine() const {
+  return m_engine;
+}
+
+std::unique_ptr<Expression> ArithmeticParser::optimise(std::unique_ptr<Expression> tree,
+                                                       std::pmr::memory_resource& resource) const {
+  if (m_flattensChains) {
+    tree = flattenAssociativeChains(std::move(tree), SummationMode::Sequential, resource).tree;
+  }
+  if (m_foldsConstants) {
+    tree = foldConstants(std::move(tree), resource).tree;
+  }
+  if (m_recognisesPolynomials) {
+    tree = recognisePolynomials(std::move(tree), resource).tree;
+  }
+  if (m_reducesStrength) {
+    tree = reduceStrength(std::move(tree), resource).tree;
+  }
+  if (m_contractsMultiplyAdds) {
+    tree = contractMultiplyAdds(std::move(tree), m_multiplyAddRounding, resource).tree;
+  }
+  if (m_memoisation == Memoisation::ConstantSubtrees) {
+    tree = memoiseConstantSubtrees(std::move(tree), resource).tree;
+  }
+  return tree;
 }
 
 }
\ No newline at end of file
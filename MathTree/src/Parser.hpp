@@ -1,13 +1,17 @@
 #ifndef MATHTREE_PARSER
 #define MATHTREE_PARSER
 
+#include <array>
 #include <memory>
 #include <optional>
 #include "Expression.hpp"
 #include "InfixParselets.hpp"
 #include "Lexer.hpp"
 #include <limits>
+#include <memory_resource>
 #include "PrefixParselets.hpp"
+#include <stdexcept>
+#include "SymbolTable.hpp"
 #include "Token.hpp"
 #include <unordered_map>
 
@@ -26,37 +30,66 @@ public:
   virtual std::unique_ptr<Expression> parse(int priority) = 0;
   /// Returns the current token and removes it from the internal cache.
   virtual Token consumeCurrentToken() = 0;
+  /// Returns the memory resource from which the expressions being parsed are allocated.
+  virtual std::pmr::memory_resource& memoryResource();
+  /// Returns the symbol table in which the variables being parsed are declared, or null if there is none.
+  virtual std::shared_ptr<SymbolTable> symbols();
   
   AbstractPrattParser& operator=(AbstractPrattParser const&) = delete;
   AbstractPrattParser& operator=(AbstractPrattParser&&) = delete;
   virtual ~AbstractPrattParser() = default;
 };
 
-/// A Pratt parser implementation.
+/**
+ * The parselets that make up the grammar understood by a Pratt parser.
+ * Once built, a grammar is only read by the parsers using it, so it can be shared
+ * by any number of parsers running on different threads.
+ **/
+class PrattGrammar {
+public:
+  /// Uniquely associates a token type to a prefix parselet.
+  void setPrefixParselet(TokenType token, std::unique_ptr<PrefixParselet> parselet);
+  /// Uniquely associates a token type to an infix parselet.
+  void setInfixParselet(TokenType token, std::unique_ptr<InfixParselet> parselet);
+  /// Returns the prefix parselet associated to the given token type, or null if there is none.
+  PrefixParselet const* prefixParseletFor(TokenType token) const;
+  /// Returns the infix parselet associated to the given token type, or null if there is none.
+  InfixParselet const* infixParseletFor(TokenType token) const;
+
+private:
+  std::unordered_map<TokenType, std::unique_ptr<PrefixParselet>> m_prefixParselets;
+  std::unordered_map<TokenType, std::unique_ptr<InfixParselet>> m_infixParselets;
+};
+
+/**
+ * A Pratt parser implementation.
+ * The parser only holds the state of the parse in progress, and is cheap enough to
+ * be constructed on the stack for every input. The grammar and the lexer must outlive it.
+ **/
 class PrattParser: public AbstractPrattParser {
 public:
   /// Represents the minimum priority that a token can have when being parsed.
   static auto constexpr minAllowedPriority = std::numeric_limits<int>::min();
-  /// Constructs a Pratt parser with the given lexer as its source of tokens.
-  PrattParser(std::unique_ptr<Lexer> lexer);
+  /**
+   * Constructs a Pratt parser which recognises the given grammar, and uses the given lexer as its
+   * source of tokens. Variables are declared in the symbol table provided, if any, and expressions
+   * are allocated from the given memory resource, which must outlive them.
+   **/
+  PrattParser(PrattGrammar const& grammar,
+              Lexer& lexer,
+              std::shared_ptr<SymbolTable> symbols = nullptr,
+              std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
 
   //! @copydoc AbstractPrattParser::parse()
   std::unique_ptr<Expression> parse() override;
   //! @copydoc AbstractPrattParser::parse(int)
   std::unique_ptr<Expression> parse(int priority) override;
-  /**
-   * Returns the expression tree produced by parsing the input string
-   * with the priority provided.
-   * Effectively sets the internal lexer to tokenise the given input string.
-   **/
-  std::unique_ptr<Expression> parse(std::string input,
-                                    int priority = minAllowedPriority);
-  /// Uniquely associates a token type to a prefix parselet.
-  void setPrefixParselet(TokenType token, std::unique_ptr<PrefixParselet> parselet);
-  /// Uniquely associates a token type to an infix parselet.
-  void setInfixParselet(TokenType token, std::unique_ptr<InfixParselet> parselet);
   //! @copydoc AbstractPrattParser::consumeCurrentToken()
   Token consumeCurrentToken() override;
+  //! @copydoc AbstractPrattParser::memoryResource()
+  std::pmr::memory_resource& memoryResource() override;
+  //! @copydoc AbstractPrattParser::symbols()
+  std::shared_ptr<SymbolTable> symbols() override;
   
 private:
   class ReferenceCountingResetter;
@@ -65,13 +98,132 @@ private:
   int infixPriorityFor(Token const& token);
   Token const& currentToken();
 
+  PrattGrammar const& m_grammar;
+  Lexer& m_lexer;
+  std::shared_ptr<SymbolTable> m_symbols;
+  std::pmr::memory_resource& m_memoryResource;
+  std::optional<Token> m_currentToken;
+  int m_parseCallCount = 0;
+};
+
+/**
+ * A Pratt parser whose grammar is fixed at compile time, which suits grammars that are never
+ * configured at run time. The grammar is a type providing the following static functions, which the
+ * parser calls directly, rather than looking up parselets and calling them virtually, so they can be inlined:
+ * - int infixPriority(TokenType), returning the priority of the infix operation of a token type,
+ *   or minAllowedPriority if there is none;
+ * - template<typename Parser> std::unique_ptr<Expression> parsePrefix(Parser&, Token const&),
+ *   building the expression starting with the token given, and throwing if there is none;
+ * - template<typename Parser> std::unique_ptr<Expression> parseInfix(Parser&, std::unique_ptr<Expression>, Token const&),
+ *   building the infix operation of the token given from its left operand.
+ * Like PrattParser, the parser only holds the state of the parse in progress, and the lexer must outlive it.
+ **/
+template<typename Grammar>
+class StaticPrattParser {
+public:
+  /// Represents the minimum priority that a token can have when being parsed.
+  static auto constexpr minAllowedPriority = PrattParser::minAllowedPriority;
+  /**
+   * Constructs a Pratt parser which uses the given lexer as its source of tokens. Variables are declared
+   * in the symbol table provided, if any, and expressions are allocated from the given memory resource,
+   * which must outlive them.
+   **/
+  explicit StaticPrattParser(Lexer& lexer,
+                             std::shared_ptr<SymbolTable> symbols = nullptr,
+                             std::pmr::memory_resource& resource = *std::pmr::get_default_resource());
+
+  //! @copydoc AbstractPrattParser::parse()
+  std::unique_ptr<Expression> parse();
+  //! @copydoc AbstractPrattParser::parse(int)
+  std::unique_ptr<Expression> parse(int priority);
+  //! @copydoc AbstractPrattParser::consumeCurrentToken()
+  Token consumeCurrentToken();
+  //! @copydoc AbstractPrattParser::memoryResource()
+  std::pmr::memory_resource& memoryResource();
+  //! @copydoc AbstractPrattParser::symbols()
+  std::shared_ptr<SymbolTable> const& symbols();
+
+private:
+  class ParseCallCounter;
+
+  Token const& currentToken();
+
+  Lexer& m_lexer;
+  std::shared_ptr<SymbolTable> m_symbols;
+  std::pmr::memory_resource& m_memoryResource;
   std::optional<Token> m_currentToken;
-  std::unordered_map<TokenType, std::unique_ptr<PrefixParselet>> m_prefixParselets;
-  std::unordered_map<TokenType, std::unique_ptr<InfixParselet>> m_infixParselets;
-  std::unique_ptr<Lexer> m_lexer;
   int m_parseCallCount = 0;
 };
 
+// resets the parser once the outermost call to parse returns, like PrattParser does
+template<typename Grammar>
+class StaticPrattParser<Grammar>::ParseCallCounter {
+public:
+  ParseCallCounter(StaticPrattParser& parser): m_parser(parser) {
+    ++m_parser.m_parseCallCount;
+  }
+  ~ParseCallCounter() {
+    if (--m_parser.m_parseCallCount <= 0) {
+      m_parser.m_currentToken = std::nullopt;
+      m_parser.m_lexer.reset();
+    }
+  }
+
+private:
+  StaticPrattParser& m_parser;
+};
+
+template<typename Grammar>
+StaticPrattParser<Grammar>::StaticPrattParser(Lexer& lexer,
+                                              std::shared_ptr<SymbolTable> symbols,
+                                              std::pmr::memory_resource& resource): m_lexer(lexer),
+                                                                                    m_symbols(std::move(symbols)),
+                                                                                    m_memoryResource(resource) {}
+
+template<typename Grammar>
+std::unique_ptr<Expression> StaticPrattParser<Grammar>::parse() {
+  return parse(minAllowedPriority);
+}
+
+template<typename Grammar>
+std::unique_ptr<Expression> StaticPrattParser<Grammar>::parse(int priority) {
+  ParseCallCounter counter(*this);
+  auto token = consumeCurrentToken();
+  auto left = Grammar::parsePrefix(*this, token);
+
+  while (priority < Grammar::infixPriority(currentToken().type())) {
+    token = consumeCurrentToken();
+    left = Grammar::parseInfix(*this, std::move(left), token);
+  }
+
+  return left;
+}
+
+template<typename Grammar>
+Token StaticPrattParser<Grammar>::consumeCurrentToken() {
+  auto token = currentToken();
+  m_currentToken = std::nullopt;
+  return token;
+}
+
+template<typename Grammar>
+std::pmr::memory_resource& StaticPrattParser<Grammar>::memoryResource() {
+  return m_memoryResource;
+}
+
+template<typename Grammar>
+std::shared_ptr<SymbolTable> const& StaticPrattParser<Grammar>::symbols() {
+  return m_symbols;
+}
+
+template<typename Grammar>
+Token const& StaticPrattParser<Grammar>::currentToken() {
+  if (!m_currentToken.has_value()) {
+    m_currentToken = m_lexer.next();
+  }
+  return *m_currentToken;
+}
+
 /// Represents a parser of arithmetic expressions.
 class ArithmeticParser {
 public:
@@ -88,11 +240,39 @@ public:
     /// Unknown symbol.
     UnrecognisedSymbol,
     /// Brackets that do not enclose anything between them.
-    NothingBetweenBrackets
+    NothingBetweenBrackets,
+    /// An input without any symbol other than spaces.
+    EmptyExpression,
+    /// A logarithm whose explicit base is not a finite, positive number.
+    InvalidLogarithmBase,
+    /**
+     * A name starting with the symbol of a function, such as logistic, sqrtx or log_x, which cannot name a variable
+     * as it would read as the function applied to the rest of the name.
+     **/
+    ReservedPrefix
   };
   /// A list of pairs containing an index and its corresponding syntax error, in this order.
   using IndexErrorPairs = std::vector<std::pair<size_t, SyntaxErrors>>;
 
+  /// Represents the outcome of ArithmeticParser::tryParse, which is either a tree or the syntax errors of the input.
+  struct ParseResult {
+    /// The tree of expressions parsed from the input, or null if the input has syntax errors.
+    std::unique_ptr<Expression> tree;
+    /// The syntax errors of the input, as returned by validateSyntax, or an empty list if the tree was built.
+    IndexErrorPairs errors;
+  };
+
+  /// Represents the ways in which the parser can go through the tokens of the input.
+  enum class ParsingEngine {
+    /// A Pratt parser recursing once per nesting level, whose native stack grows with the depth of the input.
+    Recursive,
+    /**
+     * An operator-precedence parser keeping the operations waiting for an operand on an explicit stack.
+     * It builds the same trees in linear time and with a bounded native stack, whatever the depth of the input.
+     **/
+    Iterative
+  };
+
   /// A number indicating the order in which operations are solved. Higher is solved earlier.
   enum class OperationPriority {
     Addition = 1,
@@ -112,19 +292,230 @@ public:
    **/
   static IndexErrorPairs validateSyntax(std::string_view input);
   
-  /// Creates a parser for arithmetic expressions.
+  /**
+   * Returns the grammar of arithmetic expressions, which is built once and shared by all parsers.
+   * The arithmetic parser itself parses with ArithmeticGrammar, which is the same grammar fixed at compile time.
+   **/
+  static PrattGrammar const& grammar();
+
+  /// Creates a parser for arithmetic expressions, with an empty symbol table.
   ArithmeticParser();
 
   /**
    * Returns a tree of expressions by parsing the given expression.
    * It is recommended to validate the syntax before parsing.
+   * Any variable found is declared in the symbol table of the parser, which
+   * can then be used to bind it before evaluating the tree.
+   * Parsing keeps no state in the parser, so many threads can parse at once,
+   * as long as they do not declare variables in the same symbol table.
+   * The input is read in place and is not referenced by the tree, so it only needs to outlive the call.
   **/
-  std::unique_ptr<Expression> parse(std::string input);
+  std::unique_ptr<Expression> parse(std::string_view input) const;
+  /**
+   * Returns a tree of expressions by parsing the given expression, like parse(std::string_view),
+   * but allocates every expression of the tree from the memory resource provided.
+   * The resource must outlive the tree. With a std::pmr::monotonic_buffer_resource, a parse
+   * makes no allocation other than growing the buffer, and destroying the tree frees no memory:
+   * the whole tree is released at once with the buffer.
+   **/
+  std::unique_ptr<Expression> parse(std::string_view input, std::pmr::memory_resource& resource) const;
+  /**
+   * Returns a tree of expressions by parsing the given expression, like parse(std::string_view,std::pmr::memory_resource&),
+   * but declares any variable found in the symbol table provided rather than in the one of the parser.
+   * Threads parsing with the same parser can each use their own symbol table.
+   **/
+  std::unique_ptr<Expression> parse(std::string_view input,
+                                    std::shared_ptr<SymbolTable> symbols,
+                                    std::pmr::memory_resource& resource = *std::pmr::get_default_resource()) const;
+  /**
+   * Validates the syntax of the input and parses it in a single pass, without ever throwing on a malformed input.
+   * Returns the tree of expressions, built as parse(std::string_view) would, if the input is free of syntax errors,
+   * or the same errors as validateSyntax otherwise. The tree is always built without recursion, whatever the
+   * parsing engine. Variables read before the first error is found may be declared in the symbol table.
+   **/
+  ParseResult tryParse(std::string_view input) const;
+  /// Validates and parses the input like tryParse(std::string_view), allocating the tree from the memory resource provided.
+  ParseResult tryParse(std::string_view input, std::pmr::memory_resource& resource) const;
+  /**
+   * Validates and parses the input like tryParse(std::string_view,std::pmr::memory_resource&),
+   * but declares any variable found in the symbol table provided rather than in the one of the parser.
+   **/
+  ParseResult tryParse(std::string_view input,
+                       std::shared_ptr<SymbolTable> symbols,
+                       std::pmr::memory_resource& resource = *std::pmr::get_default_resource()) const;
+  /// Returns the symbol table shared by all the trees built by this parser.
+  SymbolTable& symbols();
+  /**
+   * Sets whether the trees built by the parser have the subtrees not depending on variables
+   * collapsed into single numbers, as done by foldConstants. Disabled by default.
+   **/
+  void setConstantFolding(bool enabled);
+  /// Returns true if the trees built by the parser have their constant subtrees collapsed, false otherwise.
+  bool foldsConstants() const;
+  /**
+   * Sets whether the trees built by the parser have their chains of additions, subtractions and
+   * multiplications merged into n-ary nodes, as done by flattenAssociativeChains with sequential summation.
+   * Flattening takes place before constant folding. Disabled by default.
+   **/
+  void setChainFlattening(bool enabled);
+  /// Returns true if the trees built by the parser have their chains merged into n-ary nodes, false otherwise.
+  bool flattensChains() const;
+  /**
+   * Sets whether the trees built by the parser have their polynomials of a single variable replaced by
+   * PolynomialExpression nodes, as done by recognisePolynomials. Recognition takes place after constant folding.
+   * Disabled by default.
+   **/
+  void setPolynomialRecognition(bool enabled);
+  /// Returns true if the trees built by the parser have their polynomials replaced by PolynomialExpression nodes, false otherwise.
+  bool recognisesPolynomials() const;
+  /**
+   * Sets whether the trees built by the parser have their operations replaced by cheaper equivalents,
+   * as done by reduceStrength. Reduction takes place after constant folding and polynomial recognition.
+   * Disabled by default.
+   **/
+  void setStrengthReduction(bool enabled);
+  /// Returns true if the trees built by the parser have their operations replaced by cheaper equivalents, false otherwise.
+  bool reducesStrength() const;
+  /**
+   * Sets whether the trees built by the parser have their multiply-adds contracted into FmaExpression nodes
+   * rounding as given, as done by contractMultiplyAdds. Contraction takes place after all other optimisations,
+   * so chains merged by flattening are not contracted. Disabled by default.
+   **/
+  void setMultiplyAddContraction(bool enabled, MultiplyAddRounding rounding = MultiplyAddRounding::Fused);
+  /// Returns true if the trees built by the parser have their multiply-adds contracted, false otherwise.
+  bool contractsMultiplyAdds() const;
+  /// Returns how the multiply-adds contracted by the parser round their results.
+  MultiplyAddRounding multiplyAddRounding() const;
+  /**
+   * Sets which results of the trees built by the parser are kept across evaluations. With
+   * Memoisation::ConstantSubtrees, their largest constant subtrees are memoised as done by memoiseConstantSubtrees,
+   * after all other optimisations, which takes no recursion. Memoisation::None by default, so that the nodes of
+   * the trees take no memory for results unless asked to.
+   **/
+  void setMemoisation(Memoisation memoisation);
+  /// Returns which results of the trees built by the parser are kept across evaluations.
+  Memoisation memoisation() const;
+  /**
+   * Sets the engine going through the tokens of the input. ParsingEngine::Recursive by default.
+   * With ParsingEngine::Iterative, deeply nested inputs are parsed without recursing, and so are optimised,
+   * as every optimisation walks the tree without recursing.
+   **/
+  void setParsingEngine(ParsingEngine engine);
+  /// Returns the engine going through the tokens of the input.
+  ParsingEngine parsingEngine() const;
 
 private:
-  PrattParser m_parser;
+  // applies the optimisations enabled on the parser to a tree it has just built
+  std::unique_ptr<Expression> optimise(std::unique_ptr<Expression> tree, std::pmr::memory_resource& resource) const;
+
+  std::shared_ptr<SymbolTable> m_symbols;
+  bool m_foldsConstants = false;
+  bool m_flattensChains = false;
+  bool m_recognisesPolynomials = false;
+  bool m_reducesStrength = false;
+  bool m_contractsMultiplyAdds = false;
+  MultiplyAddRounding m_multiplyAddRounding = MultiplyAddRounding::Fused;
+  Memoisation m_memoisation = Memoisation::None;
+  ParsingEngine m_engine = ParsingEngine::Recursive;
+};
+
+/**
+ * The grammar of arithmetic expressions for StaticPrattParser, which recognises the same expressions
+ * as ArithmeticParser::grammar(). The priorities are read from a table indexed by token type,
+ * and the expressions are built by switching on the token type instead of through parselets.
+ **/
+class ArithmeticGrammar {
+public:
+  /// Returns the priority of the binary operation of the given token type, or PrattParser::minAllowedPriority if there is none.
+  static int infixPriority(TokenType type);
+  /// Returns the expression starting with the given token. Throws if no expression can start with it.
+  template<typename Parser>
+  static std::unique_ptr<Expression> parsePrefix(Parser& parser, Token const& token);
+  /// Returns the binary operation of the given token, applied to the left operand given and to the parser's next expression.
+  template<typename Parser>
+  static std::unique_ptr<Expression> parseInfix(Parser& parser, std::unique_ptr<Expression> left, Token const& token);
+
+private:
+  static int constexpr priorityOf(ArithmeticParser::OperationPriority priority) {
+    return static_cast<int>(priority);
+  }
 };
 
+inline int ArithmeticGrammar::infixPriority(TokenType type) {
+  static auto constexpr priorities = [] {
+    std::array<int, tokenTypeCount> priorities{};
+    for (auto& priority: priorities) {
+      priority = PrattParser::minAllowedPriority;
+    }
+    priorities[static_cast<size_t>(TokenType::Plus)] = priorityOf(ArithmeticParser::OperationPriority::Addition);
+    priorities[static_cast<size_t>(TokenType::Minus)] = priorityOf(ArithmeticParser::OperationPriority::Subtraction);
+    priorities[static_cast<size_t>(TokenType::Asterisk)] = priorityOf(ArithmeticParser::OperationPriority::Multiplication);
+    priorities[static_cast<size_t>(TokenType::Slash)] = priorityOf(ArithmeticParser::OperationPriority::Division);
+    priorities[static_cast<size_t>(TokenType::Caret)] = priorityOf(ArithmeticParser::OperationPriority::Exponentiation);
+    return priorities;
+  }();
+  return priorities[static_cast<size_t>(type)];
+}
+
+template<typename Parser>
+std::unique_ptr<Expression> ArithmeticGrammar::parsePrefix(Parser& parser, Token const& token) {
+  using Priority = ArithmeticParser::OperationPriority;
+  auto& resource = parser.memoryResource();
+  switch (token.type()) {
+  case TokenType::Number:
+    return allocateExpression<RealNumberExpression>(resource, token.value());
+  case TokenType::Variable: {
+    auto const& symbols = parser.symbols();
+    if (symbols == nullptr) {
+      throw std::logic_error("Cannot parse a variable without a symbol table.");
+    }
+    auto const index = symbols->declare(token.text());
+    return allocateExpression<VariableExpression>(resource, symbols, index);
+  }
+  case TokenType::OpeningBracket: {
+    auto expression = parser.parse();
+    if (parser.consumeCurrentToken().type() != TokenType::ClosingBracket) {
+      throw std::logic_error("Expected a closing bracket during parsing.");
+    }
+    return expression;
+  }
+  case TokenType::Plus:
+    return parser.parse(priorityOf(Priority::Sign));
+  case TokenType::Minus:
+    return allocateExpression<NegativeSignExpression>(resource, token.type(), parser.parse(priorityOf(Priority::Sign)));
+  case TokenType::SquareRoot:
+    return allocateExpression<SquareRootExpression>(resource, parser.parse(priorityOf(Priority::SquareRoot)), token.type());
+  case TokenType::Log: {
+    // the lexer decodes the base written after the delimeter, if any
+    auto const base = token.text().size() > symboliseTokenType(TokenType::Log).size() ? token.value() : 10.0;
+    return allocateExpression<LogarithmExpression>(resource, parser.parse(priorityOf(Priority::Logarithm)), base, token.type());
+  }
+  default:
+    throw std::logic_error("Expected a prefix parselet while parsing.");
+  }
+}
+
+template<typename Parser>
+std::unique_ptr<Expression> ArithmeticGrammar::parseInfix(Parser& parser, std::unique_ptr<Expression> left, Token const& token) {
+  auto const priority = infixPriority(token.type());
+  auto& resource = parser.memoryResource();
+  switch (token.type()) {
+  case TokenType::Plus:
+    return allocateExpression<AdditionExpression>(resource, std::move(left), token.type(), parser.parse(priority));
+  case TokenType::Minus:
+    return allocateExpression<SubtractionExpression>(resource, std::move(left), token.type(), parser.parse(priority));
+  case TokenType::Asterisk:
+    return allocateExpression<MultiplicationExpression>(resource, std::move(left), token.type(), parser.parse(priority));
+  case TokenType::Slash:
+    return allocateExpression<DivisionExpression>(resource, std::move(left), token.type(), parser.parse(priority));
+  case TokenType::Caret:
+    // right associativity needs a lower priority
+    return allocateExpression<ExponentiationExpression>(resource, std::move(left), token.type(), parser.parse(priority - 1));
+  default:
+    throw std::logic_error("Expected an infix parselet while parsing.");
+  }
+}
+
 }
 
 #endif // MATHTREE_PARSER
\ No newline at end of file
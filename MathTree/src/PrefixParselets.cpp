@@ -2,15 +2,23 @@
 #include "Parser.hpp"
 #include "PrefixParselets.hpp"
 #include <stdexcept>
-#include "Utils.hpp"
 
 namespace MathTree {
 
-std::unique_ptr<Expression> NumberParselet::parse(AbstractPrattParser&, Token const& token) {
-  return std::make_unique<RealNumberExpression>(token.text());
+std::unique_ptr<Expression> NumberParselet::parse(AbstractPrattParser& parser, Token const& token) const {
+  return allocateExpression<RealNumberExpression>(parser.memoryResource(), token.value());
 }
 
-std::unique_ptr<Expression> GroupParselet::parse(AbstractPrattParser& parser, Token const&) {
+std::unique_ptr<Expression> VariableParselet::parse(AbstractPrattParser& parser, Token const& token) const {
+  auto symbols = parser.symbols();
+  if (symbols == nullptr) {
+    throw std::logic_error("Cannot parse a variable without a symbol table.");
+  }
+  auto index = symbols->declare(token.text());
+  return allocateExpression<VariableExpression>(parser.memoryResource(), std::move(symbols), index);
+}
+
+std::unique_ptr<Expression> GroupParselet::parse(AbstractPrattParser& parser, Token const&) const {
   auto expression = parser.parse();
   auto nextToken = parser.consumeCurrentToken();
   if (nextToken.type() != TokenType::ClosingBracket) {
@@ -21,35 +29,32 @@ std::unique_ptr<Expression> GroupParselet::parse(AbstractPrattParser& parser, To
 
 SquareRootParselet::SquareRootParselet(int priority): m_priority(priority) {}
 
-std::unique_ptr<Expression> SquareRootParselet::parse(AbstractPrattParser& parser, Token const& token) {
-  return std::make_unique<SquareRootExpression>(parser.parse(m_priority), token.type());
+std::unique_ptr<Expression> SquareRootParselet::parse(AbstractPrattParser& parser, Token const& token) const {
+  return allocateExpression<SquareRootExpression>(parser.memoryResource(), parser.parse(m_priority), token.type());
 }
 
 NegativeSignParselet::NegativeSignParselet(int priority): m_priority(priority) {}
 
-std::unique_ptr<Expression> NegativeSignParselet::parse(AbstractPrattParser& parser, Token const& token) {
-  return std::make_unique<NegativeSignExpression>(token.type(), parser.parse(m_priority));
+std::unique_ptr<Expression> NegativeSignParselet::parse(AbstractPrattParser& parser, Token const& token) const {
+  return allocateExpression<NegativeSignExpression>(parser.memoryResource(), token.type(), parser.parse(m_priority));
 }
 
 PositiveSignParselet::PositiveSignParselet(int priority): m_priority(priority) {}
 
-std::unique_ptr<Expression> PositiveSignParselet::parse(AbstractPrattParser& parser, Token const&) {
+std::unique_ptr<Expression> PositiveSignParselet::parse(AbstractPrattParser& parser, Token const&) const {
   return parser.parse(m_priority);
 }
 
 LogarithmParselet::LogarithmParselet(int priority): m_priority(priority) {}
 
-std::unique_ptr<Expression> LogarithmParselet::parse(AbstractPrattParser& parser, Token const& token) {
+std::unique_ptr<Expression> LogarithmParselet::parse(AbstractPrattParser& parser, Token const& token) const {
   double base = 10.0;
   auto const logSymbol = symboliseTokenType(token.type());
   if (token.text().size() > logSymbol.size()) {
-    auto const baseStr = token.text().substr(logSymbol.size() +
-                                             delimeterFor(TokenType::Log).size());
-    if (auto baseOpt = Utils::parseFirstDouble(baseStr)) {
-      base = *baseOpt;
-    }
+    // the lexer decodes the base written after the delimeter
+    base = token.value();
   }
-  return std::make_unique<LogarithmExpression>(parser.parse(m_priority), base, token.type());
+  return allocateExpression<LogarithmExpression>(parser.memoryResource(), parser.parse(m_priority), base, token.type());
 }
 
 }
\ No newline at end of file
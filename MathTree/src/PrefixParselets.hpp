@@ -12,7 +12,7 @@ class AbstractPrattParser;
 class PrefixParselet {
 public:
   /// Constructs an expression using the Pratt parser and the token given.
-  virtual std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) = 0;
+  virtual std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) const = 0;
 
   PrefixParselet& operator=(PrefixParselet const&) = delete;
   PrefixParselet& operator=(PrefixParselet&&) = delete;
@@ -23,14 +23,24 @@ public:
 class NumberParselet: public PrefixParselet {
 public:
   /// Builds a real number expression using the token provided. 
-  std::unique_ptr<Expression> parse(AbstractPrattParser&, Token const& token) override;
+  std::unique_ptr<Expression> parse(AbstractPrattParser&, Token const& token) const override;
+};
+
+/// Responsible for building variable expressions from a token.
+class VariableParselet: public PrefixParselet {
+public:
+  /**
+   * Builds a variable expression named after the text of the token provided, declaring
+   * it in the symbol table of the parser. Throws if the parser has no symbol table.
+   **/
+  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) const override;
 };
 
 /// Responsible for grouping together multiple subexpressions into one cohesive expression.
 class GroupParselet: public PrefixParselet {
 public:
   /// Parses an expression from a group of subexpressions. Expects the group to be terminated by a closing bracket.
-  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const&) override;
+  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const&) const override;
 };
 
 /// Responsible for building a square root expression from a token.
@@ -39,7 +49,7 @@ public:
   /// Constructs a square root parselet with the given priority.
   SquareRootParselet(int priority);
   /// Returns a square root expression applied to the parser's next expression and using the token type of the given token.
-  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) override;
+  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) const override;
 private:
   int m_priority{0};
 };
@@ -50,7 +60,7 @@ public:
   /// Constructs a negative sign parselet with the given priority.
   NegativeSignParselet(int priority);
   /// Returns a negative sign expression applied to the parser's next expression and using the token type of the given token.
-  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) override;
+  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) const override;
 
 private:
   int m_priority{0};
@@ -62,7 +72,7 @@ public:
   /// Constructs a positive sign parselet with the given priority.
   PositiveSignParselet(int priority);
   /// Returns the parser's next expression associated to the token type of the given token.
-  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) override;
+  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) const override;
 
 private:
   int m_priority{0};
@@ -78,7 +88,7 @@ public:
    * the token type of the given token.
    * If no base is specified, it is assumed to be 10.
    **/
-  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) override;
+  std::unique_ptr<Expression> parse(AbstractPrattParser& parser, Token const& token) const override;
 private:
   int m_priority{0};
 };
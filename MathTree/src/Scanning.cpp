@@ -0,0 +1,180 @@
+#include "Scanning.hpp"
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MATHTREE_X86_64
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MATHTREE_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define MATHTREE_AVX2_TARGET
+#endif
+
+namespace MathTree {
+
+namespace Scanning {
+
+namespace {
+
+struct Scanners {
+  size_t (*skipSpaces)(char const* text, size_t index, size_t size);
+  size_t (*skipNumberCharacters)(char const* text, size_t index, size_t size);
+};
+
+namespace Scalar {
+
+size_t skipSpaces(char const* text, size_t index, size_t size) {
+  while (index < size && isSpace(text[index])) {
+    ++index;
+  }
+  return index;
+}
+
+size_t skipNumberCharacters(char const* text, size_t index, size_t size) {
+  while (index < size && (isDigit(text[index]) || text[index] == '.')) {
+    ++index;
+  }
+  return index;
+}
+
+Scanners constexpr scanners{skipSpaces, skipNumberCharacters};
+
+}
+
+#ifdef MATHTREE_X86_64
+unsigned countTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Both instruction sets find the characters of a range [first, first + span] by subtracting first,
+// and then by checking that the difference, seen as unsigned, is left unchanged by a minimum with span.
+
+namespace Sse2 {
+
+unsigned spaceMask(__m128i chunk) {
+  auto const controls = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+  auto const isControl = _mm_cmpeq_epi8(_mm_min_epu8(controls, _mm_set1_epi8('\r' - '\t')), controls);
+  return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(isControl, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')))));
+}
+
+unsigned numberMask(__m128i chunk) {
+  auto const digits = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+  auto const isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+  return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(isDigit, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('.')))));
+}
+
+size_t skipSpaces(char const* text, size_t index, size_t size) {
+  for (; index + 16 <= size; index += 16) {
+    auto const mask = spaceMask(_mm_loadu_si128(reinterpret_cast<__m128i const*>(text + index)));
+    if (mask != 0xFFFF) {
+      return index + countTrailingZeros(~mask);
+    }
+  }
+  return Scalar::skipSpaces(text, index, size);
+}
+
+size_t skipNumberCharacters(char const* text, size_t index, size_t size) {
+  for (; index + 16 <= size; index += 16) {
+    auto const mask = numberMask(_mm_loadu_si128(reinterpret_cast<__m128i const*>(text + index)));
+    if (mask != 0xFFFF) {
+      return index + countTrailingZeros(~mask);
+    }
+  }
+  return Scalar::skipNumberCharacters(text, index, size);
+}
+
+Scanners constexpr scanners{skipSpaces, skipNumberCharacters};
+
+}
+
+namespace Avx2 {
+
+MATHTREE_AVX2_TARGET unsigned spaceMask(__m256i chunk) {
+  auto const controls = _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+  auto const isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(controls, _mm256_set1_epi8('\r' - '\t')), controls);
+  return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(isControl,
+                                                                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')))));
+}
+
+MATHTREE_AVX2_TARGET unsigned numberMask(__m256i chunk) {
+  auto const digits = _mm256_sub_epi8(chunk, _mm256_set1_epi8('0'));
+  auto const isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+  return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(isDigit,
+                                                                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('.')))));
+}
+
+MATHTREE_AVX2_TARGET size_t skipSpaces(char const* text, size_t index, size_t size) {
+  for (; index + 32 <= size; index += 32) {
+    auto const mask = spaceMask(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + index)));
+    if (mask != 0xFFFFFFFF) {
+      return index + countTrailingZeros(~mask);
+    }
+  }
+  return Sse2::skipSpaces(text, index, size);
+}
+
+MATHTREE_AVX2_TARGET size_t skipNumberCharacters(char const* text, size_t index, size_t size) {
+  for (; index + 32 <= size; index += 32) {
+    auto const mask = numberMask(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + index)));
+    if (mask != 0xFFFFFFFF) {
+      return index + countTrailingZeros(~mask);
+    }
+  }
+  return Sse2::skipNumberCharacters(text, index, size);
+}
+
+Scanners constexpr scanners{skipSpaces, skipNumberCharacters};
+
+}
+#endif
+
+Scanners const& scannersFor(Utils::InstructionSet instructionSet) {
+  if (!Utils::isSupported(instructionSet)) {
+    throw std::logic_error("Cannot scan with an instruction set which is not supported.");
+  }
+  switch (instructionSet) {
+#ifdef MATHTREE_X86_64
+  case Utils::InstructionSet::Avx2:
+    return Avx2::scanners;
+  case Utils::InstructionSet::Sse2:
+    return Sse2::scanners;
+#endif
+  default:
+    return Scalar::scanners;
+  }
+}
+
+Scanners const& bestScanners() {
+  static Scanners const& scanners = scannersFor(Utils::bestInstructionSet());
+  return scanners;
+}
+
+}
+
+size_t skipSpaces(std::string_view source, size_t index) {
+  return bestScanners().skipSpaces(source.data(), index, source.size());
+}
+
+size_t skipSpaces(std::string_view source, size_t index, Utils::InstructionSet instructionSet) {
+  return scannersFor(instructionSet).skipSpaces(source.data(), index, source.size());
+}
+
+size_t skipNumberCharacters(std::string_view source, size_t index) {
+  return bestScanners().skipNumberCharacters(source.data(), index, source.size());
+}
+
+size_t skipNumberCharacters(std::string_view source, size_t index, Utils::InstructionSet instructionSet) {
+  return scannersFor(instructionSet).skipNumberCharacters(source.data(), index, source.size());
+}
+
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef MATHTREE_SCANNING
+#define MATHTREE_SCANNING
+
+#include <string_view>
+#include "Utils.hpp"
+
+namespace MathTree {
+
+/**
+ * Routines finding where runs of characters of the same class end in a string, which classify
+ * 16 characters at a time with SSE2 and 32 with AVX2. Unlike the functions of <cctype>,
+ * the classes of characters do not depend on the current locale.
+ **/
+namespace Scanning {
+
+/// Returns true if the character is a space, a tab, a line feed, a vertical tab, a form feed or a carriage return.
+constexpr bool isSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/// Returns true if the character is a decimal digit.
+constexpr bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/// Returns true if the character is an unaccented latin letter.
+constexpr bool isLetter(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/**
+ * Returns the index of the first character which is not a space, starting from the given index.
+ * Returns the size of the source if there is no such character.
+ **/
+size_t skipSpaces(std::string_view source, size_t index);
+/// Like skipSpaces(std::string_view,size_t), but uses the instruction set given. Throws if it is not supported.
+size_t skipSpaces(std::string_view source, size_t index, Utils::InstructionSet instructionSet);
+/**
+ * Returns the index of the first character which is neither a digit nor a decimal place, starting from the given index.
+ * Returns the size of the source if there is no such character.
+ **/
+size_t skipNumberCharacters(std::string_view source, size_t index);
+/// Like skipNumberCharacters(std::string_view,size_t), but uses the instruction set given. Throws if it is not supported.
+size_t skipNumberCharacters(std::string_view source, size_t index, Utils::InstructionSet instructionSet);
+
+}
+
+}
+
+#endif // MATHTREE_SCANNING
\ No newline at end of file
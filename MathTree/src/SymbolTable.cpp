@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <stdexcept>
+#include "SymbolTable.hpp"
+
+namespace MathTree {
+
+size_t SymbolTable::declare(std::string_view name) {
+  if (auto indexOpt = indexOf(name)) {
+    return *indexOpt;
+  }
+  m_names.emplace_back(name);
+  m_values.emplace_back(std::nullopt);
+  return m_names.size() - 1;
+}
+
+std::optional<size_t> SymbolTable::indexOf(std::string_view name) const {
+  // tables hold a handful of variables, so a linear search is faster than hashing
+  auto it = std::find(m_names.begin(), m_names.end(), name);
+  if (it == m_names.end()) {
+    return std::nullopt;
+  }
+  return static_cast<size_t>(it - m_names.begin());
+}
+
+size_t SymbolTable::bind(std::string_view name, double value) {
+  auto index = declare(name);
+  m_values[index] = value;
+  return index;
+}
+
+void SymbolTable::bind(size_t index, double value) {
+  if (index >= m_values.size()) {
+    throw std::out_of_range("Cannot bind a variable which was never declared.");
+  }
+  m_values[index] = value;
+}
+
+bool SymbolTable::isBound(size_t index) const {
+  return index < m_values.size() && m_values[index].has_value();
+}
+
+double SymbolTable::value(size_t index) const {
+  if (!isBound(index)) {
+    throw std::logic_error("Variable \"" + name(index) + "\" is not bound to any value.");
+  }
+  return *m_values[index];
+}
+
+double SymbolTable::valueOr(size_t index, double fallback) const {
+  return index < m_values.size() ? m_values[index].value_or(fallback) : fallback;
+}
+
+std::string const& SymbolTable::name(size_t index) const {
+  if (index >= m_names.size()) {
+    throw std::out_of_range("No variable was declared with index " + std::to_string(index) + ".");
+  }
+  return m_names[index];
+}
+
+size_t SymbolTable::size() const {
+  return m_names.size();
+}
+
+}
\ No newline at end of file
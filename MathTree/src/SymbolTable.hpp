@@ -0,0 +1,53 @@
+#ifndef MATHTREE_SYMBOLTABLE
+#define MATHTREE_SYMBOLTABLE
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MathTree {
+
+/**
+ * Associates the names of variables to the values they are bound to.
+ * Each variable is identified by the index it received when first declared,
+ * which never changes for the lifetime of the table.
+ **/
+class SymbolTable {
+public:
+  /// Returns the index of the variable with the given name, declaring it as unbound if not present.
+  size_t declare(std::string_view name);
+  /// Returns the index of the variable with the given name, or std::nullopt if it was never declared.
+  std::optional<size_t> indexOf(std::string_view name) const;
+  /// Binds the variable with the given name to a value, declaring it if not present. Returns its index.
+  size_t bind(std::string_view name, double value);
+  /// Binds the variable at the given index to a value. Throws if no such variable exists.
+  void bind(size_t index, double value);
+  /// Returns true if the variable at the given index is bound to a value, false otherwise.
+  bool isBound(size_t index) const;
+  /// Returns the value of the variable at the given index. Throws if the variable is unbound.
+  double value(size_t index) const;
+  /// Returns the value of the variable at the given index, or the fallback given if the variable is unbound or undeclared.
+  double valueOr(size_t index, double fallback) const;
+  /**
+   * Returns the value of the variable at the given index without checking that it is declared and bound,
+   * for the evaluations which have already ensured it. The behaviour is undefined otherwise.
+   **/
+  double boundValue(size_t index) const;
+  /// Returns the name of the variable at the given index. Throws if no such variable exists.
+  std::string const& name(size_t index) const;
+  /// Returns the number of variables declared.
+  size_t size() const;
+
+private:
+  std::vector<std::string> m_names;
+  std::vector<std::optional<double>> m_values;
+};
+
+inline double SymbolTable::boundValue(size_t index) const {
+  return *m_values[index];
+}
+
+}
+
+#endif // MATHTREE_SYMBOLTABLE
\ No newline at end of file
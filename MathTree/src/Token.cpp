@@ -2,16 +2,22 @@
 
 namespace MathTree {
 
-Token::Token(TokenType type, std::string text): m_type(type), m_text(std::move(text)) {}
+Token::Token(TokenType type, std::string_view text): m_type(type), m_text(text) {}
+
+Token::Token(TokenType type, std::string_view text, double value): m_type(type), m_text(text), m_value(value) {}
 
 TokenType Token::type() const {
   return m_type;
 }
 
-std::string const& Token::text() const {
+std::string_view Token::text() const {
   return m_text;
 }
 
+double Token::value() const {
+  return m_value;
+}
+
 bool Token::operator==(Token const& other) const {
   return other.m_text == m_text && other.m_type == m_type;
 }
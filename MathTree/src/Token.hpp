@@ -1,7 +1,6 @@
 #ifndef MATHTREE_TOKEN
 #define MATHTREE_TOKEN
 #include <stdexcept>
-#include <string>
 #include <string_view>
 
 namespace MathTree {
@@ -16,20 +15,36 @@ enum class TokenType {
   Slash,
   Caret,
   Number,
+  Variable,
   SquareRoot,
   Log,
   Stop
 };
 
-/// Represents the unit of information that is used to determine how to parse an expression.
+/// The number of token types, which can index tables with an entry per token type.
+size_t constexpr tokenTypeCount = static_cast<size_t>(TokenType::Stop) + 1;
+
+/**
+ * Represents the unit of information that is used to determine how to parse an expression.
+ * A token does not own its text, which is a view into the input it was read from, so the
+ * input must outlive the token. Tokens holding a number also carry its value, decoded
+ * once by the lexer, so that the parser never reads the text of a number again.
+ **/
 class Token {
 public:
-  /// Constructs a token with the given type and text.
-  Token(TokenType type, std::string text);
+  /// Constructs a token with the given type and text, and with a value of 0.
+  Token(TokenType type, std::string_view text);
+  /// Constructs a token with the given type, text and value.
+  Token(TokenType type, std::string_view text, double value);
   /// Returns the type of this token.
   TokenType type() const;
   /// Returns the string corresponding to this token.
-  std::string const& text() const;
+  std::string_view text() const;
+  /**
+   * Returns the number held by this token: the value of a number, or the base of a logarithm
+   * with an explicit base. Returns 0 for any other token.
+   **/
+  double value() const;
 
   /// Returns true if the two tokens have the same type and text, false otherwise.
   bool operator==(Token const& other) const;
@@ -38,7 +53,8 @@ public:
   
 private:
   TokenType m_type;
-  std::string m_text;
+  std::string_view m_text;
+  double m_value{0};
 };
 
 /// Returns the string representation of a token type. Throws if no string representation exists.
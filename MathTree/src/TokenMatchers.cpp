@@ -1,5 +1,7 @@
+#include <charconv>
+#include <cmath>
+#include "Scanning.hpp"
 #include "TokenMatchers.hpp"
-#include "Utils.hpp"
 
 namespace MathTree {
 
@@ -20,8 +22,9 @@ std::optional<Token> SymbolMatcher::match(std::string_view source, size_t startI
 std::optional<Token> SymbolMatcher::match(std::string_view source, size_t startIdx) const {
   for (auto const& tokenType: m_tokenTypes) {
     auto symbol = symboliseTokenType(tokenType);
-    if (source.substr(startIdx, symbol.size()) == symbol) {
-      return Token{tokenType, std::string(symbol)};
+    auto const text = source.substr(startIdx, symbol.size());
+    if (text == symbol) {
+      return Token{tokenType, text};
     }
   }
   return std::nullopt;   
@@ -32,29 +35,19 @@ std::optional<Token> UnsignedNumberMatcher::match(std::string_view source, size_
 }
 
 std::optional<Token> UnsignedNumberMatcher::match(std::string_view source, size_t startIdx) const {
-  if (startIdx >= source.size()) {
+  auto const endIdx = Scanning::skipNumberCharacters(source, startIdx);
+  if (endIdx <= startIdx) {
     return std::nullopt;
   }
 
-  auto endIdx = startIdx;
-  bool decimalPlace = false;
-  while(endIdx < source.size() && 
-        (std::isdigit(source[endIdx]) || source[endIdx] == '.')) {
-    if (source[endIdx] == '.') {
-      if (decimalPlace) {
-        // allow at most one decimal place
-        break;
-      }
-      decimalPlace = true;
-    }
-    ++endIdx;
-  }
-
-  auto numberStr = source.substr(startIdx, endIdx - startIdx);
-  if (Utils::parseDouble(numberStr).has_value()) {
-    return Token{TokenType::Number, std::string(numberStr)};
+  // the number ends at its second decimal place, if any, which decoding finds
+  auto const begin = source.data() + startIdx;
+  double value = 0;
+  auto const [end, error] = std::from_chars(begin, source.data() + endIdx, value, std::chars_format::fixed);
+  if (error != std::errc()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  return Token{TokenType::Number, source.substr(startIdx, end - begin), value};
 }
 
 std::optional<Token> LogarithmMatcher::match(std::string_view source, size_t startIdx) {
@@ -69,11 +62,16 @@ std::optional<Token> LogarithmMatcher::match(std::string_view source, size_t sta
       return logOpt; // implicit base
     }
 
-    if (auto const baseOpt = m_numberMatcher.match(source,
-                                                   startIdx + logSymbolLength + logDelimeter.size())) {
+    auto const baseIdx = startIdx + logSymbolLength + logDelimeter.size();
+    // the base e is written as its symbol, unless the symbol starts a longer name such as exp
+    if (source.substr(baseIdx, naturalBaseSymbol.size()) == naturalBaseSymbol &&
+        IdentifierMatcher::identifierLength(source, baseIdx) == naturalBaseSymbol.size()) {
+      auto const logWithBaseLength = baseIdx + naturalBaseSymbol.size() - startIdx;
+      return Token{TokenType::Log, source.substr(startIdx, logWithBaseLength), std::exp(1.0)};
+    }
+    if (auto const baseOpt = m_numberMatcher.match(source, baseIdx)) {
       auto logWithBaseLength = logSymbolLength + 1 + baseOpt->text().size();
-      auto logWithBase = std::string(source.substr(startIdx, logWithBaseLength));
-      return Token{TokenType::Log, std::move(logWithBase)};
+      return Token{TokenType::Log, source.substr(startIdx, logWithBaseLength), baseOpt->value()};
     }
   }
   return std::nullopt;
@@ -81,4 +79,36 @@ std::optional<Token> LogarithmMatcher::match(std::string_view source, size_t sta
 
 LogarithmMatcher::LogarithmMatcher(): m_symbolMatcher({TokenType::Log}) {}
 
+std::optional<Token> IdentifierMatcher::match(std::string_view source, size_t startIdx) {
+  return static_cast<IdentifierMatcher const&>(*this).match(source, startIdx);
+}
+
+std::optional<Token> IdentifierMatcher::match(std::string_view source, size_t startIdx) const {
+  if (startIdx >= source.size() || m_reservedMatcher.match(source, startIdx)) {
+    return std::nullopt;
+  }
+  if (auto const length = identifierLength(source, startIdx)) {
+    return Token{TokenType::Variable, source.substr(startIdx, length)};
+  }
+  return std::nullopt;
+}
+
+size_t IdentifierMatcher::identifierLength(std::string_view source, size_t startIdx) {
+  auto isIdentifierStart = [](char c) {
+    return Scanning::isLetter(c) || c == '_';
+  };
+  if (startIdx >= source.size() || !isIdentifierStart(source[startIdx])) {
+    return 0;
+  }
+
+  auto endIdx = startIdx + 1;
+  while (endIdx < source.size() &&
+         (isIdentifierStart(source[endIdx]) || Scanning::isDigit(source[endIdx]))) {
+    ++endIdx;
+  }
+  return endIdx - startIdx;
+}
+
+IdentifierMatcher::IdentifierMatcher(): m_reservedMatcher({TokenType::SquareRoot, TokenType::Log}) {}
+
 }
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace MathTree {
 class TokenMatcher {
 public:
   /**
-   * Returns a token from the input and the starting index given.
+   * Returns a token from the input and the starting index given, whose text is a view into the input.
    * Returns std::nullopt if no token can be constructed by this matcher.
   **/
   virtual std::optional<Token> match(std::string_view source, size_t startIdx) = 0;
@@ -55,9 +55,15 @@ public:
   std::optional<Token> match(std::string_view source, size_t startIdx) const;
 };
 
-/// Token matcher which can construct a token from a string containing a logarithm with or without a base.
+/**
+ * Token matcher which can construct a token from a string containing a logarithm with or without a base.
+ * The base is either a number, or the symbol of Euler's number for natural logarithms (e.g. log_e).
+ **/
 class LogarithmMatcher: public TokenMatcher {
 public:
+  /// The symbol standing for Euler's number as the base of a logarithm.
+  static std::string_view constexpr naturalBaseSymbol = "e";
+
   LogarithmMatcher();
   //! @copydoc TokenMatcher::match(std::string_view,size_t)
   std::optional<Token> match(std::string_view source, size_t startIdx) override;
@@ -68,6 +74,27 @@ private:
   UnsignedNumberMatcher m_numberMatcher;
 };
 
+/**
+ * Token matcher which can construct a variable token from a string containing an identifier.
+ * Identifiers start with a letter or an underscore, which can be followed by letters, digits and underscores.
+ * Identifiers starting with the symbol of a function (e.g. sqrt or log) are not matched.
+ **/
+class IdentifierMatcher: public TokenMatcher {
+public:
+  IdentifierMatcher();
+  //! @copydoc TokenMatcher::match(std::string_view,size_t)
+  std::optional<Token> match(std::string_view source, size_t startIdx) override;
+  //! @copydoc TokenMatcher::match(std::string_view,size_t)
+  std::optional<Token> match(std::string_view source, size_t startIdx) const;
+  /**
+   * Returns the length of the identifier found at the given index of the input, or 0 if there is none.
+   * Unlike match, identifiers starting with the symbol of a function are not rejected.
+   **/
+  static size_t identifierLength(std::string_view source, size_t startIdx);
+private:
+  SymbolMatcher m_reservedMatcher;
+};
+
 }
 
 #endif // MATHTREE_TOKENMATCHERS
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include <cmath>
 #include "Utils.hpp"
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
 namespace MathTree {
 
 namespace Utils {
@@ -36,6 +40,52 @@ std::optional<double> parseFirstDouble(std::string_view input) {
   return number;
 }
 
+bool supportsAvx2() {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  static bool const supported = __builtin_cpu_supports("avx2");
+  return supported;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  static bool const supported = [] {
+    int registers[4];
+    __cpuid(registers, 1);
+    auto const osUsesXsave = (registers[2] & (1 << 27)) != 0;
+    auto const hasAvx = (registers[2] & (1 << 28)) != 0;
+    if (!osUsesXsave || !hasAvx || (_xgetbv(0) & 0x6) != 0x6) {
+      return false;
+    }
+    __cpuidex(registers, 7, 0);
+    return (registers[1] & (1 << 5)) != 0;
+  }();
+  return supported;
+#else
+  return false;
+#endif
+}
+
+bool isSupported(InstructionSet instructionSet) {
+  switch (instructionSet) {
+#if defined(__x86_64__) || defined(_M_X64)
+  case InstructionSet::Avx2:
+    return supportsAvx2();
+  case InstructionSet::Sse2:
+    return true; // SSE2 is part of the x86-64 baseline
+#endif
+  case InstructionSet::Scalar:
+    return true;
+  default:
+    return false;
+  }
+}
+
+InstructionSet bestInstructionSet() {
+  if (isSupported(InstructionSet::Avx2)) {
+    return InstructionSet::Avx2;
+  } else if (isSupported(InstructionSet::Sse2)) {
+    return InstructionSet::Sse2;
+  }
+  return InstructionSet::Scalar;
+}
+
 }
 
 }
\ No newline at end of file
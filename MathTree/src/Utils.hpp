@@ -8,10 +8,26 @@ namespace MathTree {
 
 namespace Utils {
 
+/// Represents the instructions used by the routines which process many values at once.
+enum class InstructionSet {
+  /// Plain scalar code, available on any processor.
+  Scalar,
+  /// 128-bit SSE2 instructions.
+  Sse2,
+  /// 256-bit AVX2 instructions.
+  Avx2
+};
+
 /// Returns a signed double if the input string only contains that. Otherwise returns std::nullopt.
 std::optional<double> parseDouble(std::string_view input);
 /// Returns the first signed double if the input string contains one. Otherwise returns std::nullopt.
 std::optional<double> parseFirstDouble(std::string_view input);
+/// Returns true if the processor running the program supports the AVX2 instruction set, false otherwise.
+bool supportsAvx2();
+/// Returns true if the given instruction set can be used by both the build and the processor, false otherwise.
+bool isSupported(InstructionSet instructionSet);
+/// Returns the widest instruction set supported by both the build and the processor.
+InstructionSet bestInstructionSet();
 
 }
 
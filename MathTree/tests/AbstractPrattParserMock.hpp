@@ -11,6 +11,7 @@ public:
   MOCK_METHOD(std::unique_ptr<MathTree::Expression>, parse, ());
   MOCK_METHOD(std::unique_ptr<MathTree::Expression>, parse, (int));
   MOCK_METHOD(MathTree::Token, consumeCurrentToken, ());
+  MOCK_METHOD(std::shared_ptr<MathTree::SymbolTable>, symbols, ());
 };
 using NiceAbstractPrattParserMock = ::testing::NiceMock<AbstractPrattParserMock>;
 
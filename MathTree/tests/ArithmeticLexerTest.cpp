@@ -1,6 +1,10 @@
 #include "Lexer.hpp"
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using ::testing::Property;
 using ::testing::Eq;
@@ -38,6 +42,19 @@ TEST_F(ArithmeticLexerTest, canTokeniseAnUnsignedNumber) {
   EXPECT_EQ(token.text(), "100.2");
 }
 
+TEST_F(ArithmeticLexerTest, canTokeniseAVariable) {
+  lexer.reset("rate*2");
+  auto token = lexer.next();
+  EXPECT_EQ(token.type(), TokenType::Variable);
+  EXPECT_EQ(token.text(), "rate");
+}
+
+TEST_F(ArithmeticLexerTest, tokenisesFunctionsBeforeVariables) {
+  lexer.reset("sqrtx");
+  EXPECT_EQ(lexer.next().type(), TokenType::SquareRoot);
+  EXPECT_EQ(lexer.next().type(), TokenType::Variable);
+}
+
 TEST_F(ArithmeticLexerTest, canTokeniseAnOpeningBracket) {
   lexer.reset("(1+1)");
   auto token = lexer.next();
@@ -64,4 +81,58 @@ TEST_F(ArithmeticLexerTest, returnsASentinelValueWhenThereIsNoMoreInputThatNeeds
 TEST_F(ArithmeticLexerTest, throwsWhenACharacterIsNotRecognised) {
   lexer.reset("\1");
   EXPECT_ANY_THROW(lexer.next());
+}
+
+TEST_F(ArithmeticLexerTest, tokensAreViewsIntoTheInput) {
+  std::string const input = "log_2(rate) * 100.25";
+  lexer.reset(input);
+  for (auto const& [offset, length]: std::vector<std::pair<size_t, size_t>>{{0, 5}, {5, 1}, {6, 4}, {10, 1},
+                                                                              {12, 1}, {14, 6}}) {
+    auto const token = lexer.next();
+    EXPECT_EQ(token.text().data(), input.data() + offset);
+    EXPECT_EQ(token.text().size(), length);
+  }
+  EXPECT_EQ(lexer.next().type(), TokenType::Stop);
+}
+
+TEST_F(ArithmeticLexerTest, canTokeniseAnInputThatIsNotNullTerminated) {
+  std::string_view const input = "12+34";
+  lexer.reset(input.substr(0, 4));
+  EXPECT_EQ(lexer.next().text(), "12");
+  EXPECT_EQ(lexer.next().type(), TokenType::Plus);
+  EXPECT_EQ(lexer.next().text(), "3");
+  EXPECT_EQ(lexer.next().type(), TokenType::Stop);
+}
+
+TEST_F(ArithmeticLexerTest, canTokeniseEveryOperator) {
+  lexer.reset("+-*/^()");
+  for (auto type: {TokenType::Plus, TokenType::Minus, TokenType::Asterisk, TokenType::Slash,
+                   TokenType::Caret, TokenType::OpeningBracket, TokenType::ClosingBracket}) {
+    EXPECT_EQ(lexer.next().type(), type);
+  }
+  EXPECT_EQ(lexer.next().type(), TokenType::Stop);
+}
+
+TEST_F(ArithmeticLexerTest, tokenisesVariablesStartingWithTheFirstLetterOfAFunction) {
+  lexer.reset("lemma\t*\rsize");
+  EXPECT_EQ(lexer.next().text(), "lemma");
+  EXPECT_EQ(lexer.next().type(), TokenType::Asterisk);
+  auto const token = lexer.next();
+  EXPECT_EQ(token.type(), TokenType::Variable);
+  EXPECT_EQ(token.text(), "size");
+}
+
+TEST_F(ArithmeticLexerTest, tokenisesALogarithmWithItsBase) {
+  lexer.reset("log_2.5 x");
+  auto const token = lexer.next();
+  EXPECT_EQ(token.type(), TokenType::Log);
+  EXPECT_EQ(token.text(), "log_2.5");
+  EXPECT_EQ(lexer.next().type(), TokenType::Variable);
+}
+
+TEST_F(ArithmeticLexerTest, throwsWhenADecimalPlaceIsNotPartOfANumber) {
+  lexer.reset("1+.");
+  lexer.next();
+  lexer.next();
+  EXPECT_ANY_THROW(lexer.next());
 }
\ No newline at end of file
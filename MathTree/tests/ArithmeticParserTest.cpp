@@ -1,12 +1,43 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include <cmath>
 #include "Expression.hpp"
+#include "IterativeEvaluator.hpp"
+#include <memory_resource>
 #include "Parser.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 using MathTree::ArithmeticParser;
+using MathTree::Expression;
 using ::testing::ElementsAre;
 using ::testing::Pair;
 
+class CountingMemoryResource: public std::pmr::memory_resource {
+public:
+  size_t allocations = 0;
+  size_t deallocations = 0;
+  size_t bytesInUse = 0;
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    bytesInUse += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+    ++deallocations;
+    bytesInUse -= bytes;
+    std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+  }
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    return this == &other;
+  }
+};
+
 class ArithmeticParserTest: public ::testing::Test {
 protected:
   ArithmeticParser parser;
@@ -118,4 +149,262 @@ TEST_F(ArithmeticParserTest, logWithoutParenthesesHasTheSamePriorityAsExponentia
     auto result = parser.parse("log100 ^ 0");
     ASSERT_NE(result, nullptr);
     EXPECT_DOUBLE_EQ(result->evaluate(), 1.0);
+}
+
+TEST_F(ArithmeticParserTest, variablesAreDeclaredInTheSymbolTableOfTheParser) {
+    auto result = parser.parse("x*rate+x");
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(parser.symbols().size(), 2);
+    EXPECT_TRUE(parser.symbols().indexOf("x").has_value());
+    EXPECT_TRUE(parser.symbols().indexOf("rate").has_value());
+}
+
+TEST_F(ArithmeticParserTest, treesWithVariablesCanBeReevaluatedAfterBindingNewValues) {
+    auto result = parser.parse("sqrt(x)*(2+3)");
+    ASSERT_NE(result, nullptr);
+    parser.symbols().bind("x", 4.0);
+    EXPECT_DOUBLE_EQ(result->evaluate(), 10.0);
+    parser.symbols().bind("x", 9.0);
+    EXPECT_DOUBLE_EQ(result->evaluate(), 15.0);
+}
+
+TEST_F(ArithmeticParserTest, evaluatingATreeWithAnUnboundVariableThrows) {
+    auto result = parser.parse("1+y");
+    ASSERT_NE(result, nullptr);
+    EXPECT_ANY_THROW(result->evaluate());
+}
+
+TEST_F(ArithmeticParserTest, everyExpressionOfTheTreeIsAllocatedFromTheMemoryResourceProvided) {
+    CountingMemoryResource resource;
+    auto result = parser.parse("1+2*sqrt(4)", resource);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(resource.allocations, 6);
+    EXPECT_DOUBLE_EQ(result->evaluate(), 5.0);
+    result.reset();
+    EXPECT_EQ(resource.deallocations, 6);
+    EXPECT_EQ(resource.bytesInUse, 0);
+}
+
+TEST_F(ArithmeticParserTest, theMemoryOfAnExpressionWhoseConstructionThrowsIsReturnedToItsResource) {
+    CountingMemoryResource resource;
+    EXPECT_THROW(MathTree::allocateExpression<MathTree::AdditionExpression>(resource, nullptr, MathTree::TokenType::Plus,
+                                                                           parser.parse("1")),
+                 std::logic_error);
+    EXPECT_EQ(resource.allocations, 1);
+    EXPECT_EQ(resource.deallocations, 1);
+    EXPECT_EQ(resource.bytesInUse, 0);
+}
+
+TEST_F(ArithmeticParserTest, theMemoryResourceProvidedIsOnlyUsedForOneParse) {
+    CountingMemoryResource resource;
+    auto first = parser.parse("1+2", resource);
+    auto second = parser.parse("3*4");
+    EXPECT_EQ(resource.allocations, 3);
+    EXPECT_DOUBLE_EQ(second->evaluate(), 12.0);
+}
+
+TEST_F(ArithmeticParserTest, treesAllocatedFromAMonotonicBufferCanBeEvaluated) {
+    std::pmr::monotonic_buffer_resource arena;
+    auto result = parser.parse("log_2(8)+x^2", arena);
+    ASSERT_NE(result, nullptr);
+    parser.symbols().bind("x", 3.0);
+    EXPECT_DOUBLE_EQ(result->evaluate(), 12.0);
+}
+
+TEST_F(ArithmeticParserTest, aTreeCanBeEvaluatedByManyThreadsAtOnce) {
+    auto result = parser.parse("sqrt(16)*(2+3)-log_2(8)/x");
+    ASSERT_NE(result, nullptr);
+    parser.symbols().bind("x", 3.0);
+    std::vector<double> results(8);
+    std::vector<std::thread> threads;
+    for (auto& threadResult: results) {
+      threads.emplace_back([&result, &threadResult] {
+        for (int i = 0; i < 1000; ++i) {
+          threadResult = result->evaluate();
+        }
+      });
+    }
+    for (auto& thread: threads) {
+      thread.join();
+    }
+    for (auto threadResult: results) {
+      EXPECT_DOUBLE_EQ(threadResult, 19.0);
+    }
+}
+
+TEST_F(ArithmeticParserTest, variablesCanBeDeclaredInTheSymbolTableProvided) {
+    auto symbols = std::make_shared<MathTree::SymbolTable>();
+    auto result = parser.parse("y*2", symbols);
+    ASSERT_NE(result, nullptr);
+    EXPECT_TRUE(symbols->indexOf("y").has_value());
+    EXPECT_EQ(parser.symbols().size(), 0);
+    symbols->bind("y", 4.0);
+    EXPECT_DOUBLE_EQ(result->evaluate(), 8.0);
+}
+
+TEST_F(ArithmeticParserTest, oneParserCanBeUsedByManyThreadsAtOnce) {
+    std::vector<double> results(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+      threads.emplace_back([this, i, &results] {
+        auto symbols = std::make_shared<MathTree::SymbolTable>();
+        symbols->bind("x", static_cast<double>(i));
+        for (int j = 0; j < 100; ++j) {
+          results[i] = parser.parse("2*x+sqrt(16)", symbols)->evaluate();
+        }
+      });
+    }
+    for (auto& thread: threads) {
+      thread.join();
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      EXPECT_DOUBLE_EQ(results[i], 2.0 * i + 4.0);
+    }
+}
+
+TEST_F(ArithmeticParserTest, parsingWithTheRuntimeGrammarBuildsTheSameTrees) {
+  auto printed = [](Expression const& expression) {
+    std::ostringstream stream;
+    expression.print(stream);
+    return stream.str();
+  };
+  for (auto const& input: {"1+2*3-4/5^6^7", "-(+x--y)*sqrt 4^2", "log_2.5(x)+log 100^2/(x-(y*2))", "2^-x^-3"}) {
+    auto symbols = std::make_shared<MathTree::SymbolTable>();
+    MathTree::ArithmeticLexer lexer(input);
+    MathTree::PrattParser runtimeParser(ArithmeticParser::grammar(), lexer, symbols);
+    EXPECT_EQ(printed(*runtimeParser.parse()), printed(*parser.parse(input, symbols))) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, parsingAnIncompleteInputThrows) {
+  for (auto const& input: {"1+", "(2*3", "sqrt", "*2"}) {
+    EXPECT_THROW(parser.parse(input), std::logic_error) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, parsingWithTheIterativeEngineBuildsTheSameTrees) {
+  auto printed = [](Expression const& expression) {
+    std::ostringstream stream;
+    expression.print(stream);
+    return stream.str();
+  };
+  ArithmeticParser iterativeParser;
+  iterativeParser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  for (auto const& input: {"1+2*3-4/5^6^7", "-(+x--y)*sqrt 4^2", "log_2.5(x)+log 100^2/(x-(y*2))", "2^-x^-3",
+                           "((x))", "-2^2", "sqrt-sqrt(4)*+-3", "1-2-3+4*5/6/7", "x y"}) {
+    auto symbols = std::make_shared<MathTree::SymbolTable>();
+    EXPECT_EQ(printed(*iterativeParser.parse(input, symbols)), printed(*parser.parse(input, symbols))) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, theIterativeEngineParsesInputsOfAnyDepth) {
+  ArithmeticParser iterativeParser;
+  iterativeParser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  EXPECT_EQ(iterativeParser.parsingEngine(), ArithmeticParser::ParsingEngine::Iterative);
+  size_t const depth = 100000;
+  std::string brackets = std::string(depth, '(') + "-1" + std::string(depth, ')');
+  std::string powers;
+  std::string signs;
+  for (size_t i = 0; i < depth; ++i) {
+    powers += "1^";
+    signs += "-sqrt ";
+  }
+  powers += "2";
+  signs += "4";
+
+  MathTree::IterativeEvaluator evaluator;
+  EXPECT_EQ(evaluator.evaluate(*iterativeParser.parse(brackets)), -1);
+  EXPECT_EQ(evaluator.evaluate(*iterativeParser.parse(powers)), 1);
+  auto tree = iterativeParser.parse(signs);
+  EXPECT_EQ(tree->height(), 2 * depth + 1);
+  EXPECT_THROW(evaluator.evaluate(*tree), std::domain_error);
+}
+
+TEST_F(ArithmeticParserTest, parsingAnIncompleteInputWithTheIterativeEngineThrows) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  for (auto const& input: std::vector<std::string>{"1+", "(2*3", "sqrt", "*2", "2*)", std::string(100000, '(') + "1"}) {
+    EXPECT_THROW(parser.parse(input), std::logic_error) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, tryingToParseAValidInputBuildsTheSameTreeAsParsing) {
+  auto printed = [](Expression const& expression) {
+    std::ostringstream stream;
+    expression.print(stream);
+    return stream.str();
+  };
+  for (auto const& input: {"1+2*3-4/5^6^7", "-(+x--y)*sqrt 4^2", "log_2.5(x)+log 100^2/(x-(y*2))", "2^-x^-3",
+                           " ((x)) ", "sqrt-sqrt(4)*+-3"}) {
+    auto result = parser.tryParse(input);
+    ASSERT_NE(result.tree, nullptr) << input;
+    EXPECT_TRUE(result.errors.empty()) << input;
+    EXPECT_EQ(printed(*result.tree), printed(*parser.parse(input))) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, tryingToParseAMalformedInputReturnsItsSyntaxErrorsWithoutThrowing) {
+  for (auto const& input: {"", "  ", "1+", "(2*3", "sqrt", "*2", "2*)", "(1)(2)", "x y", "2 $ 3", "()", "log_2", "1..2"}) {
+    ArithmeticParser::ParseResult result;
+    EXPECT_NO_THROW(result = parser.tryParse(input)) << input;
+    EXPECT_EQ(result.tree, nullptr) << input;
+    EXPECT_FALSE(result.errors.empty()) << input;
+    EXPECT_EQ(result.errors, ArithmeticParser::validateSyntax(input)) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, tryingToParseALogarithmWithAnInvalidBaseReturnsASyntaxErrorWithoutThrowing) {
+  auto const invalidBase = ArithmeticParser::SyntaxErrors::InvalidLogarithmBase;
+  for (auto const& input: {"log_0(5)", "log_-1(5)", "log_0.0(2)", "log_0 x+1", "log_0 2+", "2*(log_0 x)"}) {
+    ArithmeticParser::ParseResult result;
+    EXPECT_NO_THROW(result = parser.tryParse(input)) << input;
+    EXPECT_EQ(result.tree, nullptr) << input;
+    EXPECT_FALSE(result.errors.empty()) << input;
+  }
+  EXPECT_THAT(parser.tryParse("log_0(5)").errors, ElementsAre(Pair(0, invalidBase)));
+  EXPECT_THAT(parser.tryParse("1+log_0.0 2").errors, ElementsAre(Pair(2, invalidBase)));
+  EXPECT_THAT(parser.tryParse("log_0 x+1").errors, ElementsAre(Pair(0, invalidBase)));
+}
+
+TEST_F(ArithmeticParserTest, naturalLogarithmsAreWrittenWithTheSymbolOfEulersNumberAsBase) {
+  EXPECT_TRUE(ArithmeticParser::validateSyntax("log_e(x)+log_e 2").empty());
+  auto result = parser.tryParse("log_e(x)+log_e 2");
+  ASSERT_NE(result.tree, nullptr);
+  parser.symbols().bind("x", 5.0);
+  EXPECT_EQ(result.tree->evaluate(), std::log(5.0) + std::log(2.0));
+  std::ostringstream stream;
+  stream << *result.tree;
+  EXPECT_EQ(stream.str(), "(log_e(x) + log_e(2))");
+  EXPECT_EQ(parser.parse("log_e(x)+log_e 2")->evaluate(), result.tree->evaluate());
+  EXPECT_THAT(parser.tryParse("log_ex").errors, ElementsAre(Pair(0, ArithmeticParser::SyntaxErrors::ReservedPrefix)));
+}
+
+TEST_F(ArithmeticParserTest, namesStartingWithTheSymbolOfAFunctionAreSyntaxErrors) {
+  auto const reservedPrefix = ArithmeticParser::SyntaxErrors::ReservedPrefix;
+  EXPECT_THAT(parser.tryParse("logistic").errors, ElementsAre(Pair(0, reservedPrefix)));
+  EXPECT_THAT(parser.tryParse("2*sqrtx").errors, ElementsAre(Pair(2, reservedPrefix)));
+  EXPECT_THAT(parser.tryParse("log_x+1").errors, ElementsAre(Pair(0, reservedPrefix)));
+  EXPECT_THAT(parser.tryParse("1+log_2y").errors, ElementsAre(Pair(2, reservedPrefix)));
+  EXPECT_THAT(ArithmeticParser::validateSyntax("logistic"), ElementsAre(Pair(0, reservedPrefix)));
+  // functions can still be followed by numbers, other functions, brackets and variables after a space
+  for (auto const& input: {"log100", "sqrtsqrt16", "sqrtlog_2(8)", "log(istic)", "log istic", "x_log+sqrt(y)"}) {
+    EXPECT_TRUE(parser.tryParse(input).errors.empty()) << input;
+  }
+}
+
+TEST_F(ArithmeticParserTest, tryingToParseAppliesTheOptimisationsOfTheParser) {
+  parser.setConstantFolding(true);
+  auto result = parser.tryParse("x*(1+2)");
+  ASSERT_NE(result.tree, nullptr);
+  parser.symbols().bind("x", 2.0);
+  EXPECT_EQ(result.tree->evaluate(), 6.0);
+  EXPECT_EQ(result.tree->subexpressions().size(), 2);
+  EXPECT_TRUE(result.tree->subexpressions().back()->subexpressions().empty());
+}
+
+TEST_F(ArithmeticParserTest, tryingToParseHandlesInputsOfAnyDepth) {
+  size_t const depth = 100000;
+  auto result = parser.tryParse(std::string(depth, '(') + "2" + std::string(depth, ')'));
+  ASSERT_NE(result.tree, nullptr);
+  EXPECT_EQ(MathTree::IterativeEvaluator().evaluate(*result.tree), 2);
+  EXPECT_EQ(parser.tryParse(std::string(depth, '(') + "2").errors.size(), depth);
 }
\ No newline at end of file
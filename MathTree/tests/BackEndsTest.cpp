@@ -0,0 +1,151 @@
+#include "Bytecode.hpp"
+#include "DomainErrors.hpp"
+#include "Expression.hpp"
+#include "ExpressionDag.hpp"
+#include "gtest/gtest.h"
+#include <initializer_list>
+#include "IterativeEvaluator.hpp"
+#include "PackedTree.hpp"
+#include "Parser.hpp"
+#include <string>
+
+using MathTree::ArithmeticParser;
+using MathTree::Expression;
+using MathTree::MultiplyAddRounding;
+
+// every back-end evaluates a tree through the structure it builds from it
+struct BytecodeBackEnd {
+  static double evaluate(Expression const& expression) {
+    return MathTree::BytecodeProgram::compile(expression).evaluate();
+  }
+};
+
+struct GraphBackEnd {
+  static double evaluate(Expression const& expression) {
+    return MathTree::ExpressionDag::build(expression).evaluate();
+  }
+};
+
+struct IterativeBackEnd {
+  static double evaluate(Expression const& expression) {
+    return MathTree::IterativeEvaluator().evaluate(expression);
+  }
+};
+
+struct PackedTreeBackEnd {
+  static double evaluate(Expression const& expression) {
+    return MathTree::PackedTree::build(expression).evaluate();
+  }
+};
+
+template<typename BackEnd>
+class BackEndsTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+
+  // expects the back-end to give the same result as the tree, or to throw the same domain error, for every value of x
+  void expectSameResultsAndErrorsAsTheTree(std::string const& input, std::initializer_list<double> values) {
+    auto const expression = parser.parse(input);
+    for (auto x: values) {
+      parser.symbols().bind("x", x);
+      auto const treeError = domainErrorOf(*expression);
+      EXPECT_EQ(domainErrorOf([&expression] { BackEnd::evaluate(*expression); }), treeError) << input << " at " << x;
+      if (treeError.empty()) {
+        EXPECT_EQ(BackEnd::evaluate(*expression), expression->evaluate()) << input << " at " << x;
+      }
+    }
+  }
+
+  // expects the back-end to throw the same domain error as the tree, which must throw one
+  void expectSameErrorAsTheTree(std::string const& input) {
+    auto const expression = parser.parse(input);
+    auto const treeError = domainErrorOf(*expression);
+    EXPECT_FALSE(treeError.empty()) << input;
+    EXPECT_EQ(domainErrorOf([&expression] { BackEnd::evaluate(*expression); }), treeError) << input;
+  }
+
+  // returns an expression made of the given number of terms added together, which is as deep as the number of terms
+  static std::string longSum(std::string const& term, size_t terms) {
+    std::string input = term;
+    input.reserve(terms * (term.size() + 1));
+    for (size_t i = 1; i < terms; ++i) {
+      input += '+';
+      input += term;
+    }
+    return input;
+  }
+};
+
+using BackEnds = ::testing::Types<BytecodeBackEnd, GraphBackEnd, IterativeBackEnd, PackedTreeBackEnd>;
+TYPED_TEST_SUITE(BackEndsTest, BackEnds);
+
+TYPED_TEST(BackEndsTest, treesGiveTheSameResultAsTheTree) {
+  for (auto const& input: {"42.5", "10+2*5-20/2", "100-(30/3/(3-1)+0-3-2)-10/5", "2^3^0", "-(-3)", "sqrtsqrt16",
+                           "log_2(8)*3", "sqrt(2)*log_3(7.5)^2-1.5/(4+0.3)+-2^-3+log_3(7.5)/(4+0.3)"}) {
+    this->expectSameResultsAndErrorsAsTheTree(input, {0.0});
+  }
+}
+
+TYPED_TEST(BackEndsTest, treesThrowTheSameDomainErrorsAsTheTree) {
+  // the tree validates the divisor before evaluating the dividend, so a zero divisor is reported first
+  for (auto const& input: {"1/(2-2)", "0^0", "(-8)^(1/3)", "sqrt(-1)", "log(1-1)", "sqrt(-1)/0", "sqrt(-1)+log(0)",
+                           "log(0)*sqrt(-1)", "(0-1)^0.5^sqrt(-1)", "-sqrt(-4)-1/0"}) {
+    this->expectSameErrorAsTheTree(input);
+  }
+}
+
+TYPED_TEST(BackEndsTest, treesHigherThanTheRecursionLimitGiveTheSameResultsAndErrorsAsTheTree) {
+  // adding a long sum of zeros makes every operation too high to be evaluated by recursing
+  auto const zero = "(" + this->longSum("0", Expression::maxRecursionHeight + 1) + ")";
+  auto const left = "(2.5+" + zero + ")";
+  auto const right = "(1.5+" + zero + ")";
+  for (auto const& input: {left + "+" + right, left + "-" + right, left + "*" + right, left + "/" + right,
+                           left + "^" + right, "-" + left, "sqrt" + left, "log_3" + left}) {
+    this->expectSameResultsAndErrorsAsTheTree(input, {0.0});
+  }
+  for (auto const& input: {"1/" + zero, zero + "^" + zero, "(-8+" + zero + ")^(1/3+" + zero + ")",
+                           "sqrt(-1+" + zero + ")", "log" + zero, "sqrt(-1)/" + zero,
+                           "(log(0)+" + zero + ")^sqrt(-1+" + zero + ")"}) {
+    this->expectSameErrorAsTheTree(input);
+  }
+}
+
+TYPED_TEST(BackEndsTest, strengthReducedTreesGiveTheSameResultsAndErrorsAsTheTree) {
+  this->parser.setStrengthReduction(true);
+  for (auto const& input: {"x^2*x^-3+x^0.5+x^2", "log_2(x)+log(x)*log_7.5(x)+log_2(x)+log_e(x)"}) {
+    this->expectSameResultsAndErrorsAsTheTree(input, {-2.0, 0.0, 1.3, 4.0});
+  }
+  for (auto const& input: {"(2-2)^-2", "sqrt(-1)^3", "log_7(1-1)", "log_2(sqrt(-1))", "sqrt(-1)^2+1/0"}) {
+    this->expectSameErrorAsTheTree(input);
+  }
+}
+
+TYPED_TEST(BackEndsTest, recognisedPolynomialsGiveTheSameResultsAndErrorsAsTheTree) {
+  this->parser.setPolynomialRecognition(true);
+  // the ninth degree polynomial is evaluated with Estrin's scheme, and the fourth degree one with Horner's
+  auto const input = "sqrt(x^9-2*x^7+0.5*x^6-x^2+0.25)+(x^9-2*x^7+0.5*x^6-x^2+0.25)*(3*x^2-x)+"
+                     "(3*x^4+2*x^3-x^2+7*x+1)";
+  this->expectSameResultsAndErrorsAsTheTree(input, {-2.0, -0.3, 0.0, 1.3, 1e10});
+  for (auto const& input: {"log(0)*3+sqrt(-1)", "2+sqrt(-1)*log(0)", "(sqrt(-1)+1)^2+3"}) {
+    this->expectSameErrorAsTheTree(input);
+  }
+}
+
+TYPED_TEST(BackEndsTest, contractedMultiplyAddsGiveTheSameResultsAndErrorsAsTheTree) {
+  for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+    this->parser.setMultiplyAddContraction(true, rounding);
+    auto const input = "(x*0.1+0.7)*(0.3-x*x)-(sqrt(x)-x*3)/(x*x-1)+(0.7+x*0.1)";
+    this->expectSameResultsAndErrorsAsTheTree(input, {-2.0, 0.25, 1.0 / 3.0, 1.0, 1.3});
+    this->expectSameErrorAsTheTree("2+sqrt(-1)*log(0)");
+  }
+}
+
+TYPED_TEST(BackEndsTest, treesOptimisedInEveryWayThrowTheSameDomainErrorsAsTheTree) {
+  this->parser.setStrengthReduction(true);
+  this->parser.setPolynomialRecognition(true);
+  this->parser.setMultiplyAddContraction(true);
+  for (auto const& input: {"(2-2)^-2", "sqrt(-1)^3", "log_7(1-1)", "log_2(sqrt(-1))", "sqrt(-1)^2+1/0",
+                           "log(0)*3+sqrt(-1)", "2+sqrt(-1)*log(0)", "(sqrt(-1)+1)^2+3"}) {
+    this->expectSameErrorAsTheTree(input);
+  }
+}
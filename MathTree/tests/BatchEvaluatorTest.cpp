@@ -0,0 +1,154 @@
+#include "BatchEvaluator.hpp"
+#include <cmath>
+#include <cstdint>
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using MathTree::ArithmeticParser;
+using MathTree::BatchEvaluator;
+using MathTree::MultiplyAddRounding;
+using InstructionSet = MathTree::BatchEvaluator::InstructionSet;
+
+class BatchEvaluatorTest: public ::testing::TestWithParam<InstructionSet> {
+protected:
+  ArithmeticParser parser;
+  std::vector<double> xs, ys;
+
+  void SetUp() override {
+    if (!BatchEvaluator::isSupported(GetParam())) {
+      GTEST_SKIP() << "Instruction set not supported on this machine.";
+    }
+    // an odd number of rows spanning more than a chunk exercises the scalar tails
+    for (int i = 0; i < 600; ++i) {
+      xs.push_back((i % 37) * 0.75 - 9.0);
+      ys.push_back((i % 11) * 0.5 - 2.0);
+    }
+  }
+
+  // evaluates the input row by row with the tree, and then in batch, expecting identical results
+  void expectSameResultsAsTheTree(std::string const& input) {
+    auto expression = parser.parse(input);
+    auto& symbols = parser.symbols();
+    std::vector<double const*> columns(symbols.size());
+    if (auto xIdx = symbols.indexOf("x")) {
+      columns[*xIdx] = xs.data();
+    }
+    if (auto yIdx = symbols.indexOf("y")) {
+      columns[*yIdx] = ys.data();
+    }
+
+    BatchEvaluator evaluator(*expression, GetParam());
+    std::vector<double> out(xs.size());
+    std::vector<std::uint8_t> errorMask(xs.size());
+    auto errorCount = evaluator.evaluateBatch(columns.data(), columns.size(),
+                                              out.data(), out.size(), errorMask.data());
+
+    size_t expectedErrorCount = 0;
+    for (size_t row = 0; row < xs.size(); ++row) {
+      auto reparsed = parser.parse(input); // fresh tree, so that no result is kept from another row
+      symbols.bind("x", xs[row]);
+      symbols.bind("y", ys[row]);
+      try {
+        auto expected = reparsed->evaluate();
+        EXPECT_EQ(errorMask[row], 0) << input << " at row " << row;
+        if (std::isnan(expected)) {
+          EXPECT_TRUE(std::isnan(out[row])) << input << " at row " << row;
+        } else {
+          EXPECT_EQ(out[row], expected) << input << " at row " << row;
+        }
+      } catch (std::domain_error const&) {
+        ++expectedErrorCount;
+        EXPECT_EQ(errorMask[row], 1) << input << " at row " << row;
+        EXPECT_TRUE(std::isnan(out[row])) << input << " at row " << row;
+      }
+    }
+    EXPECT_EQ(errorCount, expectedErrorCount) << input;
+  }
+};
+
+TEST_P(BatchEvaluatorTest, basicArithmeticGivesTheSameResultsAsTheTree) {
+  expectSameResultsAsTheTree("x + y * 2.5 - -x / 3");
+}
+
+TEST_P(BatchEvaluatorTest, divisionsByZeroAreReportedPerRow) {
+  expectSameResultsAsTheTree("x / y");
+}
+
+TEST_P(BatchEvaluatorTest, invalidSquareRootsAreReportedPerRow) {
+  expectSameResultsAsTheTree("sqrt(x) + sqrt(y + 2)");
+}
+
+TEST_P(BatchEvaluatorTest, invalidPowersAreReportedPerRow) {
+  expectSameResultsAsTheTree("x ^ y");
+  expectSameResultsAsTheTree("y ^ 3 + 2 ^ x");
+}
+
+TEST_P(BatchEvaluatorTest, invalidLogarithmsAreReportedPerRow) {
+  expectSameResultsAsTheTree("log(x) + log_2(y) * log_7.5(x*x)");
+}
+
+TEST_P(BatchEvaluatorTest, constantExpressionsAreEvaluatedForEveryRow) {
+  expectSameResultsAsTheTree("sqrt(2) * log_3(9)");
+}
+
+TEST_P(BatchEvaluatorTest, strengthReducedPowersAndLogarithmsGiveTheSameResultsAsTheTree) {
+  parser.setStrengthReduction(true);
+  expectSameResultsAsTheTree("x^2 * y^-3 + x^0.5 - y^7");
+  expectSameResultsAsTheTree("log_2(x) + log(y) * log_7.5(x*x)");
+}
+
+TEST_P(BatchEvaluatorTest, recognisedPolynomialsGiveTheSameResultsAsTheTree) {
+  parser.setPolynomialRecognition(true);
+  expectSameResultsAsTheTree("3*x^4 + 2*x^3 - x^2 + 7*x + 1");
+  // polynomials of a high enough degree are evaluated with Estrin's scheme, whose last block is padded
+  expectSameResultsAsTheTree("x^9 - 2*x^7 + 0.5*x^6 - x^2 + 0.25 + sqrt(y^2 - y)");
+  expectSameResultsAsTheTree("x^8 - x^5 + y^11 + 3*y^4 - y");
+}
+
+TEST_P(BatchEvaluatorTest, contractedMultiplyAddsGiveTheSameResultsAsTheTree) {
+  for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+    parser.setMultiplyAddContraction(true, rounding);
+    expectSameResultsAsTheTree("(x*0.1 + 0.7) * (0.3 - x*y) - (sqrt(x) - y*3) / (x*y - 1)");
+  }
+}
+
+TEST_P(BatchEvaluatorTest, aMillionTermChainIsCompiledWithoutOverflowingTheStack) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  std::string input = "x";
+  for (int i = 1; i < 1000000; ++i) {
+    input += "+x";
+  }
+  auto expression = parser.parse(input);
+  BatchEvaluator evaluator(*expression, GetParam());
+  // a few rows are enough, as each of them goes through every instruction
+  std::vector<double const*> columns{xs.data()};
+  std::vector<double> out(7);
+  std::vector<std::uint8_t> errorMask(out.size());
+  EXPECT_EQ(evaluator.evaluateBatch(columns.data(), columns.size(), out.data(), out.size(), errorMask.data()), 0u);
+  for (size_t row = 0; row < out.size(); ++row) {
+    EXPECT_EQ(out[row], xs[row] * 1000000) << "at row " << row;
+  }
+  expression.reset();
+}
+
+INSTANTIATE_TEST_SUITE_P(AllInstructionSets, BatchEvaluatorTest,
+                         ::testing::Values(InstructionSet::Scalar, InstructionSet::Sse2, InstructionSet::Avx2));
+
+TEST(BatchEvaluatorValidationTest, evaluatingWithFewerColumnsThanVariablesThrows) {
+  ArithmeticParser parser;
+  auto expression = parser.parse("x + y");
+  BatchEvaluator evaluator(*expression);
+  std::vector<double> xs{1.0}, out(1);
+  double const* columns[] = {xs.data()};
+  EXPECT_THROW(evaluator.evaluateBatch(columns, 1, out.data(), out.size()), std::invalid_argument);
+}
+
+TEST(BatchEvaluatorValidationTest, theBestInstructionSetIsAlwaysSupported) {
+  EXPECT_TRUE(BatchEvaluator::isSupported(BatchEvaluator::bestInstructionSet()));
+  EXPECT_TRUE(BatchEvaluator::isSupported(InstructionSet::Scalar));
+}
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
+#include <cmath>
 #include "Expression.hpp"
 #include "ExpressionMock.hpp"
 #include <iostream>
+#include <stdexcept>
 #include "Token.hpp"
 
 using ::testing::Return;
@@ -108,4 +110,97 @@ TEST_F(BinaryExpressionsTest, aBinaryExpressionReturnsTheTwoSubexpressionsUsedTo
   auto rightMockPtr = rightMock.get();
   BinaryExpressionStub binary(std::move(leftMock), TokenType::Asterisk, std::move(rightMock));
   EXPECT_THAT(binary.subexpressions(), ElementsAreArray({leftMockPtr, rightMockPtr}));
+}
+
+TEST_F(BinaryExpressionsTest, aBinaryExpressionGivesAccessToItsSubexpressionsByPosition) {
+  auto leftMockPtr = leftMock.get();
+  auto rightMockPtr = rightMock.get();
+  BinaryExpressionStub binary(std::move(leftMock), TokenType::Asterisk, std::move(rightMock));
+  EXPECT_EQ(binary.subexpressionCount(), 2);
+  EXPECT_EQ(&binary.subexpression(0), leftMockPtr);
+  EXPECT_EQ(&binary.subexpression(1), rightMockPtr);
+  EXPECT_THROW(binary.subexpression(2), std::out_of_range);
+}
+
+TEST_F(BinaryExpressionsTest, expressionsWhichOnlyListTheirSubexpressionsCanBeAccessedByPosition) {
+  auto const rightMockPtr = rightMock.get();
+  EXPECT_CALL(*leftMock, subexpressions()).WillRepeatedly(Return(std::vector<Expression const*>{rightMockPtr}));
+  EXPECT_EQ(leftMock->subexpressionCount(), 1);
+  EXPECT_EQ(&leftMock->subexpression(0), rightMockPtr);
+  EXPECT_THROW(leftMock->subexpression(1), std::out_of_range);
+}
+
+TEST_F(BinaryExpressionsTest, transformingTheSubexpressionsReplacesThemOrderedLeftToRight) {
+  auto replacementPtrs = std::vector<Expression const*>{};
+  BinaryExpressionStub binary(std::move(leftMock), TokenType::Asterisk, std::move(rightMock));
+  binary.transformSubexpressions([&replacementPtrs](std::unique_ptr<Expression>) {
+    auto replacement = std::make_unique<NiceExpressionMock>();
+    ON_CALL(*replacement, isConstant()).WillByDefault(Return(true));
+    replacementPtrs.push_back(replacement.get());
+    return replacement;
+  });
+  EXPECT_THAT(binary.subexpressions(), ElementsAreArray(replacementPtrs));
+  EXPECT_TRUE(binary.isConstant());
+}
+
+TEST_F(BinaryExpressionsTest, transformingASubexpressionIntoANullExpressionThrows) {
+  BinaryExpressionStub binary(std::move(leftMock), TokenType::Asterisk, std::move(rightMock));
+  EXPECT_ANY_THROW(binary.transformSubexpressions([](std::unique_ptr<Expression>) {
+    return std::unique_ptr<Expression>();
+  }));
+}
+
+TEST_F(BinaryExpressionsTest, theHeightOfABinaryExpressionIsOneMoreThanTheHighestSubexpression) {
+  auto left = std::make_unique<AdditionExpression>(std::move(leftMock), TokenType::Plus, std::move(rightMock));
+  AdditionExpression adder{std::move(left), TokenType::Plus, std::make_unique<NiceExpressionMock>()};
+  EXPECT_EQ(adder.height(), 3);
+}
+
+TEST_F(BinaryExpressionsTest, tryingToDivideByZeroReturnsTheErrorWithoutEvaluatingTheDividend) {
+  EXPECT_CALL(*leftMock, evaluate()).Times(0);
+  EXPECT_CALL(*rightMock, evaluate()).WillOnce(Return(0.0));
+
+  DivisionExpression divider{std::move(leftMock), TokenType::Slash, std::move(rightMock)};
+  auto const result = divider.tryEvaluate();
+  ASSERT_FALSE(result.hasValue());
+  EXPECT_EQ(result.error(), MathTree::EvaluationError::DivisionByZero);
+  EXPECT_EQ(result.failedExpression(), &divider);
+}
+
+TEST_F(BinaryExpressionsTest, theErrorOfAnInvalidPowerIsThrownWithItsOperandsWhenItsValueIsRead) {
+  ExponentiationExpression power{std::make_unique<MathTree::RealNumberExpression>(-8.0), TokenType::Caret,
+                                 std::make_unique<MathTree::RealNumberExpression>(0.5)};
+  auto const result = power.tryEvaluate();
+  ASSERT_FALSE(result);
+  EXPECT_EQ(result.error(), MathTree::EvaluationError::InvalidPower);
+  try {
+    result.value();
+    FAIL() << "Reading the value of an invalid power did not throw.";
+  } catch (std::domain_error const& error) {
+    EXPECT_STREQ(error.what(), "Cannot compute -8.000000 to the power of 0.500000.");
+  }
+}
+
+TEST_F(BinaryExpressionsTest, divisionsByZeroGiveAnInfinityWhenErrorsArePropagated) {
+  DivisionExpression divider{std::make_unique<MathTree::RealNumberExpression>(1.0), TokenType::Slash,
+                             std::make_unique<MathTree::RealNumberExpression>(0.0)};
+  EXPECT_EQ(divider.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), HUGE_VAL);
+  EXPECT_THROW(divider.evaluate(), std::domain_error);
+}
+
+TEST_F(BinaryExpressionsTest, invalidPowersGiveTheResultOfStdPowWhenErrorsArePropagated) {
+  ExponentiationExpression zeroToTheZero{std::make_unique<MathTree::RealNumberExpression>(0.0), TokenType::Caret,
+                                         std::make_unique<MathTree::RealNumberExpression>(0.0)};
+  EXPECT_EQ(zeroToTheZero.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), 1.0);
+  ExponentiationExpression cubeRoot{std::make_unique<MathTree::RealNumberExpression>(-8.0), TokenType::Caret,
+                                    std::make_unique<MathTree::RealNumberExpression>(1.0 / 3)};
+  EXPECT_TRUE(std::isnan(cubeRoot.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+}
+
+TEST_F(BinaryExpressionsTest, expressionsWithARealResultGiveTheSameResultWithoutChecks) {
+  EXPECT_CALL(*leftMock, evaluate()).WillOnce(Return(5.0));
+  EXPECT_CALL(*rightMock, evaluate()).WillOnce(Return(2.0));
+
+  DivisionExpression divider{std::move(leftMock), TokenType::Slash, std::move(rightMock)};
+  EXPECT_DOUBLE_EQ(divider.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), 2.5);
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include "Bytecode.hpp"
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using MathTree::ArithmeticParser;
+using MathTree::BytecodeProgram;
+using MathTree::flattenAssociativeChains;
+using MathTree::memoiseConstantSubtrees;
+using MathTree::MultiplyAddRounding;
+using MathTree::SummationMode;
+
+class BytecodeTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+
+  double evaluateCompiled(std::string input) {
+    auto expression = parser.parse(std::move(input));
+    return BytecodeProgram::compile(*expression).evaluate();
+  }
+};
+
+TEST_F(BytecodeTest, aCompiledNumberEvaluatesToTheNumberItself) {
+  EXPECT_DOUBLE_EQ(evaluateCompiled("42.5"), 42.5);
+}
+
+TEST_F(BytecodeTest, compiledProgramsRespectThePriorityAndAssociativityOfOperators) {
+  EXPECT_DOUBLE_EQ(evaluateCompiled("10+2*5-20/2"), 10.0);
+  EXPECT_DOUBLE_EQ(evaluateCompiled("100-(30/3/(3-1)+0-3-2)-10/5"), 98.0);
+  EXPECT_DOUBLE_EQ(evaluateCompiled("2^3^0"), 2.0);
+  EXPECT_DOUBLE_EQ(evaluateCompiled("-(-3)"), 3.0);
+}
+
+TEST_F(BytecodeTest, compiledProgramsCanEvaluateSquareRootsAndLogarithms) {
+  EXPECT_DOUBLE_EQ(evaluateCompiled("sqrtsqrt16"), 2.0);
+  EXPECT_DOUBLE_EQ(evaluateCompiled("log100"), 2.0);
+  EXPECT_DOUBLE_EQ(evaluateCompiled("log_2(8)*3"), 9.0);
+}
+
+TEST_F(BytecodeTest, deeplyNestedExpressionsCanUseMoreStackThanAvailableInline) {
+  std::string input;
+  for (int i = 0; i < 100; ++i) {
+    input += "1+(";
+  }
+  input += "1";
+  input += std::string(100, ')');
+  auto expression = parser.parse(input);
+  auto program = BytecodeProgram::compile(*expression);
+  EXPECT_GT(program.maxStackDepth(), 64);
+  EXPECT_DOUBLE_EQ(program.evaluate(), 101.0);
+}
+
+TEST_F(BytecodeTest, aMillionTermChainIsCompiledWithoutOverflowingTheStack) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  std::string input = "x";
+  for (int i = 1; i < 1000000; ++i) {
+    input += "+x";
+  }
+  auto expression = parser.parse(input);
+  auto program = BytecodeProgram::compile(*expression);
+  EXPECT_EQ(program.instructions().size(), 1999999u);
+  EXPECT_EQ(program.maxStackDepth(), 2u);
+  parser.symbols().bind("x", 0.5);
+  EXPECT_DOUBLE_EQ(program.evaluate(), 500000.0);
+  expression.reset();
+}
+
+TEST_F(BytecodeTest, compilingAnExpressionOfUnknownTypeThrows) {
+  NiceExpressionMock unknown;
+  EXPECT_THROW(BytecodeProgram::compile(unknown), std::logic_error);
+}
+
+TEST_F(BytecodeTest, compiledProgramsReadTheCurrentValueOfVariables) {
+  auto expression = parser.parse("x^2+rate");
+  auto program = BytecodeProgram::compile(*expression);
+  parser.symbols().bind("x", 3.0);
+  parser.symbols().bind("rate", 0.5);
+  EXPECT_DOUBLE_EQ(program.evaluate(), 9.5);
+  parser.symbols().bind("x", 2.0);
+  EXPECT_DOUBLE_EQ(program.evaluate(), 4.5);
+}
+
+TEST_F(BytecodeTest, flattenedTreesGiveTheSameResultAsTheTreeTheyWereCompiledFrom) {
+  auto expression = flattenAssociativeChains(parser.parse("-x+0.1*x*0.3-sqrt(x+0.2+0.7)+1")).tree;
+  auto program = BytecodeProgram::compile(*expression);
+  parser.symbols().bind("x", 1.3);
+  EXPECT_EQ(program.evaluate(), expression->evaluate());
+}
+
+TEST_F(BytecodeTest, compilingASumWhoseTermsAreNotAddedSequentiallyThrows) {
+  auto expression = flattenAssociativeChains(parser.parse("1+2+3"), SummationMode::Pairwise).tree;
+  EXPECT_THROW(BytecodeProgram::compile(*expression), std::logic_error);
+}
+
+TEST_F(BytecodeTest, memoisedSubtreesAreCompiledAsTheyAre) {
+  auto expression = memoiseConstantSubtrees(parser.parse("x*(2+3)-sqrt(4)")).tree;
+  auto program = BytecodeProgram::compile(*expression);
+  parser.symbols().bind("x", 1.5);
+  EXPECT_EQ(program.evaluate(), expression->evaluate());
+}
+
+TEST_F(BytecodeTest, strengthReducedTreesAreCompiledIntoTheirOwnInstructions) {
+  parser.setStrengthReduction(true);
+  auto const program = BytecodeProgram::compile(*parser.parse("x^2*x^0.5+log_2(x)*log_7.5(x)"));
+  auto const& instructions = program.instructions();
+  auto const count = [&instructions](BytecodeProgram::OpCode opCode) {
+    return std::count_if(instructions.begin(), instructions.end(), [opCode](auto const& instruction) {
+      return instruction.opCode == opCode;
+    });
+  };
+  EXPECT_EQ(count(BytecodeProgram::OpCode::ConstantPower), 2);
+  EXPECT_EQ(count(BytecodeProgram::OpCode::SpecialisedLogarithm), 2);
+  EXPECT_EQ(count(BytecodeProgram::OpCode::Power) + count(BytecodeProgram::OpCode::Logarithm), 0);
+}
+
+TEST_F(BytecodeTest, recognisedPolynomialsAreCompiledWithTheirCoefficients) {
+  parser.setPolynomialRecognition(true);
+  auto const program = BytecodeProgram::compile(*parser.parse("sqrt(3*x^4+2*x^3-x^2+7*x+1)+(0.5*x^2-x)*(y^2-y)"));
+  ASSERT_EQ(program.polynomials().size(), 3);
+  EXPECT_EQ(program.polynomials()[0], (std::vector<double>{1, 7, -1, 2, 3}));
+}
+
+TEST_F(BytecodeTest, contractedMultiplyAddsAreCompiledIntoFusedInstructionsOnlyWhenRoundedOnce) {
+  for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+    parser.setMultiplyAddContraction(true, rounding);
+    auto const program = BytecodeProgram::compile(*parser.parse("(x*0.1+0.7)*(0.3-x*x)"));
+    auto const& instructions = program.instructions();
+    auto const fused = std::count_if(instructions.begin(), instructions.end(), [](auto const& instruction) {
+      return instruction.opCode == BytecodeProgram::OpCode::FusedMultiplyAdd ||
+             instruction.opCode == BytecodeProgram::OpCode::FusedAddMultiply;
+    });
+    EXPECT_EQ(fused, rounding == MultiplyAddRounding::Fused ? 2 : 0);
+  }
+}
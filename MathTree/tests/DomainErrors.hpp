@@ -0,0 +1,23 @@
+#ifndef MATHTREE_DOMAINERRORS
+#define MATHTREE_DOMAINERRORS
+#include "Expression.hpp"
+#include <stdexcept>
+#include <string>
+
+/// Returns the message of the domain error thrown by the evaluation given, or an empty string if it throws none.
+template<typename Evaluation>
+std::string domainErrorOf(Evaluation const& evaluation) {
+  try {
+    evaluation();
+  } catch (std::domain_error const& error) {
+    return error.what();
+  }
+  return "";
+}
+
+/// Returns the message of the domain error thrown by evaluating the expression, or an empty string if it throws none.
+inline std::string domainErrorOf(MathTree::Expression const& expression) {
+  return domainErrorOf([&expression] { expression.evaluate(); });
+}
+
+#endif // MATHTREE_DOMAINERRORS
\ No newline at end of file
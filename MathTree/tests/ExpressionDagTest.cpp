@@ -0,0 +1,173 @@
+#include <algorithm>
+#include "ExpressionDag.hpp"
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+
+using MathTree::ArithmeticParser;
+using MathTree::ExpressionDag;
+using MathTree::flattenAssociativeChains;
+using MathTree::memoiseConstantSubtrees;
+using MathTree::MultiplyAddRounding;
+using MathTree::SummationMode;
+
+class ExpressionDagTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+};
+
+TEST_F(ExpressionDagTest, repeatedSubexpressionsAreMergedIntoASingleNode) {
+  auto expression = parser.parse("(a+b)^2+(a+b)*c+sqrt(a+b)");
+  auto dag = ExpressionDag::build(*expression);
+  EXPECT_EQ(dag.treeSize(), 16);
+  EXPECT_EQ(dag.nodes().size(), 10);
+}
+
+TEST_F(ExpressionDagTest, repeatedNumbersAndVariablesAreMergedIntoASingleNode) {
+  auto dag = ExpressionDag::build(*parser.parse("2*x+2-x"));
+  EXPECT_EQ(dag.treeSize(), 7);
+  EXPECT_EQ(dag.nodes().size(), 5);
+}
+
+TEST_F(ExpressionDagTest, subexpressionsWithTheSameTermsInADifferentOrderAreKeptApart) {
+  auto dag = ExpressionDag::build(*parser.parse("(x-y)+(y-x)"));
+  EXPECT_EQ(dag.nodes().size(), 5);
+}
+
+TEST_F(ExpressionDagTest, logarithmsWithDifferentBasesAreKeptApart) {
+  auto dag = ExpressionDag::build(*parser.parse("log_2(x)+log_3(x)+log_2(x)"));
+  EXPECT_EQ(dag.nodes().size(), 5);
+}
+
+TEST_F(ExpressionDagTest, theRootIsTheLastNode) {
+  auto dag = ExpressionDag::build(*parser.parse("x*(x+1)"));
+  ASSERT_FALSE(dag.nodes().empty());
+  EXPECT_EQ(dag.nodes().back().operation, ExpressionDag::Operation::Multiply);
+}
+
+TEST_F(ExpressionDagTest, graphsReadTheCurrentValueOfVariables) {
+  auto expression = parser.parse("(x+y)^2-(x+y)/y");
+  auto dag = ExpressionDag::build(*expression);
+  parser.symbols().bind("x", 3.0);
+  parser.symbols().bind("y", 1.0);
+  EXPECT_DOUBLE_EQ(dag.evaluate(), 12.0);
+  parser.symbols().bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(dag.evaluate(), 22.5);
+}
+
+TEST_F(ExpressionDagTest, buildingAGraphFromAnExpressionOfUnknownTypeThrows) {
+  NiceExpressionMock unknown;
+  EXPECT_THROW(ExpressionDag::build(unknown), std::logic_error);
+}
+
+TEST_F(ExpressionDagTest, buildingAGraphFromVariablesOfDifferentSymbolTablesThrows) {
+  ArithmeticParser otherParser;
+  auto left = parser.parse("x");
+  auto right = otherParser.parse("x");
+  MathTree::AdditionExpression sum(std::move(left), MathTree::TokenType::Plus, std::move(right));
+  EXPECT_THROW(ExpressionDag::build(sum), std::logic_error);
+}
+
+TEST_F(ExpressionDagTest, flattenedTreesGiveTheSameResultAsTheTreeTheyWereBuiltFrom) {
+  auto expression = flattenAssociativeChains(parser.parse("-x+0.1*x*0.3-sqrt(x+0.2+0.7)+0.1*x*0.3")).tree;
+  auto dag = ExpressionDag::build(*expression);
+  parser.symbols().bind("x", 1.3);
+  EXPECT_EQ(dag.evaluate(), expression->evaluate());
+  EXPECT_LT(dag.nodes().size(), dag.treeSize() + 6);
+}
+
+TEST_F(ExpressionDagTest, sumsWhoseTermsAreNotAddedSequentiallyGiveTheSameResultAsTheTreeTheyWereBuiltFrom) {
+  for (auto mode: {SummationMode::Pairwise, SummationMode::Kahan}) {
+    auto const input = "-x+0.1-x*3+sqrt(x-0.3+x)+x*3-(x-0.3+x)";
+    auto expression = flattenAssociativeChains(parser.parse(input), mode).tree;
+    auto dag = ExpressionDag::build(*expression);
+    // the two sums of x-0.3+x are merged into a single list of terms
+    EXPECT_EQ(dag.termLists().size(), 2);
+    for (auto x: {0.5, 1.3, 7.0}) {
+      parser.symbols().bind("x", x);
+      EXPECT_EQ(dag.evaluate(), expression->evaluate()) << x;
+    }
+    parser.symbols().bind("x", 0.0);
+    EXPECT_THROW(dag.evaluate(), std::domain_error);
+  }
+}
+
+TEST_F(ExpressionDagTest, memoisedSubtreesAreMergedWithTheSameSubtreesLeftAsTheyAre) {
+  auto expression = memoiseConstantSubtrees(parser.parse("x*(2+3)-(2+3)")).tree;
+  auto dag = ExpressionDag::build(*expression);
+  EXPECT_EQ(dag.treeSize(), 11);
+  EXPECT_EQ(dag.nodes().size(), 6);
+  parser.symbols().bind("x", 1.5);
+  EXPECT_EQ(dag.evaluate(), expression->evaluate());
+}
+
+TEST_F(ExpressionDagTest, repeatedStrengthReducedPowersAndLogarithmsAreMerged) {
+  parser.setStrengthReduction(true);
+  for (auto const& input: {"x^2*x^-3+x^0.5+x^2", "log_2(x)+log(x)*log_7.5(x)+log_2(x)"}) {
+    auto dag = ExpressionDag::build(*parser.parse(input));
+    // the repeated power or logarithm is merged with its first occurrence
+    EXPECT_LT(dag.nodes().size(), dag.treeSize()) << input;
+  }
+}
+
+TEST_F(ExpressionDagTest, recognisedPolynomialsWithTheSameCoefficientsAndArgumentAreMerged) {
+  parser.setPolynomialRecognition(true);
+  auto const input = "sqrt(x^9-2*x^7+0.5*x^6-x^2+0.25)+(x^9-2*x^7+0.5*x^6-x^2+0.25)*(y^2-y)+(3*x^2-x)";
+  auto dag = ExpressionDag::build(*parser.parse(input));
+  EXPECT_EQ(dag.polynomials().size(), 3);
+  EXPECT_EQ(dag.nodes().size(), 9);
+}
+
+TEST_F(ExpressionDagTest, contractedMultiplyAddsAreBuiltIntoFusedNodesOnlyWhenRoundedOnce) {
+  for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+    parser.setMultiplyAddContraction(true, rounding);
+    auto dag = ExpressionDag::build(*parser.parse("(x*0.1+0.7)*(0.3-x*x)"));
+    auto const& nodes = dag.nodes();
+    auto const fused = std::count_if(nodes.begin(), nodes.end(), [](auto const& node) {
+      return node.operation == ExpressionDag::Operation::FusedMultiplyAdd;
+    });
+    EXPECT_EQ(fused, rounding == MultiplyAddRounding::Fused ? 2 : 0);
+  }
+}
+
+TEST_F(ExpressionDagTest, aGraphIsBuiltFromAMillionTermChainWithoutOverflowingTheStack) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  std::string input = "sqrt(x)";
+  for (int i = 1; i < 1000000; ++i) {
+    input += "+sqrt(x)";
+  }
+  auto expression = parser.parse("(" + input + ")/y");
+  auto dag = ExpressionDag::build(*expression);
+  EXPECT_EQ(dag.treeSize(), 3000001);
+  EXPECT_EQ(dag.nodes().size(), 1000004);
+  parser.symbols().bind("x", 4.0);
+  parser.symbols().bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(dag.evaluate(), 1000000.0);
+  expression.reset();
+}
+
+TEST_F(ExpressionDagTest, optimisedTreesHigherThanTheRecursionLimitGiveTheSameResultAsTheTree) {
+  parser.setStrengthReduction(true);
+  parser.setPolynomialRecognition(true);
+  parser.setMultiplyAddContraction(true);
+  // nesting square roots makes a term too high to be added by recursing, which no optimisation can collapse
+  std::string root = "x";
+  for (size_t i = 0; i < MathTree::Expression::maxRecursionHeight; ++i) {
+    root = "sqrt(" + root + ")";
+  }
+  auto const input = "sqrt(x)^2+log_3(" + root + ")-(x^3-2*x+1)*(x+" + root + ")+x*y+" + root;
+  for (auto mode: {SummationMode::Sequential, SummationMode::Pairwise, SummationMode::Kahan}) {
+    auto expression = flattenAssociativeChains(parser.parse(input), mode).tree;
+    EXPECT_GT(expression->height(), MathTree::Expression::maxRecursionHeight);
+    auto dag = ExpressionDag::build(*expression);
+    parser.symbols().bind("y", 0.7);
+    for (auto x: {0.1, 1.3, 7.0}) {
+      parser.symbols().bind("x", x);
+      EXPECT_EQ(dag.evaluate(), expression->evaluate()) << x;
+    }
+  }
+}
@@ -8,6 +8,7 @@ public:
   MOCK_METHOD(double, evaluate, (), (const, override));
   MOCK_METHOD(void, print, (std::ostream&), (const, override));
   MOCK_METHOD(std::vector<Expression const*>, subexpressions, (), (const, override));
+  MOCK_METHOD(bool, isConstant, (), (const, override));
 };
 using NiceExpressionMock = ::testing::NiceMock<ExpressionMock>;
 
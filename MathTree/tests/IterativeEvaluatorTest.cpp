@@ -0,0 +1,199 @@
+#include <cmath>
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "IterativeEvaluator.hpp"
+#include <memory>
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+
+using MathTree::ArithmeticParser;
+using MathTree::Expression;
+using MathTree::flattenAssociativeChains;
+using MathTree::IterativeEvaluator;
+using MathTree::Memoisation;
+using MathTree::SummationMode;
+using ::testing::Return;
+
+class IterativeEvaluatorTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+  IterativeEvaluator evaluator;
+
+  /// Returns an expression made of the given number of terms added together, which is as deep as the number of terms.
+  static std::string longSum(std::string const& term, size_t terms) {
+    std::string input = term;
+    input.reserve(terms * (term.size() + 1));
+    for (size_t i = 1; i < terms; ++i) {
+      input += '+';
+      input += term;
+    }
+    return input;
+  }
+};
+
+TEST_F(IterativeEvaluatorTest, expressionsHigherThanTheRecursionLimitReturnTheSameResultsAndErrorsAsTryEvaluate) {
+  auto const zero = "(" + longSum("0", Expression::maxRecursionHeight + 1) + ")";
+  auto const left = "(2.5+" + zero + ")";
+  for (auto const& input: {left + "/" + left, left + "^2", "sqrt" + left, "log_3" + left, "1/" + zero,
+                           zero + "^" + zero, "sqrt(-1+" + zero + ")", "log" + zero, "sqrt(-1)/" + zero,
+                           "(log(0)+" + zero + ")^sqrt(-1+" + zero + ")", "x*" + left}) {
+    auto expression = parser.parse(input);
+    auto const iterative = evaluator.tryEvaluate(*expression);
+    auto const recursive = expression->tryEvaluate();
+    ASSERT_EQ(iterative.hasValue(), recursive.hasValue()) << input;
+    if (recursive.hasValue()) {
+      EXPECT_EQ(iterative.value(), recursive.value()) << input;
+    } else {
+      EXPECT_EQ(iterative.error(), recursive.error()) << input;
+      EXPECT_EQ(iterative.failedExpression(), recursive.failedExpression()) << input;
+    }
+  }
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionTermChainIsTriedWithoutOverflowingTheStack) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  auto expression = parser.parse("(" + longSum("x", 1000000) + ")/y");
+  parser.symbols().bind("x", 0.5);
+  parser.symbols().bind("y", 0.0);
+  auto const failed = evaluator.tryEvaluate(*expression);
+  EXPECT_EQ(failed.error(), MathTree::EvaluationError::DivisionByZero);
+  EXPECT_EQ(failed.failedExpression(), expression.get());
+  parser.symbols().bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(evaluator.tryEvaluate(*expression).value(), 250000.0);
+  expression.reset();
+}
+
+TEST_F(IterativeEvaluatorTest, expressionsHigherThanTheRecursionLimitGiveTheSameResultsAsTheRecursivePolicies) {
+  using MathTree::EvaluationPolicy::Propagating;
+  using MathTree::EvaluationPolicy::Unchecked;
+  parser.setMemoisation(Memoisation::ConstantSubtrees);
+  auto const zero = "(" + longSum("0", Expression::maxRecursionHeight + 1) + ")";
+  auto const left = "(2.5+" + zero + ")";
+  for (auto const& input: {left + "/" + left, left + "^" + left, "-" + left, "sqrt" + left, "log_3" + left,
+                           "1/" + zero, zero + "^" + zero, "sqrt(-1+" + zero + ")", "log" + zero}) {
+    auto const propagating = parser.parse(input)->evaluateWith<Propagating>();
+    auto const expression = parser.parse(input);
+    if (std::isnan(propagating)) {
+      EXPECT_TRUE(std::isnan(evaluator.evaluateWith<Propagating>(*expression))) << input;
+    } else {
+      EXPECT_EQ(evaluator.evaluateWith<Propagating>(*expression), propagating) << input;
+      EXPECT_EQ(evaluator.evaluateWith<Unchecked>(*parser.parse(input)), propagating) << input;
+    }
+    // results without a real value are not kept, so the checked evaluation still fails
+    if (!std::isfinite(propagating)) {
+      EXPECT_FALSE(expression->tryEvaluate().hasValue()) << input;
+    }
+  }
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionTermChainIsEvaluatedAsPerAPolicyWithoutOverflowingTheStack) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  auto expression = parser.parse("(" + longSum("x", 1000000) + ")/y");
+  parser.symbols().bind("x", 0.5);
+  parser.symbols().bind("y", 0.0);
+  EXPECT_EQ(evaluator.evaluateWith<MathTree::EvaluationPolicy::Propagating>(*expression), HUGE_VAL);
+  parser.symbols().bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(evaluator.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(*expression), 250000.0);
+  expression.reset();
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionTermChainIsOptimisedWithoutOverflowingTheStack) {
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  parser.setConstantFolding(true);
+  auto const input = longSum("x^2*(3-1)", 500000) + "+" + longSum("sqrt(x)*2^-1", 500000);
+  parser.symbols().bind("x", 0.25);
+  auto folded = parser.parse(input);
+  EXPECT_GT(folded->height(), Expression::maxRecursionHeight);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*folded), 187500.0);
+  folded.reset();
+
+  // the chain is left as high as it is parsed unless it is flattened
+  parser.setStrengthReduction(true);
+  parser.setPolynomialRecognition(true);
+  parser.setMultiplyAddContraction(true);
+  auto optimised = parser.parse(input);
+  EXPECT_GT(optimised->height(), Expression::maxRecursionHeight);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*optimised), 187500.0);
+  optimised.reset();
+
+  parser.setChainFlattening(true);
+  auto flattened = parser.parse(input);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*flattened), 187500.0);
+}
+
+TEST_F(IterativeEvaluatorTest, anEvaluatorCanBeReusedAfterAnError) {
+  auto invalid = parser.parse(longSum("1", 100) + "+sqrt(-1)");
+  EXPECT_THROW(evaluator.evaluate(*invalid), std::domain_error);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*parser.parse("1+2*3")), 7.0);
+}
+
+TEST_F(IterativeEvaluatorTest, variablesAreReadOnEveryEvaluation) {
+  auto expression = parser.parse("x^2+rate");
+  parser.symbols().bind("x", 3.0);
+  parser.symbols().bind("rate", 0.5);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 9.5);
+  parser.symbols().bind("x", 2.0);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 4.5);
+}
+
+TEST_F(IterativeEvaluatorTest, expressionsOfUnknownTypeAreEvaluatedThroughEvaluate) {
+  NiceExpressionMock unknown;
+  ON_CALL(unknown, evaluate()).WillByDefault(Return(3.5));
+  EXPECT_CALL(unknown, evaluate()).Times(1);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(unknown), 3.5);
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionTermSumIsEvaluatedAndDestroyedWithoutOverflowingTheStack) {
+  parser.setMemoisation(Memoisation::ConstantSubtrees);
+  auto expression = parser.parse(longSum("1", 1000000));
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 1000000.0);
+  // the result of the constant tree is memoised, so the recursive evaluation stops at the root
+  EXPECT_DOUBLE_EQ(expression->evaluate(), 1000000.0);
+  expression.reset();
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionTermSumOfVariablesIsMemoisedWithoutOverflowingTheStack) {
+  parser.setMemoisation(Memoisation::ConstantSubtrees);
+  auto expression = parser.parse(longSum("x", 1000000) + "+sqrt(4)");
+  parser.symbols().bind("x", 0.5);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 500002.0);
+  parser.symbols().bind("x", 2.0);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 2000002.0);
+  expression.reset();
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionTermSumOfVariablesIsEvaluatedWithoutOverflowingTheStack) {
+  auto expression = parser.parse(longSum("x", 1000000));
+  parser.symbols().bind("x", 0.5);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 500000.0);
+  parser.symbols().bind("x", 2.0);
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 2000000.0);
+}
+
+TEST_F(IterativeEvaluatorTest, aMillionNestedNegationsAreEvaluatedAndDestroyedWithoutOverflowingTheStack) {
+  std::unique_ptr<Expression> expression = std::make_unique<MathTree::RealNumberExpression>(2.0);
+  for (int i = 0; i < 1000000; ++i) {
+    expression = std::make_unique<MathTree::NegativeSignExpression>(MathTree::TokenType::Minus, std::move(expression));
+  }
+  EXPECT_DOUBLE_EQ(evaluator.evaluate(*expression), 2.0);
+  expression.reset();
+}
+
+TEST_F(IterativeEvaluatorTest, nAryExpressionsHigherThanTheRecursionLimitGiveTheSameResultAsTheRecursiveEvaluation) {
+  // nesting square roots of one makes a term too high to be evaluated by recursing, but which cannot be flattened
+  std::string one = "1";
+  for (size_t i = 0; i < Expression::maxRecursionHeight; ++i) {
+    one = "sqrt(" + one + ")";
+  }
+  auto const input = "2.5-" + one + "+0.1+3*" + one + "*x";
+  parser.symbols().bind("x", 1.5);
+  for (auto mode: {SummationMode::Sequential, SummationMode::Pairwise, SummationMode::Kahan}) {
+    auto iterative = flattenAssociativeChains(parser.parse(input), mode).tree;
+    auto recursive = flattenAssociativeChains(parser.parse(input), mode).tree;
+    EXPECT_GT(iterative->height(), Expression::maxRecursionHeight);
+    EXPECT_EQ(evaluator.evaluate(*iterative), recursive->evaluate());
+  }
+}
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <cmath>
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "TokenMatchers.hpp"
@@ -5,6 +6,7 @@
 using ::testing::Property;
 using ::testing::Optional;
 using ::testing::Eq;
+using MathTree::IdentifierMatcher;
 using MathTree::LogarithmMatcher;
 using MathTree::TokenType;
 using MathTree::SymbolMatcher;
@@ -50,6 +52,21 @@ TEST(MatchersTest, unsignedNumberMatcherDoesNotMatchSignedNumbers) {
   EXPECT_EQ(matcher.match("-100", 0), std::nullopt);
 }
 
+TEST(MatchersTest, unsignedNumberMatcherDecodesTheValueOfTheNumber) {
+  UnsignedNumberMatcher matcher;
+  EXPECT_THAT(matcher.match("2*100.39+0.1", 2), Optional(Property(&MathTree::Token::value, Eq(100.39))));
+  EXPECT_THAT(matcher.match(".5", 0), Optional(Property(&MathTree::Token::value, Eq(0.5))));
+}
+
+TEST(MatchersTest, unsignedNumberMatcherStopsAtTheSecondDecimalPlace) {
+  UnsignedNumberMatcher matcher;
+  auto const token = matcher.match("1.5.2", 0);
+  ASSERT_TRUE(token.has_value());
+  EXPECT_EQ(token->text(), "1.5");
+  EXPECT_EQ(token->value(), 1.5);
+  EXPECT_EQ(matcher.match(".", 0), std::nullopt);
+}
+
 TEST(MatchersTest, logMatcherMatchesLogWithImpliedBase10) {
   LogarithmMatcher matcher;
   EXPECT_THAT(matcher.match("log10", 0), 
@@ -60,4 +77,41 @@ TEST(MatchersTest, logMatcherMatchesLogWithArbitraryBasePrecededByAnUnderscore)
   LogarithmMatcher matcher;
   EXPECT_THAT(matcher.match("log_3(9)", 0), 
               Optional(Property(&MathTree::Token::text, Eq("log_3"))));
+}
+
+TEST(MatchersTest, identifierMatcherMatchesLettersDigitsAndUnderscores) {
+  IdentifierMatcher matcher;
+  EXPECT_THAT(matcher.match("2*rate_2+1", 2),
+              Optional(Property(&MathTree::Token::text, Eq("rate_2"))));
+  EXPECT_THAT(matcher.match("_x", 0),
+              Optional(Property(&MathTree::Token::type, Eq(TokenType::Variable))));
+}
+
+TEST(MatchersTest, identifierMatcherDoesNotMatchIdentifiersStartingWithADigit) {
+  IdentifierMatcher matcher;
+  EXPECT_EQ(matcher.match("2x", 0), std::nullopt);
+}
+
+TEST(MatchersTest, identifierMatcherDoesNotMatchTheSymbolsOfFunctions) {
+  IdentifierMatcher matcher;
+  EXPECT_EQ(matcher.match("sqrtx", 0), std::nullopt);
+  EXPECT_EQ(matcher.match("log_x", 0), std::nullopt);
+}
+
+TEST(MatchersTest, logMatcherDecodesTheBaseOfTheLogarithm) {
+  LogarithmMatcher matcher;
+  EXPECT_THAT(matcher.match("log_2.5(9)", 0), Optional(Property(&MathTree::Token::value, Eq(2.5))));
+}
+
+TEST(MatchersTest, logMatcherMatchesTheSymbolOfEulersNumberAsBase) {
+  LogarithmMatcher matcher;
+  EXPECT_THAT(matcher.match("log_e(9)", 0), Optional(Property(&MathTree::Token::text, Eq("log_e"))));
+  EXPECT_THAT(matcher.match("log_e x", 0), Optional(Property(&MathTree::Token::value, Eq(std::exp(1.0)))));
+  EXPECT_EQ(matcher.match("log_exp", 0), std::nullopt);
+  EXPECT_EQ(matcher.match("log_e2", 0), std::nullopt);
+}
+
+TEST(MatchersTest, identifierLengthDoesNotRejectTheSymbolsOfFunctions) {
+  EXPECT_EQ(IdentifierMatcher::identifierLength("2*sqrt_1+1", 2), 6);
+  EXPECT_EQ(IdentifierMatcher::identifierLength("2*sqrt_1+1", 0), 0);
 }
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include <cmath>
+#include "Expression.hpp"
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using ::testing::ElementsAreArray;
+using ::testing::Return;
+using MathTree::Expression;
+using MathTree::FmaExpression;
+using MathTree::MultiplyAddRounding;
+using MathTree::ProductExpression;
+using MathTree::RealNumberExpression;
+using MathTree::SumExpression;
+using MathTree::SummationMode;
+
+class NaryExpressionsTest: public ::testing::Test {
+protected:
+  static std::unique_ptr<NiceExpressionMock> mockReturning(double value) {
+    auto mock = std::make_unique<NiceExpressionMock>();
+    ON_CALL(*mock, evaluate()).WillByDefault(Return(value));
+    return mock;
+  }
+
+  static std::unique_ptr<FmaExpression> multiplyAddOf(double multiplicand, double multiplier, double addend,
+                                                      FmaExpression::Pattern pattern, MultiplyAddRounding rounding) {
+    return std::make_unique<FmaExpression>(std::make_unique<RealNumberExpression>(multiplicand),
+                                           std::make_unique<RealNumberExpression>(multiplier),
+                                           std::make_unique<RealNumberExpression>(addend), pattern, rounding);
+  }
+
+  static SumExpression::TermList termsOf(std::vector<double> const& values) {
+    SumExpression::TermList terms;
+    for (auto value: values) {
+      terms.push_back({std::make_unique<RealNumberExpression>(value), false});
+    }
+    return terms;
+  }
+};
+
+TEST_F(NaryExpressionsTest, evaluatingASumAddsAndSubtractsItsTerms) {
+  SumExpression::TermList terms;
+  terms.push_back({mockReturning(5.0), false});
+  terms.push_back({mockReturning(4.5), true});
+  terms.push_back({mockReturning(2.0), false});
+  SumExpression sum(std::move(terms));
+  EXPECT_DOUBLE_EQ(sum.evaluate(), 2.5);
+}
+
+TEST_F(NaryExpressionsTest, theFirstTermOfASumCanBeSubtracted) {
+  SumExpression::TermList terms;
+  terms.push_back({mockReturning(5.0), true});
+  terms.push_back({mockReturning(2.0), false});
+  SumExpression sum(std::move(terms));
+  EXPECT_DOUBLE_EQ(sum.evaluate(), -3.0);
+}
+
+TEST_F(NaryExpressionsTest, aSequentialSumGivesTheSameResultAsAChainOfAdditions) {
+  std::vector<double> const values{0.1, 1e16, 0.7, -1e16, 0.3, 1e-3};
+  auto chain = values.front();
+  for (size_t i = 1; i < values.size(); ++i) {
+    chain = chain + values[i];
+  }
+  EXPECT_EQ(SumExpression(termsOf(values)).evaluate(), chain);
+}
+
+TEST_F(NaryExpressionsTest, compensatedAndPairwiseSumsAreMoreAccurateThanSequentialSums) {
+  // adding a tenth ten thousand times accumulates a visible rounding error when done sequentially
+  std::vector<double> const values(10000, 0.1);
+  auto const sequentialError = std::abs(SumExpression(termsOf(values), SummationMode::Sequential).evaluate() - 1000.0);
+  auto const pairwiseError = std::abs(SumExpression(termsOf(values), SummationMode::Pairwise).evaluate() - 1000.0);
+  auto const kahanError = std::abs(SumExpression(termsOf(values), SummationMode::Kahan).evaluate() - 1000.0);
+  EXPECT_GT(sequentialError, 1e-10);
+  EXPECT_LT(pairwiseError, sequentialError);
+  EXPECT_LT(kahanError, 1e-12);
+}
+
+TEST_F(NaryExpressionsTest, aCompensatedSumRecoversTermsSmallerThanTheRoundingError) {
+  SumExpression sum(termsOf({1.0, 1e100, 1.0, -1e100}), SummationMode::Kahan);
+  EXPECT_DOUBLE_EQ(sum.evaluate(), 2.0);
+}
+
+TEST_F(NaryExpressionsTest, aCompensatedSumOfInfiniteTermsIsInfinite) {
+  SumExpression sum(termsOf({1.0, 1e308, 1e308}), SummationMode::Kahan);
+  EXPECT_TRUE(std::isinf(sum.evaluate()));
+}
+
+TEST_F(NaryExpressionsTest, evaluatingAProductMultipliesItsFactors) {
+  Expression::ExpressionList factors;
+  factors.push_back(mockReturning(2.0));
+  factors.push_back(mockReturning(-3.0));
+  factors.push_back(mockReturning(1.5));
+  ProductExpression product(std::move(factors));
+  EXPECT_DOUBLE_EQ(product.evaluate(), -9.0);
+}
+
+TEST_F(NaryExpressionsTest, nAryExpressionsReturnTheirOperandsOrderedLeftToRight) {
+  auto first = mockReturning(1.0);
+  auto second = mockReturning(2.0);
+  std::vector<Expression const*> const pointers{first.get(), second.get()};
+  Expression::ExpressionList factors;
+  factors.push_back(std::move(first));
+  factors.push_back(std::move(second));
+  ProductExpression product(std::move(factors));
+  EXPECT_THAT(product.subexpressions(), ElementsAreArray(pointers));
+}
+
+TEST_F(NaryExpressionsTest, nAryExpressionsGiveAccessToTheirOperandsByPosition) {
+  SumExpression sum(termsOf({1.0, 2.0, 3.0}));
+  Expression::ExpressionList factors;
+  factors.push_back(mockReturning(1.0));
+  factors.push_back(mockReturning(2.0));
+  ProductExpression product(std::move(factors));
+  for (Expression const* expression: {static_cast<Expression const*>(&sum), static_cast<Expression const*>(&product)}) {
+    auto const operands = expression->subexpressions();
+    ASSERT_EQ(expression->subexpressionCount(), operands.size());
+    for (size_t i = 0; i < operands.size(); ++i) {
+      EXPECT_EQ(&expression->subexpression(i), operands[i]);
+    }
+    EXPECT_THROW(expression->subexpression(operands.size()), std::out_of_range);
+  }
+}
+
+TEST_F(NaryExpressionsTest, nAryExpressionsThrowIfConstructedWithFewerThanTwoOperands) {
+  EXPECT_THROW(SumExpression(termsOf({1.0})), std::logic_error);
+  Expression::ExpressionList factors;
+  factors.push_back(mockReturning(1.0));
+  EXPECT_THROW(ProductExpression(std::move(factors)), std::logic_error);
+}
+
+TEST_F(NaryExpressionsTest, nAryExpressionsThrowIfConstructedWithANullOperand) {
+  auto terms = termsOf({1.0, 2.0});
+  terms.push_back({nullptr, false});
+  EXPECT_THROW(SumExpression(std::move(terms)), std::logic_error);
+  Expression::ExpressionList factors;
+  factors.push_back(mockReturning(1.0));
+  factors.push_back(nullptr);
+  EXPECT_THROW(ProductExpression(std::move(factors)), std::logic_error);
+}
+
+TEST_F(NaryExpressionsTest, aSumIsConstantOnlyIfAllItsTermsAreConstant) {
+  EXPECT_TRUE(SumExpression(termsOf({1.0, 2.0})).isConstant());
+  auto terms = termsOf({1.0});
+  terms.push_back({std::make_unique<NiceExpressionMock>(), false});
+  EXPECT_FALSE(SumExpression(std::move(terms)).isConstant());
+}
+
+TEST_F(NaryExpressionsTest, theHeightOfAnNAryExpressionIsOneMoreThanTheHighestOperand) {
+  Expression::ExpressionList factors;
+  factors.push_back(std::make_unique<SumExpression>(termsOf({1.0, 2.0})));
+  factors.push_back(mockReturning(1.0));
+  EXPECT_EQ(ProductExpression(std::move(factors)).height(), 3);
+}
+
+TEST_F(NaryExpressionsTest, nAryExpressionsArePrintedWithTheirOperatorsBetweenTheirOperands) {
+  SumExpression::TermList terms;
+  terms.push_back({std::make_unique<RealNumberExpression>(1.0), true});
+  terms.push_back({std::make_unique<RealNumberExpression>(2.0), false});
+  terms.push_back({std::make_unique<RealNumberExpression>(3.0), true});
+  Expression::ExpressionList factors;
+  factors.push_back(std::make_unique<SumExpression>(std::move(terms)));
+  factors.push_back(std::make_unique<RealNumberExpression>(4.0));
+  factors.push_back(std::make_unique<RealNumberExpression>(5.0));
+  std::stringstream stream;
+  stream << ProductExpression(std::move(factors));
+  EXPECT_EQ(stream.str(), "((-1 + 2 - 3) * 4 * 5)");
+}
+
+TEST_F(NaryExpressionsTest, tryingToEvaluateASumStopsAtTheFirstTermInError) {
+  auto failedTerm = std::make_unique<MathTree::SquareRootExpression>(std::make_unique<RealNumberExpression>(-1.0),
+                                                                     MathTree::TokenType::SquareRoot);
+  auto const failedTermPtr = failedTerm.get();
+  auto lastTerm = std::make_unique<NiceExpressionMock>();
+  EXPECT_CALL(*lastTerm, evaluate()).Times(0);
+  SumExpression::TermList terms;
+  terms.push_back({mockReturning(1.0), false});
+  terms.push_back({std::move(failedTerm), true});
+  terms.push_back({std::move(lastTerm), false});
+  SumExpression sum(std::move(terms), SummationMode::Pairwise);
+  auto const result = sum.tryEvaluate();
+  ASSERT_FALSE(result.hasValue());
+  EXPECT_EQ(result.failedExpression(), failedTermPtr);
+}
+
+TEST_F(NaryExpressionsTest, sumsAndProductsGiveTheSameResultWithEveryPolicy) {
+  for (auto mode: {SummationMode::Sequential, SummationMode::Pairwise, SummationMode::Kahan}) {
+    SumExpression sum(termsOf({0.1, 0.2, 0.3, 1e16, -1e16}), mode);
+    auto const checked = sum.evaluate();
+    EXPECT_EQ(sum.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), checked);
+    EXPECT_EQ(sum.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), checked);
+  }
+  Expression::ExpressionList factors;
+  for (auto value: {1.5, -2.0, 0.25}) {
+    factors.push_back(std::make_unique<RealNumberExpression>(value));
+  }
+  ProductExpression product(std::move(factors));
+  EXPECT_DOUBLE_EQ(product.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), -0.75);
+}
+
+TEST_F(NaryExpressionsTest, termsWithoutARealResultPropagateThroughASum) {
+  SumExpression::TermList terms;
+  terms.push_back({std::make_unique<RealNumberExpression>(1.0), false});
+  terms.push_back({std::make_unique<MathTree::SquareRootExpression>(std::make_unique<RealNumberExpression>(-1.0),
+                                                                     MathTree::TokenType::SquareRoot), true});
+  SumExpression sum(std::move(terms), SummationMode::Pairwise);
+  EXPECT_TRUE(std::isnan(sum.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+  EXPECT_THROW(sum.evaluate(), std::domain_error);
+}
+
+TEST_F(NaryExpressionsTest, evaluatingAMultiplyAddComputesItsPattern) {
+  using Pattern = FmaExpression::Pattern;
+  for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+    EXPECT_DOUBLE_EQ(multiplyAddOf(3.0, 4.0, 2.0, Pattern::ProductPlusAddend, rounding)->evaluate(), 14.0);
+    EXPECT_DOUBLE_EQ(multiplyAddOf(3.0, 4.0, 2.0, Pattern::AddendPlusProduct, rounding)->evaluate(), 14.0);
+    EXPECT_DOUBLE_EQ(multiplyAddOf(3.0, 4.0, 2.0, Pattern::ProductMinusAddend, rounding)->evaluate(), 10.0);
+    EXPECT_DOUBLE_EQ(multiplyAddOf(3.0, 4.0, 2.0, Pattern::AddendMinusProduct, rounding)->evaluate(), -10.0);
+  }
+}
+
+TEST_F(NaryExpressionsTest, aSeparatelyRoundedMultiplyAddGivesTheSameResultAsAProductAndASum) {
+  // (1 + 2^-30)^2 - 1 loses its last term when the product is rounded
+  auto const value = 1.0 + std::ldexp(1.0, -30);
+  auto const product = value * value;
+  auto const separate = multiplyAddOf(value, value, 1.0, FmaExpression::Pattern::ProductMinusAddend,
+                                      MultiplyAddRounding::Separate);
+  EXPECT_EQ(separate->evaluate(), product - 1.0);
+  auto const fused = multiplyAddOf(value, value, 1.0, FmaExpression::Pattern::ProductMinusAddend,
+                                   MultiplyAddRounding::Fused);
+  EXPECT_EQ(fused->evaluate(), std::ldexp(1.0, -29) + std::ldexp(1.0, -60));
+  EXPECT_NE(fused->evaluate(), separate->evaluate());
+}
+
+TEST_F(NaryExpressionsTest, aMultiplyAddEvaluatesItsOperandsInTheOrderOfTheOriginalExpression) {
+  auto multiplicand = std::make_unique<NiceExpressionMock>();
+  auto multiplier = std::make_unique<NiceExpressionMock>();
+  auto addend = std::make_unique<NiceExpressionMock>();
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(*addend, evaluate()).WillOnce(Return(1.0));
+    EXPECT_CALL(*multiplicand, evaluate()).WillOnce(Return(2.0));
+    EXPECT_CALL(*multiplier, evaluate()).WillOnce(Return(3.0));
+  }
+  auto const pointers = std::vector<Expression const*>{addend.get(), multiplicand.get(), multiplier.get()};
+  FmaExpression multiplyAdd(std::move(multiplicand), std::move(multiplier), std::move(addend),
+                            FmaExpression::Pattern::AddendMinusProduct, MultiplyAddRounding::Fused);
+  EXPECT_THAT(multiplyAdd.subexpressions(), ElementsAreArray(pointers));
+  EXPECT_DOUBLE_EQ(multiplyAdd.evaluate(), -5.0);
+}
+
+TEST_F(NaryExpressionsTest, multiplyAddsArePrintedAsTheProductAndSumTheyReplace) {
+  std::stringstream stream;
+  stream << *multiplyAddOf(2.0, 3.0, 4.0, FmaExpression::Pattern::ProductPlusAddend, MultiplyAddRounding::Fused);
+  stream << ' ' << *multiplyAddOf(2.0, 3.0, 4.0, FmaExpression::Pattern::AddendMinusProduct,
+                                  MultiplyAddRounding::Separate);
+  EXPECT_EQ(stream.str(), "((2 * 3) + 4) (4 - (2 * 3))");
+}
+
+TEST_F(NaryExpressionsTest, multiplyAddsThrowIfConstructedWithANullOperand) {
+  EXPECT_THROW(FmaExpression(mockReturning(1.0), nullptr, mockReturning(1.0), FmaExpression::Pattern::ProductPlusAddend,
+                             MultiplyAddRounding::Fused), std::logic_error);
+}
+
+TEST_F(NaryExpressionsTest, multiplyAddsGiveTheSameResultWithEveryPolicy) {
+  for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+    auto const multiplyAdd = multiplyAddOf(0.1, 0.7, -0.07, FmaExpression::Pattern::AddendPlusProduct, rounding);
+    auto const checked = multiplyAdd->evaluate();
+    EXPECT_EQ(multiplyAdd->evaluateWith<MathTree::EvaluationPolicy::Propagating>(), checked);
+    EXPECT_EQ(multiplyAdd->evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), checked);
+  }
+}
+
+TEST_F(NaryExpressionsTest, multiplyAddsGiveAccessToTheirOperandsByPositionInTheOrderTheyAreEvaluated) {
+  for (auto pattern: {FmaExpression::Pattern::ProductMinusAddend, FmaExpression::Pattern::AddendPlusProduct}) {
+    auto const multiplyAdd = multiplyAddOf(1.0, 2.0, 3.0, pattern, MultiplyAddRounding::Fused);
+    auto const operands = multiplyAdd->subexpressions();
+    ASSERT_EQ(multiplyAdd->subexpressionCount(), 3);
+    for (size_t i = 0; i < operands.size(); ++i) {
+      EXPECT_EQ(&multiplyAdd->subexpression(i), operands[i]);
+    }
+    EXPECT_THROW(multiplyAdd->subexpression(3), std::out_of_range);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,583 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "DomainErrors.hpp"
+#include "Expression.hpp"
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Optimisations.hpp"
+#include "Parser.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+using ::testing::NotNull;
+using ::testing::Return;
+using ::testing::WhenDynamicCastTo;
+using MathTree::ArithmeticParser;
+using MathTree::ConstantPowerExpression;
+using MathTree::contractMultiplyAdds;
+using MathTree::Expression;
+using MathTree::flattenAssociativeChains;
+using MathTree::FmaExpression;
+using MathTree::foldConstants;
+using MathTree::Memoisation;
+using MathTree::MemoisedExpression;
+using MathTree::memoiseConstantSubtrees;
+using MathTree::MultiplyAddRounding;
+using MathTree::NegativeSignExpression;
+using MathTree::PolynomialExpression;
+using MathTree::ProductExpression;
+using MathTree::RealNumberExpression;
+using MathTree::recognisePolynomials;
+using MathTree::reduceStrength;
+using MathTree::SpecialisedLogarithmExpression;
+using MathTree::SumExpression;
+using MathTree::SummationMode;
+using MathTree::TokenType;
+
+// returns the expression as printed, which shows the shape of its tree
+std::string printed(Expression const& expression) {
+  std::stringstream stream;
+  stream << expression;
+  return stream.str();
+}
+
+class ConstantFoldingTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+};
+
+TEST_F(ConstantFoldingTest, aTreeWithoutVariablesIsFoldedIntoASingleNumber) {
+  auto expected = parser.parse("sqrt(2)*log_2(1024)")->evaluate();
+  auto result = foldConstants(parser.parse("sqrt(2)*log_2(1024)"));
+  EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<RealNumberExpression*>(NotNull()));
+  EXPECT_EQ(result.removedNodes, 4);
+  EXPECT_DOUBLE_EQ(result.tree->evaluate(), expected);
+}
+
+TEST_F(ConstantFoldingTest, constantSubtreesNextToVariablesAreFolded) {
+  auto result = foldConstants(parser.parse("sqrt(4)*log_2(1024)*x"));
+  EXPECT_EQ(result.removedNodes, 4);
+  ASSERT_EQ(result.tree->subexpressions().size(), 2);
+  EXPECT_THAT(result.tree->subexpressions()[0], WhenDynamicCastTo<RealNumberExpression const*>(NotNull()));
+  parser.symbols().bind("x", 3.0);
+  EXPECT_DOUBLE_EQ(result.tree->evaluate(), 60.0);
+}
+
+TEST_F(ConstantFoldingTest, variablesAreNotFolded) {
+  auto result = foldConstants(parser.parse("x*y"));
+  EXPECT_EQ(result.removedNodes, 0);
+  parser.symbols().bind("x", 3.0);
+  parser.symbols().bind("y", 5.0);
+  EXPECT_DOUBLE_EQ(result.tree->evaluate(), 15.0);
+  parser.symbols().bind("y", 6.0);
+  EXPECT_DOUBLE_EQ(result.tree->evaluate(), 18.0);
+}
+
+TEST_F(ConstantFoldingTest, aConstantDivisionByZeroStillThrowsWhenTheTreeIsEvaluated) {
+  auto original = parser.parse("1/(2-2)");
+  std::string expectedMessage;
+  try {
+    original->evaluate();
+  } catch (std::domain_error const& error) {
+    expectedMessage = error.what();
+  }
+
+  auto result = foldConstants(parser.parse("1/(2-2)"));
+  EXPECT_EQ(result.removedNodes, 2);
+  try {
+    result.tree->evaluate();
+    FAIL() << "Expected the folded tree to throw.";
+  } catch (std::domain_error const& error) {
+    EXPECT_EQ(error.what(), expectedMessage);
+  }
+}
+
+TEST_F(ConstantFoldingTest, subtreesWithInfiniteResultsAreNotFolded) {
+  auto result = foldConstants(parser.parse("10^400+x"));
+  EXPECT_EQ(result.removedNodes, 0);
+  EXPECT_EQ(printed(*result.tree), "((10 ^ 400) + x)");
+}
+
+TEST_F(ConstantFoldingTest, constantSubtreesAboveAFailedOneAreNotEvaluatedAgain) {
+  auto throwing = std::make_unique<NiceExpressionMock>();
+  ON_CALL(*throwing, isConstant()).WillByDefault(Return(true));
+  EXPECT_CALL(*throwing, evaluate()).WillOnce([]() -> double { throw std::domain_error("failed"); });
+  std::unique_ptr<Expression> tree = std::move(throwing);
+  for (size_t i = 0; i < 1000; ++i) {
+    tree = std::make_unique<NegativeSignExpression>(TokenType::Minus, std::move(tree));
+  }
+  auto result = foldConstants(std::move(tree));
+  EXPECT_EQ(result.removedNodes, 0);
+  EXPECT_EQ(result.tree->height(), 1001);
+}
+
+TEST_F(ConstantFoldingTest, aTreeMadeOfASingleNumberIsLeftUntouched) {
+  auto tree = parser.parse("3");
+  auto treePtr = tree.get();
+  auto result = foldConstants(std::move(tree));
+  EXPECT_EQ(result.tree.get(), treePtr);
+  EXPECT_EQ(result.removedNodes, 0);
+}
+
+TEST_F(ConstantFoldingTest, foldingAnEmptyTreeThrows) {
+  EXPECT_THROW(foldConstants(nullptr), std::logic_error);
+}
+
+TEST_F(ConstantFoldingTest, theParserCanFoldTheTreesItBuilds) {
+  EXPECT_FALSE(parser.foldsConstants());
+  parser.setConstantFolding(true);
+  auto tree = parser.parse("(1+2)*x");
+  EXPECT_EQ(printed(*tree), "(3 * x)");
+}
+
+class ChainFlatteningTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+};
+
+TEST_F(ChainFlatteningTest, aChainOfAdditionsAndSubtractionsBecomesASingleSum) {
+  auto result = flattenAssociativeChains(parser.parse("1+2-3+4"));
+  EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<SumExpression*>(NotNull()));
+  EXPECT_EQ(result.tree->subexpressions().size(), 4);
+  EXPECT_EQ(result.removedNodes, 2);
+  EXPECT_EQ(printed(*result.tree), "(1 + 2 - 3 + 4)");
+}
+
+TEST_F(ChainFlatteningTest, aChainOfMultiplicationsBecomesASingleProduct) {
+  auto result = flattenAssociativeChains(parser.parse("x*2*y*3"));
+  EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<ProductExpression*>(NotNull()));
+  EXPECT_EQ(result.removedNodes, 2);
+  EXPECT_EQ(printed(*result.tree), "(x * 2 * y * 3)");
+}
+
+TEST_F(ChainFlatteningTest, chainsNestedInOtherExpressionsAreFlattened) {
+  auto result = flattenAssociativeChains(parser.parse("sqrt(1+2+3)*x*y+4/(5*6*7)"));
+  EXPECT_EQ(printed(*result.tree), "((sqrt((1 + 2 + 3)) * x * y) + (4 / (5 * 6 * 7)))");
+  EXPECT_EQ(result.removedNodes, 3);
+}
+
+TEST_F(ChainFlatteningTest, rightOperandsAreNotMergedIntoTheChain) {
+  auto result = flattenAssociativeChains(parser.parse("1-(2+3)+4"));
+  EXPECT_EQ(printed(*result.tree), "(1 - (2 + 3) + 4)");
+}
+
+TEST_F(ChainFlatteningTest, sequentiallyFlattenedTreesGiveTheSameResultsAsTheOriginalOnes) {
+  auto const input = "0.1+0.2*x*0.3-0.4+x*0.7-sqrt(x+0.1+0.2)";
+  auto original = parser.parse(input);
+  auto result = flattenAssociativeChains(parser.parse(input));
+  for (auto value: {0.3, 1.7, 1e10}) {
+    parser.symbols().bind("x", value);
+    EXPECT_EQ(result.tree->evaluate(), original->evaluate());
+  }
+}
+
+TEST_F(ChainFlatteningTest, theSummationModeIsAppliedToEverySum) {
+  auto result = flattenAssociativeChains(parser.parse("1+2+sqrt(3+4)"), SummationMode::Kahan);
+  auto sum = dynamic_cast<SumExpression const*>(result.tree.get());
+  ASSERT_NE(sum, nullptr);
+  EXPECT_EQ(sum->mode(), SummationMode::Kahan);
+  auto innerSum = dynamic_cast<SumExpression const*>(sum->subexpressions()[2]->subexpressions()[0]);
+  ASSERT_NE(innerSum, nullptr);
+  EXPECT_EQ(innerSum->mode(), SummationMode::Kahan);
+}
+
+TEST_F(ChainFlatteningTest, aMillionTermChainIsFlattenedIntoASingleShallowSum) {
+  std::string input = "1";
+  for (int i = 1; i < 1000000; ++i) {
+    input += "+1";
+  }
+  auto result = flattenAssociativeChains(parser.parse(input));
+  EXPECT_EQ(result.tree->height(), 2);
+  EXPECT_DOUBLE_EQ(result.tree->evaluate(), 1000000.0);
+}
+
+TEST_F(ChainFlatteningTest, flatteningAnEmptyTreeThrows) {
+  EXPECT_THROW(flattenAssociativeChains(nullptr), std::logic_error);
+}
+
+TEST_F(ChainFlatteningTest, theParserCanFlattenTheTreesItBuilds) {
+  EXPECT_FALSE(parser.flattensChains());
+  parser.setChainFlattening(true);
+  parser.setConstantFolding(true);
+  EXPECT_EQ(printed(*parser.parse("x*2*y+1+2")), "((x * 2 * y) + 1 + 2)");
+  EXPECT_EQ(printed(*parser.parse("(1+2+3)*x*y")), "(6 * x * y)");
+}
+
+class StrengthReductionTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+
+  // returns the number of representable doubles between both values, which must have the same sign
+  static std::int64_t ulpsBetween(double left, double right) {
+    std::int64_t leftBits;
+    std::int64_t rightBits;
+    std::memcpy(&leftBits, &left, sizeof(left));
+    std::memcpy(&rightBits, &right, sizeof(right));
+    return std::abs(leftBits - rightBits);
+  }
+};
+
+TEST_F(StrengthReductionTest, smallIntegerAndHalfExponentsAreStoredInTheirPower) {
+  for (auto const& input: {"x^2", "x^0.5", "x^8", "x^0"}) {
+    auto result = reduceStrength(parser.parse(input));
+    EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<ConstantPowerExpression*>(NotNull())) << input;
+    EXPECT_EQ(result.removedNodes, 1) << input;
+  }
+}
+
+TEST_F(StrengthReductionTest, otherExponentsAreLeftToStdPow) {
+  for (auto const& input: {"x^2.5", "x^9", "x^x", "x^(1/2)"}) {
+    auto result = reduceStrength(parser.parse(input));
+    EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<MathTree::ExponentiationExpression*>(NotNull())) << input;
+    EXPECT_EQ(result.removedNodes, 0) << input;
+  }
+}
+
+TEST_F(StrengthReductionTest, reducedTreesArePrintedAsTheOriginalOnes) {
+  for (auto const& input: {"(x+1)^3*log_2(x)", "log(x)^0.5-log_3(2*x)"}) {
+    auto original = printed(*parser.parse(input));
+    EXPECT_EQ(printed(*reduceStrength(parser.parse(input)).tree), original) << input;
+  }
+}
+
+TEST_F(StrengthReductionTest, integerPowersAreWithinTheirBoundInUlpsOfStdPow) {
+  auto const x = parser.symbols().declare("x");
+  for (int exponent = -ConstantPowerExpression::maxIntegerExponent;
+       exponent <= ConstantPowerExpression::maxIntegerExponent; ++exponent) {
+    auto const input = "x^" + std::to_string(exponent);
+    auto const original = parser.parse(input);
+    // negative exponents are only real numbers once folded
+    auto const reduced = reduceStrength(foldConstants(parser.parse(input)).tree).tree;
+    ASSERT_THAT(reduced.get(), WhenDynamicCastTo<ConstantPowerExpression*>(NotNull())) << input;
+    for (auto value = 0.013; value < 40.0; value *= 1.37) {
+      parser.symbols().bind(x, value);
+      EXPECT_LE(ulpsBetween(reduced->evaluate(), original->evaluate()), std::abs(exponent) + 1) << input << value;
+    }
+  }
+}
+
+TEST_F(StrengthReductionTest, halfPowersGiveTheSameResultsAsStdPow) {
+  auto const x = parser.symbols().declare("x");
+  auto const original = parser.parse("x^0.5");
+  auto const reduced = reduceStrength(parser.parse("x^0.5")).tree;
+  for (auto value: {0.0, -0.0, 1e-310, 0.3, 2.0, 1e300, HUGE_VAL}) {
+    parser.symbols().bind(x, value);
+    EXPECT_TRUE(std::signbit(reduced->evaluate()) == std::signbit(original->evaluate())) << value;
+    EXPECT_EQ(reduced->evaluate(), original->evaluate()) << value;
+  }
+}
+
+TEST_F(StrengthReductionTest, logarithmsAreWithinTwoUlpsOfTheOriginalOnes) {
+  auto const x = parser.symbols().declare("x");
+  for (auto const& input: {"log(x)", "log_3(x)", "log_0.5(x)", "log_e(x)"}) {
+    auto const original = parser.parse(input);
+    auto const reduced = reduceStrength(parser.parse(input)).tree;
+    ASSERT_THAT(reduced.get(), WhenDynamicCastTo<SpecialisedLogarithmExpression*>(NotNull()));
+    for (auto value = 1e-200; value < 1e200; value *= 3.7) {
+      parser.symbols().bind(x, value);
+      EXPECT_LE(ulpsBetween(reduced->evaluate(), original->evaluate()), 2) << input << value;
+    }
+  }
+}
+
+TEST_F(StrengthReductionTest, binaryLogarithmsGiveTheSameResultsAsTheOriginalOnes) {
+  auto const x = parser.symbols().declare("x");
+  auto const original = parser.parse("log_2(x)");
+  auto const reduced = reduceStrength(parser.parse("log_2(x)")).tree;
+  for (auto value = 1e-200; value < 1e200; value *= 3.7) {
+    parser.symbols().bind(x, value);
+    EXPECT_EQ(reduced->evaluate(), original->evaluate()) << value;
+  }
+}
+
+TEST_F(StrengthReductionTest, naturalLogarithmsAreComputedByTheStandardLibrary) {
+  auto const x = parser.symbols().declare("x");
+  auto const reduced = reduceStrength(parser.parse("log_e(x)")).tree;
+  for (auto value = 1e-200; value < 1e200; value *= 3.7) {
+    parser.symbols().bind(x, value);
+    EXPECT_EQ(reduced->evaluate(), std::log(value)) << value;
+  }
+}
+
+TEST_F(StrengthReductionTest, reducedTreesThrowTheSameDomainErrorsAsTheOriginalOnes) {
+  auto const x = parser.symbols().declare("x");
+  for (auto const& input: {"x^0", "x^-2", "x^0.5", "log(x)", "log_3(x)"}) {
+    auto const original = parser.parse(input);
+    auto const reduced = reduceStrength(foldConstants(parser.parse(input)).tree).tree;
+    for (auto value: {0.0, -4.0}) {
+      parser.symbols().bind(x, value);
+      auto const error = domainErrorOf(*original);
+      EXPECT_EQ(domainErrorOf(*reduced), error) << input << value;
+      if (!error.empty()) {
+        EXPECT_FALSE(reduced->tryEvaluate()) << input << value;
+      }
+    }
+  }
+}
+
+TEST_F(StrengthReductionTest, reducingAnEmptyTreeThrows) {
+  EXPECT_THROW(reduceStrength(nullptr), std::logic_error);
+}
+
+TEST_F(StrengthReductionTest, theParserCanReduceTheTreesItBuildsOnceTheirConstantsAreFolded) {
+  EXPECT_FALSE(parser.reducesStrength());
+  parser.setStrengthReduction(true);
+  parser.setConstantFolding(true);
+  auto const tree = parser.parse("x^(1/2)+x^-(1+1)");
+  ASSERT_EQ(tree->subexpressions().size(), 2);
+  EXPECT_THAT(tree->subexpressions()[0], WhenDynamicCastTo<ConstantPowerExpression const*>(NotNull()));
+  EXPECT_THAT(tree->subexpressions()[1], WhenDynamicCastTo<ConstantPowerExpression const*>(NotNull()));
+}
+
+class PolynomialRecognitionTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+};
+
+TEST_F(PolynomialRecognitionTest, anExpandedPolynomialBecomesASinglePolynomialNode) {
+  auto const original = parser.parse("3*x^4+2*x^3-x^2+7*x+1");
+  auto const result = recognisePolynomials(parser.parse("3*x^4+2*x^3-x^2+7*x+1"));
+  auto const polynomial = dynamic_cast<PolynomialExpression const*>(result.tree.get());
+  ASSERT_THAT(polynomial, NotNull());
+  EXPECT_THAT(polynomial->coefficients(), ::testing::ElementsAre(1.0, 7.0, -1.0, 2.0, 3.0));
+  EXPECT_EQ(result.removedNodes, 21 - 2);
+  for (auto value: {-2.5, -1.0, 0.0, 0.3, 4.0}) {
+    parser.symbols().bind("x", value);
+    EXPECT_DOUBLE_EQ(result.tree->evaluate(), original->evaluate()) << value;
+  }
+}
+
+TEST_F(PolynomialRecognitionTest, polynomialsNestedInOtherExpressionsAreReplaced) {
+  auto const result = recognisePolynomials(parser.parse("sqrt(x^2+1)+log(x)"));
+  EXPECT_EQ(printed(*result.tree), "(sqrt((1 * x ^ 2 + 1)) + log_10(x))");
+}
+
+TEST_F(PolynomialRecognitionTest, polynomialsOfADegreeLowerThanTwoAreLeftUntouched) {
+  auto const result = recognisePolynomials(parser.parse("2*x+1"));
+  EXPECT_EQ(result.removedNodes, 0);
+  EXPECT_EQ(printed(*result.tree), "((2 * x) + 1)");
+}
+
+TEST_F(PolynomialRecognitionTest, productsOfSumsAreNotExpanded) {
+  auto const result = recognisePolynomials(parser.parse("(x+1)*(x-1)"));
+  EXPECT_EQ(result.removedNodes, 0);
+  EXPECT_EQ(printed(*recognisePolynomials(parser.parse("x*(x+1)")).tree), "(1 * x ^ 2 + 1 * x)");
+}
+
+TEST_F(PolynomialRecognitionTest, polynomialsInDifferentVariablesAreReplacedSeparately) {
+  auto const result = recognisePolynomials(parser.parse("(x^2-x)*(y^3/2)"));
+  EXPECT_EQ(printed(*result.tree), "((1 * x ^ 2 - 1 * x) * (0.5 * y ^ 3))");
+}
+
+TEST_F(PolynomialRecognitionTest, constantSubtreesAreTakenAsCoefficients) {
+  auto const result = recognisePolynomials(parser.parse("log_2(8)*x^2-(1+1)*x+0.5"));
+  auto const polynomial = dynamic_cast<PolynomialExpression const*>(result.tree.get());
+  ASSERT_THAT(polynomial, NotNull());
+  EXPECT_THAT(polynomial->coefficients(), ::testing::ElementsAre(0.5, -2.0, 3.0));
+}
+
+TEST_F(PolynomialRecognitionTest, operationsThatMayThrowAreLeftInTheTree) {
+  auto const x = parser.symbols().declare("x");
+  for (auto const& input: {"x^0+x^2", "x^2/(x-x)", "x^2+1/(1-1)", "x^2*sqrt(0-1)"}) {
+    auto const result = recognisePolynomials(parser.parse(input));
+    EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<PolynomialExpression*>(::testing::IsNull())) << input;
+    parser.symbols().bind(x, 0.0);
+    EXPECT_THROW(result.tree->evaluate(), std::domain_error) << input;
+  }
+}
+
+TEST_F(PolynomialRecognitionTest, highDegreePolynomialsGiveTheSameResultsAsTheirExpandedForm) {
+  std::string input = "1";
+  for (int degree = 1; degree <= 20; ++degree) {
+    input += "+" + std::to_string(degree % 3 + 1) + "*x^" + std::to_string(degree);
+  }
+  auto const original = parser.parse(input);
+  auto const result = recognisePolynomials(parser.parse(input));
+  auto const polynomial = dynamic_cast<PolynomialExpression const*>(result.tree.get());
+  ASSERT_THAT(polynomial, NotNull());
+  EXPECT_GE(polynomial->degree(), PolynomialExpression::estrinDegree);
+  for (auto value: {-1.1, -0.5, 0.0, 0.7, 1.3}) {
+    parser.symbols().bind("x", value);
+    EXPECT_DOUBLE_EQ(result.tree->evaluate(), original->evaluate()) << value;
+  }
+}
+
+TEST_F(PolynomialRecognitionTest, flattenedAndReducedTreesAreRecognised) {
+  parser.setChainFlattening(true);
+  parser.setStrengthReduction(true);
+  auto const result = recognisePolynomials(parser.parse("x^3*2*0.5+x*x-4"));
+  auto const polynomial = dynamic_cast<PolynomialExpression const*>(result.tree.get());
+  ASSERT_THAT(polynomial, NotNull());
+  EXPECT_THAT(polynomial->coefficients(), ::testing::ElementsAre(-4.0, 0.0, 1.0, 1.0));
+}
+
+TEST_F(PolynomialRecognitionTest, recognisingThePolynomialsOfAnEmptyTreeThrows) {
+  EXPECT_THROW(recognisePolynomials(nullptr), std::logic_error);
+}
+
+TEST_F(PolynomialRecognitionTest, theParserCanRecogniseThePolynomialsOfTheTreesItBuilds) {
+  EXPECT_FALSE(parser.recognisesPolynomials());
+  parser.setPolynomialRecognition(true);
+  EXPECT_THAT(parser.parse("x^2+x+1").get(), WhenDynamicCastTo<PolynomialExpression*>(NotNull()));
+}
+
+class MultiplyAddContractionTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+};
+
+TEST_F(MultiplyAddContractionTest, everyPatternIsContractedIntoOneNodeLess) {
+  using Pattern = FmaExpression::Pattern;
+  for (auto [input, pattern]: {std::pair{"x*y+z", Pattern::ProductPlusAddend}, {"z+x*y", Pattern::AddendPlusProduct},
+                               {"x*y-z", Pattern::ProductMinusAddend}, {"z-x*y", Pattern::AddendMinusProduct}}) {
+    auto const result = contractMultiplyAdds(parser.parse(input));
+    auto const multiplyAdd = dynamic_cast<FmaExpression const*>(result.tree.get());
+    ASSERT_THAT(multiplyAdd, NotNull()) << input;
+    EXPECT_EQ(multiplyAdd->pattern(), pattern) << input;
+    EXPECT_EQ(multiplyAdd->rounding(), MultiplyAddRounding::Fused) << input;
+    EXPECT_EQ(result.removedNodes, 1) << input;
+  }
+}
+
+TEST_F(MultiplyAddContractionTest, contractedTreesArePrintedAsTheOriginalOnes) {
+  for (auto const& input: {"a*b+c*d", "sqrt(x*x+1)-2*x", "(a+b)*c+d/e-f"}) {
+    auto const original = parser.parse(input);
+    EXPECT_EQ(printed(*contractMultiplyAdds(parser.parse(input)).tree), printed(*original)) << input;
+  }
+}
+
+TEST_F(MultiplyAddContractionTest, nestedPatternsAreContractedFromTheLeaves) {
+  auto const result = contractMultiplyAdds(parser.parse("(a*b+c)*d+e-f*g"));
+  EXPECT_EQ(result.removedNodes, 3);
+  auto const outer = dynamic_cast<FmaExpression const*>(result.tree.get());
+  ASSERT_THAT(outer, NotNull());
+  EXPECT_EQ(outer->pattern(), FmaExpression::Pattern::AddendMinusProduct);
+  EXPECT_THAT(outer->subexpressions().front(), WhenDynamicCastTo<FmaExpression const*>(NotNull()));
+}
+
+TEST_F(MultiplyAddContractionTest, separatelyRoundedTreesGiveTheSameResultsAsTheOriginalOnesBitForBit) {
+  auto const input = "x*x-y+(x*0.1+y*0.7)*z-z*x";
+  auto const original = parser.parse(input);
+  auto const contracted = contractMultiplyAdds(parser.parse(input), MultiplyAddRounding::Separate).tree;
+  for (auto [x, y, z]: {std::tuple{1.0 + 1e-9, 1.0, 0.3}, {0.1, 0.2, 0.3}, {-7.5, 1e16, 1e-16}, {0.0, -0.0, 0.0}}) {
+    parser.symbols().bind("x", x);
+    parser.symbols().bind("y", y);
+    parser.symbols().bind("z", z);
+    auto const expected = original->evaluate();
+    auto const result = contracted->evaluate();
+    EXPECT_EQ(std::memcmp(&result, &expected, sizeof(result)), 0) << x << ' ' << y << ' ' << z;
+  }
+}
+
+TEST_F(MultiplyAddContractionTest, fusedTreesAreMoreAccurateThanTheOriginalOnes) {
+  // x * x - 1 for x = 1 + 2^-30 loses its smallest term when the product is rounded first
+  auto const x = 1.0 + std::ldexp(1.0, -30);
+  parser.symbols().bind("x", x);
+  auto const exact = std::ldexp(1.0, -29) + std::ldexp(1.0, -60);
+  EXPECT_NE(parser.parse("x*x-1")->evaluate(), exact);
+  EXPECT_EQ(contractMultiplyAdds(parser.parse("x*x-1")).tree->evaluate(), exact);
+  EXPECT_EQ(contractMultiplyAdds(parser.parse("1-x*x")).tree->evaluate(), -exact);
+}
+
+TEST_F(MultiplyAddContractionTest, contractedTreesThrowTheSameDomainErrorsAsTheOriginalOnes) {
+  auto const x = parser.symbols().declare("x");
+  parser.symbols().bind(x, -1.0);
+  for (auto const& input: {"sqrt(x)+log(x)*2", "log(x)*sqrt(x)-1", "1/(x+1)-sqrt(x)*2", "sqrt(x)*2+log(x)"}) {
+    auto const original = parser.parse(input);
+    auto const error = domainErrorOf(*original);
+    EXPECT_FALSE(error.empty()) << input;
+    for (auto rounding: {MultiplyAddRounding::Separate, MultiplyAddRounding::Fused}) {
+      auto const contracted = contractMultiplyAdds(parser.parse(input), rounding).tree;
+      EXPECT_EQ(domainErrorOf(*contracted), error) << input;
+      EXPECT_FALSE(contracted->tryEvaluate()) << input;
+    }
+  }
+}
+
+TEST_F(MultiplyAddContractionTest, sumsWithoutAProductAreLeftUntouched) {
+  auto const result = contractMultiplyAdds(parser.parse("(x+y)/z-x^2"));
+  EXPECT_EQ(result.removedNodes, 0);
+  EXPECT_EQ(printed(*result.tree), "(((x + y) / z) - (x ^ 2))");
+}
+
+TEST_F(MultiplyAddContractionTest, contractingTheMultiplyAddsOfAnEmptyTreeThrows) {
+  EXPECT_THROW(contractMultiplyAdds(nullptr), std::logic_error);
+}
+
+TEST_F(MultiplyAddContractionTest, theParserCanContractTheMultiplyAddsOfTheTreesItBuilds) {
+  EXPECT_FALSE(parser.contractsMultiplyAdds());
+  parser.setMultiplyAddContraction(true, MultiplyAddRounding::Separate);
+  EXPECT_EQ(parser.multiplyAddRounding(), MultiplyAddRounding::Separate);
+  auto const tree = parser.parse("2*x+1");
+  auto const multiplyAdd = dynamic_cast<FmaExpression const*>(tree.get());
+  ASSERT_THAT(multiplyAdd, NotNull());
+  EXPECT_EQ(multiplyAdd->rounding(), MultiplyAddRounding::Separate);
+}
+
+class MemoisationTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+
+  size_t memoisedNodesOf(Expression const& expression) {
+    size_t count = dynamic_cast<MemoisedExpression const*>(&expression) != nullptr;
+    for (size_t i = 0; i < expression.subexpressionCount(); ++i) {
+      count += memoisedNodesOf(expression.subexpression(i));
+    }
+    return count;
+  }
+};
+
+TEST_F(MemoisationTest, theLargestConstantSubtreesAreMemoised) {
+  auto const result = memoiseConstantSubtrees(parser.parse("x*(2+3)-sqrt(4)/x+y"));
+  EXPECT_EQ(result.removedNodes, 0);
+  EXPECT_EQ(memoisedNodesOf(*result.tree), 2);
+  auto const& product = result.tree->subexpression(0).subexpression(0);
+  EXPECT_THAT(&product.subexpression(1), WhenDynamicCastTo<MemoisedExpression const*>(NotNull()));
+}
+
+TEST_F(MemoisationTest, aConstantTreeIsMemoisedAtItsRoot) {
+  auto const result = memoiseConstantSubtrees(parser.parse("2*(3+4)"));
+  EXPECT_THAT(result.tree.get(), WhenDynamicCastTo<MemoisedExpression*>(NotNull()));
+  EXPECT_EQ(memoisedNodesOf(*result.tree), 1);
+}
+
+TEST_F(MemoisationTest, leavesAndSubtreesAlreadyMemoisedAreLeftAsTheyAre) {
+  EXPECT_EQ(memoisedNodesOf(*memoiseConstantSubtrees(parser.parse("x+1")).tree), 0);
+  EXPECT_EQ(memoisedNodesOf(*memoiseConstantSubtrees(parser.parse("2")).tree), 0);
+  auto tree = memoiseConstantSubtrees(parser.parse("x*(2+3)")).tree;
+  EXPECT_EQ(memoisedNodesOf(*memoiseConstantSubtrees(std::move(tree)).tree), 1);
+}
+
+TEST_F(MemoisationTest, memoisedTreesArePrintedAndEvaluatedAsTheOriginalOnes) {
+  auto const input = "log_2(8)*x^2-(1+2)/x+sqrt(2)";
+  auto const original = parser.parse(input);
+  auto const memoised = memoiseConstantSubtrees(parser.parse(input)).tree;
+  EXPECT_EQ(printed(*memoised), printed(*original));
+  for (auto x: {1.5, -2.0, 10.0}) {
+    parser.symbols().bind("x", x);
+    EXPECT_EQ(memoised->evaluate(), original->evaluate()) << x;
+  }
+}
+
+TEST_F(MemoisationTest, theHeightsOfMemoisedTreesCountTheirMemoisations) {
+  auto const tree = memoiseConstantSubtrees(parser.parse("x+sqrt(sqrt(2))")).tree;
+  EXPECT_EQ(tree->subexpression(1).height(), 4);
+  EXPECT_EQ(tree->height(), 5);
+}
+
+TEST_F(MemoisationTest, memoisingTheConstantSubtreesOfAnEmptyTreeThrows) {
+  EXPECT_THROW(memoiseConstantSubtrees(nullptr), std::logic_error);
+}
+
+TEST_F(MemoisationTest, theParserCanMemoiseTheConstantSubtreesOfTheTreesItBuilds) {
+  EXPECT_EQ(parser.memoisation(), Memoisation::None);
+  EXPECT_EQ(memoisedNodesOf(*parser.parse("x*(2+3)")), 0);
+  parser.setMemoisation(Memoisation::ConstantSubtrees);
+  EXPECT_EQ(parser.memoisation(), Memoisation::ConstantSubtrees);
+  EXPECT_EQ(memoisedNodesOf(*parser.parse("x*(2+3)")), 1);
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "ExpressionMock.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Optimisations.hpp"
+#include "PackedTree.hpp"
+#include "Parser.hpp"
+#include <stdexcept>
+#include <string>
+
+using ::testing::ElementsAre;
+using MathTree::ArithmeticParser;
+using MathTree::flattenAssociativeChains;
+using MathTree::memoiseConstantSubtrees;
+using MathTree::PackedTree;
+using MathTree::SummationMode;
+using Operation = MathTree::PackedTree::Operation;
+
+class PackedTreeTest: public ::testing::Test {
+protected:
+  ArithmeticParser parser;
+};
+
+TEST_F(PackedTreeTest, nodesAreStoredInDepthFirstOrder) {
+  auto const tree = PackedTree::build(*parser.parse("(x+2)*sqrt(3)-log_2(x)"));
+  EXPECT_THAT(tree.operations(), ElementsAre(Operation::Subtract, Operation::Multiply, Operation::Add,
+                                             Operation::Variable, Operation::Constant, Operation::SquareRoot,
+                                             Operation::Constant, Operation::Logarithm, Operation::Variable));
+  EXPECT_THAT(tree.subtreeEnds(), ElementsAre(9, 7, 5, 4, 5, 7, 7, 9, 9));
+  EXPECT_THAT(tree.literals(), ElementsAre(2.0, 3.0));
+  EXPECT_THAT(tree.bases(), ElementsAre(2.0));
+}
+
+TEST_F(PackedTreeTest, nodeViewsGiveTheOperandsOfEveryNode) {
+  auto const tree = PackedTree::build(*parser.parse("(x+2)*sqrt(3)-log_2(y)"));
+  auto const root = tree.root();
+  EXPECT_EQ(root.size(), tree.size());
+  auto const operands = root.subexpressions();
+  ASSERT_EQ(operands.size(), 2);
+  EXPECT_EQ(operands[0].operation(), Operation::Multiply);
+  EXPECT_EQ(operands[1].operation(), Operation::Logarithm);
+  EXPECT_EQ(operands[1].value(), 2.0);
+  auto const sum = operands[0].subexpressions().front();
+  ASSERT_EQ(sum.subexpressions().size(), 2);
+  EXPECT_EQ(sum.subexpressions()[0].variableIndex(), *parser.symbols().indexOf("x"));
+  EXPECT_EQ(sum.subexpressions()[1].value(), 2.0);
+  EXPECT_EQ(operands[1].subexpressions().front().variableIndex(), *parser.symbols().indexOf("y"));
+  EXPECT_TRUE(tree.node(tree.size() - 1).subexpressions().empty());
+  EXPECT_THROW(tree.node(tree.size()), std::out_of_range);
+}
+
+TEST_F(PackedTreeTest, packedTreesReadTheCurrentValueOfVariables) {
+  auto const tree = PackedTree::build(*parser.parse("(x+y)^2-(x+y)/y"));
+  parser.symbols().bind("x", 3.0);
+  parser.symbols().bind("y", 1.0);
+  EXPECT_DOUBLE_EQ(tree.evaluate(), 12.0);
+  parser.symbols().bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(tree.evaluate(), 22.5);
+}
+
+TEST_F(PackedTreeTest, unboundVariablesAreReportedInTheOrderOfTheTree) {
+  auto const expression = parser.parse("sqrt(-1)+x");
+  auto const tree = PackedTree::build(*expression);
+  EXPECT_THROW(tree.evaluate(), std::domain_error);
+  auto const unbound = PackedTree::build(*parser.parse("x+sqrt(-1)"));
+  EXPECT_THROW(unbound.evaluate(), std::logic_error);
+  EXPECT_THROW(parser.parse("x+sqrt(-1)")->evaluate(), std::logic_error);
+}
+
+TEST_F(PackedTreeTest, flattenedChainsArePackedAsBinaryNodesComputedInTheSameOrder) {
+  auto const expression = flattenAssociativeChains(parser.parse("-x+0.1*x*0.3-sqrt(x+0.2+0.7)+0.5-x")).tree;
+  auto const tree = PackedTree::build(*expression);
+  EXPECT_EQ(tree.root().operation(), Operation::Subtract);
+  for (auto value: {-0.4, 0.0, 2.7}) {
+    parser.symbols().bind("x", value);
+    EXPECT_EQ(tree.evaluate(), expression->evaluate()) << value;
+  }
+}
+
+TEST_F(PackedTreeTest, aSubtractedFirstTermIsPackedAsANegation) {
+  MathTree::SumExpression::TermList terms;
+  terms.push_back({parser.parse("x"), true});
+  terms.push_back({parser.parse("2"), false});
+  auto const tree = PackedTree::build(MathTree::SumExpression(std::move(terms)));
+  EXPECT_THAT(tree.operations(), ElementsAre(Operation::Add, Operation::Negate, Operation::Variable,
+                                             Operation::Constant));
+  parser.symbols().bind("x", 5.0);
+  EXPECT_DOUBLE_EQ(tree.evaluate(), -3.0);
+}
+
+TEST_F(PackedTreeTest, largeTreesAreEvaluatedWithoutRecursion) {
+  std::string input = "1";
+  for (int i = 0; i < 100000; ++i) {
+    input += "+x";
+  }
+  auto const sum = flattenAssociativeChains(parser.parse(input)).tree;
+  auto const tree = PackedTree::build(*sum);
+  parser.symbols().bind("x", 0.5);
+  EXPECT_EQ(tree.size(), 200001);
+  EXPECT_EQ(tree.evaluate(), sum->evaluate());
+  EXPECT_LT(tree.memoryFootprint(), tree.size() * 10 + 256);
+}
+
+TEST_F(PackedTreeTest, deepTreesArePackedWithoutRecursion) {
+  std::string chain = "1";
+  for (int i = 0; i < 100000; ++i) {
+    chain += "+x";
+  }
+  auto const sum = PackedTree::build(*parser.parse(chain));
+  EXPECT_EQ(sum.size(), 200001);
+  EXPECT_EQ(sum.root().subexpressions().size(), 2);
+
+  size_t const depth = 1000000;
+  parser.setParsingEngine(ArithmeticParser::ParsingEngine::Iterative);
+  auto const negation = PackedTree::build(*parser.parse(std::string(depth, '-') + "x"));
+  EXPECT_EQ(negation.size(), depth + 1);
+  EXPECT_EQ(negation.subtreeEnds().front(), depth + 1);
+
+  parser.symbols().bind("x", 0.5);
+  EXPECT_EQ(sum.evaluate(), 50001.0);
+  EXPECT_EQ(negation.evaluate(), 0.5);
+}
+
+TEST_F(PackedTreeTest, buildingAPackedTreeFromAnExpressionOfUnknownTypeThrows) {
+  NiceExpressionMock unknown;
+  EXPECT_THROW(PackedTree::build(unknown), std::logic_error);
+}
+
+TEST_F(PackedTreeTest, buildingAPackedTreeFromVariablesOfDifferentSymbolTablesThrows) {
+  ArithmeticParser otherParser;
+  MathTree::AdditionExpression sum(parser.parse("x"), MathTree::TokenType::Plus, otherParser.parse("x"));
+  EXPECT_THROW(PackedTree::build(sum), std::logic_error);
+}
+
+TEST_F(PackedTreeTest, optimisedTreesArePackedWithTheOperationsOfTheirNodes) {
+  auto const expectPackedAs = [this](std::string const& input, Operation operation) {
+    auto const expression = parser.parse(input);
+    auto const tree = PackedTree::build(*expression);
+    EXPECT_EQ(tree.root().operation(), operation) << input;
+    for (auto value: {-2.5, 0.3, 1.0, 7.0}) {
+      parser.symbols().bind("x", value);
+      EXPECT_EQ(tree.evaluate(), expression->evaluate()) << input << " at " << value;
+    }
+  };
+  parser.setStrengthReduction(true);
+  expectPackedAs("(x+1)^3", Operation::ConstantPower);
+  expectPackedAs("(x*x)^0.5", Operation::ConstantPower);
+  parser.setConstantFolding(true);
+  expectPackedAs("(x-1.5)^-3", Operation::ConstantPower);
+  parser.setConstantFolding(false);
+  expectPackedAs("log_2(x*x+1)", Operation::SpecialisedLogarithm);
+  expectPackedAs("log_7(x*x+1)", Operation::SpecialisedLogarithm);
+  parser.setStrengthReduction(false);
+
+  parser.setPolynomialRecognition(true);
+  expectPackedAs("3*x^2-x+0.5", Operation::Polynomial);
+  expectPackedAs("x^9/7+x^6*3-x^3+0.1", Operation::Polynomial);
+  parser.setPolynomialRecognition(false);
+
+  parser.setMultiplyAddContraction(true, MathTree::MultiplyAddRounding::Fused);
+  expectPackedAs("0.1*x+0.7", Operation::FusedMultiplyAdd);
+  expectPackedAs("0.7-x*0.1", Operation::FusedMultiplyAdd);
+  parser.setMultiplyAddContraction(true, MathTree::MultiplyAddRounding::Separate);
+  expectPackedAs("0.7+x*0.1", Operation::MultiplyAdd);
+  expectPackedAs("x*0.1-0.7", Operation::MultiplyAdd);
+}
+
+TEST_F(PackedTreeTest, sumsWhoseTermsAreNotAddedSequentiallyArePackedAsSingleNodes) {
+  for (auto mode: {SummationMode::Pairwise, SummationMode::Kahan}) {
+    auto const expression = flattenAssociativeChains(parser.parse("-x+10000000000000000+x*0.1-10000000000000000+0.3+x-1"), mode).tree;
+    auto const tree = PackedTree::build(*expression);
+    EXPECT_EQ(tree.root().operation(), Operation::Sum);
+    EXPECT_EQ(tree.root().subexpressions().size(), 7);
+    for (auto value: {-2.5, 0.3, 7.0}) {
+      parser.symbols().bind("x", value);
+      EXPECT_EQ(tree.evaluate(), expression->evaluate());
+    }
+  }
+  auto const sum = flattenAssociativeChains(parser.parse("1+log(0)-sqrt(-1)"), SummationMode::Kahan).tree;
+  EXPECT_THROW(PackedTree::build(*sum).evaluate(), std::domain_error);
+}
+
+TEST_F(PackedTreeTest, memoisedSubtreesArePackedAsTheyAre) {
+  auto const expression = memoiseConstantSubtrees(parser.parse("x*(2+3)-sqrt(4)")).tree;
+  auto const tree = PackedTree::build(*expression);
+  EXPECT_EQ(tree.size(), 8);
+  parser.symbols().bind("x", 1.5);
+  EXPECT_EQ(tree.evaluate(), expression->evaluate());
+}
\ No newline at end of file
@@ -2,7 +2,10 @@
 #include "gmock/gmock.h"
 #include "ExpressionMock.hpp"
 #include "Lexer.hpp"
+#include <memory_resource>
 #include "Parser.hpp"
+#include <sstream>
+#include <stdexcept>
 
 using ::testing::NiceMock;
 using ::testing::Return;
@@ -16,7 +19,9 @@ using ::testing::Pointee;
 using ::testing::InSequence;
 using MathTree::Expression;
 using MathTree::Token;
+using MathTree::PrattGrammar;
 using MathTree::PrattParser;
+using MathTree::StaticPrattParser;
 using MathTree::AbstractPrattParser;
 using MathTree::TokenType;
 
@@ -24,36 +29,36 @@ class LexerMock: public MathTree::Lexer {
 public:
   MOCK_METHOD(Token, next, (), ());
   MOCK_METHOD(void, reset, (), ());
-  MOCK_METHOD(void, reset, (std::string), ());
+  MOCK_METHOD(void, reset, (std::string_view), ());
 };
 using NiceLexerMock = NiceMock<LexerMock>;
 
 class PrefixParseletMock: public MathTree::PrefixParselet {
 public:
-  MOCK_METHOD(std::unique_ptr<Expression>, parse, (AbstractPrattParser&, Token const&), ());
+  MOCK_METHOD(std::unique_ptr<Expression>, parse, (AbstractPrattParser&, Token const&), (const));
 };
 using NicePrefixParseletMock = NiceMock<PrefixParseletMock>;
 
 class InfixParseletMock: public MathTree::InfixParselet {
 public:
   MOCK_METHOD(std::unique_ptr<Expression>, 
-                  parse, (AbstractPrattParser&, std::unique_ptr<Expression> left, Token const&), ());
+                  parse, (AbstractPrattParser&, std::unique_ptr<Expression> left, Token const&), (const));
   MOCK_METHOD(int, priority, (), (const));
 };
 using NiceInfixParseletMock = NiceMock<InfixParseletMock>;
 
 class PrattParserTest: public ::testing::Test {
 private:
-  std::unique_ptr<NiceLexerMock> lexerMockPtr = std::make_unique<NiceLexerMock>();
   std::unique_ptr<NicePrefixParseletMock> prefixMockPtr = std::make_unique<NicePrefixParseletMock>();
   std::unique_ptr<NiceInfixParseletMock> infixMockPtr = std::make_unique<NiceInfixParseletMock>();
 
 protected:
-  NiceLexerMock& lexerMock{*lexerMockPtr};
+  NiceLexerMock lexerMock;
   NicePrefixParseletMock& prefixMock{*prefixMockPtr};
   NiceInfixParseletMock& infixMock{*infixMockPtr};
 
-  PrattParser parser{std::move(lexerMockPtr)};
+  PrattGrammar grammar;
+  PrattParser parser{grammar, lexerMock};
   Token tokenNum{TokenType::Number, "1"};
   Token tokenPlus{TokenType::Plus, "+"};
 
@@ -61,8 +66,8 @@ protected:
     ON_CALL(lexerMock, next()).WillByDefault(
                                      Return(Token(TokenType::Stop, "")));
     ON_CALL(infixMock, priority()).WillByDefault(Return(1));
-    parser.setPrefixParselet(TokenType::Number, std::move(prefixMockPtr));
-    parser.setInfixParselet(TokenType::Plus, std::move(infixMockPtr));
+    grammar.setPrefixParselet(TokenType::Number, std::move(prefixMockPtr));
+    grammar.setInfixParselet(TokenType::Plus, std::move(infixMockPtr));
   }
 };
 
@@ -100,3 +105,91 @@ TEST_F(PrattParserTest, theLexerIsResetAfterParsingIsCompleted) {
   EXPECT_CALL(lexerMock, reset());
   parser.parse();
 }
+
+
+TEST_F(PrattParserTest, throwsIfTheGrammarHasNoPrefixParseletForTheCurrentToken) {
+  EXPECT_CALL(lexerMock, next).WillOnce(Return(tokenPlus))
+                              .WillRepeatedly(DoDefault());
+  EXPECT_THROW(parser.parse(), std::logic_error);
+}
+
+TEST_F(PrattParserTest, grammarHasNoParseletsForTokenTypesThatWereNeverAssociated) {
+  EXPECT_EQ(grammar.prefixParseletFor(TokenType::Minus), nullptr);
+  EXPECT_EQ(grammar.infixParseletFor(TokenType::Minus), nullptr);
+  EXPECT_EQ(grammar.prefixParseletFor(TokenType::Number), &prefixMock);
+  EXPECT_EQ(grammar.infixParseletFor(TokenType::Plus), &infixMock);
+}
+
+TEST_F(PrattParserTest, providesTheSymbolTableAndMemoryResourceGivenOnConstruction) {
+  auto symbols = std::make_shared<MathTree::SymbolTable>();
+  std::pmr::monotonic_buffer_resource resource;
+  PrattParser parserWithSymbols{grammar, lexerMock, symbols, resource};
+  EXPECT_EQ(parserWithSymbols.symbols(), symbols);
+  EXPECT_EQ(&parserWithSymbols.memoryResource(), &resource);
+}
+
+// a grammar of numbers and left associative additions, fixed at compile time
+struct AdditionGrammar {
+  static int infixPriority(TokenType type) {
+    return type == TokenType::Plus ? 1 : PrattParser::minAllowedPriority;
+  }
+
+  template<typename Parser>
+  static std::unique_ptr<Expression> parsePrefix(Parser&, Token const& token) {
+    if (token.type() != TokenType::Number) {
+      throw std::logic_error("Expected a number.");
+    }
+    return std::make_unique<MathTree::RealNumberExpression>(token.value());
+  }
+
+  template<typename Parser>
+  static std::unique_ptr<Expression> parseInfix(Parser& parser, std::unique_ptr<Expression> left, Token const& token) {
+    return std::make_unique<MathTree::AdditionExpression>(std::move(left), token.type(), parser.parse(1));
+  }
+};
+
+class StaticPrattParserTest: public ::testing::Test {
+protected:
+  NiceLexerMock lexerMock;
+  StaticPrattParser<AdditionGrammar> parser{lexerMock};
+
+  void SetUp() override {
+    ON_CALL(lexerMock, next()).WillByDefault(Return(Token(TokenType::Stop, "")));
+  }
+};
+
+TEST_F(StaticPrattParserTest, buildsTheTreeWithTheFunctionsOfTheGrammar) {
+  EXPECT_CALL(lexerMock, next()).WillOnce(Return(Token{TokenType::Number, "1", 1.0}))
+                                .WillOnce(Return(Token{TokenType::Plus, "+"}))
+                                .WillOnce(Return(Token{TokenType::Number, "2", 2.0}))
+                                .WillOnce(Return(Token{TokenType::Plus, "+"}))
+                                .WillOnce(Return(Token{TokenType::Number, "3", 3.0}))
+                                .WillRepeatedly(DoDefault());
+  auto tree = parser.parse();
+  ASSERT_NE(tree, nullptr);
+  std::ostringstream printed;
+  tree->print(printed);
+  EXPECT_EQ(printed.str(), "((1 + 2) + 3)");
+}
+
+TEST_F(StaticPrattParserTest, theLexerIsResetAfterParsingIsCompleted) {
+  EXPECT_CALL(lexerMock, next).WillOnce(Return(Token{TokenType::Number, "1", 1.0}))
+                              .WillRepeatedly(DoDefault());
+  EXPECT_CALL(lexerMock, reset());
+  parser.parse();
+}
+
+TEST_F(StaticPrattParserTest, throwsWhatTheGrammarThrowsForATokenStartingNoExpression) {
+  EXPECT_CALL(lexerMock, next).WillOnce(Return(Token{TokenType::Plus, "+"}))
+                              .WillRepeatedly(DoDefault());
+  EXPECT_CALL(lexerMock, reset());
+  EXPECT_THROW(parser.parse(), std::logic_error);
+}
+
+TEST_F(StaticPrattParserTest, providesTheSymbolTableAndMemoryResourceGivenOnConstruction) {
+  auto symbols = std::make_shared<MathTree::SymbolTable>();
+  std::pmr::monotonic_buffer_resource resource;
+  StaticPrattParser<AdditionGrammar> parserWithSymbols{lexerMock, symbols, resource};
+  EXPECT_EQ(parserWithSymbols.symbols(), symbols);
+  EXPECT_EQ(&parserWithSymbols.memoryResource(), &resource);
+}
\ No newline at end of file
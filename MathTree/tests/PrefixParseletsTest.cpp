@@ -14,7 +14,10 @@ using ::testing::WhenDynamicCastTo;
 using MathTree::GroupParselet;
 using MathTree::LogarithmParselet;
 using MathTree::NegativeSignParselet;
+using MathTree::NumberParselet;
 using MathTree::SquareRootParselet;
+using MathTree::SymbolTable;
+using MathTree::VariableParselet;
 using MathTree::Token;
 using MathTree::TokenType;
 
@@ -93,4 +96,37 @@ TEST_F(PrefixParseletsTest, logarithmSignParseletReturnsAnObjectOfTheCorrespondi
   auto parseResult = parselet.parse(parserMock, Token{TokenType::Log, "log"});
   ASSERT_THAT(parseResult, NotNull());
   EXPECT_THAT(parseResult.get(), WhenDynamicCastTo<MathTree::LogarithmExpression*>(NotNull()));
+}
+
+TEST_F(PrefixParseletsTest, variableParseletDeclaresTheVariableInTheSymbolTableOfTheParser) {
+  auto symbols = std::make_shared<SymbolTable>();
+  ON_CALL(parserMock, symbols()).WillByDefault(Return(symbols));
+  VariableParselet parselet;
+  auto parseResult = parselet.parse(parserMock, Token{TokenType::Variable, "x"});
+  ASSERT_THAT(parseResult, NotNull());
+  EXPECT_THAT(parseResult.get(), WhenDynamicCastTo<MathTree::VariableExpression*>(NotNull()));
+  EXPECT_TRUE(symbols->indexOf("x").has_value());
+}
+
+TEST_F(PrefixParseletsTest, variableParseletThrowsIfTheParserHasNoSymbolTable) {
+  VariableParselet parselet;
+  EXPECT_THROW(parselet.parse(parserMock, Token{TokenType::Variable, "x"}), std::logic_error);
+}
+
+TEST_F(PrefixParseletsTest, numberParseletBuildsANumberFromTheValueCarriedByTheToken) {
+  NumberParselet parselet;
+  // the text is not read again, so it can differ from the value
+  auto parseResult = parselet.parse(parserMock, Token{TokenType::Number, "1", 2.5});
+  ASSERT_THAT(parseResult, NotNull());
+  EXPECT_EQ(parseResult->evaluate(), 2.5);
+}
+
+TEST_F(PrefixParseletsTest, logarithmParseletUsesTheBaseCarriedByTheToken) {
+  LogarithmParselet parselet(1);
+  ON_CALL(parserMock, parse(1)).WillByDefault(
+                                        Return(ByMove(std::make_unique<NiceExpressionMock>())));
+  auto parseResult = parselet.parse(parserMock, Token{TokenType::Log, "log_2", 3.0});
+  auto logarithm = dynamic_cast<MathTree::LogarithmExpression*>(parseResult.get());
+  ASSERT_THAT(logarithm, NotNull());
+  EXPECT_EQ(logarithm->base(), 3.0);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Expression.hpp"
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
+#include <limits>
+#include <stdexcept>
 
 using ::testing::IsEmpty;
 using MathTree::RealNumberExpression;
@@ -50,4 +52,15 @@ TEST(NumbersTest, creatingARealNumberUsingHexadecimalThrows) {
 TEST(NumbersTest, aRealNumberHasNoSubexpressions) {
   RealNumberExpression numberTen("10");
   EXPECT_THAT(numberTen.subexpressions(), IsEmpty());
+  EXPECT_EQ(numberTen.subexpressionCount(), 0);
+  EXPECT_THROW(numberTen.subexpression(0), std::out_of_range);
+}
+
+TEST(NumbersTest, aRealNumberCanBeCreatedFromADouble) {
+  RealNumberExpression number{42.2};
+  EXPECT_DOUBLE_EQ(number.evaluate(), 42.2);
+}
+
+TEST(NumbersTest, creatingARealNumberFromAnInfiniteDoubleThrows) {
+  EXPECT_ANY_THROW(RealNumberExpression{std::numeric_limits<double>::infinity()});
 }
\ No newline at end of file
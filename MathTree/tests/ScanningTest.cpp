@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "Scanning.hpp"
+#include <stdexcept>
+#include <string>
+
+using MathTree::Utils::InstructionSet;
+namespace Scanning = MathTree::Scanning;
+
+class ScanningTest: public ::testing::TestWithParam<InstructionSet> {
+protected:
+  void SetUp() override {
+    if (!MathTree::Utils::isSupported(GetParam())) {
+      GTEST_SKIP() << "Instruction set not supported on this machine.";
+    }
+  }
+};
+
+TEST_P(ScanningTest, skippingSpacesStopsAtTheFirstOtherCharacter) {
+  // runs of every length up to a few chunks exercise both the vector loops and the scalar tails
+  for (size_t length = 0; length < 100; ++length) {
+    std::string input = "1" + std::string(length, ' ') + "+2";
+    for (size_t i = 1; i <= length; ++i) {
+      input[i] = " \t\n\v\f\r"[i % 6];
+    }
+    EXPECT_EQ(Scanning::skipSpaces(input, 1, GetParam()), length + 1) << length;
+  }
+}
+
+TEST_P(ScanningTest, skippingSpacesReachesTheEndOfAnInputMadeOfSpaces) {
+  std::string const input(70, ' ');
+  EXPECT_EQ(Scanning::skipSpaces(input, 3, GetParam()), input.size());
+  EXPECT_EQ(Scanning::skipSpaces(input, input.size(), GetParam()), input.size());
+}
+
+TEST_P(ScanningTest, skippingSpacesDoesNotSkipOtherControlOrNonAsciiCharacters) {
+  for (auto c: {'\b', '\x0e', '\x1f', '\x7f', '\x80', '\x89', '\xa0', '\xff', '0', 'a'}) {
+    auto const input = std::string(40, ' ') + c + std::string(40, ' ');
+    EXPECT_EQ(Scanning::skipSpaces(input, 0, GetParam()), 40) << static_cast<int>(c);
+  }
+}
+
+TEST_P(ScanningTest, skippingNumberCharactersStopsAtTheFirstOtherCharacter) {
+  for (size_t length = 0; length < 100; ++length) {
+    std::string input = "+";
+    for (size_t i = 0; i < length; ++i) {
+      input += i % 13 == 5 ? '.' : static_cast<char>('0' + i % 10);
+    }
+    input += "*3";
+    EXPECT_EQ(Scanning::skipNumberCharacters(input, 1, GetParam()), length + 1) << length;
+  }
+}
+
+TEST_P(ScanningTest, skippingNumberCharactersDoesNotSkipCharactersNextToDigits) {
+  for (auto c: {'/', ':', '-', ',', 'e', '\xb0', '\xb9'}) {
+    auto const input = std::string(40, '7') + c + std::string(40, '7');
+    EXPECT_EQ(Scanning::skipNumberCharacters(input, 0, GetParam()), 40) << static_cast<int>(c);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllInstructionSets, ScanningTest,
+                         ::testing::Values(InstructionSet::Scalar, InstructionSet::Sse2, InstructionSet::Avx2));
+
+TEST(ScanningValidationTest, scanningWithAnUnsupportedInstructionSetThrows) {
+  for (auto instructionSet: {InstructionSet::Sse2, InstructionSet::Avx2}) {
+    if (!MathTree::Utils::isSupported(instructionSet)) {
+      EXPECT_THROW(Scanning::skipSpaces(" ", 0, instructionSet), std::logic_error);
+    }
+  }
+}
+
+TEST(ScanningValidationTest, classesOfCharactersDoNotDependOnTheLocale) {
+  EXPECT_TRUE(Scanning::isSpace('\v'));
+  EXPECT_FALSE(Scanning::isSpace('\xa0'));
+  EXPECT_FALSE(Scanning::isDigit('\xb2'));
+  EXPECT_FALSE(Scanning::isLetter('\xe9'));
+  EXPECT_TRUE(Scanning::isLetter('Z'));
+}
\ No newline at end of file
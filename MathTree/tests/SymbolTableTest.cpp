@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include "SymbolTable.hpp"
+
+using MathTree::SymbolTable;
+
+TEST(SymbolTableTest, declaringTheSameNameTwiceReturnsTheSameIndex) {
+  SymbolTable symbols;
+  auto index = symbols.declare("x");
+  EXPECT_EQ(symbols.declare("x"), index);
+  EXPECT_EQ(symbols.size(), 1);
+}
+
+TEST(SymbolTableTest, variablesAreIndexedInOrderOfDeclaration) {
+  SymbolTable symbols;
+  EXPECT_EQ(symbols.declare("x"), 0);
+  EXPECT_EQ(symbols.declare("rate"), 1);
+  EXPECT_EQ(symbols.name(1), "rate");
+  EXPECT_EQ(symbols.indexOf("rate"), 1);
+}
+
+TEST(SymbolTableTest, lookingUpAnUndeclaredNameReturnsAnEmptyOptional) {
+  SymbolTable symbols;
+  EXPECT_EQ(symbols.indexOf("x"), std::nullopt);
+}
+
+TEST(SymbolTableTest, declaredVariablesAreUnboundUntilBound) {
+  SymbolTable symbols;
+  auto index = symbols.declare("x");
+  EXPECT_FALSE(symbols.isBound(index));
+  EXPECT_ANY_THROW(symbols.value(index));
+
+  symbols.bind(index, 4.5);
+  EXPECT_TRUE(symbols.isBound(index));
+  EXPECT_DOUBLE_EQ(symbols.value(index), 4.5);
+}
+
+TEST(SymbolTableTest, bindingByNameDeclaresTheVariableIfNeeded) {
+  SymbolTable symbols;
+  auto index = symbols.bind("x", 2.0);
+  EXPECT_EQ(symbols.indexOf("x"), index);
+  EXPECT_DOUBLE_EQ(symbols.value(index), 2.0);
+}
+
+TEST(SymbolTableTest, rebindingAVariableReplacesItsValue) {
+  SymbolTable symbols;
+  auto index = symbols.bind("x", 2.0);
+  symbols.bind("x", 3.0);
+  EXPECT_DOUBLE_EQ(symbols.value(index), 3.0);
+}
+
+TEST(SymbolTableTest, bindingAnUndeclaredIndexThrows) {
+  SymbolTable symbols;
+  EXPECT_ANY_THROW(symbols.bind(0, 1.0));
+}
+
+TEST(SymbolTableTest, readingAValueWithAFallbackReturnsTheFallbackForUnboundVariables) {
+  SymbolTable symbols;
+  auto const unbound = symbols.declare("x");
+  auto const bound = symbols.bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(symbols.valueOr(unbound, -1.0), -1.0);
+  EXPECT_DOUBLE_EQ(symbols.valueOr(bound, -1.0), 2.0);
+  EXPECT_DOUBLE_EQ(symbols.valueOr(bound + 1, -1.0), -1.0);
+}
+
+TEST(SymbolTableTest, readingABoundValueWithoutCheckingReturnsTheValueLastBound) {
+  SymbolTable symbols;
+  symbols.declare("x");
+  auto const index = symbols.bind("y", 2.0);
+  EXPECT_DOUBLE_EQ(symbols.boundValue(index), 2.0);
+  symbols.bind(index, -1.0);
+  EXPECT_DOUBLE_EQ(symbols.boundValue(index), -1.0);
+}
\ No newline at end of file
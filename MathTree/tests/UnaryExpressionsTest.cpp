@@ -1,19 +1,48 @@
+#include <cmath>
 #include "Expression.hpp"
 #include "ExpressionMock.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include <limits>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 using ::testing::ElementsAreArray;
 using ::testing::Return;
 
+using MathTree::ConstantPowerExpression;
 using MathTree::LogarithmExpression;
+using MathTree::MemoisedExpression;
 using MathTree::NegativeSignExpression;
+using MathTree::PolynomialExpression;
 using MathTree::RealNumberExpression;
+using MathTree::SpecialisedLogarithmExpression;
 using MathTree::SquareRootExpression;
 using MathTree::TokenType;
 
+/// An expression defined outside the library, overriding only the members it is required to.
+class AbsoluteValueExpression: public MathTree::Expression {
+public:
+  explicit AbsoluteValueExpression(std::unique_ptr<Expression> operand): m_operand(std::move(operand)) {}
+
+  double evaluate() const override {
+    return std::abs(m_operand->evaluate());
+  }
+
+  void print(std::ostream& stream) const override {
+    stream << "|" << *m_operand << "|";
+  }
+
+  std::vector<Expression const*> subexpressions() const override {
+    return {m_operand.get()};
+  }
+
+private:
+  std::unique_ptr<Expression> m_operand;
+};
+
 class UnaryExpressionsTest: public ::testing::Test {
 protected:
   std::unique_ptr<NiceExpressionMock> exprMock = std::make_unique<NiceExpressionMock>();
@@ -31,6 +60,25 @@ TEST_F(UnaryExpressionsTest, aSquareRootReturnsTheRadicandAsItsOnlySubexpression
   EXPECT_THAT(sqrt.subexpressions(), ElementsAreArray({exprMockPtr}));
 }
 
+TEST_F(UnaryExpressionsTest, unaryExpressionsGiveAccessToTheirOnlySubexpressionByPosition) {
+  auto const argument = [] {
+    return std::make_unique<RealNumberExpression>(4.0);
+  };
+  std::vector<std::unique_ptr<MathTree::Expression>> expressions;
+  expressions.push_back(std::make_unique<NegativeSignExpression>(TokenType::Minus, argument()));
+  expressions.push_back(std::make_unique<SquareRootExpression>(argument(), TokenType::SquareRoot));
+  expressions.push_back(std::make_unique<LogarithmExpression>(argument(), 10.0, TokenType::Log));
+  expressions.push_back(std::make_unique<ConstantPowerExpression>(argument(), 2.0));
+  expressions.push_back(std::make_unique<SpecialisedLogarithmExpression>(argument(), 2.0, TokenType::Log));
+  expressions.push_back(std::make_unique<PolynomialExpression>(argument(), PolynomialExpression::Coefficients{1.0, 2.0}));
+  expressions.push_back(std::make_unique<MemoisedExpression>(argument()));
+  for (auto const& expression: expressions) {
+    EXPECT_EQ(expression->subexpressionCount(), 1) << *expression;
+    EXPECT_EQ(&expression->subexpression(0), expression->subexpressions().front()) << *expression;
+    EXPECT_THROW(expression->subexpression(1), std::out_of_range) << *expression;
+  }
+}
+
 TEST_F(UnaryExpressionsTest, evaluatingASquareRootReturnsTheSquareRootOfItsRadicand) {
   EXPECT_CALL(*exprMock, evaluate).WillOnce(Return(16));
   SquareRootExpression sqrt(std::move(exprMock), TokenType::SquareRoot);
@@ -107,4 +155,198 @@ TEST_F(UnaryExpressionsTest, aLogarithmReturnsItsArgumentAsItsOnlySubexpression)
   auto exprMockPtr = exprMock.get();
   LogarithmExpression logarithm(std::move(exprMock), 10.0, TokenType::Log);
   EXPECT_THAT(logarithm.subexpressions(), ElementsAreArray({exprMockPtr}));
+}
+
+TEST_F(UnaryExpressionsTest, transformingTheSubexpressionOfASquareRootReplacesIt) {
+  SquareRootExpression sqrt(std::move(exprMock), TokenType::SquareRoot);
+  auto replacement = std::make_unique<RealNumberExpression>(16.0);
+  auto replacementPtr = replacement.get();
+  sqrt.transformSubexpressions([&replacement](std::unique_ptr<MathTree::Expression>) {
+    return std::move(replacement);
+  });
+  EXPECT_THAT(sqrt.subexpressions(), ElementsAreArray({replacementPtr}));
+  EXPECT_TRUE(sqrt.isConstant());
+  EXPECT_DOUBLE_EQ(sqrt.evaluate(), 4.0);
+}
+
+TEST_F(UnaryExpressionsTest, theHeightOfAUnaryExpressionIsOneMoreThanTheHeightOfItsSubexpression) {
+  auto sqrt = std::make_unique<SquareRootExpression>(std::move(exprMock), TokenType::SquareRoot);
+  auto logarithm = std::make_unique<LogarithmExpression>(std::move(sqrt), 10.0, TokenType::Log);
+  NegativeSignExpression negation(TokenType::Minus, std::move(logarithm));
+  EXPECT_EQ(negation.height(), 4);
+}
+
+TEST_F(UnaryExpressionsTest, tryingToEvaluateASquareRootOfANegativeNumberReturnsTheErrorAndTheSquareRoot) {
+  EXPECT_CALL(*exprMock, evaluate).WillOnce(Return(-4));
+  SquareRootExpression sqrt(std::move(exprMock), TokenType::SquareRoot);
+  auto const result = sqrt.tryEvaluate();
+  ASSERT_FALSE(result.hasValue());
+  EXPECT_EQ(result.error(), MathTree::EvaluationError::InvalidSquareRoot);
+  EXPECT_EQ(result.failedExpression(), &sqrt);
+  EXPECT_THROW(result.value(), std::domain_error);
+}
+
+TEST_F(UnaryExpressionsTest, tryingToEvaluateAnExpressionReturnsTheErrorOfItsSubexpression) {
+  auto log = std::make_unique<LogarithmExpression>(std::make_unique<RealNumberExpression>(0.0), 10, TokenType::Log);
+  auto const logPtr = log.get();
+  NegativeSignExpression negation(TokenType::Minus, std::move(log));
+  auto const result = negation.tryEvaluate();
+  ASSERT_FALSE(result.hasValue());
+  EXPECT_EQ(result.error(), MathTree::EvaluationError::InvalidLogarithm);
+  EXPECT_EQ(result.failedExpression(), logPtr);
+}
+
+TEST_F(UnaryExpressionsTest, tryingToEvaluateAValidExpressionReturnsItsValue) {
+  NegativeSignExpression negation(TokenType::Minus, std::make_unique<RealNumberExpression>(2.5));
+  auto const result = negation.tryEvaluate();
+  ASSERT_TRUE(result.hasValue());
+  EXPECT_EQ(result.failedExpression(), nullptr);
+  EXPECT_DOUBLE_EQ(result.value(), -2.5);
+}
+
+TEST_F(UnaryExpressionsTest, invalidSquareRootsAndLogarithmsGiveNanOrInfinityWhenErrorsArePropagated) {
+  SquareRootExpression sqrt(std::make_unique<RealNumberExpression>(-1.0), TokenType::SquareRoot);
+  EXPECT_TRUE(std::isnan(sqrt.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+  LogarithmExpression log(std::make_unique<RealNumberExpression>(0.0), 10, TokenType::Log);
+  EXPECT_EQ(log.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), -HUGE_VAL);
+}
+
+TEST_F(UnaryExpressionsTest, propagatedErrorsAreNotCachedForLaterCheckedEvaluations) {
+  NegativeSignExpression negation(TokenType::Minus, std::make_unique<SquareRootExpression>(
+                                                      std::make_unique<RealNumberExpression>(-4.0), TokenType::SquareRoot));
+  ASSERT_TRUE(negation.isConstant());
+  EXPECT_TRUE(std::isnan(negation.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+  EXPECT_THROW(negation.evaluate(), std::domain_error);
+}
+
+TEST_F(UnaryExpressionsTest, expressionsWithARealResultGiveTheSameResultWithEveryPolicy) {
+  NegativeSignExpression negation(TokenType::Minus, std::make_unique<LogarithmExpression>(
+                                                      std::make_unique<RealNumberExpression>(8.0), 2, TokenType::Log));
+  auto const checked = negation.evaluateWith<MathTree::EvaluationPolicy::Checked>();
+  EXPECT_DOUBLE_EQ(checked, -3.0);
+  EXPECT_EQ(negation.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), checked);
+  EXPECT_EQ(negation.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), checked);
+}
+
+TEST_F(UnaryExpressionsTest, constructingAConstantPowerWithAnExponentThatCannotBeReducedThrows) {
+  EXPECT_THROW(ConstantPowerExpression(std::make_unique<RealNumberExpression>(2.0), 1.5), std::logic_error);
+  EXPECT_THROW(ConstantPowerExpression(std::make_unique<RealNumberExpression>(2.0),
+                                       ConstantPowerExpression::maxIntegerExponent + 1), std::logic_error);
+  EXPECT_THROW(ConstantPowerExpression(nullptr, 2.0), std::logic_error);
+}
+
+TEST_F(UnaryExpressionsTest, constantPowersComputeIntegerPowersAndSquareRoots) {
+  EXPECT_EQ(ConstantPowerExpression(std::make_unique<RealNumberExpression>(-3.0), 3).evaluate(), -27.0);
+  EXPECT_EQ(ConstantPowerExpression(std::make_unique<RealNumberExpression>(2.0), -2).evaluate(), 0.25);
+  EXPECT_EQ(ConstantPowerExpression(std::make_unique<RealNumberExpression>(-3.0), 0).evaluate(), 1.0);
+  EXPECT_EQ(ConstantPowerExpression(std::make_unique<RealNumberExpression>(6.25), 0.5).evaluate(), 2.5);
+}
+
+TEST_F(UnaryExpressionsTest, invalidConstantPowersThrowWhenCheckedAndPropagateOtherwise) {
+  ConstantPowerExpression reciprocal(std::make_unique<RealNumberExpression>(0.0), -2);
+  EXPECT_THROW(reciprocal.evaluate(), std::domain_error);
+  EXPECT_EQ(reciprocal.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), HUGE_VAL);
+  ConstantPowerExpression squareRoot(std::make_unique<RealNumberExpression>(-4.0), 0.5);
+  EXPECT_EQ(squareRoot.tryEvaluate().error(), MathTree::EvaluationError::InvalidPower);
+  EXPECT_TRUE(std::isnan(squareRoot.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+}
+
+TEST_F(UnaryExpressionsTest, specialisedLogarithmsComputeTheLogarithmInTheirBase) {
+  for (auto base: {2.0, 10.0, std::exp(1.0), 3.0}) {
+    SpecialisedLogarithmExpression log(std::make_unique<RealNumberExpression>(base * base * base), base, TokenType::Log);
+    EXPECT_DOUBLE_EQ(log.evaluate(), 3.0) << base;
+  }
+  SpecialisedLogarithmExpression log(std::make_unique<RealNumberExpression>(-1.0), 10, TokenType::Log);
+  EXPECT_THROW(log.evaluate(), std::domain_error);
+  EXPECT_THROW(SpecialisedLogarithmExpression(std::make_unique<RealNumberExpression>(1.0), -2, TokenType::Log),
+               std::domain_error);
+}
+
+TEST_F(UnaryExpressionsTest, polynomialsAreEvaluatedAtTheResultOfTheirArgument) {
+  EXPECT_CALL(*exprMock, evaluate).WillOnce(Return(2.0));
+  PolynomialExpression polynomial(std::move(exprMock), {1.0, -3.0, 0.5});
+  EXPECT_DOUBLE_EQ(polynomial.evaluate(), -3.0);
+  EXPECT_EQ(polynomial.degree(), 2);
+}
+
+TEST_F(UnaryExpressionsTest, polynomialsOfHighDegreeAreEvaluatedWithTheSameResult) {
+  // 2^0 + 2^1 + ... + 2^20, whose partial sums are all exact
+  PolynomialExpression::Coefficients coefficients(21, 1.0);
+  PolynomialExpression polynomial(std::make_unique<RealNumberExpression>(2.0), std::move(coefficients));
+  EXPECT_EQ(polynomial.evaluate(), 2097151.0);
+}
+
+TEST_F(UnaryExpressionsTest, printingAPolynomialPrintsItsNonZeroTermsInDecreasingDegree) {
+  PolynomialExpression polynomial(std::make_unique<RealNumberExpression>(2.0), {-1.0, 0.0, 0.5, -3.0});
+  std::stringstream stream;
+  polynomial.print(stream);
+  EXPECT_EQ(stream.str(), "(-3 * 2 ^ 3 + 0.5 * 2 ^ 2 - 1)");
+}
+
+TEST_F(UnaryExpressionsTest, constructingAPolynomialWithoutCoefficientsOrWithTooManyThrows) {
+  EXPECT_THROW(PolynomialExpression(std::make_unique<RealNumberExpression>(2.0), {}), std::logic_error);
+  PolynomialExpression::Coefficients coefficients(PolynomialExpression::maxDegree + 2, 1.0);
+  EXPECT_THROW(PolynomialExpression(std::make_unique<RealNumberExpression>(2.0), coefficients), std::logic_error);
+  EXPECT_THROW(PolynomialExpression(nullptr, {1.0}), std::logic_error);
+}
+
+TEST_F(UnaryExpressionsTest, memoisedExpressionsEvaluateTheirSubexpressionOnlyOnce) {
+  ON_CALL(*exprMock, isConstant()).WillByDefault(Return(true));
+  EXPECT_CALL(*exprMock, evaluate).WillOnce(Return(42.0));
+  MemoisedExpression memoised(std::move(exprMock));
+  EXPECT_EQ(memoised.evaluate(), 42.0);
+  EXPECT_EQ(memoised.evaluate(), 42.0);
+  EXPECT_EQ(memoised.tryEvaluate().value(), 42.0);
+  EXPECT_EQ(memoised.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), 42.0);
+}
+
+TEST_F(UnaryExpressionsTest, memoisedExpressionsKeepNoErrorNorResultWithoutARealValue) {
+  ON_CALL(*exprMock, isConstant()).WillByDefault(Return(true));
+  EXPECT_CALL(*exprMock, evaluate).WillOnce(Return(-1.0))
+                                  .WillOnce(Return(-1.0))
+                                  .WillOnce(Return(4.0));
+  MemoisedExpression memoised(std::make_unique<SquareRootExpression>(std::move(exprMock), TokenType::SquareRoot));
+  EXPECT_THROW(memoised.evaluate(), std::domain_error);
+  EXPECT_TRUE(std::isnan(memoised.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+  EXPECT_EQ(memoised.evaluate(), 2.0);
+  EXPECT_EQ(memoised.evaluate(), 2.0);
+}
+
+TEST_F(UnaryExpressionsTest, memoisedExpressionsKeepOnlyTheFiniteResultsOfAnUncheckedEvaluation) {
+  ON_CALL(*exprMock, isConstant()).WillByDefault(Return(true));
+  EXPECT_CALL(*exprMock, evaluate).WillOnce(Return(-1.0))
+                                  .WillOnce(Return(-1.0))
+                                  .WillOnce(Return(4.0));
+  MemoisedExpression memoised(std::make_unique<SquareRootExpression>(std::move(exprMock), TokenType::SquareRoot));
+  EXPECT_TRUE(std::isnan(memoised.evaluateWith<MathTree::EvaluationPolicy::Unchecked>()));
+  EXPECT_THROW(memoised.evaluate(), std::domain_error);
+  EXPECT_EQ(memoised.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), 2.0);
+  EXPECT_EQ(memoised.evaluate(), 2.0);
+}
+
+TEST_F(UnaryExpressionsTest, memoisedExpressionsPrintAsTheirSubexpression) {
+  MemoisedExpression memoised(std::make_unique<NegativeSignExpression>(TokenType::Minus,
+                                                                       std::make_unique<RealNumberExpression>(2.0)));
+  std::stringstream stream;
+  memoised.print(stream);
+  EXPECT_EQ(stream.str(), "(-2)");
+  EXPECT_TRUE(memoised.isConstant());
+  EXPECT_EQ(memoised.height(), 3);
+}
+
+TEST_F(UnaryExpressionsTest, memoisingAnExpressionWhichIsNotConstantThrows) {
+  ON_CALL(*exprMock, isConstant()).WillByDefault(Return(false));
+  EXPECT_THROW(MemoisedExpression{std::move(exprMock)}, std::logic_error);
+  EXPECT_THROW(MemoisedExpression{nullptr}, std::logic_error);
+}
+
+TEST_F(UnaryExpressionsTest, expressionsDefinedOutsideTheLibraryAreConstantIfAllTheirSubexpressionsAre) {
+  AbsoluteValueExpression constant(std::make_unique<RealNumberExpression>(-2.0));
+  EXPECT_TRUE(constant.isConstant());
+  EXPECT_EQ(MemoisedExpression(std::make_unique<AbsoluteValueExpression>(std::make_unique<RealNumberExpression>(-2.0)))
+                .evaluate(), 2.0);
+
+  ON_CALL(*exprMock, isConstant()).WillByDefault(Return(false));
+  AbsoluteValueExpression variable(std::move(exprMock));
+  EXPECT_FALSE(variable.isConstant());
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "Parser.hpp"
+#include <string>
 
 using MathTree::ArithmeticParser;
 using ::testing::ElementsAre;
@@ -142,7 +143,7 @@ TEST(ValidationTest, repeatedDecimalPointsAreReportedAsMissingOperatorWithTheCor
 }
 
 TEST(ValidationTest, anUnrecognisedSymbolIsReportedAsAnErrorWithTheCorrespondingIndex) {
-  auto errors = ArithmeticParser::validateSyntax("2+a*3");
+  auto errors = ArithmeticParser::validateSyntax("2+#*3");
   auto symbolError = ArithmeticParser::SyntaxErrors::UnrecognisedSymbol;
   EXPECT_THAT(errors, Contains(Pair(2, symbolError)));
 }
@@ -236,4 +237,40 @@ TEST(ValidationTest, canCascadeLogs) {
 TEST(ValidationTest, canCascadeLogsWithSpaces) {
   auto errors = ArithmeticParser::validateSyntax("log log_2 (2^10)");
   EXPECT_THAT(errors, IsEmpty());
+}
+
+TEST(ValidationTest, canValidateCorrectInputsWithVariables) {
+  auto errors = ArithmeticParser::validateSyntax("x + sqrt(rate) * -y_2 / log_2 z");
+  EXPECT_THAT(errors, IsEmpty());
+}
+
+TEST(ValidationTest, variablesNextToNumbersOrOtherVariablesAreReportedAsMissingOperators) {
+  auto missingOperator = ArithmeticParser::SyntaxErrors::MissingOperator;
+  EXPECT_THAT(ArithmeticParser::validateSyntax("2 x"), ElementsAre(Pair(2, missingOperator)));
+  EXPECT_THAT(ArithmeticParser::validateSyntax("x y"), ElementsAre(Pair(2, missingOperator)));
+  EXPECT_THAT(ArithmeticParser::validateSyntax("x(1)"), ElementsAre(Pair(1, missingOperator)));
+}
+
+TEST(ValidationTest, aMissingOperatorAfterALongRunOfSpacesIsReportedWithTheCorrespondingIndex) {
+  auto const input = "12" + std::string(45, ' ') + "\t\n34";
+  auto errors = ArithmeticParser::validateSyntax(input);
+  EXPECT_THAT(errors, ElementsAre(Pair(49, ArithmeticParser::SyntaxErrors::MissingOperator)));
+}
+
+TEST(ValidationTest, anOpeningBracketAfterAClosingBracketIsReportedAsMissingOperatorWithTheCorrespondingIndex) {
+  auto errors = ArithmeticParser::validateSyntax("(1) (2)");
+  EXPECT_THAT(errors, ElementsAre(Pair(4, ArithmeticParser::SyntaxErrors::MissingOperator)));
+}
+
+TEST(ValidationTest, anInputWithoutAnySymbolIsReportedAsEmpty) {
+  auto emptyError = ArithmeticParser::SyntaxErrors::EmptyExpression;
+  EXPECT_THAT(ArithmeticParser::validateSyntax(""), ElementsAre(Pair(0, emptyError)));
+  EXPECT_THAT(ArithmeticParser::validateSyntax(" \t "), ElementsAre(Pair(0, emptyError)));
+}
+
+TEST(ValidationTest, aLogarithmWithANonPositiveBaseIsReportedAsInvalidBaseWithTheCorrespondingIndex) {
+  auto invalidBase = ArithmeticParser::SyntaxErrors::InvalidLogarithmBase;
+  EXPECT_THAT(ArithmeticParser::validateSyntax("2*log_0(5)"), ElementsAre(Pair(2, invalidBase)));
+  EXPECT_THAT(ArithmeticParser::validateSyntax("log_0.0 2"), ElementsAre(Pair(0, invalidBase)));
+  EXPECT_THAT(ArithmeticParser::validateSyntax("log 2+log_0.5 2"), IsEmpty());
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <cmath>
+#include "Expression.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include "SymbolTable.hpp"
+
+using ::testing::IsEmpty;
+using MathTree::SymbolTable;
+using MathTree::VariableExpression;
+
+class VariableTest: public ::testing::Test {
+protected:
+  std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>();
+};
+
+TEST_F(VariableTest, evaluatingAVariableReturnsTheValueItIsCurrentlyBoundTo) {
+  VariableExpression variable(symbols, symbols->bind("x", 1.5));
+  EXPECT_DOUBLE_EQ(variable.evaluate(), 1.5);
+  symbols->bind("x", -2.0);
+  EXPECT_DOUBLE_EQ(variable.evaluate(), -2.0);
+}
+
+TEST_F(VariableTest, evaluatingAnUnboundVariableThrows) {
+  VariableExpression variable(symbols, symbols->declare("x"));
+  EXPECT_ANY_THROW(variable.evaluate());
+}
+
+TEST_F(VariableTest, printingAVariablePrintsItsName) {
+  VariableExpression variable(symbols, symbols->declare("rate"));
+  std::stringstream ss;
+  variable.print(ss);
+  EXPECT_EQ(ss.str(), "rate");
+}
+
+TEST_F(VariableTest, aVariableIsNotConstant) {
+  VariableExpression variable(symbols, symbols->declare("x"));
+  EXPECT_FALSE(variable.isConstant());
+}
+
+TEST_F(VariableTest, aVariableHasNoSubexpressions) {
+  VariableExpression variable(symbols, symbols->declare("x"));
+  EXPECT_THAT(variable.subexpressions(), IsEmpty());
+  EXPECT_EQ(variable.subexpressionCount(), 0);
+  EXPECT_THROW(variable.subexpression(0), std::out_of_range);
+}
+
+TEST_F(VariableTest, constructingAVariableThatWasNotDeclaredThrows) {
+  EXPECT_ANY_THROW(VariableExpression(symbols, 0));
+  EXPECT_ANY_THROW(VariableExpression(nullptr, 0));
+}
+
+TEST_F(VariableTest, tryingToEvaluateAnUnboundVariableReturnsTheErrorAndTheVariable) {
+  VariableExpression variable(symbols, symbols->declare("x"));
+  auto const result = variable.tryEvaluate();
+  ASSERT_FALSE(result.hasValue());
+  EXPECT_EQ(result.error(), MathTree::EvaluationError::UnboundVariable);
+  EXPECT_EQ(result.failedExpression(), &variable);
+  EXPECT_THROW(result.value(), std::logic_error);
+}
+
+TEST_F(VariableTest, unboundVariablesEvaluateToNanWhenErrorsArePropagated) {
+  VariableExpression variable(symbols, symbols->declare("x"));
+  EXPECT_TRUE(std::isnan(variable.evaluateWith<MathTree::EvaluationPolicy::Propagating>()));
+  symbols->bind("x", 4.5);
+  EXPECT_DOUBLE_EQ(variable.evaluateWith<MathTree::EvaluationPolicy::Propagating>(), 4.5);
+  EXPECT_DOUBLE_EQ(variable.evaluateWith<MathTree::EvaluationPolicy::Unchecked>(), 4.5);
+}
\ No newline at end of file
@@ -4,12 +4,16 @@
 #include "Expression.hpp"
 #include "Parser.hpp"
 #include "Lexer.hpp"
+#include <memory>
 #include <unordered_set>
 #include <stack>
 #include <string>
+#include "SymbolTable.hpp"
+#include "Utils.hpp"
 #include <vector>
 
 void printError(size_t idx, MathTree::ArithmeticParser::SyntaxErrors error);
+bool bindUnboundVariables(MathTree::SymbolTable& symbols);
 bool userWantsToContinue();
 
 int main() {
@@ -20,11 +24,18 @@ int main() {
     std::string input;
     std::cout << "Parentheses and the following operators are supported:\n";
     std::cout << "+ (addition), - (subtraction), * (multiplication), / (division)\n";
-    std::cout << "^ (exponentiation), sqrt (square root), log (logarithm base 10) and log_n (logarithm base n).\n\n";
+    std::cout << "^ (exponentiation), sqrt (square root), log (logarithm base 10)\n";
+    std::cout << "and log_n (logarithm base n, such as log_2 or log_e).\n";
+    std::cout << "Variables (e.g. x or rate) can be used, and their value will be asked after parsing.\n";
+    std::cout << "Their names cannot start with sqrt or log, which would read as a function applied to a variable.\n\n";
     std::cout << "Enter an expression:\n";
-    std::getline(std::cin, input);
+    if (!std::getline(std::cin, input)) {
+      break;
+    }
 
-    auto idxErrorPairs = ArithmeticParser::validateSyntax(input);
+    // every input gets its own symbol table, so that values bound for one are never reused by the next
+    auto symbols = std::make_shared<SymbolTable>();
+    auto [expression, idxErrorPairs] = parser.tryParse(input, symbols);
     std::sort(idxErrorPairs.begin(), idxErrorPairs.end(), [](auto const& leftPair, 
                                                              auto const& rightPair) {
       return leftPair.first < rightPair.first;
@@ -38,8 +49,10 @@ int main() {
     }
 
     try {
-      auto expression = parser.parse(std::move(input));
       std::cout << "Expression parsed as " << *expression << "\n";
+      if (!bindUnboundVariables(*symbols)) {
+        break;
+      }
       auto result = expression->evaluate();
       std::cout << "Result is " << result;
     } catch (std::logic_error const& ex) {
@@ -66,16 +79,40 @@ void printError(size_t idx, MathTree::ArithmeticParser::SyntaxErrors error) {
       std::cerr << "Unrecognised symbol at index " << idx << ".\n"; break;
     case ArithmeticParser::SyntaxErrors::NothingBetweenBrackets:
       std::cerr << "Nothing between brackets starting at index " << idx << ".\n"; break;
+    case ArithmeticParser::SyntaxErrors::EmptyExpression:
+      std::cerr << "The expression is empty.\n"; break;
+    case ArithmeticParser::SyntaxErrors::InvalidLogarithmBase:
+      std::cerr << "Logarithm with a non-positive base at index " << idx << ".\n"; break;
+    case ArithmeticParser::SyntaxErrors::ReservedPrefix:
+      std::cerr << "Name starting with sqrt or log at index " << idx << ".\n"; break;
     default:
       std::cerr << "Unknown error at index " << idx << ".\n"; break;
   }
 }
 
+bool bindUnboundVariables(MathTree::SymbolTable& symbols) {
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    while (!symbols.isBound(i)) {
+      std::string input;
+      std::cout << "Enter a value for " << symbols.name(i) << ":\n";
+      if (!std::getline(std::cin, input)) {
+        return false;
+      }
+      if (auto valueOpt = MathTree::Utils::parseDouble(input)) {
+        symbols.bind(i, *valueOpt);
+      }
+    }
+  }
+  return true;
+}
+
 bool userWantsToContinue() {
   std::string input;
   do {
     std::cout << "Continue? (y/n)\n";
-    std::getline(std::cin, input);
+    if (!std::getline(std::cin, input)) {
+      return false;
+    }
   } while (input != "y" && input != "n");
   
   auto wantsToContinue = input == "y";